@@ -0,0 +1,335 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef BIG_DIGITS_HH_
+#define BIG_DIGITS_HH_
+
+#include "digit_adaptor.hh"
+#include "digit_batch.hh"
+#include "string_digit_adaptor.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace jz {
+namespace detail {
+
+// Returns the most digits a big_digits limb holds:  the largest multiple
+// of 3 whose power of RADIX stays below 2^63.  Below 2^63, two limbs and a
+// carry add without overflow.  The multiple of 3 lets the NTT multiply in
+// big_multiply.hh split each limb into three equal pieces.
+template <int RADIX>
+constexpr std::size_t big_limb_digits() noexcept {
+  auto digits = std::size_t{0};
+  for (auto power = std::uint64_t{1};
+       power <= (std::uint64_t{1} << 63) / RADIX; power *= RADIX) {
+    ++digits;
+  }
+  return digits - digits % 3;
+}
+
+}  // namespace detail
+
+// Holds an unsigned number of any length as a standard container of its
+// RADIX digits.  Digits are numbered as digit_adaptor numbers them, most
+// significant first.
+//
+// The number lives in limbs of kLimbDigits digits each, least significant
+// limb first, so each limb is a digit_adaptor<std::uint64_t, RADIX> with a
+// fixed width.  That makes any digit one division away, with no radix
+// conversion, and the references are digit_adaptor's own.  Arithmetic on
+// the limbs, such as big_multiply(), works in base kBase directly.
+//
+// The limbs come from Allocator, such as digit_arena.hh's arena_allocator,
+// or a std::pmr::polymorphic_allocator<std::uint64_t>.
+template <int RADIX = 10,
+          typename Allocator = std::allocator<std::uint64_t>>
+class big_digits {
+  static_assert(RADIX > 1 && RADIX <= 36, "Digits are 0-9 and a-z");
+
+  using limb_adaptor_       = digit_adaptor<std::uint64_t, RADIX>;
+  using const_limb_adaptor_ = digit_adaptor<const std::uint64_t, RADIX>;
+
+ public:
+  static constexpr std::size_t kLimbDigits =
+      detail::big_limb_digits<RADIX>();
+  static constexpr std::uint64_t kBase =
+      detail::radix_power<std::uint64_t, RADIX>(kLimbDigits);
+
+  using limbs_type     = std::vector<std::uint64_t, Allocator>;
+  using allocator_type = Allocator;
+
+  // Zero, with one digit.
+  big_digits() : big_digits(Allocator{}) {}
+
+  explicit big_digits(const Allocator& alloc)
+  : limbs_(1, 0, alloc), digits_{1} {}
+
+  explicit big_digits(std::uint64_t value,
+                      const Allocator& alloc = Allocator{})
+  : limbs_(alloc) {
+    do {
+      limbs_.push_back(value % kBase);
+      value /= kBase;
+    } while (value != 0);
+    digits_ = natural_digits();
+  }
+
+  // Reads digits, most significant first, keeping any leading zeros in
+  // size().  Characters that aren't RADIX digits give unspecified digits.
+  explicit big_digits(const std::string& text,
+                      const Allocator& alloc = Allocator{})
+  : limbs_(std::max<std::size_t>(1, (text.size() + kLimbDigits - 1) /
+                                        kLimbDigits), 0, alloc),
+    digits_{text.size()} {
+    auto p = text.size();
+    for (auto& limb : limbs_) {
+      const auto first = p > kLimbDigits ? p - kLimbDigits : 0;
+      for (auto i = first; i != p; ++i) {
+        limb = limb * RADIX + detail::char_digit<RADIX>(text[i]) % RADIX;
+      }
+      p = first;
+    }
+  }
+
+  // Adopts limbs in base kBase, least significant first.  Each must be
+  // below kBase.  Leading zero limbs are dropped.
+  explicit big_digits(limbs_type limbs)
+  : limbs_{std::move(limbs)} {
+    trim();
+    digits_ = natural_digits();
+  }
+
+  // Forward iterators.
+  auto begin() noexcept { return make_iterator(data(), 0); }
+  auto end() noexcept { return make_iterator(data(), digits_); }
+  auto begin() const noexcept { return cbegin(); }
+  auto end() const noexcept { return cend(); }
+  auto cbegin() const noexcept { return make_iterator(data(), 0); }
+  auto cend() const noexcept { return make_iterator(data(), digits_); }
+
+  // Reverse iterators.
+  auto rbegin() noexcept { return std::make_reverse_iterator(end()); }
+  auto rend() noexcept { return std::make_reverse_iterator(begin()); }
+  auto rbegin() const noexcept { return crbegin(); }
+  auto rend() const noexcept { return crend(); }
+  auto crbegin() const noexcept { return std::make_reverse_iterator(cend()); }
+  auto crend() const noexcept { return std::make_reverse_iterator(cbegin()); }
+
+  // Provides indirect access to each digit, through digit_adaptor's
+  // references to the limb that holds it.
+  auto operator[](std::size_t index) noexcept {
+    return begin()[static_cast<std::ptrdiff_t>(index)];
+  }
+  auto operator[](std::size_t index) const noexcept {
+    return cbegin()[static_cast<std::ptrdiff_t>(index)];
+  }
+
+  // Returns the number of digits in the container.
+  std::size_t size() const noexcept {
+    return digits_;
+  }
+
+  // Returns the limbs, least significant first.
+  const limbs_type& limbs() const noexcept {
+    return limbs_;
+  }
+
+  allocator_type get_allocator() const noexcept {
+    return limbs_.get_allocator();
+  }
+
+  // Writes size() digits, most significant first, one per byte.
+  void decode(std::uint8_t* out) const noexcept {
+    auto p = out + digits_;
+    for (auto limb : limbs_) {
+      const auto first = p - std::min<std::size_t>(p - out, kLimbDigits);
+      while (p != first) {
+        *--p = static_cast<std::uint8_t>(limb % RADIX);
+        limb /= RADIX;
+      }
+    }
+  }
+
+  // Returns the digits as text, in lowercase past 9.
+  std::string str() const {
+    auto text = std::string(digits_, '0');
+    decode(reinterpret_cast<std::uint8_t*>(&text[0]));
+    for (auto& c : text) {
+      c = detail::digit_char(c);
+    }
+    return text;
+  }
+
+  // Compares as standard containers do, so 12 and 012 differ.
+  bool operator==(const big_digits& rhs) const noexcept {
+    if (digits_ != rhs.digits_) {
+      return false;
+    }
+    const auto n = std::min(limbs_.size(), rhs.limbs_.size());
+    return std::equal(limbs_.begin(), limbs_.begin() + n, rhs.limbs_.begin());
+  }
+
+  bool operator!=(const big_digits& rhs) const noexcept {
+    return !this->operator==(rhs);
+  }
+
+ private:
+  limbs_type  limbs_;
+  std::size_t digits_;
+
+  std::uint64_t* data() noexcept { return limbs_.data(); }
+  const std::uint64_t* data() const noexcept { return limbs_.data(); }
+
+  void trim() noexcept {
+    while (limbs_.size() > 1 && limbs_.back() == 0) {
+      limbs_.pop_back();
+    }
+    if (limbs_.empty()) {
+      limbs_.push_back(0);
+    }
+  }
+
+  std::size_t natural_digits() const noexcept {
+    return (limbs_.size() - 1) * kLimbDigits +
+           const_limb_adaptor_{limbs_.back()}.size();
+  }
+
+  // Walks digit positions, most significant first, and hands out the
+  // owning limb's digit_adaptor references.  QL is the "qualified limb."
+  template <typename QL>
+  class iterator_ {
+    using adaptor_ = std::conditional_t<std::is_const<QL>::value,
+                         const_limb_adaptor_, limb_adaptor_>;
+
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = std::uint64_t;
+    using pointer           = typename adaptor_::pointer;
+    using reference         = typename adaptor_::reference;
+
+    constexpr iterator_() noexcept : limbs_{nullptr}, end_{0}, index_{0} {}
+
+    constexpr iterator_(const iterator_&)            = default;
+    constexpr iterator_& operator=(const iterator_&) = default;
+
+    constexpr auto& operator++() noexcept { ++index_; return *this; }
+    constexpr auto& operator--() noexcept { --index_; return *this; }
+
+    constexpr auto operator++(int) noexcept {
+      auto temp = iterator_{*this};
+      ++index_;
+      return temp;
+    }
+
+    constexpr auto operator--(int) noexcept {
+      auto temp = iterator_{*this};
+      --index_;
+      return temp;
+    }
+
+    constexpr auto operator+(difference_type rhs) const noexcept {
+      return iterator_{*this} += rhs;
+    }
+
+    constexpr auto operator-(difference_type rhs) const noexcept {
+      return iterator_{*this} -= rhs;
+    }
+
+    friend constexpr auto operator+(difference_type lhs,
+                                    const iterator_& rhs) noexcept {
+      return rhs + lhs;
+    }
+
+    constexpr difference_type operator-(const iterator_& rhs) const noexcept {
+      return index_ - rhs.index_;
+    }
+
+    constexpr auto& operator+=(difference_type rhs) noexcept {
+      index_ += rhs;
+      return *this;
+    }
+
+    constexpr auto& operator-=(difference_type rhs) noexcept {
+      index_ -= rhs;
+      return *this;
+    }
+
+    constexpr bool operator==(const iterator_& rhs) const noexcept {
+      return index_ == rhs.index_;
+    }
+
+    constexpr bool operator!=(const iterator_& rhs) const noexcept {
+      return index_ != rhs.index_;
+    }
+
+    constexpr bool operator<(const iterator_& rhs) const noexcept {
+      return index_ < rhs.index_;
+    }
+
+    constexpr bool operator>=(const iterator_& rhs) const noexcept {
+      return index_ >= rhs.index_;
+    }
+
+    constexpr bool operator>(const iterator_& rhs) const noexcept {
+      return index_ > rhs.index_;
+    }
+
+    constexpr bool operator<=(const iterator_& rhs) const noexcept {
+      return index_ <= rhs.index_;
+    }
+
+    // end_ is the digit count, so the position counting from the least
+    // significant digit is end_ - 1 - index_.
+    constexpr reference operator*() const noexcept {
+      const auto p = end_ - 1 - static_cast<std::size_t>(index_);
+      return reference{
+          limbs_ + p / kLimbDigits,
+          detail::radix_power<std::uint64_t, RADIX>(p % kLimbDigits)};
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+      return *(*this + index);
+    }
+
+   private:
+    QL* limbs_;
+    std::size_t end_;
+    difference_type index_;
+
+    constexpr iterator_(QL* limbs, std::size_t digits,
+                        difference_type index) noexcept
+    : limbs_{limbs}, end_{digits}, index_{index} {}
+
+    friend class big_digits;
+  };
+
+  template <typename QL>
+  auto make_iterator(QL* limbs, std::size_t index) const noexcept {
+    return iterator_<QL>{limbs, digits_, static_cast<std::ptrdiff_t>(index)};
+  }
+
+ public:
+  using value_type      = std::uint64_t;
+  using size_type       = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference       = typename limb_adaptor_::reference;
+  using const_reference = typename const_limb_adaptor_::reference;
+  using iterator        = iterator_<std::uint64_t>;
+  using const_iterator  = iterator_<const std::uint64_t>;
+};
+
+template <int RADIX, typename Allocator>
+constexpr std::size_t big_digits<RADIX, Allocator>::kLimbDigits;
+
+template <int RADIX, typename Allocator>
+constexpr std::uint64_t big_digits<RADIX, Allocator>::kBase;
+
+}  // namespace jz
+#endif // BIG_DIGITS_HH_
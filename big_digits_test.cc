@@ -0,0 +1,108 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "big_digits.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+using jz::big_digits;
+
+// Tests reading digits across limb boundaries, from text and from a value.
+bool TestReadingDigits() {
+  const auto text = std::string{"1234567890123456789012345678901234567"};
+  const big_digits<> d{text};
+  if (d.size() != text.size() || d.limbs().size() != 3) { return false; }
+  for (std::size_t i = 0; i != text.size(); ++i) {
+    if (d[i] != std::uint64_t(text[i] - '0')) { return false; }
+  }
+
+  const big_digits<> v{18446744073709551615ULL};
+  return v.size() == 20 && v.str() == "18446744073709551615" &&
+         v.limbs() == std::vector<std::uint64_t>{
+             446744073709551615ULL, 18} &&
+         big_digits<>{}.str() == "0" && big_digits<>{}.size() == 1;
+}
+
+// Tests that leading zeros from text count as digits, and that adopted
+// limbs lose theirs.
+bool TestLeadingZeros() {
+  const big_digits<> d{std::string{"000000000000000000000042"}};
+  if (d.size() != 24 || d[0] != 0 || d[22] != 4 || d[23] != 2) {
+    return false;
+  }
+  if (d == big_digits<>{42}) { return false; }
+
+  const big_digits<> v{std::vector<std::uint64_t>{42, 0, 0}};
+  return v.size() == 2 && v.limbs().size() == 1 && v == big_digits<>{42} &&
+         big_digits<>{std::vector<std::uint64_t>{}}.str() == "0";
+}
+
+// Tests writing through references, which write into the owning limb.
+bool TestWritingDigits() {
+  big_digits<> d{std::string{"1000000000000000000000"}};
+  d[0] = 9;
+  d[3] = 5;
+  d[d.size() - 1] = 7;
+  if (d.str() != "9005000000000000000007") { return false; }
+
+  for (auto digit : d) {
+    digit = 3;
+  }
+  return d.str() == std::string(22, '3') &&
+         d.limbs() == std::vector<std::uint64_t>{
+             333333333333333333ULL, 3333};
+}
+
+// Tests that the iterators work with the standard algorithms, including
+// sorting, which swaps digits in different limbs.
+bool TestStandardAlgorithms() {
+  big_digits<> d{std::string{"31415926535897932384626433832795"}};
+  if (std::count(d.cbegin(), d.cend(), 3) != 7) { return false; }
+  if (d.crend() - d.crbegin() != 32 || d.rbegin()[0] != 5) { return false; }
+
+  auto reversed = std::string{};
+  std::for_each(d.crbegin(), d.crend(),
+                [&](int digit) { reversed += char('0' + digit); });
+  if (reversed != "59723833462648323979853562951413") { return false; }
+
+  std::sort(d.begin(), d.end());
+  return d.str() == "11222233333334445555666778889999" &&
+         std::is_sorted(d.cbegin(), d.cend());
+}
+
+// Tests other radices, whose limbs hold different numbers of digits.
+bool TestOtherRadices() {
+  const auto bits = std::string(100, '1');
+  const big_digits<2> b{bits};
+  const big_digits<16> h{std::string{"0123456789abcdefedcba9876543210"}};
+  const big_digits<36> z{std::string{"zyxwvutsrqponmlkjihgfedcba9876543210"}};
+
+  auto digits = std::vector<std::uint8_t>(h.size());
+  h.decode(digits.data());
+  return big_digits<2>::kLimbDigits == 63 && b.str() == bits &&
+         b.limbs().size() == 2 && std::count(b.begin(), b.end(), 1) == 100 &&
+         big_digits<16>::kLimbDigits == 15 && h[10] == 10 && h[15] == 15 &&
+         digits[30] == 0 && digits[15] == 15 &&
+         z.str() == "zyxwvutsrqponmlkjihgfedcba9876543210" && z[0] == 35;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestReadingDigits),
+  TEST_CASE(TestLeadingZeros),
+  TEST_CASE(TestWritingDigits),
+  TEST_CASE(TestStandardAlgorithms),
+  TEST_CASE(TestOtherRadices),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,548 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef BIG_MULTIPLY_HH_
+#define BIG_MULTIPLY_HH_
+
+#include "big_digits.hh"
+#include "wide_digit_adaptor.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace jz {
+
+// Picks big_multiply()'s algorithm by the shorter operand's length in
+// limbs.  The defaults come from the benchmark's multiply report, for
+// decimal limbs.
+struct big_multiply_options {
+  // Shorter than this, schoolbook multiplication.
+  std::size_t karatsuba_limbs = 16;
+
+  // From this length, Toom-3, while the operands are within a factor of
+  // 1.5 in length; Karatsuba otherwise.
+  std::size_t toom3_limbs = 192;
+
+  // From this length, a number-theoretic transform (NTT), as long as the
+  // product fits its largest transform.
+  std::size_t ntt_limbs = 768;
+
+  // The NTT works modulo three primes, independently, so up to three
+  // threads help.  Starting a thread allocates, whatever the Allocator.
+  unsigned threads = 1;
+};
+
+namespace detail {
+
+// Adds and subtracts limbs in base BASE, which must be at most 2^63 so
+// that two limbs and a carry can't overflow.
+template <std::uint64_t BASE>
+struct base_limbs {
+  static_assert(BASE <= std::uint64_t{1} << 63, "Limbs could overflow");
+
+  // Sets x += y, where nx >= ny, and returns the carry out of x.
+  static std::uint64_t add(std::uint64_t* x, std::size_t nx,
+                           const std::uint64_t* y, std::size_t ny) noexcept {
+    auto carry = std::uint64_t{0};
+    auto i = std::size_t{0};
+    for (; i != ny; ++i) {
+      const auto sum = x[i] + y[i] + carry;
+      carry = sum >= BASE;
+      x[i] = carry ? sum - BASE : sum;
+    }
+    for (; carry != 0 && i != nx; ++i) {
+      carry = ++x[i] == BASE;
+      x[i] = carry ? 0 : x[i];
+    }
+    return carry;
+  }
+
+  // Sets x -= y, where nx >= ny, and returns the borrow out of x.
+  static std::uint64_t subtract(std::uint64_t* x, std::size_t nx,
+                                const std::uint64_t* y,
+                                std::size_t ny) noexcept {
+    auto borrow = std::uint64_t{0};
+    auto i = std::size_t{0};
+    for (; i != ny; ++i) {
+      const auto take = y[i] + borrow;
+      borrow = x[i] < take;
+      x[i] = x[i] - take + (borrow ? BASE : 0);
+    }
+    for (; borrow != 0 && i != nx; ++i) {
+      borrow = x[i] == 0;
+      x[i] = borrow ? BASE - 1 : x[i] - 1;
+    }
+    return borrow;
+  }
+
+  // Sets x *= m, for a small m, and returns the limb that spills out.
+  static std::uint64_t multiply_small(std::uint64_t* x, std::size_t n,
+                                      std::uint64_t m) noexcept {
+    auto carry = std::uint64_t{0};
+    for (auto i = std::size_t{0}; i != n; ++i) {
+      const auto p = umul128(x[i], m);
+      const auto lo = p.lo + carry;
+      auto hi = p.hi + (lo < p.lo);
+      carry = limb_divider<BASE>::step(hi, lo);
+      x[i] = hi;
+    }
+    return carry;
+  }
+
+  // Sets x /= d, for a small d that divides x exactly.  With BASE =
+  // q * d + r, each step is rem * BASE + x[i] = rem * q * d + (rem * r +
+  // x[i]), which keeps everything in 64 bits.
+  static void divide_exact(std::uint64_t* x, std::size_t n,
+                           std::uint64_t d) noexcept {
+    const auto q = BASE / d, r = BASE % d;
+    auto rem = std::uint64_t{0};
+    for (auto i = n; i-- != 0; ) {
+      const auto low = rem * r + x[i];
+      x[i] = rem * q + low / d;
+      rem = low % d;
+    }
+  }
+
+  // Sets out[0, na + nb) = a * b, one row of b per limb of a.  Each step
+  // is at most (BASE - 1)^2 + 2 * (BASE - 1), which is under BASE * 2^64,
+  // so one limb_divider step splits it into a digit and a carry.
+  static void schoolbook(std::uint64_t* out, const std::uint64_t* a,
+                         std::size_t na, const std::uint64_t* b,
+                         std::size_t nb) noexcept {
+    std::fill(out, out + na + nb, 0);
+    for (auto i = std::size_t{0}; i != na; ++i) {
+      auto carry = std::uint64_t{0};
+      for (auto j = std::size_t{0}; j != nb; ++j) {
+        const auto p = umul128(a[i], b[j]);
+        const auto lo = p.lo + out[i + j];
+        const auto sum = lo + carry;
+        auto hi = p.hi + (lo < p.lo) + (sum < lo);
+        carry = limb_divider<BASE>::step(hi, sum);
+        out[i + j] = hi;
+      }
+      out[i + nb] = carry;
+    }
+  }
+};
+
+// Number-theoretic transforms modulo a prime P = c * 2^k + 1, for which 3
+// is a primitive root.  Values are in [0, P).
+template <std::uint32_t P>
+struct ntt_prime {
+  static std::uint32_t multiply(std::uint32_t a, std::uint32_t b) noexcept {
+    return static_cast<std::uint32_t>(std::uint64_t{a} * b % P);
+  }
+
+  static constexpr std::uint32_t power(std::uint32_t a,
+                                       std::uint64_t e) noexcept {
+    auto result = std::uint64_t{1}, base = std::uint64_t{a} % P;
+    for (; e != 0; e >>= 1, base = base * base % P) {
+      if (e & 1) {
+        result = result * base % P;
+      }
+    }
+    return static_cast<std::uint32_t>(result);
+  }
+
+  // Returns x * w mod P, by Shoup's method:  with w' = floor(w * 2^32 / P)
+  // computed ahead, the quotient estimate is one multiply-high, and off
+  // by at most one.  Needs P < 2^31.
+  static std::uint32_t multiply_shoup(std::uint32_t x, std::uint32_t w,
+                                      std::uint32_t w_shoup) noexcept {
+    const auto q = static_cast<std::uint32_t>((std::uint64_t{x} * w_shoup) >>
+                                              32);
+    const auto r = x * w - q * P;
+    return r >= P ? r - P : r;
+  }
+
+  // Fills roots[h, 2h) with the powers of a primitive (2h)th root of
+  // unity, for each power of 2 h below n, and shoup[] with their Shoup
+  // factors.  Each needs room for n values.
+  static void make_roots(std::uint32_t* roots, std::uint32_t* shoup,
+                         std::size_t n) noexcept {
+    for (auto half = std::size_t{1}; half < n; half <<= 1) {
+      const auto root = power(3, (P - 1) / (2 * half));
+      auto w = std::uint32_t{1};
+      for (auto k = half; k != 2 * half; ++k) {
+        roots[k] = w;
+        shoup[k] = static_cast<std::uint32_t>((std::uint64_t{w} << 32) / P);
+        w = multiply(w, root);
+      }
+    }
+  }
+
+  // Transforms a[0, n) in place, where n is a power of 2 that divides
+  // P - 1, using make_roots()'s tables for n.
+  static void transform(std::uint32_t* a, std::size_t n,
+                        const std::uint32_t* roots,
+                        const std::uint32_t* shoup) noexcept {
+    for (auto i = std::size_t{1}, j = std::size_t{0}; i < n; ++i) {
+      auto bit = n >> 1;
+      for (; j & bit; bit >>= 1) {
+        j ^= bit;
+      }
+      j ^= bit;
+      if (i < j) {
+        std::swap(a[i], a[j]);
+      }
+    }
+
+    for (auto half = std::size_t{1}; half < n; half <<= 1) {
+      const auto w = roots + half;
+      const auto w_shoup = shoup + half;
+      for (auto i = std::size_t{0}; i != n; i += 2 * half) {
+        for (auto k = std::size_t{0}; k != half; ++k) {
+          const auto u = a[i + k];
+          const auto v = multiply_shoup(a[i + k + half], w[k], w_shoup[k]);
+          a[i + k] = u + v >= P ? u + v - P : u + v;
+          a[i + k + half] = u >= v ? u - v : u + P - v;
+        }
+      }
+    }
+  }
+
+  // Sets a[0, n) to the cyclic convolution of a and b, modulo P, leaving
+  // b transformed.  'tables' is room for make_roots().  The inverse
+  // transform is the forward one with the outputs past the first reversed,
+  // and scaled by 1/n, which folds into the pointwise products.
+  static void convolve(std::uint32_t* a, std::uint32_t* b, std::size_t n,
+                       std::uint32_t* tables) noexcept {
+    const auto roots = tables, shoup = tables + n;
+    make_roots(roots, shoup, n);
+
+    transform(a, n, roots, shoup);
+    transform(b, n, roots, shoup);
+    const auto scale = power(static_cast<std::uint32_t>(n % P), P - 2);
+    const auto scale_shoup =
+        static_cast<std::uint32_t>((std::uint64_t{scale} << 32) / P);
+    for (auto i = std::size_t{0}; i != n; ++i) {
+      a[i] = multiply_shoup(multiply(a[i], b[i]), scale, scale_shoup);
+    }
+    transform(a, n, roots, shoup);
+    std::reverse(a + 1, a + n);
+  }
+};
+
+// Multiplies by NTT modulo three primes, which recover each term of the
+// convolution exactly by the Chinese remainder theorem.  The primes'
+// product is about 2^86.  Each limb splits into pieces:  two, when a
+// piece is below 2^31, since a term is then under 2^62 times the longest
+// operand's 2^23 pieces; otherwise three, each below 2^21.
+template <int RADIX>
+struct big_ntt {
+  static constexpr std::uint32_t kP1 = 998244353;      // 119 * 2^23 + 1
+  static constexpr std::uint32_t kP2 = 167772161;      //   5 * 2^25 + 1
+  static constexpr std::uint32_t kP3 = 469762049;      //   7 * 2^26 + 1
+
+  // The longest transform all three primes support.
+  static constexpr std::size_t kMaxLength = std::size_t{1} << 23;
+
+  static constexpr std::size_t kLimbDigits = big_digits<RADIX>::kLimbDigits;
+  static constexpr std::size_t kPieces =
+      kLimbDigits % 2 == 0 && radix_power<std::uint64_t, RADIX>(
+          kLimbDigits / 2) < (std::uint64_t{1} << 31) ? 2 : 3;
+  static constexpr std::uint64_t kPiece =
+      radix_power<std::uint64_t, RADIX>(kLimbDigits / kPieces);
+
+  static constexpr std::size_t max_product_limbs() noexcept {
+    return kMaxLength / kPieces;
+  }
+
+  // Returns the term whose residues are r1, r2 and r3, by Garner's method.
+  static uint128_parts combine(std::uint32_t r1, std::uint32_t r2,
+                               std::uint32_t r3) noexcept {
+    constexpr auto kInvP1 = ntt_prime<kP2>::power(kP1 % kP2, kP2 - 2);
+    constexpr auto kP1P2 = std::uint64_t{kP1} * kP2;
+    constexpr auto kInvP1P2 = ntt_prime<kP3>::power(
+        static_cast<std::uint32_t>(kP1P2 % kP3), kP3 - 2);
+
+    const auto v2 = ntt_prime<kP2>::multiply(r2 + kP2 - r1 % kP2, kInvP1);
+    const auto low = r1 + std::uint64_t{v2} * kP1;
+    const auto v3 = ntt_prime<kP3>::multiply(
+        static_cast<std::uint32_t>((r3 + kP3 - low % kP3) % kP3), kInvP1P2);
+    auto x = umul128(v3, kP1P2);
+    x.lo += low;
+    x.hi += x.lo < low;
+    return x;
+  }
+
+  static void split(std::uint32_t* pieces, const std::uint64_t* a,
+                    std::size_t n) noexcept {
+    for (auto i = std::size_t{0}; i != n; ++i) {
+      auto limb = a[i];
+      for (auto j = std::size_t{0}; j != kPieces; ++j, limb /= kPiece) {
+        pieces[kPieces * i + j] = static_cast<std::uint32_t>(limb % kPiece);
+      }
+    }
+  }
+
+  // Sets out[0, na + nb) = a * b.  Every buffer comes from 'alloc', in
+  // this thread, in one piece:  the three residues, the pieces of b, and a
+  // lane of room for each convolution that runs at once.
+  template <typename Alloc>
+  static void multiply(std::uint64_t* out, const std::uint64_t* a,
+                       std::size_t na, const std::uint64_t* b,
+                       std::size_t nb, unsigned threads, const Alloc& alloc) {
+    using buffer = std::vector<std::uint32_t, typename std::allocator_traits<
+                                   Alloc>::template rebind_alloc<
+                                   std::uint32_t>>;
+
+    const auto terms = kPieces * (na + nb);
+    auto n = std::size_t{1};
+    while (n < terms) {
+      n <<= 1;
+    }
+    const auto lanes = std::size_t{std::min(std::max(threads, 1u), 3u)};
+    auto work = buffer(n * (4 + 3 * lanes), alloc);
+    std::uint32_t* const residues[] = {work.data(), work.data() + n,
+                                       work.data() + 2 * n};
+    const auto pieces = work.data() + 3 * n;
+    split(residues[0], a, na);
+    split(pieces, b, nb);
+    std::copy(residues[0], residues[0] + n, residues[1]);
+    std::copy(residues[0], residues[0] + n, residues[2]);
+
+    // Each lane has a copy of b's pieces, and the tables.
+    const auto convolve = [&](std::size_t prime, std::size_t lane) {
+      const auto copy = pieces + n + 3 * n * lane, tables = copy + n;
+      std::copy(pieces, pieces + n, copy);
+      switch (prime) {
+        case 0:  ntt_prime<kP1>::convolve(residues[0], copy, n, tables); break;
+        case 1:  ntt_prime<kP2>::convolve(residues[1], copy, n, tables); break;
+        default: ntt_prime<kP3>::convolve(residues[2], copy, n, tables); break;
+      }
+    };
+    auto workers = std::vector<std::thread>{};
+    if (lanes > 1) {
+      workers.reserve(lanes - 1);
+    }
+    for (auto prime = std::size_t{1}; prime != 3; ++prime) {
+      if (prime < lanes) {
+        workers.emplace_back(convolve, prime, prime);
+      } else {
+        convolve(prime, 0);
+      }
+    }
+    convolve(0, 0);
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    // Carries the terms into pieces, then packs the pieces into limbs.
+    auto carry = uint128_parts{0, 0};
+    const auto digits = pieces;
+    for (auto i = std::size_t{0}; i != terms; ++i) {
+      auto x = combine(residues[0][i], residues[1][i], residues[2][i]);
+      x.lo += carry.lo;
+      x.hi += carry.hi + (x.lo < carry.lo);
+      auto rem = std::uint64_t{0};
+      carry.hi = limb_divider<kPiece>::step(rem, x.hi);
+      carry.lo = limb_divider<kPiece>::step(rem, x.lo);
+      digits[i] = static_cast<std::uint32_t>(rem);
+    }
+    for (auto i = std::size_t{0}; i != na + nb; ++i) {
+      auto limb = std::uint64_t{0};
+      for (auto j = kPieces; j-- != 0; ) {
+        limb = limb * kPiece + digits[kPieces * i + j];
+      }
+      out[i] = limb;
+    }
+  }
+};
+
+template <int RADIX> constexpr std::uint32_t big_ntt<RADIX>::kP1;
+template <int RADIX> constexpr std::uint32_t big_ntt<RADIX>::kP2;
+template <int RADIX> constexpr std::uint32_t big_ntt<RADIX>::kP3;
+template <int RADIX> constexpr std::size_t big_ntt<RADIX>::kMaxLength;
+template <int RADIX> constexpr std::size_t big_ntt<RADIX>::kLimbDigits;
+template <int RADIX> constexpr std::size_t big_ntt<RADIX>::kPieces;
+template <int RADIX> constexpr std::uint64_t big_ntt<RADIX>::kPiece;
+
+template <int RADIX, typename Alloc>
+void big_karatsuba(std::uint64_t* out, const std::uint64_t* a,
+                   std::size_t na, const std::uint64_t* b, std::size_t nb,
+                   const big_multiply_options& options, const Alloc& alloc);
+
+template <int RADIX, typename Alloc>
+void big_toom3(std::uint64_t* out, const std::uint64_t* a, std::size_t na,
+               const std::uint64_t* b, std::size_t nb,
+               const big_multiply_options& options, const Alloc& alloc);
+
+// Sets out[0, na + nb) = a * b in base RADIX^kLimbDigits.  'out' must not
+// overlap either input.  Scratch comes from 'alloc', and is freed in the
+// reverse order it was allocated, so a digit_arena reuses it as it goes.
+template <int RADIX, typename Alloc>
+void big_multiply_limbs(std::uint64_t* out, const std::uint64_t* a,
+                        std::size_t na, const std::uint64_t* b,
+                        std::size_t nb, const big_multiply_options& options,
+                        const Alloc& alloc) {
+  constexpr auto kBase = big_digits<RADIX>::kBase;
+  using limbs = base_limbs<kBase>;
+
+  if (na < nb) {
+    std::swap(a, b);
+    std::swap(na, nb);
+  }
+  // Karatsuba's middle product, at (na + 1) / 2 + 1 limbs, only shrinks
+  // from 4 limbs up.
+  if (nb < std::max<std::size_t>(options.karatsuba_limbs, 4)) {
+    limbs::schoolbook(out, a, na, b, nb);
+    return;
+  }
+  if (nb >= options.ntt_limbs &&
+      na + nb <= big_ntt<RADIX>::max_product_limbs()) {
+    big_ntt<RADIX>::multiply(out, a, na, b, nb, options.threads, alloc);
+    return;
+  }
+
+  // A much longer 'a' goes in pieces as long as 'b', each of which is
+  // balanced enough for Karatsuba.
+  if (na >= 2 * nb) {
+    auto product = std::vector<std::uint64_t, Alloc>(2 * nb, alloc);
+    std::fill(out, out + na + nb, 0);
+    for (auto i = std::size_t{0}; i < na; i += nb) {
+      const auto n = std::min(nb, na - i);
+      big_multiply_limbs<RADIX>(product.data(), a + i, n, b, nb, options,
+                                alloc);
+      limbs::add(out + i, na + nb - i, product.data(), n + nb);
+    }
+    return;
+  }
+
+  if (nb >= options.toom3_limbs && nb > 2 * ((na + 2) / 3)) {
+    big_toom3<RADIX>(out, a, na, b, nb, options, alloc);
+  } else {
+    big_karatsuba<RADIX>(out, a, na, b, nb, options, alloc);
+  }
+}
+
+// Karatsuba:  with a = a1 * B^h + a0, and b likewise, the middle term
+// a1 * b0 + a0 * b1 is (a0 + a1) * (b0 + b1) - a0 * b0 - a1 * b1.  The outer
+// products go straight into 'out'.  Needs na >= nb > na / 2, so nb >= h.
+template <int RADIX, typename Alloc>
+void big_karatsuba(std::uint64_t* out, const std::uint64_t* a,
+                   std::size_t na, const std::uint64_t* b, std::size_t nb,
+                   const big_multiply_options& options, const Alloc& alloc) {
+  using limbs = base_limbs<big_digits<RADIX>::kBase>;
+
+  const auto h = (na + 1) / 2;
+  big_multiply_limbs<RADIX>(out, a, h, b, h, options, alloc);
+  big_multiply_limbs<RADIX>(out + 2 * h, a + h, na - h, b + h, nb - h,
+                            options, alloc);
+
+  auto scratch = std::vector<std::uint64_t, Alloc>(4 * h + 4, alloc);
+  const auto sa = scratch.data(), sb = sa + h + 1, middle = sb + h + 1;
+  std::copy(a, a + h, sa);
+  std::copy(b, b + h, sb);
+  limbs::add(sa, h + 1, a + h, na - h);
+  limbs::add(sb, h + 1, b + h, nb - h);
+  big_multiply_limbs<RADIX>(middle, sa, h + 1, sb, h + 1, options, alloc);
+  limbs::subtract(middle, 2 * h + 2, out, 2 * h);
+  limbs::subtract(middle, 2 * h + 2, out + 2 * h, na + nb - 2 * h);
+  limbs::add(out + h, na + nb - h, middle,
+             std::min(2 * h + 2, na + nb - h));
+}
+
+// Sets e = x0 + x * (x1 + x * x2), where x0 and x1 have k limbs, x2 has n2,
+// and e has k + 1.
+template <typename Limbs>
+void big_evaluate(std::uint64_t* e, const std::uint64_t* x0,
+                  const std::uint64_t* x1, const std::uint64_t* x2,
+                  std::size_t k, std::size_t n2, std::uint64_t x) {
+  std::fill(std::copy(x2, x2 + n2, e), e + k + 1, 0);
+  Limbs::multiply_small(e, k + 1, x);
+  Limbs::add(e, k + 1, x1, k);
+  Limbs::multiply_small(e, k + 1, x);
+  Limbs::add(e, k + 1, x0, k);
+}
+
+// Toom-3 splits each operand in three, a = a2 * B^2k + a1 * B^k + a0, and
+// multiplies their values at 0, 1, 2, 3 and infinity, five products of a
+// third the size.  The usual choice of points includes -1; 3 instead keeps
+// every value and every step of the interpolation non-negative, so it all
+// stays in unsigned limbs, at the price of exact divisions by 2 and 3.
+// Needs na >= nb > 2k.
+template <int RADIX, typename Alloc>
+void big_toom3(std::uint64_t* out, const std::uint64_t* a, std::size_t na,
+               const std::uint64_t* b, std::size_t nb,
+               const big_multiply_options& options, const Alloc& alloc) {
+  using limbs = base_limbs<big_digits<RADIX>::kBase>;
+
+  const auto k = (na + 2) / 3;
+  const auto n = 2 * k + 2;                 // The length of each product.
+  const auto ninf = na + nb - 4 * k;        // The length of a2 * b2.
+
+  // v(0) and v(infinity) go straight to where they belong in 'out'.
+  big_multiply_limbs<RADIX>(out, a, k, b, k, options, alloc);
+  big_multiply_limbs<RADIX>(out + 4 * k, a + 2 * k, na - 2 * k, b + 2 * k,
+                            nb - 2 * k, options, alloc);
+  std::fill(out + 2 * k, out + 4 * k, 0);
+  const auto v0 = out, vinf = out + 4 * k;
+
+  auto scratch = std::vector<std::uint64_t, Alloc>(
+      3 * n + 2 * (k + 1) + n, alloc);
+  const auto w1 = scratch.data(), w2 = w1 + n, w3 = w2 + n;
+  const auto ea = w3 + n, eb = ea + k + 1, temp = eb + k + 1;
+
+  // w(x) = v(x) - v(0) - x^4 * v(infinity) = r1 * x + r2 * x^2 + r3 * x^3.
+  std::uint64_t* const w[] = {w1, w2, w3};
+  for (auto x = std::uint64_t{1}; x != 4; ++x) {
+    big_evaluate<limbs>(ea, a, a + k, a + 2 * k, k, na - 2 * k, x);
+    big_evaluate<limbs>(eb, b, b + k, b + 2 * k, k, nb - 2 * k, x);
+    big_multiply_limbs<RADIX>(w[x - 1], ea, k + 1, eb, k + 1, options,
+                              alloc);
+    limbs::subtract(w[x - 1], n, v0, 2 * k);
+    std::fill(std::copy(vinf, vinf + ninf, temp), temp + ninf + 1, 0);
+    limbs::multiply_small(temp, ninf + 1, x * x * x * x);
+    limbs::subtract(w[x - 1], n, temp, ninf + 1);
+  }
+
+  // w2 / 2 - w1 = r2 + 3 * r3, and ((w3 / 3 - w1) / 2) - that = r3.
+  limbs::divide_exact(w2, n, 2);
+  limbs::subtract(w2, n, w1, n);
+  limbs::divide_exact(w3, n, 3);
+  limbs::subtract(w3, n, w1, n);
+  limbs::divide_exact(w3, n, 2);
+  limbs::subtract(w3, n, w2, n);
+
+  // Then r2 = w2 - 3 * r3, and r1 = w1 - r2 - r3.
+  std::copy(w3, w3 + n, temp);
+  limbs::multiply_small(temp, n, 3);
+  limbs::subtract(w2, n, temp, n);
+  limbs::subtract(w1, n, w2, n);
+  limbs::subtract(w1, n, w3, n);
+
+  // Each r_i * B^(i * k) is part of the product, so its limbs past the end
+  // of 'out' are zero.
+  for (auto i = std::size_t{1}; i != 4; ++i) {
+    const auto room = na + nb - i * k;
+    limbs::add(out + i * k, room, w[i - 1], std::min(n, room));
+  }
+}
+
+}  // namespace detail
+
+// Returns a * b.  The product is a big_digits like its operands, so its
+// digits are as directly addressable as theirs.  The product, and all the
+// scratch along the way, come from a's allocator.
+template <int RADIX, typename Allocator>
+big_digits<RADIX, Allocator> big_multiply(
+    const big_digits<RADIX, Allocator>& a,
+    const big_digits<RADIX, Allocator>& b,
+    const big_multiply_options& options = {}) {
+  const auto& x = a.limbs();
+  const auto& y = b.limbs();
+  const auto alloc = a.get_allocator();
+  auto product = typename big_digits<RADIX, Allocator>::limbs_type(
+      x.size() + y.size(), alloc);
+  detail::big_multiply_limbs<RADIX>(product.data(), x.data(), x.size(),
+                                    y.data(), y.size(), options, alloc);
+  return big_digits<RADIX, Allocator>{std::move(product)};
+}
+
+}  // namespace jz
+#endif // BIG_MULTIPLY_HH_
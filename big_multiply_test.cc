@@ -0,0 +1,170 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "big_multiply.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using jz::big_digits;
+using jz::big_multiply;
+using jz::big_multiply_options;
+
+// A slow reference:  long multiplication on text, one digit at a time,
+// sharing nothing with the limbs.
+template <int RADIX>
+std::string slow_multiply(const std::string& a, const std::string& b) {
+  auto product = std::vector<int>(a.size() + b.size());
+  for (std::size_t i = a.size(); i-- != 0; ) {
+    for (std::size_t j = b.size(); j-- != 0; ) {
+      product[i + j + 1] += jz::detail::char_digit<RADIX>(a[i]) *
+                            jz::detail::char_digit<RADIX>(b[j]);
+    }
+  }
+  for (std::size_t k = product.size(); k-- > 1; ) {
+    product[k - 1] += product[k] / RADIX;
+    product[k] %= RADIX;
+  }
+  auto text = std::string{};
+  for (const auto digit : product) {
+    if (!text.empty() || digit != 0) {
+      text += jz::detail::digit_char(digit);
+    }
+  }
+  return text.empty() ? "0" : text;
+}
+
+template <int RADIX>
+std::string random_digits(std::mt19937_64& rng, std::size_t n) {
+  auto text = std::string{};
+  for (std::size_t i = 0; i != n; ++i) {
+    text += jz::detail::digit_char(static_cast<int>(rng() % RADIX));
+  }
+  return text;
+}
+
+// Options that force each algorithm as far down as it will go.
+big_multiply_options schoolbook() {
+  auto options = big_multiply_options{};
+  options.karatsuba_limbs = options.toom3_limbs = options.ntt_limbs = ~0u;
+  return options;
+}
+
+big_multiply_options karatsuba() {
+  auto options = schoolbook();
+  options.karatsuba_limbs = 1;
+  return options;
+}
+
+big_multiply_options toom3() {
+  auto options = karatsuba();
+  options.toom3_limbs = 1;
+  return options;
+}
+
+big_multiply_options ntt(unsigned threads) {
+  auto options = schoolbook();
+  options.ntt_limbs = 1;
+  options.threads = threads;
+  return options;
+}
+
+template <int RADIX>
+bool MatchesReference(std::mt19937_64& rng, std::size_t da, std::size_t db) {
+  const auto ta = random_digits<RADIX>(rng, da);
+  const auto tb = random_digits<RADIX>(rng, db);
+  const auto expected = slow_multiply<RADIX>(ta, tb);
+  const big_digits<RADIX> a{ta}, b{tb};
+  for (const auto& options : {schoolbook(), karatsuba(), toom3(), ntt(1),
+                              ntt(3), big_multiply_options{}}) {
+    if (big_multiply(a, b, options).str() != expected) { return false; }
+  }
+  return true;
+}
+
+// Tests small products, where the carries and the zeros are.
+bool TestSmallProducts() {
+  const auto nines = big_digits<>{std::string(40, '9')};
+  return big_multiply(big_digits<>{}, nines).str() == "0" &&
+         big_multiply(big_digits<>{1}, nines) == nines &&
+         big_multiply(nines, nines).str() ==
+             std::string(39, '9') + '8' + std::string(39, '0') + '1' &&
+         big_multiply(big_digits<>{4294967296}, big_digits<>{4294967296})
+             .str() == "18446744073709551616";
+}
+
+// Tests every algorithm against the reference, for operands of about the
+// same length.
+bool TestBalancedOperands() {
+  auto rng = std::mt19937_64{94};
+  for (std::size_t n = 1; n < 1500; n += n / 3 + 1) {
+    if (!MatchesReference<10>(rng, n, n) ||
+        !MatchesReference<10>(rng, n, n - n / 4)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tests operands of very different lengths, which multiply in pieces.
+bool TestUnbalancedOperands() {
+  auto rng = std::mt19937_64{940};
+  for (const std::size_t n : {1, 17, 40, 200}) {
+    if (!MatchesReference<10>(rng, 2000, n) ||
+        !MatchesReference<10>(rng, n, 1100)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tests other radices, whose limbs split differently for the NTT.
+bool TestOtherRadices() {
+  auto rng = std::mt19937_64{9400};
+  for (const std::size_t n : {5, 100, 700}) {
+    if (!MatchesReference<2>(rng, n, n + 9) ||
+        !MatchesReference<3>(rng, n, n) ||
+        !MatchesReference<16>(rng, n + 9, n) ||
+        !MatchesReference<36>(rng, n, n / 2 + 1)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tests that a product's digits are as addressable as any big_digits':
+// (10^k - 1)^2 = 9...980...01.
+bool TestProductDigits() {
+  const auto nines = big_digits<>{std::string(5000, '9')};
+  auto square = big_multiply(nines, nines);
+  if (square.size() != 10000 || square[4998] != 9 || square[4999] != 8 ||
+      square[5000] != 0 || square[9999] != 1) {
+    return false;
+  }
+  square[0] = 1;
+  square[9999] = 0;
+  return square[0] == 1 && square.limbs()[0] == 0 &&
+         std::count(square.cbegin(), square.cend(), 9) == 4998;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestSmallProducts),
+  TEST_CASE(TestBalancedOperands),
+  TEST_CASE(TestUnbalancedOperands),
+  TEST_CASE(TestOtherRadices),
+  TEST_CASE(TestProductDigits),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
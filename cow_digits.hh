@@ -0,0 +1,521 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef COW_DIGITS_HH_
+#define COW_DIGITS_HH_
+
+#include "big_digits.hh"
+#include "digit_adaptor.hh"
+#include "digit_batch.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jz {
+namespace detail {
+
+// Owns a heap block with an intrusive, atomic reference count:  T has a
+// std::atomic<std::size_t> 'refs' that starts at 1.  Copies share the
+// block.  Unlike std::shared_ptr's use_count(), unique() is an acquire
+// load, so once it's true, writes to the block can't race with another
+// owner's reads from before it let go.
+template <typename T>
+class cow_ptr {
+ public:
+  cow_ptr() noexcept = default;
+
+  explicit cow_ptr(T* block) noexcept : block_{block} {}
+
+  cow_ptr(const cow_ptr& rhs) noexcept : block_{rhs.block_} {
+    if (block_ != nullptr) {
+      block_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  cow_ptr(cow_ptr&& rhs) noexcept : block_{rhs.block_} {
+    rhs.block_ = nullptr;
+  }
+
+  cow_ptr& operator=(cow_ptr rhs) noexcept {
+    std::swap(block_, rhs.block_);
+    return *this;
+  }
+
+  ~cow_ptr() {
+    if (block_ != nullptr &&
+        block_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      delete block_;
+    }
+  }
+
+  const T* get() const noexcept { return block_; }
+
+  // Returns the block for writing, which only the sole owner may do.
+  T* get_unique() const noexcept { return block_; }
+
+  bool unique() const noexcept {
+    return block_->refs.load(std::memory_order_acquire) == 1;
+  }
+
+ private:
+  T* block_ = nullptr;
+};
+
+}  // namespace detail
+
+// Holds a large number as big_digits does, in limbs of kLimbDigits digits,
+// but in fixed-size pages of kPageLimbs limbs that versions share.
+// Copying a cow_digits, or calling snapshot(), is O(1):  it shares the
+// page table.  A write through operator[], an iterator, or a reference
+// proxy copies only the page it touches, and the table of page pointers,
+// if another version still shares them.  Every other version keeps the
+// digits it had.
+//
+// One version is one object, which isn't safe to use from two threads at
+// once.  Different versions are:  a writer can hand snapshots to readers
+// on other threads and keep writing, and each reader sees a consistent
+// number for as long as it holds its snapshot.
+template <int RADIX = 10>
+class cow_digits {
+ public:
+  static constexpr std::size_t kLimbDigits = big_digits<RADIX>::kLimbDigits;
+  static constexpr std::uint64_t kBase = big_digits<RADIX>::kBase;
+
+  // 4 KiB of limbs.
+  static constexpr std::size_t kPageLimbs = 512;
+  static constexpr std::size_t kPageDigits = kPageLimbs * kLimbDigits;
+
+  // Zero, with one digit.
+  cow_digits() : cow_digits(big_digits<RADIX>{}) {}
+
+  // Copies the digits of 'number', leading zeros and all.
+  template <typename Allocator>
+  explicit cow_digits(const big_digits<RADIX, Allocator>& number)
+  : digits_{number.size()} {
+    const auto& limbs = number.limbs();
+    const auto count = (digits_ + kLimbDigits - 1) / kLimbDigits;
+    const auto table = new table_{};
+    table_ptr_ = detail::cow_ptr<table_>{table};
+    table->pages.reserve((count + kPageLimbs - 1) / kPageLimbs);
+    for (auto i = std::size_t{0}; i < count; i += kPageLimbs) {
+      const auto page = new page_{};      // Zeros past the last limb.
+      const auto last = std::min(count, limbs.size());
+      if (i < last) {
+        std::copy(limbs.begin() + i,
+                  limbs.begin() + std::min(i + kPageLimbs, last),
+                  page->limbs);
+      }
+      table->pages.emplace_back(page);
+    }
+  }
+
+  // Reads digits, most significant first, as big_digits does.
+  explicit cow_digits(const std::string& text)
+  : cow_digits(big_digits<RADIX>{text}) {}
+
+  // Returns a version that keeps the digits this one has now, in O(1).
+  // It's the same as a copy.
+  cow_digits snapshot() const noexcept { return *this; }
+
+ private:
+  struct page_ {
+    std::atomic<std::size_t> refs{1};
+    std::uint64_t            limbs[kPageLimbs];
+  };
+
+  struct table_ {
+    std::atomic<std::size_t>             refs{1};
+    std::vector<detail::cow_ptr<page_>> pages;
+  };
+
+  detail::cow_ptr<table_> table_ptr_;
+  std::size_t             digits_;
+
+  using limb_adaptor_       = digit_adaptor<std::uint64_t, RADIX>;
+  using const_limb_adaptor_ = digit_adaptor<const std::uint64_t, RADIX>;
+
+  // Returns the limb holding the digit at 'index', and the divisor that
+  // picks the digit out of it.
+  const std::uint64_t* limb_at(std::size_t index,
+                               std::uint64_t& divisor) const noexcept {
+    const auto p = digits_ - 1 - index;
+    const auto limb = p / kLimbDigits;
+    divisor = detail::radix_power<std::uint64_t, RADIX>(p % kLimbDigits);
+    return table_ptr_.get()->pages[limb / kPageLimbs].get()->limbs +
+           limb % kPageLimbs;
+  }
+
+  // The same, after making this version the sole owner of the page, and
+  // of the table that points to it.
+  std::uint64_t* mutable_limb_at(std::size_t index, std::uint64_t& divisor) {
+    const auto p = digits_ - 1 - index;
+    const auto limb = p / kLimbDigits;
+    divisor = detail::radix_power<std::uint64_t, RADIX>(p % kLimbDigits);
+
+    if (!table_ptr_.unique()) {
+      const auto table = new table_{};
+      table->pages = table_ptr_.get()->pages;
+      table_ptr_ = detail::cow_ptr<table_>{table};
+    }
+    auto& page = table_ptr_.get_unique()->pages[limb / kPageLimbs];
+    if (!page.unique()) {
+      const auto copy = new page_;
+      std::copy_n(page.get()->limbs, kPageLimbs, copy->limbs);
+      page = detail::cow_ptr<page_>{copy};
+    }
+    return page.get_unique()->limbs + limb % kPageLimbs;
+  }
+
+  std::uint64_t read(std::size_t index) const noexcept {
+    auto divisor = std::uint64_t{0};
+    const auto limb = limb_at(index, divisor);
+    return typename const_limb_adaptor_::reference{limb, divisor};
+  }
+
+  void write(std::size_t index, std::uint64_t digit) {
+    auto divisor = std::uint64_t{0};
+    const auto limb = mutable_limb_at(index, divisor);
+    typename limb_adaptor_::reference{limb, divisor} = digit;
+  }
+
+  // Forward declarations.
+  class const_reference_;
+
+  // Provides indirect access to one digit.  This mirrors digit_adaptor's
+  // reference, but holds the version and the digit's index rather than a
+  // pointer into a page, so every write goes through copy-on-write, even
+  // from a proxy made before the last snapshot.
+  class mutable_reference_ {
+   public:
+    using is_digit_adaptor_mutable_reference = std::true_type;
+
+    constexpr mutable_reference_(cow_digits* owner,
+                                 std::size_t index) noexcept
+    : owner_{owner}, index_{index} {}
+
+    constexpr mutable_reference_(const mutable_reference_&) = default;
+
+    operator std::uint64_t () const noexcept {
+      return owner_->read(index_);
+    }
+
+    const auto& operator=(std::uint64_t digit) const {
+      owner_->write(index_, digit);
+      return *this;
+    }
+
+    // Behaves like an lvalue reference, copying the referent's value to
+    // our value, rather than copying the proxy.
+    const auto& operator=(const_reference_ rhs) const {
+      return this->operator=(std::uint64_t{rhs});
+    }
+    const auto& operator=(mutable_reference_ rhs) const {
+      return this->operator=(std::uint64_t{rhs});
+    }
+
+    ~mutable_reference_() noexcept = default;
+
+    bool operator<(const_reference_ rhs) const noexcept {
+      return std::uint64_t{*this} < std::uint64_t{rhs};
+    }
+
+    bool operator==(const_reference_ rhs) const noexcept {
+      return std::uint64_t{*this} == std::uint64_t{rhs};
+    }
+
+    const auto& operator++() const {
+      return this->operator=(std::uint64_t{*this} + 1);
+    }
+
+    const auto& operator--() const {
+      return this->operator=(std::uint64_t{*this} + RADIX - 1);
+    }
+
+    std::uint64_t operator++(int) const {
+      const auto temp = std::uint64_t{*this};
+      this->operator++();
+      return temp;
+    }
+
+    std::uint64_t operator--(int) const {
+      const auto temp = std::uint64_t{*this};
+      this->operator--();
+      return temp;
+    }
+
+    // Swaps the underlying digits, not the reference proxies.
+    void swap(const mutable_reference_& rhs) const {
+      const auto d1 = std::uint64_t{*this};
+      const auto d2 = std::uint64_t{rhs};
+      this->operator=(d2);
+      rhs.operator=(d1);
+    }
+
+    constexpr operator const_reference_() const noexcept {
+      return const_reference_{owner_, index_};
+    }
+
+   private:
+    cow_digits* const owner_;
+    const std::size_t index_;
+  };
+
+  // Provides read-only indirect access to one digit.
+  class const_reference_ {
+   public:
+    constexpr const_reference_(const cow_digits* owner,
+                               std::size_t index) noexcept
+    : owner_{owner}, index_{index} {}
+
+    constexpr const_reference_(const const_reference_&) noexcept = default;
+
+    operator std::uint64_t () const noexcept {
+      return owner_->read(index_);
+    }
+
+    ~const_reference_() noexcept = default;
+
+    bool operator<(const_reference_ rhs) const noexcept {
+      return std::uint64_t{*this} < std::uint64_t{rhs};
+    }
+
+    bool operator==(const_reference_ rhs) const noexcept {
+      return std::uint64_t{*this} == std::uint64_t{rhs};
+    }
+
+   private:
+    const cow_digits* const owner_;
+    const std::size_t index_;
+  };
+
+  // Walks digit positions, most significant first.  QC is the "qualified
+  // container."
+  template <typename QC>
+  class iterator_ {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = std::uint64_t;
+    using pointer           = void;
+    using reference         = std::conditional_t<std::is_const<QC>::value,
+                                  const_reference_, mutable_reference_>;
+
+    constexpr iterator_() noexcept : owner_{nullptr}, index_{0} {}
+
+    constexpr iterator_(const iterator_&)            = default;
+    constexpr iterator_& operator=(const iterator_&) = default;
+
+    constexpr auto& operator++() noexcept { ++index_; return *this; }
+    constexpr auto& operator--() noexcept { --index_; return *this; }
+
+    constexpr auto operator++(int) noexcept {
+      auto temp = iterator_{*this};
+      ++index_;
+      return temp;
+    }
+
+    constexpr auto operator--(int) noexcept {
+      auto temp = iterator_{*this};
+      --index_;
+      return temp;
+    }
+
+    constexpr auto operator+(difference_type rhs) const noexcept {
+      return iterator_{*this} += rhs;
+    }
+
+    constexpr auto operator-(difference_type rhs) const noexcept {
+      return iterator_{*this} -= rhs;
+    }
+
+    friend constexpr auto operator+(difference_type lhs,
+                                    const iterator_& rhs) noexcept {
+      return rhs + lhs;
+    }
+
+    constexpr difference_type operator-(const iterator_& rhs) const noexcept {
+      return index_ - rhs.index_;
+    }
+
+    constexpr auto& operator+=(difference_type rhs) noexcept {
+      index_ += rhs;
+      return *this;
+    }
+
+    constexpr auto& operator-=(difference_type rhs) noexcept {
+      index_ -= rhs;
+      return *this;
+    }
+
+    constexpr bool operator==(const iterator_& rhs) const noexcept {
+      return index_ == rhs.index_;
+    }
+
+    constexpr bool operator!=(const iterator_& rhs) const noexcept {
+      return index_ != rhs.index_;
+    }
+
+    constexpr bool operator<(const iterator_& rhs) const noexcept {
+      return index_ < rhs.index_;
+    }
+
+    constexpr bool operator>=(const iterator_& rhs) const noexcept {
+      return index_ >= rhs.index_;
+    }
+
+    constexpr bool operator>(const iterator_& rhs) const noexcept {
+      return index_ > rhs.index_;
+    }
+
+    constexpr bool operator<=(const iterator_& rhs) const noexcept {
+      return index_ <= rhs.index_;
+    }
+
+    constexpr reference operator*() const noexcept {
+      return reference{owner_, static_cast<std::size_t>(index_)};
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+      return *(*this + index);
+    }
+
+   private:
+    QC* owner_;
+    difference_type index_;
+
+    constexpr iterator_(QC* owner, difference_type index) noexcept
+    : owner_{owner}, index_{index} {}
+
+    friend class cow_digits;
+  };
+
+  template <typename QC>
+  static auto make_iterator(QC* owner, std::size_t index) noexcept {
+    return iterator_<QC>{owner, static_cast<std::ptrdiff_t>(index)};
+  }
+
+ public:
+  using value_type      = std::uint64_t;
+  using size_type       = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using reference       = mutable_reference_;
+  using const_reference = const_reference_;
+  using iterator        = iterator_<cow_digits>;
+  using const_iterator  = iterator_<const cow_digits>;
+
+  // Forward iterators.
+  auto begin() noexcept { return make_iterator(this, 0); }
+  auto end() noexcept { return make_iterator(this, digits_); }
+  auto begin() const noexcept { return cbegin(); }
+  auto end() const noexcept { return cend(); }
+  auto cbegin() const noexcept { return make_iterator(this, 0); }
+  auto cend() const noexcept { return make_iterator(this, digits_); }
+
+  // Reverse iterators.
+  auto rbegin() noexcept { return std::make_reverse_iterator(end()); }
+  auto rend() noexcept { return std::make_reverse_iterator(begin()); }
+  auto rbegin() const noexcept { return crbegin(); }
+  auto rend() const noexcept { return crend(); }
+  auto crbegin() const noexcept { return std::make_reverse_iterator(cend()); }
+  auto crend() const noexcept { return std::make_reverse_iterator(cbegin()); }
+
+  reference operator[](std::size_t index) noexcept {
+    return reference{this, index};
+  }
+  const_reference operator[](std::size_t index) const noexcept {
+    return const_reference{this, index};
+  }
+
+  // Returns the number of digits in the container.
+  std::size_t size() const noexcept {
+    return digits_;
+  }
+
+  // Returns the number of pages, and how many of them this version shares
+  // with another.
+  std::size_t pages() const noexcept {
+    return table_ptr_.get()->pages.size();
+  }
+
+  std::size_t shared_pages() const noexcept {
+    const auto& table = table_ptr_.get()->pages;
+    return std::size_t(std::count_if(table.begin(), table.end(),
+        [&](const detail::cow_ptr<page_>& page) {
+          return !table_ptr_.unique() || !page.unique();
+        }));
+  }
+
+  // Writes size() digits, most significant first, one per byte.
+  void decode(std::uint8_t* out) const noexcept {
+    auto p = out + digits_;
+    for (const auto& page : table_ptr_.get()->pages) {
+      for (auto limb : page.get()->limbs) {
+        const auto first = p - std::min<std::size_t>(p - out, kLimbDigits);
+        while (p != first) {
+          *--p = static_cast<std::uint8_t>(limb % RADIX);
+          limb /= RADIX;
+        }
+        if (p == out) {
+          return;
+        }
+      }
+    }
+  }
+
+  // Returns the digits as text, in lowercase past 9.
+  std::string str() const {
+    auto text = std::string(digits_, '0');
+    decode(reinterpret_cast<std::uint8_t*>(&text[0]));
+    for (auto& c : text) {
+      c = detail::digit_char(c);
+    }
+    return text;
+  }
+
+  // Returns the number as a big_digits, without any leading zeros.
+  big_digits<RADIX> to_big_digits() const {
+    auto limbs = std::vector<std::uint64_t>{};
+    limbs.reserve(pages() * kPageLimbs);
+    for (const auto& page : table_ptr_.get()->pages) {
+      limbs.insert(limbs.end(), page.get()->limbs,
+                   page.get()->limbs + kPageLimbs);
+    }
+    return big_digits<RADIX>{std::move(limbs)};
+  }
+
+  // Compares as standard containers do.  Versions that still share a page
+  // compare it in O(1).
+  bool operator==(const cow_digits& rhs) const noexcept {
+    if (digits_ != rhs.digits_) {
+      return false;
+    }
+    const auto& a = table_ptr_.get()->pages;
+    const auto& b = rhs.table_ptr_.get()->pages;
+    for (auto i = std::size_t{0}; i != a.size(); ++i) {
+      if (a[i].get() != b[i].get() &&
+          !std::equal(a[i].get()->limbs, a[i].get()->limbs + kPageLimbs,
+                      b[i].get()->limbs)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool operator!=(const cow_digits& rhs) const noexcept {
+    return !this->operator==(rhs);
+  }
+};
+
+template <int RADIX> constexpr std::size_t cow_digits<RADIX>::kLimbDigits;
+template <int RADIX> constexpr std::uint64_t cow_digits<RADIX>::kBase;
+template <int RADIX> constexpr std::size_t cow_digits<RADIX>::kPageLimbs;
+template <int RADIX> constexpr std::size_t cow_digits<RADIX>::kPageDigits;
+
+}  // namespace jz
+#endif // COW_DIGITS_HH_
@@ -0,0 +1,146 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "cow_digits.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using jz::cow_digits;
+
+std::string random_digits(std::mt19937_64& rng, std::size_t n) {
+  auto text = std::string(n, '0');
+  for (auto& c : text) {
+    c = char('0' + rng() % 10);
+  }
+  return text;
+}
+
+// Tests reading, writing and the standard algorithms, as on big_digits.
+bool TestContainer() {
+  cow_digits<> d{std::string{"0031415926535897932384626433832795"}};
+  if (d.size() != 34 || d[0] != 0 || d[2] != 3 || d[33] != 5) {
+    return false;
+  }
+  d[0] = 9;
+  ++d[1];
+  d[33]--;
+  if (d.str() != "9131415926535897932384626433832794") { return false; }
+
+  std::sort(d.begin() + 2, d.end());
+  auto reversed = std::string{};
+  std::for_each(d.crbegin(), d.crbegin() + 4,
+                [&](std::uint64_t digit) { reversed += char('0' + digit); });
+  return d.str() == "9111222233333334444555666778889999" &&
+         reversed == "9999" && std::count(d.cbegin(), d.cend(), 3) == 7 &&
+         cow_digits<>{}.str() == "0" &&
+         d.to_big_digits().str() == "9111222233333334444555666778889999";
+}
+
+// Tests that a snapshot keeps its digits while the original changes, and
+// that the original sees its own writes.
+bool TestSnapshotKeepsDigits() {
+  auto rng = std::mt19937_64{96};
+  const auto text = random_digits(rng, 100000);
+  cow_digits<> d{text};
+  const auto snap = d.snapshot();
+  auto proxy = d[500];                  // Made before the writes below.
+
+  for (std::size_t i = 0; i < d.size(); i += 997) {
+    d[i] = (text[i] - '0' + 1) % 10;
+  }
+  proxy = 7;
+  if (snap.str() != text || snap == d) { return false; }
+
+  auto expected = text;
+  for (std::size_t i = 0; i < expected.size(); i += 997) {
+    expected[i] = char('0' + (expected[i] - '0' + 1) % 10);
+  }
+  expected[500] = '7';
+  return d.str() == expected && d[500] == 7 &&
+         snap[500] == std::uint64_t(text[500] - '0');
+}
+
+// Tests that a write copies only the page it touches.
+bool TestWritesCopyOnePage() {
+  auto rng = std::mt19937_64{960};
+  cow_digits<> d{random_digits(rng, 10 * cow_digits<>::kPageDigits)};
+  if (d.pages() != 10 || d.shared_pages() != 0) { return false; }
+
+  const auto snap = d.snapshot();
+  if (d.shared_pages() != 10 || !(snap == d)) { return false; }
+
+  d[0] = d[0] + 1;                      // The most significant page.
+  if (d.shared_pages() != 9 || snap.shared_pages() != 9) { return false; }
+  d[1] = 0;                             // The same page again.
+  d[d.size() - 1] = 0;                  // The least significant page.
+  return d.shared_pages() == 8 && snap.shared_pages() == 8 &&
+         snap != d;
+}
+
+// Tests that versions free their pages as they go, and that a version
+// that's the last owner writes in place.
+bool TestVersionsLetGo() {
+  auto rng = std::mt19937_64{9600};
+  cow_digits<> d{random_digits(rng, 3 * cow_digits<>::kPageDigits)};
+  {
+    auto snaps = std::vector<cow_digits<>>(5, d.snapshot());
+    d[0] = 1;
+    if (d.shared_pages() != 2) { return false; }
+  }
+  d[d.size() - 1] = 1;
+  auto copy = d;
+  copy = cow_digits<>{std::string{"42"}};
+  return d.shared_pages() == 0 && copy.str() == "42";
+}
+
+// Tests one writer handing snapshots to readers on other threads, which
+// each check that their version never changes while the writer keeps
+// writing.
+bool TestConcurrentReaders() {
+  auto rng = std::mt19937_64{96000};
+  cow_digits<> d{random_digits(rng, 200000)};
+  std::atomic<int> failures{0};
+  auto readers = std::vector<std::thread>{};
+
+  for (int round = 0; round != 4; ++round) {
+    const auto snap = d.snapshot();
+    const auto expected = snap.str();
+    readers.emplace_back([snap, expected, &failures] {
+      for (int pass = 0; pass != 3; ++pass) {
+        failures += snap.str() != expected;
+      }
+    });
+    for (int i = 0; i != 2000; ++i) {
+      d[rng() % d.size()] = rng() % 10;
+    }
+  }
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  return failures == 0;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestContainer),
+  TEST_CASE(TestSnapshotKeepsDigits),
+  TEST_CASE(TestWritesCopyOnePage),
+  TEST_CASE(TestVersionsLetGo),
+  TEST_CASE(TestConcurrentReaders),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,261 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DECIMAL_DIGIT_ADAPTOR_HH_
+#define DECIMAL_DIGIT_ADAPTOR_HH_
+
+#include "digit_adaptor.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace jz {
+
+// Adapts a fixed-point number, held as an integer scaled by RADIX^SCALE, to
+// look like a container of digits.  This is a digit_adaptor with a radix
+// point:  the container is numbered most-significant digit first, and the
+// last SCALE digits are the fraction.
+//
+// Digits may also be addressed by place value with at_place().  Place 0 is
+// the units digit, place 1 the RADIX digit, place -1 the first digit after
+// the radix point, and so on.  Places outside the container read as zero.
+//
+// The rounding queries (rounding_digit(), is_sticky(), rounds_up()) work
+// directly on the integer with division, so there's no need to format the
+// number as a string to decide how it rounds.
+//
+// Tables is the table policy, passed on to digit_adaptor.
+template <typename T, int SCALE = 0, int RADIX = 10,
+          typename Tables = power_tables>
+class decimal_digit_adaptor : public digit_adaptor<T, RADIX, Tables> {
+  static_assert(SCALE >= 0, "SCALE must not be negative");
+
+  using base = digit_adaptor<T, RADIX, Tables>;
+
+ public:
+  using typename base::value_type;
+
+  // Sets number of digits based on the current magnitude of the number,
+  // but always provides at least one integer digit and SCALE fraction
+  // digits.
+  constexpr explicit decimal_digit_adaptor(T& number) noexcept
+  : decimal_digit_adaptor{number, -SCALE,
+        std::max(base{number}.size(), std::size_t{SCALE} + 1)} {}
+
+  // Sets an explicit number of digits, irrespective of the number's
+  // current magnitude.  The last SCALE of these are fraction digits.
+  constexpr explicit decimal_digit_adaptor(T& number, std::size_t digits)
+      noexcept
+  : decimal_digit_adaptor{number, -SCALE, digits} {}
+
+  // Returns the place value of the last digit in the container.  For a
+  // fixed-point number, this is -SCALE.
+  constexpr int exponent() const noexcept {
+    return exponent_;
+  }
+
+  // Returns the number of digits in the container to the left of the
+  // radix point.
+  constexpr std::size_t integer_digits() const noexcept {
+    const auto digits = static_cast<std::ptrdiff_t>(this->size());
+    return static_cast<std::size_t>(
+        std::max(std::min(digits + exponent_, digits), std::ptrdiff_t{0}));
+  }
+
+  // Returns the number of digits in the container to the right of the
+  // radix point.
+  constexpr std::size_t fraction_digits() const noexcept {
+    return this->size() - integer_digits();
+  }
+
+  // Returns an iterator to the first fraction digit.
+  constexpr auto fraction_begin() const noexcept {
+    return this->begin() + static_cast<int>(integer_digits());
+  }
+
+  constexpr bool is_negative() const noexcept {
+    return static_cast<T>(*this) < 0;
+  }
+
+  // Returns the digit at a given place value.  See the class comment.
+  constexpr value_type at_place(int place) const noexcept {
+    const auto lsb_index = static_cast<std::ptrdiff_t>(place) - exponent_;
+    const auto digits = static_cast<std::ptrdiff_t>(this->size());
+
+    if (lsb_index < 0 || lsb_index >= digits) {
+      return value_type{0};
+    }
+
+    return (*this)[static_cast<int>(digits - 1 - lsb_index)];
+  }
+
+  // Returns the first digit discarded when rounding to 'places' fraction
+  // digits.  A negative 'places' rounds to the left of the radix point.
+  constexpr value_type rounding_digit(int places) const noexcept {
+    return at_place(-places - 1);
+  }
+
+  // Returns true if any digit after the rounding digit is non-zero.
+  // Together with rounding_digit(), this is all any rounding mode needs.
+  constexpr bool is_sticky(int places) const noexcept {
+    const auto below = static_cast<std::ptrdiff_t>(-places - 1) - exponent_;
+    const auto magnitude = magnitude_();
+
+    if (below <= 0) {
+      return false;
+    }
+
+    if (below >= static_cast<std::ptrdiff_t>(this->size())) {
+      return magnitude != 0;
+    }
+
+    auto divisor = NCU{1};
+    for (auto i = std::ptrdiff_t{0}; i != below; ++i) {
+      divisor *= RADIX;
+    }
+
+    return magnitude % divisor != 0;
+  }
+
+  // Returns true if rounding the magnitude to 'places' fraction digits with
+  // round-half-to-even increments the last kept digit.
+  constexpr bool rounds_up(int places) const noexcept {
+    static_assert(RADIX % 2 == 0, "Round-half-even requires an even RADIX");
+
+    const auto round = rounding_digit(places);
+
+    if (round != RADIX / 2) {
+      return round > RADIX / 2;
+    }
+
+    return is_sticky(places) || at_place(-places) % 2 != 0;
+  }
+
+ protected:
+  using NCT = std::remove_cv_t<T>;
+  using NCU = std::make_unsigned_t<NCT>;
+
+  // Binds a coefficient with an arbitrary exponent.  Derived adaptors use
+  // this for formats where the exponent is only known at run time.
+  constexpr decimal_digit_adaptor(T& coefficient, int exponent,
+                                  std::size_t digits) noexcept
+  : base{coefficient, digits}, exponent_{exponent} {}
+
+ private:
+  const int exponent_;
+
+  constexpr NCU magnitude_() const noexcept {
+    const auto value = static_cast<NCT>(static_cast<T>(*this));
+    const auto u = static_cast<NCU>(value);
+    return value < 0 ? NCU(-u) : u;
+  }
+};
+
+// Classifies a decoded decimal or floating-point value.
+enum class decimal_class { finite, infinity, nan };
+
+// Holds the fields of an IEEE 754 decimal64 value in the binary integer
+// decimal (BID) encoding.  The value is (-1)^negative * coefficient *
+// 10^exponent.
+struct decimal64_fields {
+  bool          negative;
+  decimal_class kind;
+  std::uint64_t coefficient;
+  int           exponent;
+};
+
+// Extracts the sign, coefficient and exponent of a BID-encoded decimal64.
+// Non-canonical coefficients (larger than 10^16 - 1) decode as zero, as
+// IEEE 754 requires.  Infinities and NaNs decode with a zero coefficient.
+constexpr decimal64_fields unpack_bid64(std::uint64_t bits) noexcept {
+  constexpr auto kBias = 398;
+  constexpr auto kMaxCoefficient = std::uint64_t{9999999999999999};
+
+  const bool negative = (bits >> 63) != 0;
+
+  if (((bits >> 61) & 3) != 3) {
+    const auto exponent = static_cast<int>((bits >> 53) & 0x3FF) - kBias;
+    const auto coefficient = bits & ((std::uint64_t{1} << 53) - 1);
+    return {negative, decimal_class::finite,
+            coefficient > kMaxCoefficient ? 0 : coefficient, exponent};
+  }
+
+  if (((bits >> 58) & 0x1F) == 0x1E) {
+    return {negative, decimal_class::infinity, 0, 0};
+  }
+
+  if (((bits >> 58) & 0x1F) == 0x1F) {
+    return {negative, decimal_class::nan, 0, 0};
+  }
+
+  const auto exponent = static_cast<int>((bits >> 51) & 0x3FF) - kBias;
+  const auto coefficient = (bits & ((std::uint64_t{1} << 51) - 1))
+                         | (std::uint64_t{4} << 51);
+  return {negative, decimal_class::finite,
+          coefficient > kMaxCoefficient ? 0 : coefficient, exponent};
+}
+
+namespace detail {
+
+// Holds the decoded fields for decimal64_digit_adaptor, so they're
+// constructed before the digit_adaptor base that refers to them.
+struct decimal64_holder {
+  decimal64_fields fields_;
+};
+
+}  // namespace detail
+
+// Adapts a BID-encoded decimal64 to look like a read-only container of its
+// coefficient's decimal digits, with the decoded exponent as the place value
+// of the last digit.  Unlike digit_adaptor, this holds a decoded copy of the
+// value rather than a reference to it.
+//
+// The coefficient is never padded.  A value such as 0.000123 (123E-6) holds
+// three digits, all of them fraction digits; the leading fraction zeros are
+// still readable through at_place().
+//
+// decimal64_digit_adaptor, below, uses the default table policy.
+template <typename Tables>
+class basic_decimal64_digit_adaptor
+    : private detail::decimal64_holder,
+      public decimal_digit_adaptor<const std::uint64_t, 0, 10, Tables> {
+  using base = decimal_digit_adaptor<const std::uint64_t, 0, 10, Tables>;
+
+ public:
+  constexpr explicit basic_decimal64_digit_adaptor(std::uint64_t bits)
+      noexcept
+  : decimal64_holder{unpack_bid64(bits)},
+    base{fields_.coefficient, fields_.exponent,
+         digit_adaptor<const std::uint64_t>{fields_.coefficient}.size()} {}
+
+  // Copies refer to their own decoded coefficient, not the original's.
+  constexpr basic_decimal64_digit_adaptor(
+      const basic_decimal64_digit_adaptor& rhs) noexcept
+  : decimal64_holder{rhs.fields_},
+    base{fields_.coefficient, fields_.exponent, rhs.size()} {}
+
+  basic_decimal64_digit_adaptor& operator=(
+      const basic_decimal64_digit_adaptor&) = delete;
+
+  // Shadows decimal_digit_adaptor::is_negative(), as the sign lives outside
+  // the coefficient.
+  constexpr bool is_negative() const noexcept {
+    return fields_.negative;
+  }
+
+  constexpr bool is_finite() const noexcept {
+    return fields_.kind == decimal_class::finite;
+  }
+
+  constexpr bool is_infinity() const noexcept {
+    return fields_.kind == decimal_class::infinity;
+  }
+
+  constexpr bool is_nan() const noexcept {
+    return fields_.kind == decimal_class::nan;
+  }
+};
+
+using decimal64_digit_adaptor = basic_decimal64_digit_adaptor<power_tables>;
+
+}  // namespace jz
+#endif // DECIMAL_DIGIT_ADAPTOR_HH_
@@ -0,0 +1,211 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "decimal_digit_adaptor.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace {
+
+using jz::decimal_digit_adaptor;
+using jz::decimal64_digit_adaptor;
+
+// Tests reading integer and fraction digits from a fixed-point value.
+bool TestReadingFixedPointDigits() {
+  const long cents = 123456L;   // 1234.56
+  const decimal_digit_adaptor<const long, 2> d{cents};
+
+  if (d.size() != 6)            { return false; }
+  if (d.exponent() != -2)       { return false; }
+  if (d.integer_digits() != 4)  { return false; }
+  if (d.fraction_digits() != 2) { return false; }
+
+  if (d[0] != 1) { return false; }
+  if (d[5] != 6) { return false; }
+
+  if (d.at_place(3) != 1)  { return false; }
+  if (d.at_place(0) != 4)  { return false; }
+  if (d.at_place(-1) != 5) { return false; }
+  if (d.at_place(-2) != 6) { return false; }
+  if (d.at_place(-3) != 0) { return false; }
+  if (d.at_place(4) != 0)  { return false; }
+
+  auto it = d.fraction_begin();
+  if (*it++ != 5)     { return false; }
+  if (*it++ != 6)     { return false; }
+  if (it != d.end())  { return false; }
+
+  const decimal_digit_adaptor<const long, 2, 10, jz::no_tables> untabled{
+      cents};
+  if (!std::equal(d.begin(), d.end(), untabled.begin(), untabled.end())) {
+    return false;
+  }
+  if (untabled.at_place(-2) != 6) { return false; }
+
+  return true;
+}
+
+// Tests that small fixed-point values are padded to one integer digit plus
+// SCALE fraction digits.
+bool TestFixedPointPadding() {
+  const int x = 7;   // 0.007
+  const decimal_digit_adaptor<const int, 3> d{x};
+
+  if (d.size() != 4)            { return false; }
+  if (d.integer_digits() != 1)  { return false; }
+  if (d.fraction_digits() != 3) { return false; }
+  if (d[0] != 0)                { return false; }
+  if (d[3] != 7)                { return false; }
+
+  return true;
+}
+
+// Tests writing fraction digits through the container interface, including
+// on a negative value.
+bool TestWritingFixedPointDigits() {
+  long x = -12345L;   // -123.45
+  decimal_digit_adaptor<long, 2> d{x};
+
+  if (!d.is_negative()) { return false; }
+
+  *d.fraction_begin() = 9;
+  if (x != -12395L) { return false; }
+  d[0] = 0;
+  if (x != -2395L)  { return false; }
+
+  std::sort(d.fraction_begin(), d.end());
+  if (x != -2359L)  { return false; }
+
+  return true;
+}
+
+// Tests the rounding queries on a fixed-point value.
+bool TestFixedPointRounding() {
+  const long x = 1234500L;   // 12.34500
+  const decimal_digit_adaptor<const long, 5> d{x};
+
+  // Rounding to 2 places is an exact tie; 4 is even, so round down.
+  if (d.rounding_digit(2) != 5) { return false; }
+  if (d.is_sticky(2))           { return false; }
+  if (d.rounds_up(2))           { return false; }
+
+  // Rounding to 1 place:  4 follows, with 5 sticky below.
+  if (d.rounding_digit(1) != 4) { return false; }
+  if (!d.is_sticky(1))          { return false; }
+  if (d.rounds_up(1))           { return false; }
+
+  // Rounding to -1 places (tens):  2 follows, 34500 is sticky.
+  if (d.rounding_digit(-1) != 2) { return false; }
+  if (!d.is_sticky(-1))          { return false; }
+
+  // Rounding to -2 places (hundreds):  the whole number is discarded.
+  if (d.rounding_digit(-2) != 1) { return false; }
+  if (!d.is_sticky(-2))          { return false; }
+
+  // Rounding to more places than we hold is exact.
+  if (d.rounding_digit(7) != 0) { return false; }
+  if (d.is_sticky(7))           { return false; }
+
+  const long y = 1235000L;   // 12.35000
+  const decimal_digit_adaptor<const long, 5> e{y};
+
+  // A tie with an odd kept digit rounds up.
+  if (!e.rounds_up(1)) { return false; }
+
+  const long z = 1225001L;   // 12.25001
+  const decimal_digit_adaptor<const long, 5> f{z};
+
+  // A tie broken by a sticky digit rounds up even with an even kept digit.
+  if (!f.rounds_up(1)) { return false; }
+
+  return true;
+}
+
+// Tests decoding BID decimal64 values in the common encoding.
+bool TestReadingDecimal64Digits() {
+  // 12345E-3 == 12.345
+  const decimal64_digit_adaptor d{0x3160000000003039ULL};
+
+  if (!d.is_finite())           { return false; }
+  if (d.is_negative())          { return false; }
+  if (d.size() != 5)            { return false; }
+  if (d.exponent() != -3)       { return false; }
+  if (d.integer_digits() != 2)  { return false; }
+  if (d.fraction_digits() != 3) { return false; }
+  if (d[0] != 1 || d[4] != 5)   { return false; }
+  if (d.at_place(1) != 1)       { return false; }
+  if (d.at_place(-3) != 5)      { return false; }
+  if (d.rounds_up(1))           { return false; }
+  if (d.rounding_digit(2) != 5) { return false; }
+  if (d.rounds_up(2))           { return false; }
+
+  const jz::basic_decimal64_digit_adaptor<jz::no_tables> untabled{
+      0x3160000000003039ULL};
+  if (untabled.size() != 5 || untabled[4] != 5 ||
+      untabled.at_place(1) != 1) {
+    return false;
+  }
+
+  // -1E+0
+  const decimal64_digit_adaptor e{0xB1C0000000000001ULL};
+  if (!e.is_negative())         { return false; }
+  if (e.size() != 1)            { return false; }
+  if (e.at_place(0) != 1)       { return false; }
+
+  // 123E-6 == 0.000123
+  const decimal64_digit_adaptor f{0x310000000000007BULL};
+  if (f.size() != 3)            { return false; }
+  if (f.integer_digits() != 0)  { return false; }
+  if (f.fraction_digits() != 3) { return false; }
+  if (f.at_place(-3) != 0)      { return false; }
+  if (f.at_place(-4) != 1)      { return false; }
+  if (f.at_place(-6) != 3)      { return false; }
+
+  // Copies decode their own coefficient.
+  const auto g = d;
+  if (g[0] != 1 || g.exponent() != -3) { return false; }
+
+  return true;
+}
+
+// Tests decoding BID decimal64 values in the large-coefficient encoding, and
+// non-canonical and special values.
+bool TestReadingDecimal64SpecialEncodings() {
+  // 9999999999999999E+0 requires the 0b11 combination field.
+  const decimal64_digit_adaptor d{0x6C7386F26FC0FFFFULL};
+  if (d.size() != 16)           { return false; }
+  if (d.exponent() != 0)        { return false; }
+  for (const auto digit : d) {
+    if (digit != 9) { return false; }
+  }
+
+  // Coefficients of 10^16 and up are non-canonical, and read as zero.
+  const decimal64_digit_adaptor n{0x6C7386F26FC10000ULL};
+  if (n.size() != 1 || n[0] != 0) { return false; }
+
+  const decimal64_digit_adaptor inf{0x7800000000000000ULL};
+  if (!inf.is_infinity() || inf.is_finite()) { return false; }
+
+  const decimal64_digit_adaptor nan{0x7C00000000000000ULL};
+  if (!nan.is_nan() || nan.is_finite()) { return false; }
+
+  return true;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestReadingFixedPointDigits),
+  TEST_CASE(TestFixedPointPadding),
+  TEST_CASE(TestWritingFixedPointDigits),
+  TEST_CASE(TestFixedPointRounding),
+  TEST_CASE(TestReadingDecimal64Digits),
+  TEST_CASE(TestReadingDecimal64SpecialEncodings),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -7,9 +7,206 @@ static_assert(__cplusplus >= 201400L, "Requires C++14 or later.");
 
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <functional>
 #include <type_traits>
 
 namespace jz {
+namespace detail {
+
+// Returns the number of RADIX digits needed for the largest value of the
+// unsigned type U.  This is also the number of powers of RADIX that fit
+// in U.
+template <typename U, int RADIX>
+constexpr std::size_t max_radix_digits() noexcept {
+  auto u = static_cast<U>(~U{0});
+  auto d = std::size_t{0};
+
+  do {
+    d++;
+    u /= RADIX;
+  } while (u > 0);
+
+  return d;
+}
+
+// Shared tables start on a cache line of their own, so the entries used
+// most, at the front, never straddle two lines.
+constexpr std::size_t kTableAlign = 64;
+
+// Names the unsigned type of a given width, which is the only part of a
+// type that a table of its powers depends on.
+template <std::size_t BYTES> struct unsigned_of_width;
+template <> struct unsigned_of_width<1> { using type = std::uint8_t;  };
+template <> struct unsigned_of_width<2> { using type = std::uint16_t; };
+template <> struct unsigned_of_width<4> { using type = std::uint32_t; };
+template <> struct unsigned_of_width<8> { using type = std::uint64_t; };
+#if defined(__SIZEOF_INT128__)
+template <> struct unsigned_of_width<16> { using type = unsigned __int128; };
+#endif
+
+template <typename U>
+using unsigned_of_width_t = typename unsigned_of_width<sizeof(U)>::type;
+
+// Holds RADIX^i for every power of RADIX that fits in the unsigned type U,
+// smallest first.
+template <typename U, int RADIX>
+struct alignas(kTableAlign) radix_power_table {
+  static constexpr std::size_t kCount = max_radix_digits<U, RADIX>();
+
+  U powers[kCount];
+};
+
+template <typename U, int RADIX>
+constexpr radix_power_table<U, RADIX> make_radix_power_table() noexcept {
+  radix_power_table<U, RADIX> table{};
+  auto power = U{1};
+
+  for (auto i = std::size_t{0}; i != table.kCount; ++i) {
+    table.powers[i] = power;
+    power = static_cast<U>(power * RADIX);
+  }
+
+  return table;
+}
+
+// Holds the table in a class template, so it's shared by every translation
+// unit that includes this header.  Only use it through radix_powers, below.
+template <typename W, int RADIX>
+struct radix_power_storage {
+  static constexpr radix_power_table<W, RADIX> table =
+      make_radix_power_table<W, RADIX>();
+};
+
+template <typename W, int RADIX>
+constexpr radix_power_table<W, RADIX> radix_power_storage<W, RADIX>::table;
+
+// Finds the table for U by width alone, so unsigned, int and const int
+// share one copy, as do long and long long where they're the same size.
+template <typename U, int RADIX>
+struct radix_powers : radix_power_storage<unsigned_of_width_t<U>, RADIX> {};
+
+// Returns RADIX^exponent.  Exponents past the end of the table wrap around
+// modulo 2^bits, as repeated multiplication would.
+template <typename U, int RADIX>
+constexpr U radix_power(std::size_t exponent) noexcept {
+  constexpr auto kCount = radix_power_table<U, RADIX>::kCount;
+
+  if (exponent < kCount) {
+    return static_cast<U>(radix_powers<U, RADIX>::table.powers[exponent]);
+  }
+
+  auto power = static_cast<U>(radix_powers<U, RADIX>::table.powers[kCount - 1]);
+  for (auto i = kCount - 1; i != exponent; ++i) {
+    power = static_cast<U>(power * RADIX);
+  }
+
+  return power;
+}
+
+// Returns RADIX^exponent from the table, as above.
+template <typename U, int RADIX>
+constexpr U radix_power(std::size_t exponent,
+                        std::true_type /* tables */) noexcept {
+  return radix_power<U, RADIX>(exponent);
+}
+
+// Returns RADIX^exponent by repeated squaring, without touching memory.
+template <typename U, int RADIX>
+constexpr U radix_power(std::size_t exponent,
+                        std::false_type /* tables */) noexcept {
+  auto power = U{1};
+  auto square = static_cast<U>(RADIX);
+
+  for (; exponent != 0; exponent >>= 1) {
+    if (exponent & 1) {
+      power = static_cast<U>(power * square);
+    }
+    square = static_cast<U>(square * square);
+  }
+
+  return power;
+}
+
+// Names the smallest unsigned type that holds MAX.
+template <unsigned long long MAX>
+using smallest_unsigned_t = std::conditional_t<
+    MAX <= 0xFF, std::uint8_t, std::conditional_t<
+    MAX <= 0xFFFF, std::uint16_t, std::conditional_t<
+    MAX <= 0xFFFFFFFF, std::uint32_t, std::uint64_t>>>;
+
+// Holds the high and low halves of a 128-bit product.
+struct uint128_parts {
+  std::uint64_t hi;
+  std::uint64_t lo;
+};
+
+// Returns the full product of a and b.
+constexpr uint128_parts umul128(std::uint64_t a, std::uint64_t b) noexcept {
+#if defined(__SIZEOF_INT128__)
+  __extension__ using uint128 = unsigned __int128;
+  const auto p = static_cast<uint128>(a) * b;
+  return {static_cast<std::uint64_t>(p >> 64), static_cast<std::uint64_t>(p)};
+#else
+  const auto a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+  const auto b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+  const auto p00 = a_lo * b_lo, p01 = a_lo * b_hi;
+  const auto p10 = a_hi * b_lo, p11 = a_hi * b_hi;
+  const auto mid = (p00 >> 32) + (p01 & 0xFFFFFFFFu) + (p10 & 0xFFFFFFFFu);
+  return {p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32),
+          (mid << 32) | (p00 & 0xFFFFFFFFu)};
+#endif
+}
+
+}  // namespace detail
+
+// Names the smallest unsigned type that holds every RADIX digit:  a byte,
+// up to radix 256.  digit_adaptor uses it as its value_type, and the bulk
+// kernels in digit_batch.hh decode into it, so buffers of digits stay
+// compact whatever the integer type.
+template <int RADIX>
+using radix_digit_t = detail::smallest_unsigned_t<RADIX - 1>;
+
+// Selects digit_adaptor's constructor that doesn't count the digits up
+// front.
+struct uncounted_t {
+  explicit constexpr uncounted_t() = default;
+};
+
+constexpr uncounted_t uncounted{};
+
+// Table policies pick which lookup tables digit_adaptor and the bulk
+// kernels in digit_batch.hh use, trading cache footprint for instructions.
+// 'powers' says whether to look up powers of RADIX or compute them, and
+// kChunkDigits how many digits the kernels convert per lookup.
+//
+//   no_tables     Computes powers as needed and touches no tables.  The
+//                 bulk kernels divide only by RADIX, a constant, which
+//                 compiles to multiply-high.  digit_adaptor still divides
+//                 by the power it computes, a hardware divide.
+//   power_tables  Looks up powers of RADIX:  at most 3 cache lines.
+//   pair_tables   Adds tables of every 2-digit value:  RADIX^2 entries.
+//   quad_tables   Adds tables of every 4-digit value:  RADIX^4 entries,
+//                 40 KB in decimal.
+struct no_tables {
+  using powers = std::false_type;
+  static constexpr int kChunkDigits = 1;
+};
+
+struct power_tables {
+  using powers = std::true_type;
+  static constexpr int kChunkDigits = 1;
+};
+
+struct pair_tables {
+  using powers = std::true_type;
+  static constexpr int kChunkDigits = 2;
+};
+
+struct quad_tables {
+  using powers = std::true_type;
+  static constexpr int kChunkDigits = 4;
+};
 
 // Adapts an integer type (or type that behaves as one) to look like a standard
 // container holding digits in a particular radix.  The container can be const
@@ -18,7 +215,18 @@ namespace jz {
 // Digits in the container are numbered left-to-right.  That is, the most
 // significant digit is at the start of the container and the least signficant
 // is at the end.
-template <typename T, int RADIX = 10>
+//
+// Digits convert implicitly to T, but value_type is digit_type, the
+// smallest unsigned type that holds a digit.  Copying the digits of a
+// digit_adaptor<std::uint64_t> into a std::vector<value_type>, or decode(),
+// yields one byte per digit.
+//
+// Tables picks how the adaptor finds each digit's divisor.  The adaptor
+// reads one digit at a time, so pair_tables and quad_tables behave as
+// power_tables here.  Under no_tables, the divisor is computed by squaring
+// rather than looked up, but it's still a runtime value:  reading a digit
+// costs a hardware divide either way.
+template <typename T, int RADIX = 10, typename Tables = power_tables>
 class digit_adaptor {
   static_assert(RADIX > 1, "RADIX must be larger than 1");
 
@@ -28,6 +236,16 @@ class digit_adaptor {
   constexpr explicit digit_adaptor(T& number) noexcept
   : number_{number}, digits_{total_digits(number)} {}
 
+  // Skips counting the digits up front.  Reverse iterators start at the
+  // least significant digit, so rbegin(), and rbegin()[n], never need the
+  // count.  Everything that does, such as size(), begin() and end(),
+  // counts the number as it is at the time, each time.  Forward iterators
+  // count once, when they're made.  That suits reading a digit or two.
+  // Writes that change the number's length change size(), so sort or
+  // reverse through an adaptor from the constructor above.
+  constexpr explicit digit_adaptor(T& number, uncounted_t) noexcept
+  : number_{number}, digits_{kUncounted} {}
+
   // Sets an explicit number of digits, irrespective of the number's
   // current magnitude.  Setting the number of digits smaller than the
   // number's current magnitude may result in unusual operation.
@@ -39,13 +257,13 @@ class digit_adaptor {
     return iterator_<Forward, T>{*this, 0};
   }
   constexpr auto end() const noexcept {
-    return iterator_<Forward, T>{*this, digits_};
+    return iterator_<Forward, T>{*this, size()};
   }
   constexpr auto cbegin() const noexcept {
     return iterator_<Forward, const T>{*this, 0};
   }
   constexpr auto cend() const noexcept {
-    return iterator_<Forward, const T>{*this, digits_};
+    return iterator_<Forward, const T>{*this, size()};
   }
 
   // Reverse iterators.
@@ -53,13 +271,13 @@ class digit_adaptor {
     return iterator_<Reverse, T>{*this, 0};
   }
   constexpr auto rend() const noexcept {
-    return iterator_<Reverse, T>{*this, digits_};
+    return iterator_<Reverse, T>{*this, size()};
   }
   constexpr auto crbegin() const noexcept {
     return iterator_<Reverse, const T>{*this, 0};
   }
   constexpr auto crend() const noexcept {
-    return iterator_<Reverse, const T>{*this, digits_};
+    return iterator_<Reverse, const T>{*this, size()};
   }
 
   // Explicit casts to T return the number.
@@ -70,17 +288,43 @@ class digit_adaptor {
   // Provides indirect access to each digit.  Behaves as a reference or a
   // const reference depending on whether T is const.
   constexpr auto operator[] (int index) const noexcept {
-    return reference{&number_, compute_divisor(index, digits_)};
+    return reference{&number_, compute_divisor(index, size())};
   }
 
   // Returns the number of digits in the container.
   constexpr std::size_t size() const noexcept {
-    return digits_;
+    return digits_ != kUncounted ? digits_ : total_digits(number_);
+  }
+
+  // Writes every digit to 'out', most significant first.  'out' needs room
+  // for size() digits.
+  constexpr void decode(radix_digit_t<RADIX>* out) const noexcept {
+    auto u = make_positive(number_);
+    for (auto i = size(); i-- != 0; ) {
+      out[i] = static_cast<radix_digit_t<RADIX>>(u % RADIX);
+      u /= RADIX;
+    }
+  }
+
+  // Compares as standard containers do:  equal if both hold the same number
+  // of digits with the same values.  The sign isn't a digit, so 12 and -12
+  // compare equal, while 12 and 012 (with 3 explicit digits) do not.
+  constexpr bool operator==(const digit_adaptor& rhs) const noexcept {
+    return size() == rhs.size() &&
+           make_positive(number_) == make_positive(rhs.number_);
+  }
+
+  constexpr bool operator!=(const digit_adaptor& rhs) const noexcept {
+    return !this->operator==(rhs);
   }
 
  private:
   using NCT = std::remove_cv_t<T>;
   using NCU = std::make_unsigned_t<NCT>;
+  using table_powers = typename Tables::powers;
+
+  // Marks an adaptor from the uncounted_t constructor.
+  static constexpr std::size_t kUncounted = ~std::size_t{0};
 
   T& number_;
   const std::size_t digits_;
@@ -111,26 +355,29 @@ class digit_adaptor {
   enum iterator_dir { Forward, Reverse };
 
   // Returns the divisor for a specific digit position in RADIX.
-  // N.B. This could be converted to a lookup table later for speed.
   template <iterator_dir Direction = Forward>
   constexpr static NCU compute_divisor(
       std::size_t index, std::size_t digits) {
-    auto divisor = NCU{1};
-
     // Clamps index to digits >= index >= 0.
-    index = std::max(std::min(digits, index), std::size_t{0});
+    index = std::min(digits, index);
 
     if (Direction == Forward) {
-      for (auto i = index + 1; i < digits; ++i) {
-        divisor *= RADIX;
-      }
-    } else {
-      for (auto i = std::size_t{0}; i != index; ++i) {
-        divisor *= RADIX;
-      }
+      return detail::radix_power<NCU, RADIX>(
+          index < digits ? digits - 1 - index : 0, table_powers{});
     }
 
-    return divisor;
+    return detail::radix_power<NCU, RADIX>(index, table_powers{});
+  }
+
+  // Returns the furthest index an iterator can reach:  the digit count,
+  // if there is one.  Without one, forward iterators count the digits
+  // once, as each position depends on the count, while reverse iterators
+  // stop at the most digits an NCU can hold.
+  template <iterator_dir Direction>
+  constexpr std::size_t iterator_limit() const noexcept {
+    return digits_ != kUncounted ? digits_
+         : Direction == Forward  ? total_digits(number_)
+                                 : detail::max_radix_digits<NCU, RADIX>();
   }
 
   // Forward declarations.
@@ -329,7 +576,7 @@ class digit_adaptor {
    public:
     using iterator_category = std::random_access_iterator_tag;
     using difference_type   = std::ptrdiff_t;
-    using value_type        = std::remove_cv_t<T>;
+    using value_type        = radix_digit_t<RADIX>;
 
     // The type aliases just above this class already fold const and
     // non-const reference and pointer types into a common type for const
@@ -346,13 +593,14 @@ class digit_adaptor {
                           const_reference_, reference_>;
 
     constexpr iterator_(const digit_adaptor& da, std::size_t index) noexcept
-    : digit_adaptor_{&da}, index_{index} {}
+    : digit_adaptor_{&da}, index_{index},
+      limit_{da.template iterator_limit<Direction>()} {}
 
     constexpr iterator_(const iterator_&)            = default;
     constexpr iterator_& operator=(const iterator_&) = default;
 
     constexpr auto& operator++() noexcept {
-      if (index_ < digit_adaptor_->digits_) ++index_;
+      if (index_ < limit_) ++index_;
       return *this;
     }
 
@@ -375,14 +623,14 @@ class digit_adaptor {
 
     constexpr auto operator+(int rhs) const noexcept {
       auto temp = iterator_{*this};
-      temp.index_ = std::min(digit_adaptor_->digits_,
+      temp.index_ = std::min(limit_,
                              std::max(std::size_t{0}, index_ + rhs));
       return temp;
     }
 
     constexpr auto operator-(int rhs) const noexcept {
       auto temp = iterator_{*this};
-      temp.index_ = std::min(digit_adaptor_->digits_,
+      temp.index_ = std::min(limit_,
                              std::max(std::size_t{0}, index_ - rhs));
       return temp;
     }
@@ -392,13 +640,13 @@ class digit_adaptor {
     }
 
     constexpr auto& operator+=(int rhs) noexcept {
-      index_ = std::min(digit_adaptor_->digits_,
+      index_ = std::min(limit_,
                         std::max(std::size_t{0}, index_ + rhs));
       return *this;
     }
 
     constexpr auto& operator-=(int rhs) noexcept {
-      index_ = std::min(digit_adaptor_->digits_,
+      index_ = std::min(limit_,
                         std::max(std::size_t{0}, index_ - rhs));
       return *this;
     }
@@ -429,17 +677,25 @@ class digit_adaptor {
 
     constexpr reference operator*() const noexcept {
       return {&digit_adaptor_->number_,
-              compute_divisor<Direction>(index_, digit_adaptor_->digits_)};
+              compute_divisor<Direction>(index_, limit_)};
+    }
+
+    // Indexes from the iterator, so rbegin()[n] reads the digit n places
+    // from the least significant end.
+    constexpr reference operator[](int n) const noexcept {
+      return *(*this + n);
     }
 
    private:
     const digit_adaptor* digit_adaptor_;
     std::size_t index_;
+    std::size_t limit_;
   };
 
  public:
   using element_type    = T;
-  using value_type      = std::remove_cv_t<T>;
+  using digit_type      = radix_digit_t<RADIX>;
+  using value_type      = digit_type;
   using size_type       = std::size_t;
   using difference_type = std::ptrdiff_t;
   using pointer         = digit_adaptor::pointer_;
@@ -466,5 +722,227 @@ constexpr void swap(const T& dp1, const T& dp2) noexcept {
   dp1.swap(dp2);
 }
 
+// Digit algorithms over any container of digits, such as a digit_adaptor.
+// These go through the container's iterators.  Adaptors with a faster way
+// to do the same job, such as string_digit_adaptor, overload them, so
+// generic code calling these gets the fast path without knowing about it.
+
+// Reverses the order of the digits.
+template <typename Digits>
+void reverse_digits(const Digits& digits) {
+  std::reverse(digits.begin(), digits.end());
+}
+
+// Sorts the digits into ascending order.
+template <typename Digits>
+void sort_digits(const Digits& digits) {
+  std::sort(digits.begin(), digits.end());
+}
+
+// Returns the number of times 'digit' appears.
+template <typename Digits>
+std::size_t count_digit(const Digits& digits, int digit) {
+  using value_type = typename Digits::value_type;
+  auto count = std::size_t{0};
+  for (const auto d : digits) {
+    count += static_cast<int>(static_cast<value_type>(d)) == digit;
+  }
+  return count;
+}
+
+// Adds the number of times each digit appears to 'counts', which must hold
+// an entry for every digit in the radix.
+template <typename Digits, typename Count>
+void digit_histogram(const Digits& digits, Count* counts) {
+  using value_type = typename Digits::value_type;
+  for (const auto d : digits) {
+    ++counts[static_cast<int>(static_cast<value_type>(d))];
+  }
+}
+
+namespace detail {
+
+// Returns the magnitude of an integer as its corresponding unsigned type.
+template <typename T>
+constexpr auto magnitude(T value) noexcept {
+  using U = std::make_unsigned_t<std::remove_cv_t<T>>;
+  const auto u = static_cast<U>(value);
+  return value < 0 ? U(-u) : u;
+}
+
+// Scrambles the bits of a 64-bit value.  This is the finalizer from
+// MurmurHash3, which is a bijection, so distinct inputs never collide.
+constexpr std::uint64_t mix64(std::uint64_t x) noexcept {
+  x ^= x >> 33;
+  x *= 0xFF51AFD7ED558CCDULL;
+  x ^= x >> 33;
+  x *= 0xC4CEB9FE1A85EC53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+// Folds an unsigned value of any width into 64 bits.
+template <typename U>
+constexpr std::uint64_t fold64(U u, std::false_type /* wider than 64 */) {
+  return static_cast<std::uint64_t>(u);
+}
+
+template <typename U>
+constexpr std::uint64_t fold64(U u, std::true_type /* wider than 64 */) {
+  auto h = static_cast<std::uint64_t>(u);
+  for (auto bytes = sizeof(U); bytes > 8; bytes -= 8) {
+    u >>= 64;
+    h = mix64(h) ^ static_cast<std::uint64_t>(u);
+  }
+  return h;
+}
+
+}  // namespace detail
+
+// Hashes a digit_adaptor consistently with its operator==, by combining its
+// magnitude and digit count.  This never decodes the digits.  For types up
+// to 64 bits wide, adaptors with the same digit count never collide before
+// the result is reduced to std::size_t.
+struct digit_hash {
+  template <typename T, int RADIX, typename Tables>
+  constexpr std::size_t operator()(
+      const digit_adaptor<T, RADIX, Tables>& digits) const noexcept {
+    return (*this)(detail::magnitude(static_cast<T>(digits)), digits.size());
+  }
+
+  // Hashes a magnitude and digit count directly.
+  template <typename U>
+  constexpr std::size_t operator()(U magnitude,
+                                   std::size_t digits) const noexcept {
+    using wide = std::integral_constant<bool, (sizeof(U) > 8)>;
+    const auto folded = detail::fold64(magnitude, wide{});
+    return static_cast<std::size_t>(
+        detail::mix64(folded ^ (digits * 0x9E3779B97F4A7C15ULL)));
+  }
+};
+
+// Holds a canonical form of the multiset of digits in a digit_adaptor:  the
+// digits sorted into ascending order, along with the digit count.  Two
+// adaptors have equal signatures exactly when one's digits are a
+// permutation of the other's, counting leading zeros.  That makes the
+// signature invariant under rotations, reversal, sorting, and so on.
+//
+// Sorted ascending, the digits never form a larger number than the original,
+// so value() always fits in the adaptor's unsigned type.
+template <typename T, int RADIX = 10>
+class digit_signature {
+ public:
+  using value_type = std::make_unsigned_t<std::remove_cv_t<T>>;
+
+  template <typename Tables>
+  constexpr explicit digit_signature(
+      const digit_adaptor<T, RADIX, Tables>& digits) noexcept
+  : sorted_{sort_digits(detail::magnitude(static_cast<T>(digits)),
+                        digits.size())},
+    digits_{digits.size()} {}
+
+  // Returns the digits sorted ascending, as a number.
+  constexpr value_type value() const noexcept {
+    return sorted_;
+  }
+
+  // Returns the number of digits, including leading zeros.
+  constexpr std::size_t size() const noexcept {
+    return digits_;
+  }
+
+  constexpr bool operator==(const digit_signature& rhs) const noexcept {
+    return sorted_ == rhs.sorted_ && digits_ == rhs.digits_;
+  }
+
+  constexpr bool operator!=(const digit_signature& rhs) const noexcept {
+    return !this->operator==(rhs);
+  }
+
+ private:
+  value_type  sorted_;
+  std::size_t digits_;
+
+  // Radices up to this size sort digits by counting them.  Larger ones use
+  // an insertion sort, to keep the stack footprint bounded.
+  static constexpr int kMaxCountingRadix = 64;
+
+  constexpr static value_type sort_digits(value_type u, std::size_t digits) {
+    return RADIX <= kMaxCountingRadix ? counting_sort_digits(u, digits)
+                                      : insertion_sort_digits(u, digits);
+  }
+
+  // Sorts the last 'digits' digits of 'u'.  Only the non-zero prefix needs
+  // sorting, as leading zeros sort to the front and contribute nothing to
+  // the value.
+  constexpr static value_type counting_sort_digits(value_type u,
+                                                   std::size_t digits) {
+    std::size_t counts[RADIX <= kMaxCountingRadix ? RADIX : 1] = {};
+
+    for (auto i = std::size_t{0}; i != digits && u != 0; ++i) {
+      ++counts[u % RADIX];
+      u /= RADIX;
+    }
+
+    auto result = value_type{0};
+    for (int digit = 1; digit < RADIX; ++digit) {
+      for (auto n = counts[digit]; n != 0; --n) {
+        result = static_cast<value_type>(result * RADIX + digit);
+      }
+    }
+    return result;
+  }
+
+  constexpr static value_type insertion_sort_digits(value_type u,
+                                                    std::size_t digits) {
+    value_type sorted[8 * sizeof(value_type)] = {};
+    auto count = std::size_t{0};
+
+    for (; count != digits && u != 0; ++count) {
+      const auto digit = static_cast<value_type>(u % RADIX);
+      u /= RADIX;
+
+      auto i = count;
+      for (; i > 0 && sorted[i - 1] > digit; --i) {
+        sorted[i] = sorted[i - 1];
+      }
+      sorted[i] = digit;
+    }
+
+    auto result = value_type{0};
+    for (auto i = std::size_t{0}; i != count; ++i) {
+      result = static_cast<value_type>(result * RADIX + sorted[i]);
+    }
+    return result;
+  }
+};
+
+// Hashes a digit_adaptor by its digit_signature, so that all permutations
+// of the same digits land in the same bucket.  Useful for grouping numbers
+// by their digits, e.g. to find anagrams.
+struct digit_permutation_hash {
+  template <typename T, int RADIX, typename Tables>
+  constexpr std::size_t operator()(
+      const digit_adaptor<T, RADIX, Tables>& digits) const noexcept {
+    return (*this)(digit_signature<T, RADIX>{digits});
+  }
+
+  template <typename T, int RADIX>
+  constexpr std::size_t operator()(
+      const digit_signature<T, RADIX>& signature) const noexcept {
+    return digit_hash{}(signature.value(), signature.size());
+  }
+};
+
 }  // namespace jz
+
+namespace std {
+
+template <typename T, int RADIX, typename Tables>
+struct hash<jz::digit_adaptor<T, RADIX, Tables>> : jz::digit_hash {};
+
+template <typename T, int RADIX>
+struct hash<jz::digit_signature<T, RADIX>> : jz::digit_permutation_hash {};
+
+}  // namespace std
 #endif // DIGIT_ADAPTOR_HH_
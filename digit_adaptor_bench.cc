@@ -0,0 +1,2374 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+//
+// Micro-benchmarks for the digit adaptors.  Requires C++17 for the
+// std::to_chars baselines.
+//
+//   digit_adaptor_bench [--repeat N] [--warmup N] [--cpu N] [--filter TEXT]
+//                       [--json FILE] [--no-reports]
+//   digit_adaptor_bench --compare OLD.json NEW.json [--threshold PERCENT]
+//                       [--alpha P]
+//
+// Each case runs --warmup times untimed, then --repeat times, and reports
+// the median and the median absolute deviation (MAD) of its times.  --cpu
+// pins the process, and any threads it starts, to one CPU.  --json writes
+// every sample, so a later --compare can test two runs, case by case, with
+// a Mann-Whitney U test.  A case regresses when its median grows by more
+// than --threshold percent (default 5) and the test's p-value is below
+// --alpha (default 0.01).  --compare exits with 1 if any case regressed.
+#include "big_digits.hh"
+#include "big_multiply.hh"
+#include "cow_digits.hh"
+#include "digit_adaptor.hh"
+#include "digit_arena.hh"
+#include "digit_batch.hh"
+#include "digit_file_pipeline.hh"
+#include "digit_ingest.hh"
+#include "digit_pattern.hh"
+#include "digit_random.hh"
+#include "digit_serial.hh"
+#include "digit_shm_ring.hh"
+#include "digit_signature_index.hh"
+#include "digit_trie.hh"
+#include "float_digit_adaptor.hh"
+#include "string_digit_adaptor.hh"
+#include "wide_arithmetic.hh"
+#include "wide_digit_adaptor.hh"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <sched.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+static_assert(__cplusplus >= 201703L, "Benchmarks require C++17 or later.");
+
+namespace {
+
+using jz::digit_adaptor;
+using jz::float_digit_adaptor;
+
+// Like the tests, this uses a minimal home-grown framework rather than an
+// external benchmark library.  Each case returns its time per item in
+// nanoseconds.
+using BenchCaseFxn = double(void);
+
+// Each case names the element type it works on and its radix, which,
+// with the case's name, identify it across runs.
+struct BenchCase {
+  const char   *name;
+  const char   *type;
+  int           radix;
+  BenchCaseFxn *bench;
+};
+
+constexpr std::size_t kItems = 1 << 20;
+constexpr int kReps = 5;
+
+// Keeps the optimizer from discarding benchmark results.
+volatile std::uint64_t sink;
+
+// Runs 'fxn' over every item in 'data' kReps times, and returns the average
+// time per item in nanoseconds.  The first pass is an untimed warmup.
+template <typename Data, typename Fxn>
+double time_per_item(const Data& data, Fxn&& fxn) {
+  using clock = std::chrono::steady_clock;
+
+  auto total = std::uint64_t{0};
+  for (const auto& item : data) {
+    total += fxn(item);
+  }
+
+  const auto start = clock::now();
+  for (int rep = 0; rep != kReps; ++rep) {
+    for (const auto& item : data) {
+      total += fxn(item);
+    }
+  }
+  const auto stop = clock::now();
+
+  sink = total;
+  const auto ns = std::chrono::duration<double, std::nano>(stop - start);
+  return ns.count() / (double(kReps) * double(data.size()));
+}
+
+// Returns finite values with uniformly random bit patterns, which exercises
+// the full exponent range.
+template <typename F, typename Bits>
+const std::vector<F>& random_bit_floats() {
+  static const auto data = [] {
+    auto rng = std::mt19937_64{0xf10a7};
+    auto values = std::vector<F>{};
+    values.reserve(kItems);
+    while (values.size() != kItems) {
+      const auto bits = static_cast<Bits>(rng());
+      F value;
+      std::memcpy(&value, &bits, sizeof value);
+      if (std::isfinite(value)) { values.push_back(value); }
+    }
+    return values;
+  }();
+  return data;
+}
+
+// Returns prices in cents as doubles, i.e. values with few digits.
+const std::vector<double>& short_decimal_doubles() {
+  static const auto data = [] {
+    auto rng = std::mt19937_64{0xcafe};
+    auto dist = std::uniform_int_distribution<int>{1, 9999999};
+    auto values = std::vector<double>{};
+    values.reserve(kItems);
+    for (std::size_t i = 0; i != kItems; ++i) {
+      values.push_back(dist(rng) / 100.0);
+    }
+    return values;
+  }();
+  return data;
+}
+
+// Holds a numeric ID with an explicit digit count, so that leading zeros are
+// significant, as in fixed-width account numbers.
+struct DigitKey {
+  std::uint64_t value;
+  std::size_t   digits;
+};
+
+// Returns IDs of 1 to 19 digits, padded with up to 3 leading zeros.
+const std::vector<DigitKey>& random_digit_keys() {
+  static const auto data = [] {
+    auto dist = jz::uniform_digit_lengths(1, 19);
+    dist.leading_zeros = true;
+    auto random = jz::digit_random<std::uint64_t>{dist, 0x4417};
+    auto rng = std::mt19937_64{0x4417};
+    auto keys = std::vector<DigitKey>{};
+    keys.reserve(kItems);
+    for (std::size_t i = 0; i != kItems; ++i) {
+      std::size_t digits;
+      const auto value = random(digits);
+      keys.push_back({value, digits + rng() % 4});
+    }
+    return keys;
+  }();
+  return data;
+}
+
+// Materializes a key as a zero-padded string, as callers without
+// digit_hash have to.
+std::string key_string(const DigitKey& key) {
+  char buf[32];
+  const auto end = std::to_chars(buf, buf + sizeof buf, key.value).ptr;
+  const auto length = static_cast<std::size_t>(end - buf);
+  auto s = std::string(key.digits > length ? key.digits - length : 0, '0');
+  s.append(buf, end);
+  return s;
+}
+
+std::size_t hash_via_digit_hash(const DigitKey& key) {
+  return std::hash<digit_adaptor<const std::uint64_t>>{}(
+      digit_adaptor<const std::uint64_t>{key.value, key.digits});
+}
+
+std::size_t hash_via_string(const DigitKey& key) {
+  return std::hash<std::string>{}(key_string(key));
+}
+
+std::size_t hash_via_permutation_hash(const DigitKey& key) {
+  return jz::digit_permutation_hash{}(
+      digit_adaptor<const std::uint64_t>{key.value, key.digits});
+}
+
+std::size_t hash_via_sorted_string(const DigitKey& key) {
+  auto s = key_string(key);
+  std::sort(s.begin(), s.end());
+  return std::hash<std::string>{}(s);
+}
+
+// Returns 4M numeric IDs of 10 to 12 digits, for the trie benchmarks.
+const std::vector<std::uint64_t>& trie_ids() {
+  static const auto data = [] {
+    auto rng = std::mt19937_64{0x7e1e};
+    auto dist = std::uniform_int_distribution<std::uint64_t>{
+        1000000000ULL, 999999999999ULL};
+    auto ids = std::vector<std::uint64_t>(4 * kItems);
+    for (auto& id : ids) { id = dist(rng); }
+    return ids;
+  }();
+  return data;
+}
+
+const jz::digit_trie<std::uint64_t>& id_trie() {
+  static const auto trie =
+      jz::digit_trie<std::uint64_t>{trie_ids().begin(), trie_ids().end()};
+  return trie;
+}
+
+// Returns the IDs as sorted strings, the usual alternative to a trie.
+const std::vector<std::string>& sorted_id_strings() {
+  static const auto data = [] {
+    auto strings = std::vector<std::string>{};
+    strings.reserve(trie_ids().size());
+    for (const auto id : trie_ids()) { strings.push_back(std::to_string(id)); }
+    std::sort(strings.begin(), strings.end());
+    return strings;
+  }();
+  return data;
+}
+
+// Returns random 4-digit prefixes to look up.
+const std::vector<std::uint64_t>& id_prefixes() {
+  static const auto data = [] {
+    auto rng = std::mt19937_64{0x4417};
+    auto dist = std::uniform_int_distribution<std::uint64_t>{1000, 9999};
+    auto prefixes = std::vector<std::uint64_t>(kItems);
+    for (auto& prefix : prefixes) { prefix = dist(rng); }
+    return prefixes;
+  }();
+  return data;
+}
+
+// Returns the path of a digit signature index over the trie IDs, building
+// it on first use.  The file is removed at exit.
+const char* signature_index_path() {
+  struct index_file {
+    index_file() {
+      jz::write_digit_signature_index<std::uint64_t>(
+          path, trie_ids().begin(), trie_ids().end(),
+          std::max(1u, std::thread::hardware_concurrency()));
+    }
+    ~index_file() { std::remove(path); }
+    const char* path = "/tmp/digit_adaptor_bench.sigidx";
+  };
+  static const index_file file;
+  return file.path;
+}
+
+const jz::digit_signature_index<std::uint64_t>& signature_index() {
+  static const auto index =
+      jz::digit_signature_index<std::uint64_t>{signature_index_path()};
+  return index;
+}
+
+// Returns some of the trie IDs, shuffled, so every lookup finds a match.
+const std::vector<std::uint64_t>& signature_queries() {
+  static const auto data = [] {
+    auto queries = std::vector<std::uint64_t>(
+        trie_ids().begin(), trie_ids().begin() + kItems);
+    std::shuffle(queries.begin(), queries.end(), std::mt19937_64{0x51d});
+    return queries;
+  }();
+  return data;
+}
+
+// Returns random values of 1 to 12 digits, to filter with patterns.
+const std::vector<std::uint64_t>& pattern_values() {
+  static const auto data = [] {
+    auto dist = jz::uniform_digit_lengths(1, 12);
+    dist.leading_zeros = true;
+    auto random = jz::digit_random<std::uint64_t>{dist, 0x9a7};
+    auto values = std::vector<std::uint64_t>(kItems);
+    random.generate(values.data(), values.data() + values.size());
+    return values;
+  }();
+  return data;
+}
+
+// Times a span matcher over all of pattern_values(), per value.
+double time_pattern_span(const char* text) {
+  const auto& values = pattern_values();
+  const auto pattern = jz::digit_pattern<>{text};
+  auto bitmap = std::vector<std::uint64_t>((values.size() + 63) / 64);
+  const auto once = std::vector<int>{0};
+
+  return time_per_item(once, [&](int) {
+    return pattern.match(values.data(), values.data() + values.size(),
+                         bitmap.data());
+  }) / double(values.size());
+}
+
+// Times std::regex_match on std::to_string, the filter the pattern replaces.
+// This is slow enough that it only sees the first 64K values.
+double time_pattern_regex(const char* text) {
+  const auto& values = pattern_values();
+  const auto some = std::vector<std::uint64_t>(
+      values.begin(), values.begin() + (1 << 16));
+  const auto re = std::regex{text, std::regex::optimize};
+
+  return time_per_item(some, [&re](std::uint64_t value) {
+    return std::regex_match(std::to_string(value), re);
+  });
+}
+
+// Formats the shortest digits and exponent into a buffer via the adaptor,
+// to compare like-for-like with std::to_chars.
+template <typename F>
+std::uint64_t format_via_adaptor(F value) {
+  char buf[32];
+  const float_digit_adaptor<F> d{value};
+  auto p = buf;
+  for (const auto digit : d) {
+    *p++ = static_cast<char>('0' + digit);
+  }
+  return static_cast<std::uint64_t>(p - buf) + d.exponent();
+}
+
+template <typename F>
+std::uint64_t format_via_to_chars(F value) {
+  char buf[32];
+  const auto result = std::to_chars(buf, buf + sizeof buf, value,
+                                    std::chars_format::scientific);
+  return static_cast<std::uint64_t>(result.ptr - buf);
+}
+
+double BenchDoubleShortestDecimal() {
+  return time_per_item(random_bit_floats<double, std::uint64_t>(),
+                       [](double v) {
+                         return jz::to_shortest_decimal(v).significand;
+                       });
+}
+
+double BenchDoubleAdaptorDigits() {
+  return time_per_item(random_bit_floats<double, std::uint64_t>(),
+                       format_via_adaptor<double>);
+}
+
+double BenchDoubleToChars() {
+  return time_per_item(random_bit_floats<double, std::uint64_t>(),
+                       format_via_to_chars<double>);
+}
+
+double BenchDoubleAdaptorLeadingDigit() {
+  return time_per_item(random_bit_floats<double, std::uint64_t>(),
+                       [](double v) {
+                         const float_digit_adaptor<double> d{v};
+                         return std::uint64_t{d[0]};
+                       });
+}
+
+double BenchShortDoubleAdaptorDigits() {
+  return time_per_item(short_decimal_doubles(), format_via_adaptor<double>);
+}
+
+double BenchShortDoubleToChars() {
+  return time_per_item(short_decimal_doubles(), format_via_to_chars<double>);
+}
+
+double BenchFloatShortestDecimal() {
+  return time_per_item(random_bit_floats<float, std::uint32_t>(),
+                       [](float v) {
+                         return jz::to_shortest_decimal(v).significand;
+                       });
+}
+
+double BenchFloatAdaptorDigits() {
+  return time_per_item(random_bit_floats<float, std::uint32_t>(),
+                       format_via_adaptor<float>);
+}
+
+double BenchFloatToChars() {
+  return time_per_item(random_bit_floats<float, std::uint32_t>(),
+                       format_via_to_chars<float>);
+}
+
+double BenchDigitHash() {
+  return time_per_item(random_digit_keys(), hash_via_digit_hash);
+}
+
+double BenchStringHash() {
+  return time_per_item(random_digit_keys(), hash_via_string);
+}
+
+double BenchDigitPermutationHash() {
+  return time_per_item(random_digit_keys(), hash_via_permutation_hash);
+}
+
+double BenchSortedStringHash() {
+  return time_per_item(random_digit_keys(), hash_via_sorted_string);
+}
+
+double BenchTrieBuildPerKey() {
+  using clock = std::chrono::steady_clock;
+  const auto& ids = trie_ids();
+
+  auto sorted = ids;
+  std::sort(sorted.begin(), sorted.end(),
+            [](std::uint64_t a, std::uint64_t b) {
+              return std::to_string(a) < std::to_string(b);
+            });
+
+  const auto start = clock::now();
+  const auto trie = jz::digit_trie<std::uint64_t>{sorted.begin(), sorted.end()};
+  const auto stop = clock::now();
+
+  sink = trie.node_count();
+  const auto ns = std::chrono::duration<double, std::nano>(stop - start);
+  return ns.count() / double(ids.size());
+}
+
+double BenchTriePrefixQuery() {
+  const auto& trie = id_trie();
+  return time_per_item(id_prefixes(), [&trie](std::uint64_t prefix) {
+    return trie.find_prefix(prefix).size();
+  });
+}
+
+double BenchSortedStringPrefixQuery() {
+  const auto& strings = sorted_id_strings();
+  return time_per_item(id_prefixes(), [&strings](std::uint64_t prefix) {
+    const auto key = std::to_string(prefix);
+    const auto first = std::lower_bound(strings.begin(), strings.end(), key);
+    const auto last = std::lower_bound(
+        first, strings.end(), key,
+        [](const std::string& s, const std::string& k) {
+          return s.compare(0, k.size(), k) <= 0;
+        });
+    return static_cast<std::uint64_t>(last - first);
+  });
+}
+
+double BenchSignatureIndexBuildPerKey() {
+  using clock = std::chrono::steady_clock;
+  const auto& ids = trie_ids();
+  const auto path = "/tmp/digit_adaptor_bench.build.sigidx";
+
+  const auto start = clock::now();
+  sink = jz::write_digit_signature_index<std::uint64_t>(
+      path, ids.begin(), ids.end(),
+      std::max(1u, std::thread::hardware_concurrency()));
+  const auto stop = clock::now();
+
+  std::remove(path);
+  const auto ns = std::chrono::duration<double, std::nano>(stop - start);
+  return ns.count() / double(ids.size());
+}
+
+// Times mapping the index and answering a first query, per open.  The file
+// is in the page cache, so this measures our startup cost, not the disk.
+double BenchSignatureIndexOpen() {
+  using clock = std::chrono::steady_clock;
+  constexpr int kOpens = 1000;
+  const auto path = signature_index_path();
+  const auto query = trie_ids().front();
+
+  const auto start = clock::now();
+  for (int i = 0; i != kOpens; ++i) {
+    const auto index = jz::digit_signature_index<std::uint64_t>{path};
+    sink = index.find(digit_adaptor<const std::uint64_t>{query}).size();
+  }
+  const auto stop = clock::now();
+
+  const auto ns = std::chrono::duration<double, std::nano>(stop - start);
+  return ns.count() / kOpens;
+}
+
+double BenchSignatureIndexQuery() {
+  const auto& index = signature_index();
+  return time_per_item(signature_queries(), [&index](std::uint64_t query) {
+    return index.find(digit_adaptor<const std::uint64_t>{query}).size();
+  });
+}
+
+// Sorts the query's digits, then scans every ID for a match.  This is what
+// the index replaces, so it only runs a handful of queries.
+double BenchSortAndScanQuery() {
+  const auto& ids = trie_ids();
+  const auto queries = std::vector<std::uint64_t>(
+      signature_queries().begin(), signature_queries().begin() + 8);
+
+  const auto sorted_digits = [](std::uint64_t value) {
+    auto s = std::to_string(value);
+    std::sort(s.begin(), s.end());
+    return s;
+  };
+
+  return time_per_item(queries, [&](std::uint64_t query) {
+    const auto key = sorted_digits(query);
+    auto matches = std::uint64_t{0};
+    for (const auto id : ids) {
+      matches += sorted_digits(id) == key;
+    }
+    return matches;
+  });
+}
+
+double BenchDigitPatternFixedSpan() {
+  return time_pattern_span("1[0-4]??????7?");
+}
+
+double BenchRegexFixedToString() {
+  return time_pattern_regex("1[0-4]......7.");
+}
+
+double BenchDigitPatternStarSpan() {
+  return time_pattern_span("12?4*9");
+}
+
+double BenchRegexStarToString() {
+  return time_pattern_regex("12.4.*9");
+}
+
+// Baselines for the digit formats:  zero-padded ASCII lines, and packed BCD
+// after a digit count byte.  Each encodes every key into one buffer, and
+// returns the end.
+char* ascii_encode(const std::vector<DigitKey>& keys, char* out) {
+  for (const auto& key : keys) {
+    const auto natural = jz::count_digits(key.value);
+    const auto pad = key.digits > natural ? key.digits - natural : 0;
+    std::memset(out, '0', pad);
+    out = jz::format_digits(key.value, out + pad);
+    *out++ = '\n';
+  }
+  return out;
+}
+
+std::uint64_t ascii_decode(const char* first, const char* last) {
+  auto total = std::uint64_t{0};
+  while (first != last) {
+    const auto eol = static_cast<const char*>(
+        std::memchr(first, '\n', std::size_t(last - first)));
+    auto value = std::uint64_t{0};
+    jz::parse_digits(first, eol, value);
+    total += value + std::size_t(eol - first);
+    first = eol + 1;
+  }
+  return total;
+}
+
+unsigned char* bcd_encode(const std::vector<DigitKey>& keys,
+                          unsigned char* out) {
+  for (const auto& key : keys) {
+    *out++ = static_cast<unsigned char>(key.digits);
+    const auto bytes = (key.digits + 1) / 2;
+    auto value = key.value;
+    for (auto i = bytes; i-- != 0; ) {
+      const auto pair = value % 100;
+      value /= 100;
+      out[i] = static_cast<unsigned char>((pair / 10) << 4 | pair % 10);
+    }
+    out += bytes;
+  }
+  return out;
+}
+
+std::uint64_t bcd_decode(const unsigned char* first,
+                         const unsigned char* last) {
+  auto total = std::uint64_t{0};
+  while (first != last) {
+    const auto digits = std::size_t{*first++};
+    auto value = std::uint64_t{0};
+    for (std::size_t i = 0; i != (digits + 1) / 2; ++i) {
+      value = value * 100 + (first[i] >> 4) * 10 + (first[i] & 0xF);
+    }
+    total += value + digits;
+    first += (digits + 1) / 2;
+  }
+  return total;
+}
+
+unsigned char* record_encode(const std::vector<DigitKey>& keys,
+                             unsigned char* out) {
+  for (const auto& key : keys) {
+    out = jz::encode_digit_record(key.value, key.digits, out);
+  }
+  return out;
+}
+
+std::uint64_t record_decode(const unsigned char* first,
+                            const unsigned char* last) {
+  auto total = std::uint64_t{0};
+  while (first != last) {
+    auto value = std::uint64_t{0};
+    auto digits = std::size_t{0};
+    first = jz::decode_digit_record(first, last, value, digits);
+    total += value + digits;
+  }
+  return total;
+}
+
+struct DigitColumn {
+  std::vector<std::uint64_t> values;
+  std::vector<std::uint8_t> digits;
+};
+
+DigitColumn make_column(const std::vector<DigitKey>& keys) {
+  auto column = DigitColumn{};
+  for (const auto& key : keys) {
+    column.values.push_back(key.value);
+    column.digits.push_back(static_cast<std::uint8_t>(key.digits));
+  }
+  return column;
+}
+
+unsigned char* column_encode(const DigitColumn& column, unsigned char* out) {
+  return jz::encode_digit_column(column.values.data(), column.digits.data(),
+                                 column.values.size(), out);
+}
+
+// Times one pass of 'fxn' over all the keys, per key.
+template <typename Fxn>
+double time_per_key(Fxn&& fxn) {
+  const auto once = std::vector<int>{0};
+  return time_per_item(once, [&fxn](int) { return fxn(); }) /
+         double(random_digit_keys().size());
+}
+
+std::vector<unsigned char>& serial_buffer() {
+  static auto buffer = std::vector<unsigned char>(
+      jz::max_digit_column_bytes(kItems) + 32 * kItems);
+  return buffer;
+}
+
+double BenchDigitRecordEncode() {
+  auto out = serial_buffer().data();
+  return time_per_key([out] {
+    return std::uint64_t(record_encode(random_digit_keys(), out) - out);
+  });
+}
+
+double BenchDigitRecordDecode() {
+  const auto first = serial_buffer().data();
+  const auto last = record_encode(random_digit_keys(), first);
+  return time_per_key([=] { return record_decode(first, last); });
+}
+
+double BenchDigitColumnEncode() {
+  const auto column = make_column(random_digit_keys());
+  auto out = serial_buffer().data();
+  return time_per_key([&column, out] {
+    return std::uint64_t(column_encode(column, out) - out);
+  });
+}
+
+double BenchDigitColumnDecode() {
+  auto column = make_column(random_digit_keys());
+  const auto first = serial_buffer().data();
+  const auto last = column_encode(column, first);
+  return time_per_key([&] {
+    jz::decode_digit_column(first, last, column.values.data(),
+                            column.digits.data(), column.values.size());
+    return column.values.back();
+  });
+}
+
+double BenchAsciiEncode() {
+  auto out = reinterpret_cast<char*>(serial_buffer().data());
+  return time_per_key([out] {
+    return std::uint64_t(ascii_encode(random_digit_keys(), out) - out);
+  });
+}
+
+double BenchAsciiDecode() {
+  const auto first = reinterpret_cast<char*>(serial_buffer().data());
+  const auto last = ascii_encode(random_digit_keys(), first);
+  return time_per_key([=] { return ascii_decode(first, last); });
+}
+
+double BenchBcdEncode() {
+  auto out = serial_buffer().data();
+  return time_per_key([out] {
+    return std::uint64_t(bcd_encode(random_digit_keys(), out) - out);
+  });
+}
+
+double BenchBcdDecode() {
+  const auto first = serial_buffer().data();
+  const auto last = bcd_encode(random_digit_keys(), first);
+  return time_per_key([=] { return bcd_decode(first, last); });
+}
+
+// Reports bytes per value for each format, on random keys, on sorted
+// millisecond timestamps, and on five-digit codes with leading zeros.
+void ReportSerialSizes() {
+  auto rng = std::mt19937_64{87};
+  auto random_code = jz::digit_random<std::uint64_t>{
+      jz::fixed_width_digits(5), 87};
+  auto timestamps = std::vector<DigitKey>{};
+  auto codes = std::vector<DigitKey>{};
+  auto ms = std::uint64_t{1700000000000};
+  for (std::size_t i = 0; i != kItems; ++i) {
+    timestamps.push_back({ms += rng() % 1000, 13});
+    codes.push_back({random_code(), 5});
+  }
+
+  const struct {
+    const char* name;
+    const std::vector<DigitKey>& keys;
+  } data_sets[] = {
+    {"random keys", random_digit_keys()},
+    {"sorted timestamps", timestamps},
+    {"5-digit codes", codes},
+  };
+
+  auto& buffer = serial_buffer();
+  const auto out = buffer.data();
+  for (const auto& data : data_sets) {
+    const auto n = double(data.keys.size());
+    const auto ascii = reinterpret_cast<unsigned char*>(
+        ascii_encode(data.keys, reinterpret_cast<char*>(out))) - out;
+    const auto bcd = bcd_encode(data.keys, out) - out;
+    const auto record = record_encode(data.keys, out) - out;
+    const auto column = column_encode(make_column(data.keys), out) - out;
+
+    std::cout << std::left << std::setw(20) << data.name << std::right
+              << std::setprecision(2) << "bytes/value:  ascii "
+              << std::setw(5) << double(ascii) / n
+              << "  bcd " << std::setw(5) << double(bcd) / n
+              << "  record " << std::setw(5) << double(record) / n
+              << "  column " << std::setw(5) << double(column) / n << '\n';
+  }
+}
+
+// Prints one shared table's size, in bytes and cache lines, and adds it to
+// 'total'.
+template <typename Table>
+void ReportTable(const char* name, const Table& table, std::size_t& total) {
+  std::cout << std::left << std::setw(32) << name << std::right
+            << std::setw(8) << sizeof table << " bytes"
+            << std::setw(5) << (sizeof table + 63) / 64 << " lines"
+            << (reinterpret_cast<std::uintptr_t>(&table) % 64 ? "" :
+                "  aligned") << '\n';
+  total += sizeof table;
+}
+
+// Reports the decimal tables behind the adaptors.  Each is keyed on width
+// and radix alone, so every signed, unsigned and const type of a width
+// shares one copy.  nm -S on a binary lists every table it links.
+void ReportTableBytes() {
+  using jz::detail::digit_runs;
+  using jz::detail::radix_powers;
+
+  auto total = std::size_t{0};
+  ReportTable("radix_powers<8-bit, 10>",
+              radix_powers<std::uint8_t, 10>::table, total);
+  ReportTable("radix_powers<16-bit, 10>",
+              radix_powers<std::uint16_t, 10>::table, total);
+  ReportTable("radix_powers<32-bit, 10>",
+              radix_powers<std::uint32_t, 10>::table, total);
+  ReportTable("radix_powers<64-bit, 10>",
+              radix_powers<std::uint64_t, 10>::table, total);
+  ReportTable("digit_runs<32-bit, 10>",
+              digit_runs<std::uint32_t, 10>::table, total);
+  ReportTable("digit_runs<64-bit, 10>",
+              digit_runs<std::uint64_t, 10>::table, total);
+  ReportTable("digit_pairs<10>", jz::detail::digit_pairs<10>::table, total);
+  ReportTable("digits_by_bit_length<10>",
+              jz::detail::digits_by_bit_length<10>::table, total);
+  ReportTable("wide_powers<256-bit, 10>",
+              jz::detail::wide_powers<4, 10>::table, total);
+  ReportTable("float_pow10", jz::detail::float_pow10<>::table, total);
+  std::cout << std::left << std::setw(32) << "total" << std::right
+            << std::setw(8) << total << " bytes\n";
+
+  const bool shared =
+      static_cast<const void*>(&radix_powers<unsigned long, 10>::table) ==
+          &radix_powers<unsigned long long, 10>::table ||
+      sizeof(long) != sizeof(long long);
+  std::cout << "long and long long share tables:  "
+            << (shared ? "yes" : "no") << '\n';
+}
+
+// Writes through a buffer far larger than the caches, on a thread of its
+// own, for as long as it lives.  Tables the timed code leaves idle even
+// briefly get evicted, as they would next to a memory-hungry neighbor.
+class cache_thrasher {
+ public:
+  cache_thrasher() : buffer_(std::size_t{64} << 20), thread_{[this] {
+    while (!stop_.load(std::memory_order_relaxed)) {
+      for (std::size_t i = 0; i < buffer_.size(); i += 64) {
+        ++buffer_[i];
+      }
+    }
+  }} {}
+
+  ~cache_thrasher() {
+    stop_ = true;
+    thread_.join();
+  }
+
+ private:
+  std::vector<char>  buffer_;
+  std::atomic<bool>  stop_{false};
+  std::thread        thread_;
+};
+
+// Returns 4096 values of every length from 1 to 20 digits, few enough to
+// stay in L1 alongside the tables when nothing else runs.
+const std::vector<std::uint64_t>& random_lengths() {
+  static const auto data = [] {
+    auto rng = std::mt19937_64{98};
+    auto values = std::vector<std::uint64_t>(4096);
+    for (auto& value : values) {
+      value = rng() >> (rng() % 64);
+    }
+    return values;
+  }();
+  return data;
+}
+
+// Returns the calling thread's CPU time in ns, which leaves out time the
+// thrasher has the CPU to itself.
+double thread_cpu_ns() {
+  timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return double(ts.tv_sec) * 1e9 + double(ts.tv_nsec);
+}
+
+// Returns the CPU time per value for 'fxn' over random_lengths().
+template <typename Fxn>
+double cpu_time_per_value(Fxn&& fxn) {
+  const auto& values = random_lengths();
+  auto total = std::uint64_t{0};
+  const auto start = thread_cpu_ns();
+  for (int rep = 0; rep != 64; ++rep) {
+    for (const auto value : values) {
+      total += fxn(value);
+    }
+  }
+  sink = total;
+  return (thread_cpu_ns() - start) / (64.0 * double(values.size()));
+}
+
+template <typename Tables>
+std::uint64_t format_with(std::uint64_t value) {
+  char buf[20];
+  const auto end = jz::format_digits<10, Tables>(value, buf);
+  return std::uint64_t(buf[0]) + std::uint64_t(end - buf);
+}
+
+template <typename Tables>
+std::uint64_t decode_with(std::uint64_t value) {
+  std::uint8_t digits[20];
+  const auto n = jz::decode_digits<10, Tables>(value, digits);
+  return std::uint64_t(digits[0]) + digits[n - 1];
+}
+
+double BenchFormatNoTables() {
+  return cpu_time_per_value(format_with<jz::no_tables>);
+}
+
+double BenchFormatPowerTables() {
+  return cpu_time_per_value(format_with<jz::power_tables>);
+}
+
+double BenchFormatPairTables() {
+  return cpu_time_per_value(format_with<jz::pair_tables>);
+}
+
+double BenchFormatQuadTables() {
+  return cpu_time_per_value(format_with<jz::quad_tables>);
+}
+
+double BenchDecodeNoTables() {
+  return cpu_time_per_value(decode_with<jz::no_tables>);
+}
+
+double BenchDecodePowerTables() {
+  return cpu_time_per_value(decode_with<jz::power_tables>);
+}
+
+double BenchDecodePairTables() {
+  return cpu_time_per_value(decode_with<jz::pair_tables>);
+}
+
+double BenchDecodeQuadTables() {
+  return cpu_time_per_value(decode_with<jz::quad_tables>);
+}
+
+// Copies each value's digits through the iterators into a buffer of
+// value_type, one byte per digit.
+double BenchAdaptorCopyDigits() {
+  return cpu_time_per_value([](std::uint64_t value) {
+    digit_adaptor<std::uint64_t>::value_type digits[20] = {};
+    const auto d = digit_adaptor<std::uint64_t>{value};
+    std::copy(d.begin(), d.end(), digits);
+    return std::uint64_t(digits[0]) + digits[d.size() - 1];
+  });
+}
+
+double BenchAdaptorDecodeDigits() {
+  return cpu_time_per_value([](std::uint64_t value) {
+    digit_adaptor<std::uint64_t>::digit_type digits[20] = {};
+    const auto d = digit_adaptor<std::uint64_t>{value};
+    d.decode(digits);
+    return std::uint64_t(digits[0]) + digits[d.size() - 1];
+  });
+}
+
+// Builds an adaptor and reads its least significant digit, which never
+// needs the digit count.
+double BenchAdaptorLastDigit() {
+  return cpu_time_per_value([](std::uint64_t value) {
+    return std::uint64_t(
+        *digit_adaptor<std::uint64_t>{value, jz::uncounted}.crbegin());
+  });
+}
+
+// Reports each table policy's time to format and decode a value, alone
+// and next to a cache_thrasher.
+void ReportTablePolicies() {
+  const struct {
+    const char* name;
+    double (*format)();
+    double (*decode)();
+  } policies[] = {
+    {"no_tables", BenchFormatNoTables, BenchDecodeNoTables},
+    {"power_tables", BenchFormatPowerTables, BenchDecodePowerTables},
+    {"pair_tables", BenchFormatPairTables, BenchDecodePairTables},
+    {"quad_tables", BenchFormatQuadTables, BenchDecodeQuadTables},
+  };
+
+  std::cout << std::left << std::setw(24) << "table policy, ns/value"
+            << std::right << std::setw(12) << "format" << std::setw(12)
+            << "thrashed" << std::setw(12) << "decode" << std::setw(12)
+            << "thrashed" << '\n';
+  for (const auto& policy : policies) {
+    const auto format = policy.format(), decode = policy.decode();
+    auto format_thrashed = 0.0, decode_thrashed = 0.0;
+    {
+      cache_thrasher thrasher;
+      format_thrashed = policy.format();
+      decode_thrashed = policy.decode();
+    }
+    std::cout << std::left << std::setw(24) << policy.name << std::right
+              << std::fixed << std::setprecision(2)
+              << std::setw(12) << format << std::setw(12) << format_thrashed
+              << std::setw(12) << decode << std::setw(12) << decode_thrashed
+              << '\n';
+  }
+}
+
+// Returns the time per value to draw kItems values from 'dist'.
+double time_per_draw(const jz::digit_distribution& dist) {
+  auto random = jz::digit_random<std::uint64_t>{dist, 88};
+  auto values = std::vector<std::uint64_t>(kItems);
+  const auto once = std::vector<int>{0};
+  return time_per_item(once, [&](int) {
+    random.generate(values.data(), values.data() + values.size());
+    return values.back();
+  }) / double(kItems);
+}
+
+double BenchDigitRandomUniformLengths() {
+  return time_per_draw(jz::uniform_digit_lengths(1, 19));
+}
+
+double BenchDigitRandomBenford() {
+  return time_per_draw(jz::benford_digits(1, 19));
+}
+
+double BenchDigitRandomFixedWidth() {
+  return time_per_draw(jz::fixed_width_digits(5));
+}
+
+// Draws Benford-distributed values the usual way:  a length, then a value
+// of that length from std::uniform_int_distribution, kept with probability
+// P(leading digit) / P(1).
+double BenchRejectBenford() {
+  auto rng = std::mt19937_64{88};
+  auto coin = std::uniform_real_distribution<double>{};
+  const auto powers = jz::detail::radix_powers<std::uint64_t, 10>::table;
+  double keep[10] = {};
+  for (int d = 1; d != 10; ++d) {
+    keep[d] = std::log1p(1.0 / d) / std::log1p(1.0);
+  }
+
+  auto values = std::vector<std::uint64_t>(kItems);
+  const auto once = std::vector<int>{0};
+  return time_per_item(once, [&](int) {
+    for (auto& value : values) {
+      for (;;) {
+        const auto length = 1 + rng() % 19;
+        value = std::uniform_int_distribution<std::uint64_t>{
+            length == 1 ? 1 : powers.powers[length - 1],
+            powers.powers[length] - 1}(rng);
+        if (coin(rng) < keep[value / powers.powers[length - 1]]) {
+          break;
+        }
+      }
+    }
+    return values.back();
+  }) / double(kItems);
+}
+
+// Digit strings for string_digit_adaptor, kItems characters cut into
+// strings of this length.
+constexpr std::size_t kDigitStringLength = 64;
+
+std::string& digit_chars() {
+  static auto chars = [] {
+    auto rng = std::mt19937_64{91};
+    auto s = std::string(kItems, '0');
+    for (auto& c : s) { c = static_cast<char>('0' + rng() % 10); }
+    return s;
+  }();
+  return chars;
+}
+
+// Times 'fxn' on each string, per character.  'fxn' takes the string's
+// first and last characters.
+template <typename Fxn>
+double time_per_char(Fxn&& fxn) {
+  auto& chars = digit_chars();
+  const auto once = std::vector<int>{0};
+  return time_per_item(once, [&](int) {
+    auto total = std::uint64_t{0};
+    for (std::size_t i = 0; i != chars.size(); i += kDigitStringLength) {
+      total += fxn(&chars[i], &chars[i] + kDigitStringLength);
+    }
+    return total;
+  }) / double(chars.size());
+}
+
+double BenchStringDigitsValid() {
+  return time_per_char([](char* first, char* last) {
+    return std::uint64_t(jz::string_digit_adaptor<>{first, last}.valid());
+  });
+}
+
+double BenchStdAllOfValid() {
+  return time_per_char([](char* first, char* last) {
+    return std::uint64_t(std::all_of(first, last, [](char c) {
+      return c >= '0' && c <= '9';
+    }));
+  });
+}
+
+double BenchStringDigitsCount() {
+  return time_per_char([](char* first, char* last) {
+    return std::uint64_t(
+        jz::count_digit(jz::string_digit_adaptor<>{first, last}, 7));
+  });
+}
+
+double BenchStdCount() {
+  return time_per_char([](char* first, char* last) {
+    return std::uint64_t(std::count(first, last, '7'));
+  });
+}
+
+double BenchStringDigitsHistogram() {
+  return time_per_char([](char* first, char* last) {
+    std::uint32_t counts[10] = {};
+    jz::digit_histogram(jz::string_digit_adaptor<>{first, last}, counts);
+    return std::uint64_t(counts[7]);
+  });
+}
+
+double BenchScalarHistogram() {
+  return time_per_char([](char* first, char* last) {
+    std::uint32_t counts[10] = {};
+    for (; first != last; ++first) { ++counts[*first - '0']; }
+    return std::uint64_t(counts[7]);
+  });
+}
+
+double BenchStringDigitsReverse() {
+  return time_per_char([](char* first, char* last) {
+    jz::reverse_digits(jz::string_digit_adaptor<>{first, last});
+    return std::uint64_t(*first);
+  });
+}
+
+double BenchStdReverse() {
+  return time_per_char([](char* first, char* last) {
+    std::reverse(first, last);
+    return std::uint64_t(*first);
+  });
+}
+
+// Sorts copies, so every pass sorts unsorted digits.
+double BenchStringDigitsSort() {
+  return time_per_char([](char* first, char* last) {
+    char copy[kDigitStringLength];
+    std::memcpy(copy, first, kDigitStringLength);
+    jz::sort_digits(jz::string_digit_adaptor<>{copy, kDigitStringLength});
+    return std::uint64_t(copy[kDigitStringLength / 2]) + (last - first);
+  });
+}
+
+double BenchStdSort() {
+  return time_per_char([](char* first, char* last) {
+    char copy[kDigitStringLength];
+    std::memcpy(copy, first, kDigitStringLength);
+    std::sort(copy, copy + kDigitStringLength);
+    return std::uint64_t(copy[kDigitStringLength / 2]) + (last - first);
+  });
+}
+
+// Returns random values for the wide adaptor benchmarks, with every limb
+// in use.  The uint64_t baselines work on the limbs one at a time.
+using Uint256 = std::array<std::uint64_t, 4>;
+
+const std::vector<Uint256>& random_uint256s() {
+  static const auto data = [] {
+    auto rng = std::mt19937_64{92};
+    auto values = std::vector<Uint256>(kItems / 16);
+    for (auto& value : values) {
+      for (auto& limb : value) { limb = rng(); }
+    }
+    return values;
+  }();
+  return data;
+}
+
+std::size_t wide_digits(const Uint256& value) {
+  return jz::make_wide_digit_adaptor(value).size();
+}
+
+std::size_t limb_digits(const Uint256& value) {
+  auto count = std::size_t{0};
+  for (const auto limb : value) { count += jz::count_digits(limb); }
+  return count;
+}
+
+// Times 'fxn' on each value, per digit, as counted by 'digits'.
+template <typename Fxn>
+double time_per_wide_digit(Fxn&& fxn,
+                           std::size_t (*digits)(const Uint256&)) {
+  auto total = std::size_t{0};
+  for (const auto& value : random_uint256s()) { total += digits(value); }
+  return time_per_item(random_uint256s(), fxn) *
+         double(random_uint256s().size()) / double(total);
+}
+
+double BenchWideDecode256() {
+  return time_per_wide_digit([](const Uint256& value) {
+    std::uint8_t digits[80];
+    const auto d = jz::make_wide_digit_adaptor(value);
+    d.decode(digits);
+    return std::uint64_t(digits[0]) + digits[d.size() - 1];
+  }, wide_digits);
+}
+
+double BenchUint64Decode() {
+  return time_per_wide_digit([](const Uint256& value) {
+    std::uint8_t digits[80];
+    auto count = std::size_t{0};
+    for (const auto limb : value) {
+      count += jz::decode_digits(limb, digits + count);
+    }
+    return std::uint64_t(digits[0]) + digits[count - 1];
+  }, limb_digits);
+}
+
+// Encodes the digits of each value, decoded ahead of time.
+double BenchWideEncode256() {
+  static const auto decoded = [] {
+    auto digits = std::vector<std::uint8_t>{};
+    for (const auto& value : random_uint256s()) {
+      std::uint8_t buf[80];
+      const auto d = jz::make_wide_digit_adaptor(value);
+      d.decode(buf);
+      digits.insert(digits.end(), buf, buf + d.size());
+    }
+    return digits;
+  }();
+  auto p = decoded.data();
+  return time_per_wide_digit([&p](const Uint256& value) {
+    auto copy = Uint256{};
+    const auto n = wide_digits(value);
+    jz::wide_digit_adaptor<4>{copy, n}.encode(p);
+    p = p + n == decoded.data() + decoded.size() ? decoded.data() : p + n;
+    return copy[0];
+  }, wide_digits);
+}
+
+double BenchUint64Encode() {
+  static const auto decoded = [] {
+    auto digits = std::vector<std::uint8_t>{};
+    for (const auto& value : random_uint256s()) {
+      for (const auto limb : value) {
+        std::uint8_t buf[20];
+        digits.insert(digits.end(), buf, buf + jz::decode_digits(limb, buf));
+      }
+    }
+    return digits;
+  }();
+  auto p = decoded.data();
+  return time_per_wide_digit([&p](const Uint256& value) {
+    auto sum = std::uint64_t{0};
+    for (const auto limb : value) {
+      const auto n = jz::count_digits(limb);
+      sum += jz::encode_digits(p, n);
+      p += n;
+    }
+    if (p == decoded.data() + decoded.size()) { p = decoded.data(); }
+    return sum;
+  }, limb_digits);
+}
+
+// Reads every digit through the iterators.
+double BenchWideDigitIterate256() {
+  return time_per_wide_digit([](const Uint256& value) {
+    auto sum = std::uint64_t{0};
+    for (const auto digit : jz::make_wide_digit_adaptor(value)) {
+      sum += digit;
+    }
+    return sum;
+  }, wide_digits);
+}
+
+double BenchUint64DigitIterate() {
+  return time_per_wide_digit([](const Uint256& value) {
+    auto sum = std::uint64_t{0};
+    for (const auto limb : value) {
+      for (const auto digit : digit_adaptor<const std::uint64_t>{limb}) {
+        sum += digit;
+      }
+    }
+    return sum;
+  }, limb_digits);
+}
+
+// Operands for the limb kernels, long enough for the longest report row.
+struct LimbOperands {
+  std::vector<std::uint64_t> a, a_copy, b, out;
+};
+
+constexpr std::size_t kBenchLimbs = 1024;
+
+const LimbOperands& limb_operands() {
+  static const auto operands = [] {
+    auto rng = std::mt19937_64{93};
+    auto ops = LimbOperands{};
+    for (std::size_t i = 0; i != 4096; ++i) {
+      ops.a.push_back(rng());
+      ops.b.push_back(rng());
+    }
+    ops.a_copy = ops.a;
+    ops.out.resize(ops.a.size());
+    return ops;
+  }();
+  return operands;
+}
+
+std::uint64_t* limb_out() {
+  return const_cast<std::uint64_t*>(limb_operands().out.data());
+}
+
+// Times 'fxn' on 'n'-limb operands, per limb, over about kItems limbs.
+template <typename Fxn>
+double time_per_limb(std::size_t n, Fxn&& fxn) {
+  const auto calls =
+      std::vector<std::size_t>(std::max(kItems / n, std::size_t{1}), n);
+  return time_per_item(calls, fxn) / double(n);
+}
+
+template <typename Carry>
+std::uint64_t add_limbs_with(std::size_t n) {
+  const auto& ops = limb_operands();
+  return jz::detail::add_limbs<Carry>(limb_out(), ops.a.data(),
+                                      ops.b.data(), n);
+}
+
+template <typename Carry>
+std::uint64_t subtract_limbs_with(std::size_t n) {
+  const auto& ops = limb_operands();
+  return jz::detail::subtract_limbs<Carry>(limb_out(), ops.a.data(),
+                                           ops.b.data(), n);
+}
+
+// Compares equal operands, which scans every limb.
+std::uint64_t compare_equal_limbs(std::size_t n) {
+  const auto& ops = limb_operands();
+  return std::uint64_t(jz::compare_limbs(ops.a.data(), ops.a_copy.data(), n));
+}
+
+template <typename Carry>
+std::uint64_t multiply_limbs_with(std::size_t n) {
+  const auto& ops = limb_operands();
+  return jz::detail::multiply_limbs<Carry>(limb_out(), ops.a.data(), n,
+                                           ops.b[0], 0);
+}
+
+using jz::detail::native_carry;
+using jz::detail::portable_carry;
+
+double BenchLimbAdd() {
+  return time_per_limb(kBenchLimbs, add_limbs_with<native_carry>);
+}
+
+double BenchLimbAddPortable() {
+  return time_per_limb(kBenchLimbs, add_limbs_with<portable_carry>);
+}
+
+double BenchLimbSubtract() {
+  return time_per_limb(kBenchLimbs, subtract_limbs_with<native_carry>);
+}
+
+double BenchLimbCompare() {
+  return time_per_limb(kBenchLimbs, compare_equal_limbs);
+}
+
+double BenchLimbMultiply() {
+  return time_per_limb(kBenchLimbs, multiply_limbs_with<native_carry>);
+}
+
+double BenchLimbMultiplyPortable() {
+  return time_per_limb(kBenchLimbs, multiply_limbs_with<portable_carry>);
+}
+
+// Returns TSC ticks per nanosecond, measured against steady_clock, or 0
+// where there's no TSC.  The TSC ticks at the nominal clock rate, so with
+// turbo or power saving these are reference cycles, not core cycles.
+double tsc_ticks_per_ns() {
+#if JZ_HAVE_ADDCARRY
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+  const auto first = __rdtsc();
+  while (clock::now() - start < std::chrono::milliseconds(50)) {}
+  const auto last = __rdtsc();
+  const auto ns = std::chrono::duration<double, std::nano>(clock::now() -
+                                                           start);
+  return double(last - first) / ns.count();
+#else
+  return 0;
+#endif
+}
+
+// Reports each limb kernel's throughput in limbs per cycle, at lengths
+// from one std::array<std::uint64_t, 4> up to operands that spill out of L1.
+void ReportLimbThroughput() {
+  const auto ticks_per_ns = tsc_ticks_per_ns();
+  const auto unit = ticks_per_ns > 0 ? "limbs/cycle" : "limbs/ns";
+  const std::size_t lengths[] = {4, 64, 1024, 4096};
+  const struct {
+    const char* name;
+    std::uint64_t (*kernel)(std::size_t);
+  } kernels[] = {
+    {"add_limbs", add_limbs_with<native_carry>},
+    {"add_limbs (portable)", add_limbs_with<portable_carry>},
+    {"subtract_limbs", subtract_limbs_with<native_carry>},
+    {"subtract_limbs (portable)", subtract_limbs_with<portable_carry>},
+    {"compare_limbs", compare_equal_limbs},
+    {"multiply_limbs", multiply_limbs_with<native_carry>},
+    {"multiply_limbs (portable)", multiply_limbs_with<portable_carry>},
+  };
+
+  std::cout << std::left << std::setw(26) << unit << std::right;
+  for (const auto n : lengths) {
+    std::cout << std::setw(8) << n;
+  }
+  std::cout << '\n';
+  for (const auto& kernel : kernels) {
+    std::cout << std::left << std::setw(26) << kernel.name << std::right
+              << std::fixed << std::setprecision(2);
+    for (const auto n : lengths) {
+      const auto ns = time_per_limb(n, kernel.kernel);
+      std::cout << std::setw(8)
+                << 1 / (ticks_per_ns > 0 ? ns * ticks_per_ns : ns);
+    }
+    std::cout << '\n';
+  }
+}
+
+// Returns a random number of 'digits' decimal digits.  The deque keeps
+// earlier numbers in place as it grows.
+const jz::big_digits<>& random_big(std::size_t digits) {
+  static auto cache = std::deque<std::pair<std::size_t, jz::big_digits<>>>{};
+  for (const auto& entry : cache) {
+    if (entry.first == digits) {
+      return entry.second;
+    }
+  }
+  auto rng = std::mt19937_64{digits};
+  auto text = std::string(digits, '0');
+  for (auto& c : text) {
+    c = char('0' + rng() % 10);
+  }
+  text[0] = '1';
+  cache.emplace_back(digits, jz::big_digits<>{text});
+  return cache.back().second;
+}
+
+// Times one 'digits' by 'digits' multiply, in milliseconds, as the best of
+// as many as fit in about a tenth of a second, and at least one.
+double time_big_multiply(std::size_t digits,
+                         const jz::big_multiply_options& options) {
+  using clock = std::chrono::steady_clock;
+  const auto& a = random_big(digits);
+  const auto& b = random_big(digits + 1);
+  auto best = 0.0, spent = 0.0;
+  for (int run = 0; run == 0 || spent < 100; ++run) {
+    const auto start = clock::now();
+    const auto product = jz::big_multiply(a, b, options);
+    const auto ms = std::chrono::duration<double, std::milli>(clock::now() -
+                                                              start).count();
+    sink = product.limbs().back();
+    best = run == 0 ? ms : std::min(best, ms);
+    spent += ms;
+  }
+  return best;
+}
+
+// Options that force one algorithm for every multiply it can do.
+jz::big_multiply_options forced_multiply(std::size_t karatsuba,
+                                         std::size_t toom3, std::size_t ntt,
+                                         unsigned threads = 1) {
+  auto options = jz::big_multiply_options{};
+  options.karatsuba_limbs = karatsuba;
+  options.toom3_limbs = toom3;
+  options.ntt_limbs = ntt;
+  options.threads = threads;
+  return options;
+}
+
+constexpr std::size_t kNever = ~std::size_t{0};
+
+double BenchBigMultiply1k() {
+  const auto calls = std::vector<std::size_t>(64, 1000);
+  return time_per_item(calls, [](std::size_t digits) {
+    const auto& a = random_big(digits);
+    return jz::big_multiply(a, a).limbs().back();
+  });
+}
+
+double BenchBigMultiply10k() {
+  const auto calls = std::vector<std::size_t>(8, 10000);
+  return time_per_item(calls, [](std::size_t digits) {
+    const auto& a = random_big(digits);
+    return jz::big_multiply(a, a).limbs().back();
+  });
+}
+
+// The same, with the operands, product and scratch in the thread's arena,
+// reset after each multiply as a batch would.
+double BenchBigMultiply10kArena() {
+  using arena_digits =
+      jz::big_digits<10, jz::arena_allocator<std::uint64_t>>;
+  const auto calls = std::vector<std::size_t>(8, 10000);
+  return time_per_item(calls, [](std::size_t digits) {
+    auto last = std::uint64_t{0};
+    {
+      const auto& limbs = random_big(digits).limbs();
+      const auto a = arena_digits{
+          arena_digits::limbs_type(limbs.begin(), limbs.end())};
+      last = jz::big_multiply(a, a).limbs().back();
+    }
+    jz::digit_arena::thread_arena().reset();
+    return last;
+  });
+}
+
+// A million-digit number, for the copy-on-write cases.
+jz::cow_digits<>& cow_million() {
+  static auto number = jz::cow_digits<>{random_big(1000000)};
+  return number;
+}
+
+// Hands a reader a version of a million-digit number:  an O(1) snapshot,
+// against a full copy of a big_digits.
+double BenchCowSnapshot1M() {
+  const auto calls = std::vector<int>(1 << 16, 0);
+  return time_per_item(calls, [](int) {
+    const auto snap = cow_million().snapshot();
+    return snap.size();
+  });
+}
+
+double BenchBigDigitsCopy1M() {
+  const auto calls = std::vector<int>(64, 0);
+  return time_per_item(calls, [](int) {
+    const auto copy = random_big(1000000);
+    return copy.limbs().back();
+  });
+}
+
+// Snapshots, then writes one digit, which copies one page.
+double BenchCowWriteAfterSnapshot1M() {
+  const auto calls = std::vector<std::size_t>(1 << 12, 0);
+  return time_per_item(calls, [](std::size_t) {
+    auto& number = cow_million();
+    const auto snap = number.snapshot();
+    number[12345] = number[12345] + 1;
+    return snap.size();
+  });
+}
+
+// Reports milliseconds per multiply of two numbers of about N digits, for
+// each algorithm as far up as it finishes in reasonable time, and for the
+// default choice.  Each algorithm still hands pieces shorter than
+// karatsuba_limbs to schoolbook multiplication.
+void ReportBigMultiply() {
+  const std::size_t sizes[] = {1000, 10000, 100000, 1000000, 10000000};
+  const auto tuned = jz::big_multiply_options{};
+  const struct {
+    const char* name;
+    jz::big_multiply_options options;
+    std::size_t max_digits;
+  } methods[] = {
+    {"schoolbook", forced_multiply(kNever, kNever, kNever), 100000},
+    {"karatsuba", forced_multiply(tuned.karatsuba_limbs, kNever, kNever),
+     1000000},
+    {"toom-3", forced_multiply(tuned.karatsuba_limbs, tuned.karatsuba_limbs,
+                               kNever), 1000000},
+    {"ntt", forced_multiply(tuned.karatsuba_limbs, kNever, 1), kNever},
+    {"ntt, 3 threads",
+     forced_multiply(tuned.karatsuba_limbs, kNever, 1, 3), kNever},
+    {"default", tuned, kNever},
+  };
+
+  std::cout << std::left << std::setw(20) << "ms/multiply" << std::right;
+  for (const auto digits : sizes) {
+    std::cout << std::setw(12) << digits;
+  }
+  std::cout << '\n';
+  for (const auto& method : methods) {
+    std::cout << std::left << std::setw(20) << method.name << std::right
+              << std::fixed << std::setprecision(3);
+    for (const auto digits : sizes) {
+      if (digits > method.max_digits) {
+        std::cout << std::setw(12) << "-";
+      } else {
+        std::cout << std::setw(12)
+                  << time_big_multiply(digits, method.options);
+      }
+    }
+    std::cout << '\n';
+  }
+}
+
+// Writes 'bytes' worth of random uint32 values to 'path'.
+void write_random_uint32_file(const char* path, std::size_t bytes) {
+  auto rng = std::mt19937{0xf11e};
+  auto values = std::vector<std::uint32_t>(bytes / sizeof(std::uint32_t));
+  for (auto& value : values) { value = rng() >> (rng() % 32); }
+
+  const auto f = std::fopen(path, "wb");
+  std::fwrite(values.data(), sizeof values[0], values.size(), f);
+  std::fclose(f);
+}
+
+double BenchDigitFileReverseUint32() {
+  const auto in = "/tmp/digit_adaptor_bench.u32";
+  const auto out = "/tmp/digit_adaptor_bench.u32.out";
+  write_random_uint32_file(in, 64 << 20);
+
+  auto stats = jz::digit_file_stats{};
+  jz::transform_digit_file<std::uint32_t>(
+      in, out, jz::digit_file_op::reverse_digits,
+      std::thread::hardware_concurrency(), &stats);
+
+  std::remove(in);
+  std::remove(out);
+  return stats.seconds * 1e9 / double(stats.bytes / sizeof(std::uint32_t));
+}
+
+// Reports transform_digit_file() throughput across file sizes, where small
+// files show the fixed cost of mapping and large ones the per-value cost.
+void ReportFileThroughput() {
+  const auto in = "/tmp/digit_adaptor_bench.u32";
+  const auto out = "/tmp/digit_adaptor_bench.u32.out";
+
+  for (const auto mib : {1, 16, 256}) {
+    write_random_uint32_file(in, std::size_t(mib) << 20);
+
+    auto stats = jz::digit_file_stats{};
+    jz::transform_digit_file<std::uint32_t>(
+        in, out, jz::digit_file_op::sort_digits,
+        std::thread::hardware_concurrency(), &stats);
+
+    std::cout << "transform_digit_file sort_digits " << std::setw(4) << mib
+              << " MiB:  " << std::setw(8) << std::setprecision(1)
+              << stats.bytes_per_second() / 1e6 << " MB/s\n";
+  }
+
+  std::remove(in);
+  std::remove(out);
+}
+
+// Reports ingest_digit_file() throughput for each reader, from tmpfs and
+// from /tmp.  On tmpfs the reads are memory copies, so the gap between the
+// two readers is the syscall overhead io_uring saves.  On a disk, O_DIRECT
+// shows what the device delivers without the page cache.
+void ReportIngestThroughput() {
+  const char* const paths[] = {"/dev/shm/digit_adaptor_bench.u32",
+                               "/tmp/digit_adaptor_bench.u32"};
+  for (const auto path : paths) {
+    write_random_uint32_file(path, std::size_t{256} << 20);
+
+    for (const auto use_io_uring : {false, true}) {
+      for (const auto direct : {false, true}) {
+        auto options = jz::digit_ingest_options{};
+        options.use_io_uring = use_io_uring;
+        options.direct = direct;
+
+        auto stats = jz::digit_ingest_stats{};
+        auto checksum = std::uint32_t{0};
+        const auto error = jz::ingest_digit_file<std::uint32_t>(
+            path, jz::digit_file_op::reverse_digits,
+            [&checksum](const std::uint32_t* first,
+                        const std::uint32_t* last) {
+              for (; first != last; ++first) { checksum ^= *first; }
+            },
+            options, &stats);
+        sink = checksum;
+
+        std::cout << "ingest_digit_file " << std::left << std::setw(34)
+                  << path << std::setw(6)
+                  << (stats.used_io_uring ? "uring" : "pread")
+                  << std::setw(7) << (stats.used_direct ? "direct" : "")
+                  << std::right << std::setw(8) << std::setprecision(1);
+        if (error != 0) {
+          std::cout << "error " << error << '\n';
+        } else {
+          std::cout << stats.bytes_per_second() / 1e6 << " MB/s\n";
+        }
+      }
+    }
+
+    std::remove(path);
+  }
+}
+
+// Moves batches of values to a worker process and back, with up to 'depth'
+// batches in flight, and returns each batch's round trip in nanoseconds.
+// The worker sorts each value's digits.  One goes through a shm_digit_ring,
+// and the other through a pair of pipes, which is the baseline.
+constexpr std::size_t kIpcBatch = 256;
+
+std::vector<double> shm_ring_round_trips(std::size_t batches,
+                                         std::size_t depth) {
+  const auto name = "/digit_adaptor_bench." + std::to_string(::getpid());
+  jz::shm_digit_ring<> ring{name.c_str(), 16, kIpcBatch};
+  std::cout.flush();
+  const auto pid = ::fork();
+  if (pid == 0) {
+    jz::shm_digit_ring<> worker{name.c_str()};
+    while (!worker.finished()) {
+      if (!worker.try_process()) { std::this_thread::yield(); }
+    }
+    ::_exit(0);
+  }
+
+  auto values = std::vector<std::uint64_t>(kIpcBatch);
+  auto rng = std::mt19937_64{86};
+  for (auto& value : values) { value = rng(); }
+
+  auto latencies = std::vector<double>{};
+  auto sent_at = std::deque<std::chrono::steady_clock::time_point>{};
+  const auto reap = [&](std::uint64_t, const std::uint64_t* first,
+                        const std::uint64_t*) {
+    sink = *first;
+    latencies.push_back(std::chrono::duration<double, std::nano>(
+        std::chrono::steady_clock::now() - sent_at.front()).count());
+    sent_at.pop_front();
+  };
+
+  for (std::size_t sent = 0; latencies.size() != batches; ) {
+    if (sent != batches && sent_at.size() < depth) {
+      sent_at.push_back(std::chrono::steady_clock::now());
+      ring.try_push(jz::digit_file_op::sort_digits, values.data(),
+                    values.data() + values.size());
+      ++sent;
+    } else if (!ring.try_reap(reap)) {
+      std::this_thread::yield();
+    }
+  }
+  ring.close();
+  ::waitpid(pid, nullptr, 0);
+  return latencies;
+}
+
+bool pipe_transfer(int fd, void* data, std::size_t bytes, bool writing) {
+  auto p = static_cast<unsigned char*>(data);
+  while (bytes != 0) {
+    const auto n = writing ? ::write(fd, p, bytes) : ::read(fd, p, bytes);
+    if (n <= 0) { return false; }
+    p += n;
+    bytes -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+std::vector<double> pipe_round_trips(std::size_t batches, std::size_t depth) {
+  int to_worker[2], from_worker[2];
+  if (::pipe(to_worker) != 0 || ::pipe(from_worker) != 0) {
+    return {};
+  }
+  const auto bytes = kIpcBatch * sizeof(std::uint64_t);
+
+  std::cout.flush();
+  const auto pid = ::fork();
+  if (pid == 0) {
+    ::close(to_worker[1]);
+    ::close(from_worker[0]);
+    auto batch = std::vector<std::uint64_t>(kIpcBatch);
+    while (pipe_transfer(to_worker[0], batch.data(), bytes, false)) {
+      jz::batch_digit_adaptor<std::uint64_t>{
+          batch.data(), batch.data() + batch.size()}.sort_digits();
+      pipe_transfer(from_worker[1], batch.data(), bytes, true);
+    }
+    ::_exit(0);
+  }
+  ::close(to_worker[0]);
+  ::close(from_worker[1]);
+
+  auto values = std::vector<std::uint64_t>(kIpcBatch);
+  auto rng = std::mt19937_64{86};
+  for (auto& value : values) { value = rng(); }
+  auto results = values;
+
+  // 16 batches of 2 KiB fit in a pipe's buffer, so this can't deadlock.
+  auto latencies = std::vector<double>{};
+  auto sent_at = std::deque<std::chrono::steady_clock::time_point>{};
+  for (std::size_t sent = 0; latencies.size() != batches; ) {
+    if (sent != batches && sent_at.size() < depth) {
+      sent_at.push_back(std::chrono::steady_clock::now());
+      pipe_transfer(to_worker[1], values.data(), bytes, true);
+      ++sent;
+    } else {
+      pipe_transfer(from_worker[0], results.data(), bytes, false);
+      sink = results[0];
+      latencies.push_back(std::chrono::duration<double, std::nano>(
+          std::chrono::steady_clock::now() - sent_at.front()).count());
+      sent_at.pop_front();
+    }
+  }
+  ::close(to_worker[1]);
+  ::close(from_worker[0]);
+  ::waitpid(pid, nullptr, 0);
+  return latencies;
+}
+
+// Reports throughput with the worker kept busy, and latency with one batch
+// in flight, for the shared memory ring and for pipes.
+void ReportIpcRoundTrips() {
+  using round_trips = std::vector<double> (*)(std::size_t, std::size_t);
+  const struct {
+    const char* name;
+    round_trips run;
+  } transports[] = {
+    {"shm_digit_ring", shm_ring_round_trips},
+    {"pipes",          pipe_round_trips},
+  };
+
+  for (const auto& transport : transports) {
+    constexpr std::size_t kBatches = 20000;
+    const auto start = std::chrono::steady_clock::now();
+    transport.run(kBatches, 16);
+    const auto seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    auto latencies = transport.run(kBatches, 1);
+    std::sort(latencies.begin(), latencies.end());
+    const auto at = [&latencies](double p) {
+      return latencies[static_cast<std::size_t>(
+          p * double(latencies.size() - 1))] / 1e3;
+    };
+
+    std::cout << std::left << std::setw(16) << transport.name << std::right
+              << std::setprecision(1) << std::setw(8)
+              << double(kBatches * kIpcBatch) / seconds / 1e6
+              << " M values/s   round trip p50 " << std::setw(6) << at(0.5)
+              << " us  p99 " << std::setw(6) << at(0.99) << " us\n";
+  }
+}
+
+// Reports how many keys share a bucket in a power-of-2 hash table with as
+// many buckets as keys, compared to the expectation for a random function.
+// Keys are consecutive numbers of a fixed width, which is where weak hashes
+// tend to cluster.  Permutation hashes deliberately map many of these keys
+// to the same value, so compare those against each other.
+template <typename Hash>
+void ReportHashCollisions(const char* name, Hash&& hash) {
+  constexpr auto kBuckets = std::size_t{1} << 20;
+
+  auto keys = std::vector<DigitKey>{};
+  keys.reserve(kBuckets);
+  for (std::size_t i = 0; i != kBuckets; ++i) {
+    keys.push_back({i, 8});
+  }
+
+  auto full = std::unordered_set<std::size_t>{};
+  auto buckets = std::vector<std::uint32_t>(kBuckets);
+  for (const auto& key : keys) {
+    const auto h = hash(key);
+    full.insert(h);
+    ++buckets[h & (kBuckets - 1)];
+  }
+
+  const auto used = static_cast<std::size_t>(
+      std::count_if(buckets.begin(), buckets.end(),
+                    [](std::uint32_t n) { return n != 0; }));
+  const auto expected =
+      kBuckets * (1.0 - std::exp(-double(keys.size()) / double(kBuckets)));
+
+  std::cout << std::left << std::setw(36) << name << std::right
+            << "  distinct hashes: " << std::setw(8) << full.size()
+            << "  buckets used: " << std::setw(8) << used
+            << " (random: " << std::setw(8) << std::size_t(expected) << ")"
+            << "  max load: "
+            << *std::max_element(buckets.begin(), buckets.end()) << '\n';
+}
+
+// The common digit operations, written once over any range of digits, so
+// each strategy below runs the same algorithm.  'zero' is what the range
+// holds for the digit 0:  0 in an adaptor, and '0' in a string.  Ops that
+// rearrange digits return 0, and the strategy returns the new number.
+struct SwapEnds {
+  static constexpr bool kRearranges = true;
+  template <typename It>
+  static std::uint64_t apply(It first, It last, int) {
+    std::iter_swap(first, last - 1);
+    return 0;
+  }
+};
+
+struct ReverseDigits {
+  static constexpr bool kRearranges = true;
+  template <typename It>
+  static std::uint64_t apply(It first, It last, int) {
+    std::reverse(first, last);
+    return 0;
+  }
+};
+
+struct SortDigits {
+  static constexpr bool kRearranges = true;
+  template <typename It>
+  static std::uint64_t apply(It first, It last, int) {
+    std::sort(first, last);
+    return 0;
+  }
+};
+
+struct SumDigits {
+  static constexpr bool kRearranges = false;
+  template <typename It>
+  static std::uint64_t apply(It first, It last, int zero) {
+    auto sum = 0;
+    for (; first != last; ++first) { sum += *first - zero; }
+    return std::uint64_t(sum);
+  }
+};
+
+struct CountSevens {
+  static constexpr bool kRearranges = false;
+  template <typename It>
+  static std::uint64_t apply(It first, It last, int zero) {
+    return std::uint64_t(std::count(first, last, zero + 7));
+  }
+};
+
+template <typename Op, typename T>
+std::uint64_t op_via_adaptor(T value) {
+  auto digits = digit_adaptor<T>{value};
+  const auto result = Op::apply(digits.begin(), digits.end(), 0);
+  return Op::kRearranges ? value : result;
+}
+
+template <typename Op, typename T>
+std::uint64_t op_via_to_string(T value) {
+  auto s = std::to_string(value);
+  const auto result = Op::apply(s.begin(), s.end(), '0');
+  if (!Op::kRearranges) {
+    return result;
+  }
+  auto out = T{};
+  std::from_chars(s.data(), s.data() + s.size(), out);
+  return out;
+}
+
+template <typename Op, typename T>
+std::uint64_t op_via_to_chars(T value) {
+  char buf[24];
+  const auto end = std::to_chars(buf, buf + sizeof buf, value).ptr;
+  const auto result = Op::apply(buf, end, '0');
+  if (!Op::kRearranges) {
+    return result;
+  }
+  auto out = T{};
+  std::from_chars(buf, end, out);
+  return out;
+}
+
+// Prints one row of ReportStringBaselines():  the time for each strategy,
+// and the fastest.
+template <typename Op, typename T>
+void ReportDigitOp(const char* op, const char* type, std::size_t length,
+                   const std::vector<T>& values) {
+  const double ns[] = {
+    time_per_item(values, op_via_adaptor<Op, T>),
+    time_per_item(values, op_via_to_string<Op, T>),
+    time_per_item(values, op_via_to_chars<Op, T>),
+  };
+  const char* names[] = {"adaptor", "to_string", "to_chars"};
+  const auto best = std::min_element(std::begin(ns), std::end(ns)) - ns;
+
+  std::cout << std::left << std::setw(12) << op << std::setw(10) << type
+            << std::right << std::setw(3) << length << " digits"
+            << std::fixed << std::setprecision(2);
+  for (const auto t : ns) { std::cout << std::setw(11) << t; }
+  std::cout << "   " << names[best] << '\n';
+}
+
+template <typename T>
+void ReportDigitOps(const char* type, std::size_t length) {
+  auto random = jz::digit_random<T>{
+      jz::uniform_digit_lengths(length, length), length};
+  auto values = std::vector<T>(kItems / 8);
+  random.generate(values.data(), values.data() + values.size());
+
+  ReportDigitOp<SwapEnds>("swap ends", type, length, values);
+  ReportDigitOp<ReverseDigits>("reverse", type, length, values);
+  ReportDigitOp<SortDigits>("sort", type, length, values);
+  ReportDigitOp<SumDigits>("digit sum", type, length, values);
+  ReportDigitOp<CountSevens>("count 7s", type, length, values);
+}
+
+// Reports ns/item for each common digit operation done three ways:  with
+// digit_adaptor, with a std::to_string and std::from_chars round trip, and
+// with std::to_chars into a stack buffer.  Rearranging ops convert back to
+// a number; the others just read the digits.
+void ReportStringBaselines() {
+  std::cout << std::left << std::setw(32) << "digit op, ns/item" << std::right
+            << std::setw(11) << "adaptor" << std::setw(11) << "to_string"
+            << std::setw(11) << "to_chars" << "   fastest\n";
+  for (const auto length : {2, 5, 9}) {
+    ReportDigitOps<std::uint32_t>("uint32_t", length);
+  }
+  for (const auto length : {2, 5, 10, 19}) {
+    ReportDigitOps<std::uint64_t>("uint64_t", length);
+  }
+}
+
+// Declares our set of benchmark cases.
+#define BENCH_CASE(x, type, radix) BenchCase{ #x, #type, radix, x }
+const BenchCase benches[] = {
+  BENCH_CASE(BenchDoubleShortestDecimal, double, 10),
+  BENCH_CASE(BenchDoubleAdaptorDigits, double, 10),
+  BENCH_CASE(BenchDoubleToChars, double, 10),
+  BENCH_CASE(BenchDoubleAdaptorLeadingDigit, double, 10),
+  BENCH_CASE(BenchShortDoubleAdaptorDigits, double, 10),
+  BENCH_CASE(BenchShortDoubleToChars, double, 10),
+  BENCH_CASE(BenchFloatShortestDecimal, float, 10),
+  BENCH_CASE(BenchFloatAdaptorDigits, float, 10),
+  BENCH_CASE(BenchFloatToChars, float, 10),
+  BENCH_CASE(BenchDigitHash, uint64_t, 10),
+  BENCH_CASE(BenchStringHash, uint64_t, 10),
+  BENCH_CASE(BenchDigitPermutationHash, uint64_t, 10),
+  BENCH_CASE(BenchSortedStringHash, uint64_t, 10),
+  BENCH_CASE(BenchTrieBuildPerKey, uint64_t, 10),
+  BENCH_CASE(BenchTriePrefixQuery, uint64_t, 10),
+  BENCH_CASE(BenchSortedStringPrefixQuery, uint64_t, 10),
+  BENCH_CASE(BenchSignatureIndexBuildPerKey, uint64_t, 10),
+  BENCH_CASE(BenchSignatureIndexOpen, uint64_t, 10),
+  BENCH_CASE(BenchSignatureIndexQuery, uint64_t, 10),
+  BENCH_CASE(BenchSortAndScanQuery, uint64_t, 10),
+  BENCH_CASE(BenchDigitPatternFixedSpan, uint64_t, 10),
+  BENCH_CASE(BenchRegexFixedToString, uint64_t, 10),
+  BENCH_CASE(BenchDigitPatternStarSpan, uint64_t, 10),
+  BENCH_CASE(BenchRegexStarToString, uint64_t, 10),
+  BENCH_CASE(BenchDigitFileReverseUint32, uint32_t, 10),
+  BENCH_CASE(BenchDigitRandomUniformLengths, uint64_t, 10),
+  BENCH_CASE(BenchDigitRandomBenford, uint64_t, 10),
+  BENCH_CASE(BenchDigitRandomFixedWidth, uint64_t, 10),
+  BENCH_CASE(BenchRejectBenford, uint64_t, 10),
+  BENCH_CASE(BenchStringDigitsValid, char, 10),
+  BENCH_CASE(BenchStdAllOfValid, char, 10),
+  BENCH_CASE(BenchStringDigitsCount, char, 10),
+  BENCH_CASE(BenchStdCount, char, 10),
+  BENCH_CASE(BenchStringDigitsHistogram, char, 10),
+  BENCH_CASE(BenchScalarHistogram, char, 10),
+  BENCH_CASE(BenchStringDigitsReverse, char, 10),
+  BENCH_CASE(BenchStdReverse, char, 10),
+  BENCH_CASE(BenchStringDigitsSort, char, 10),
+  BENCH_CASE(BenchStdSort, char, 10),
+  BENCH_CASE(BenchWideDecode256, uint256, 10),
+  BENCH_CASE(BenchUint64Decode, uint64_t, 10),
+  BENCH_CASE(BenchWideEncode256, uint256, 10),
+  BENCH_CASE(BenchUint64Encode, uint64_t, 10),
+  BENCH_CASE(BenchFormatNoTables, uint64_t, 10),
+  BENCH_CASE(BenchFormatPowerTables, uint64_t, 10),
+  BENCH_CASE(BenchFormatPairTables, uint64_t, 10),
+  BENCH_CASE(BenchFormatQuadTables, uint64_t, 10),
+  BENCH_CASE(BenchDecodeNoTables, uint64_t, 10),
+  BENCH_CASE(BenchDecodePowerTables, uint64_t, 10),
+  BENCH_CASE(BenchDecodePairTables, uint64_t, 10),
+  BENCH_CASE(BenchDecodeQuadTables, uint64_t, 10),
+  BENCH_CASE(BenchAdaptorCopyDigits, uint64_t, 10),
+  BENCH_CASE(BenchAdaptorDecodeDigits, uint64_t, 10),
+  BENCH_CASE(BenchAdaptorLastDigit, uint64_t, 10),
+  BENCH_CASE(BenchWideDigitIterate256, uint256, 10),
+  BENCH_CASE(BenchUint64DigitIterate, uint64_t, 10),
+  BENCH_CASE(BenchLimbAdd, uint64_t, 10),
+  BENCH_CASE(BenchLimbAddPortable, uint64_t, 10),
+  BENCH_CASE(BenchLimbSubtract, uint64_t, 10),
+  BENCH_CASE(BenchLimbCompare, uint64_t, 10),
+  BENCH_CASE(BenchLimbMultiply, uint64_t, 10),
+  BENCH_CASE(BenchLimbMultiplyPortable, uint64_t, 10),
+  BENCH_CASE(BenchBigMultiply1k, big_digits, 10),
+  BENCH_CASE(BenchBigMultiply10k, big_digits, 10),
+  BENCH_CASE(BenchBigMultiply10kArena, big_digits, 10),
+  BENCH_CASE(BenchCowSnapshot1M, cow_digits, 10),
+  BENCH_CASE(BenchBigDigitsCopy1M, big_digits, 10),
+  BENCH_CASE(BenchCowWriteAfterSnapshot1M, cow_digits, 10),
+  BENCH_CASE(BenchDigitRecordEncode, uint64_t, 10),
+  BENCH_CASE(BenchDigitRecordDecode, uint64_t, 10),
+  BENCH_CASE(BenchDigitColumnEncode, uint64_t, 10),
+  BENCH_CASE(BenchDigitColumnDecode, uint64_t, 10),
+  BENCH_CASE(BenchAsciiEncode, uint64_t, 10),
+  BENCH_CASE(BenchAsciiDecode, uint64_t, 10),
+  BENCH_CASE(BenchBcdEncode, uint64_t, 10),
+  BENCH_CASE(BenchBcdDecode, uint64_t, 10),
+};
+
+struct BenchOptions {
+  int         repeat = 1;
+  int         warmup = 0;
+  int         cpu = -1;
+  const char* filter = nullptr;
+  const char* json = nullptr;
+  bool        reports = true;
+};
+
+// Holds every sample for one case.
+struct BenchResult {
+  std::string         name;
+  std::string         type;
+  int                 radix = 10;
+  std::vector<double> samples;
+};
+
+double median(std::vector<double> values) {
+  if (values.empty()) {
+    return 0;
+  }
+  const auto mid = values.size() / 2;
+  std::nth_element(values.begin(), values.begin() + mid, values.end());
+  if (values.size() % 2 != 0) {
+    return values[mid];
+  }
+  return (values[mid] + *std::max_element(values.begin(),
+                                          values.begin() + mid)) / 2;
+}
+
+// Returns the median absolute deviation from the median.
+double median_deviation(const std::vector<double>& values) {
+  const auto m = median(values);
+  auto deviations = values;
+  for (auto& d : deviations) { d = std::fabs(d - m); }
+  return median(deviations);
+}
+
+// Returns the two-sided p-value of a Mann-Whitney U test that 'a' and 'b'
+// come from the same distribution, from the normal approximation with a
+// correction for ties.  Returns 1 when there are too few samples to tell.
+double mann_whitney_p(const std::vector<double>& a,
+                      const std::vector<double>& b) {
+  const auto n1 = double(a.size()), n2 = double(b.size());
+  if (a.size() < 3 || b.size() < 3) {
+    return 1;
+  }
+
+  // Ranks the pooled samples, giving ties their average rank.
+  auto pooled = std::vector<std::pair<double, int>>{};
+  for (const auto x : a) { pooled.push_back({x, 0}); }
+  for (const auto x : b) { pooled.push_back({x, 1}); }
+  std::sort(pooled.begin(), pooled.end());
+
+  auto rank_sum_a = 0.0, ties = 0.0;
+  for (std::size_t i = 0; i != pooled.size();) {
+    auto j = i;
+    while (j != pooled.size() && pooled[j].first == pooled[i].first) { ++j; }
+    const auto rank = (double(i) + double(j) + 1) / 2;
+    const auto t = double(j - i);
+    ties += t * t * t - t;
+    for (; i != j; ++i) {
+      rank_sum_a += pooled[i].second == 0 ? rank : 0;
+    }
+  }
+
+  const auto n = n1 + n2;
+  const auto u = rank_sum_a - n1 * (n1 + 1) / 2;
+  const auto variance = n1 * n2 / 12 * ((n + 1) - ties / (n * (n - 1)));
+  if (variance <= 0) {
+    return 1;
+  }
+  const auto z = std::max(0.0, std::fabs(u - n1 * n2 / 2) - 0.5) /
+                 std::sqrt(variance);
+  return std::erfc(z / std::sqrt(2.0));
+}
+
+// Pins this process to 'cpu'.  Returns 0, or an errno value.
+int pin_to_cpu(int cpu) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return ::sched_setaffinity(0, sizeof set, &set) == 0 ? 0 : errno;
+}
+
+void write_json(std::ostream& out, const BenchOptions& options,
+                const std::vector<BenchResult>& results) {
+  out << "{\n  \"repeat\": " << options.repeat << ",\n  \"warmup\": "
+      << options.warmup << ",\n  \"cpu\": " << options.cpu
+      << ",\n  \"cases\": [\n" << std::setprecision(6) << std::defaultfloat;
+  for (std::size_t i = 0; i != results.size(); ++i) {
+    const auto& r = results[i];
+    out << "    {\"name\": \"" << r.name << "\", \"type\": \"" << r.type
+        << "\", \"radix\": " << r.radix << ", \"median\": "
+        << median(r.samples) << ", \"mad\": " << median_deviation(r.samples)
+        << ", \"samples\": [";
+    for (std::size_t k = 0; k != r.samples.size(); ++k) {
+      out << (k ? ", " : "") << r.samples[k];
+    }
+    out << "]}" << (i + 1 != results.size() ? "," : "") << '\n';
+  }
+  out << "  ]\n}\n";
+}
+
+// Returns the text after "key": in 'line', or nullptr.
+const char* json_field(const std::string& line, const char* key) {
+  const auto quoted = std::string{"\""} + key + "\":";
+  const auto at = line.find(quoted);
+  if (at == std::string::npos) {
+    return nullptr;
+  }
+  auto p = line.c_str() + at + quoted.size();
+  while (*p == ' ') { ++p; }
+  return p;
+}
+
+// Reads a file that write_json() wrote.  This isn't a general JSON parser:
+// it relies on the cases being the only objects with a "name", and on
+// their fields holding no braces.  Returns false if the file can't be read,
+// or has no cases.
+bool read_json(const char* path, std::vector<BenchResult>& results) {
+  std::ifstream in{path};
+  auto line = std::string{};
+  while (std::getline(in, line, '{')) {
+    const auto name = json_field(line, "name");
+    const auto type = json_field(line, "type");
+    const auto radix = json_field(line, "radix");
+    auto samples = json_field(line, "samples");
+    if (!name || !type || !radix || !samples || *name != '"' ||
+        *type != '"' || *samples != '[') {
+      continue;
+    }
+
+    auto result = BenchResult{};
+    result.name.assign(name + 1, std::strchr(name + 1, '"'));
+    result.type.assign(type + 1, std::strchr(type + 1, '"'));
+    result.radix = std::atoi(radix);
+    for (++samples; *samples != ']' && *samples != '\0';) {
+      char* end;
+      result.samples.push_back(std::strtod(samples, &end));
+      if (end == samples) {
+        return false;
+      }
+      samples = end + std::strspn(end, ", ");
+    }
+    results.push_back(std::move(result));
+  }
+  return !results.empty();
+}
+
+// Runs the selected cases, and prints each one's median and MAD.
+std::vector<BenchResult> run_benches(const BenchOptions& options) {
+  auto results = std::vector<BenchResult>{};
+  for (const auto& bench : benches) {
+    if (options.filter && !std::strstr(bench.name, options.filter)) {
+      continue;
+    }
+
+    auto result = BenchResult{bench.name, bench.type, bench.radix, {}};
+    for (int i = 0; i != options.warmup; ++i) {
+      bench.bench();
+    }
+    for (int i = 0; i != options.repeat; ++i) {
+      result.samples.push_back(bench.bench());
+    }
+
+    std::cout << std::left << std::setw(36) << bench.name
+              << std::right << std::setw(10) << std::fixed
+              << std::setprecision(2) << median(result.samples)
+              << " ns/item";
+    if (options.repeat > 1) {
+      std::cout << "  +/- " << std::setw(6)
+                << median_deviation(result.samples) << " MAD";
+    }
+    std::cout << '\n';
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+// Prints each case in both files, old and new medians, and the change.
+// Returns the number of significant regressions.
+int compare_results(const std::vector<BenchResult>& old_results,
+                    const std::vector<BenchResult>& new_results,
+                    double threshold, double alpha) {
+  std::cout << std::left << std::setw(36) << "case" << std::setw(10)
+            << "type" << std::right << std::setw(6) << "radix"
+            << std::setw(12) << "old ns" << std::setw(12) << "new ns"
+            << std::setw(10) << "change" << std::setw(10) << "p" << '\n';
+
+  auto regressions = 0;
+  for (const auto& now : new_results) {
+    const auto then = std::find_if(
+        old_results.begin(), old_results.end(), [&](const BenchResult& r) {
+          return r.name == now.name && r.type == now.type &&
+                 r.radix == now.radix;
+        });
+    if (then == old_results.end()) {
+      continue;
+    }
+
+    const auto old_ns = median(then->samples);
+    const auto new_ns = median(now.samples);
+    const auto change = old_ns > 0 ? (new_ns - old_ns) / old_ns : 0;
+    const auto p = mann_whitney_p(then->samples, now.samples);
+    const auto significant = p < alpha && std::fabs(change) > threshold;
+    regressions += significant && change > 0;
+
+    std::cout << std::left << std::setw(36) << now.name << std::setw(10)
+              << now.type << std::right << std::setw(6) << now.radix
+              << std::fixed << std::setprecision(2) << std::setw(12)
+              << old_ns << std::setw(12) << new_ns << std::setw(9)
+              << std::showpos << change * 100 << std::noshowpos << '%'
+              << std::setprecision(4) << std::setw(10) << p
+              << (!significant ? "" : change > 0 ? "  REGRESSION"
+                                                 : "  improved")
+              << '\n';
+  }
+  return regressions;
+}
+
+void RunReports() {
+  std::cout << '\n';
+  ReportHashCollisions("digit_hash", hash_via_digit_hash);
+  ReportHashCollisions("std::hash<std::string>", hash_via_string);
+  ReportHashCollisions("digit_permutation_hash", hash_via_permutation_hash);
+  ReportHashCollisions("sorted std::hash<std::string>",
+                       hash_via_sorted_string);
+
+  std::cout << '\n';
+  ReportStringBaselines();
+
+  std::cout << '\n';
+  ReportFileThroughput();
+  ReportIngestThroughput();
+
+  std::cout << '\n';
+  ReportIpcRoundTrips();
+
+  std::cout << '\n';
+  ReportSerialSizes();
+
+  std::cout << '\n';
+  ReportTableBytes();
+  ReportTablePolicies();
+
+  std::cout << '\n';
+  ReportLimbThroughput();
+
+  std::cout << '\n';
+  ReportBigMultiply();
+}
+
+int usage() {
+  std::cerr <<
+      "usage: digit_adaptor_bench [--repeat N] [--warmup N] [--cpu N] "
+      "[--filter TEXT]\n"
+      "                           [--json FILE] [--no-reports]\n"
+      "       digit_adaptor_bench --compare OLD.json NEW.json "
+      "[--threshold PERCENT]\n"
+      "                           [--alpha P]\n";
+  return 2;
+}
+
+}  // namespace
+
+
+int main(int argc, char* argv[]) {
+  auto options = BenchOptions{};
+  const char* compare[2] = {nullptr, nullptr};
+  auto threshold = 5.0;
+  auto alpha = 0.01;
+
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--repeat") == 0 && has_value) {
+      options.repeat = std::max(1, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--warmup") == 0 && has_value) {
+      options.warmup = std::max(0, std::atoi(argv[++i]));
+    } else if (std::strcmp(argv[i], "--cpu") == 0 && has_value) {
+      options.cpu = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--filter") == 0 && has_value) {
+      options.filter = argv[++i];
+    } else if (std::strcmp(argv[i], "--json") == 0 && has_value) {
+      options.json = argv[++i];
+    } else if (std::strcmp(argv[i], "--no-reports") == 0) {
+      options.reports = false;
+    } else if (std::strcmp(argv[i], "--compare") == 0 && i + 2 < argc) {
+      compare[0] = argv[++i];
+      compare[1] = argv[++i];
+    } else if (std::strcmp(argv[i], "--threshold") == 0 && has_value) {
+      threshold = std::atof(argv[++i]);
+    } else if (std::strcmp(argv[i], "--alpha") == 0 && has_value) {
+      alpha = std::atof(argv[++i]);
+    } else {
+      return usage();
+    }
+  }
+
+  if (compare[0]) {
+    std::vector<BenchResult> results[2];
+    for (int f = 0; f != 2; ++f) {
+      if (!read_json(compare[f], results[f])) {
+        std::cerr << "digit_adaptor_bench: can't read results from "
+                  << compare[f] << '\n';
+        return 2;
+      }
+    }
+    return compare_results(results[0], results[1], threshold / 100,
+                           alpha) != 0;
+  }
+
+  if (options.cpu >= 0) {
+    if (const auto e = pin_to_cpu(options.cpu)) {
+      std::cerr << "digit_adaptor_bench: can't pin to CPU " << options.cpu
+                << ": " << std::strerror(e) << '\n';
+      return 1;
+    }
+  }
+
+  const auto results = run_benches(options);
+  if (options.json) {
+    std::ofstream out{options.json};
+    write_json(out, options, results);
+    if (!out) {
+      std::cerr << "digit_adaptor_bench: can't write " << options.json
+                << '\n';
+      return 1;
+    }
+  }
+
+  if (options.reports && !options.filter) {
+    RunReports();
+  }
+  return 0;
+}
@@ -1,24 +1,22 @@
 // Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
 // SPDX-License-Identifier:  CC-BY-SA-4.0
 #include "digit_adaptor.hh"
+#include "digit_test.hh"
 
+#include <algorithm>
 #include <cstdint>
-#include <iostream>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+#include <unordered_set>
 #include <utility>
+#include <vector>
 
 namespace {
 
 using jz::digit_adaptor;
-
-// This code would benefit from a proper unit-test framework.  I have not
-// included one here to keep this repository free of external dependencies.
-// Instead, I've just produced a very minimal framework.
-using TestCaseFxn = bool(void);
-
-struct TestCase {
-  const char  *name;
-  TestCaseFxn *test;
-};
+using jz::digit_signature;
 
 // Tests that we can read decimal digits via a digit-adaptor on a signed int
 // that's positive.
@@ -629,9 +627,200 @@ bool TestReversingDigits() {
   return true;
 }
 
+// Tests comparing digit adaptors as containers.
+bool TestComparingAdaptors() {
+  const int a = 1234, b = 1234, c = -1234, z = 1234;
+  const digit_adaptor<const int> da{a}, db{b}, dc{c}, dz{z, 6};
+
+  if (!(da == db)) { return false; }
+  if (da != db)    { return false; }
+  if (da != dc)    { return false; }  // Signs aren't digits.
+  if (da == dz)    { return false; }  // Leading zeros are.
+
+  return true;
+}
+
+// Tests that std::hash and jz::digit_hash agree with operator==, and keep
+// leading zeros significant.
+bool TestHashingAdaptors() {
+  const long a = 4417, b = 4417, c = 7144;
+  const digit_adaptor<const long> da{a}, db{b}, dc{c}, dz{a, 8};
+
+  const auto hash = std::hash<digit_adaptor<const long>>{};
+
+  if (hash(da) != hash(db))                 { return false; }
+  if (hash(da) != jz::digit_hash{}(da))     { return false; }
+  if (hash(da) == hash(dc))                 { return false; }
+  if (hash(da) == hash(dz))                 { return false; }
+
+  auto seen = std::unordered_set<digit_adaptor<const long>>{};
+  seen.insert(da);
+  seen.insert(db);
+  seen.insert(dz);
+  if (seen.size() != 2) { return false; }
+
+  return true;
+}
+
+// Tests that digit signatures identify permutations of the same digits.
+bool TestDigitSignatures() {
+  const int a = 8675309, b = 9035768, c = 3098675, d = 8675310;
+  const digit_adaptor<const int> da{a}, db{b}, dc{c}, dd{d}, dz{a, 9};
+
+  const digit_signature<const int> sa{da}, sb{db}, sc{dc}, sd{dd}, sz{dz};
+
+  if (sa.value() != 356789) { return false; }
+  if (sa.size() != 7)       { return false; }
+  if (sa != sb)             { return false; }
+  if (sa != sc)             { return false; }
+  if (sa == sd)             { return false; }
+  if (sa == sz)             { return false; }
+
+  // The largest 64-bit value has digits that sort to a smaller value.
+  const auto big = ~std::uint64_t{0};
+  const digit_signature<const std::uint64_t> sbig{
+      digit_adaptor<const std::uint64_t>{big}};
+  if (sbig.value() != 111344445556677789ULL) { return false; }
+  if (sbig.size() != 20)                      { return false; }
+
+  // Hex digits sort the same way.
+  const unsigned h = 0xC0FFEE;
+  const digit_signature<const unsigned, 16> sh{
+      digit_adaptor<const unsigned, 16>{h}};
+  if (sh.value() != 0xCEEFF) { return false; }
+
+  // Large radices sort by insertion rather than counting.
+  const unsigned r = 4030201;
+  const digit_signature<const unsigned, 100> sr{
+      digit_adaptor<const unsigned, 100>{r}};
+  if (sr.value() != 1020304) { return false; }
+
+  return true;
+}
+
+// Tests grouping numbers by their digits with digit_permutation_hash.
+bool TestGroupingByPermutationHash() {
+  const int values[] = {123, 321, 213, 456, 654, 1230, 3210, 231};
+
+  auto groups = std::unordered_map<digit_signature<const int>, int>{};
+  for (const auto& value : values) {
+    ++groups[digit_signature<const int>{digit_adaptor<const int>{value}}];
+  }
+
+  if (groups.size() != 3) { return false; }
+
+  const auto hash = jz::digit_permutation_hash{};
+  const digit_adaptor<const int> d0{values[0]}, d1{values[1]};
+  if (hash(d0) != hash(d1)) { return false; }
+
+  return true;
+}
+
+// Tests that digits copy out as the narrow digit_type, and still convert
+// to T.
+bool TestDigitType() {
+  static_assert(sizeof(digit_adaptor<std::uint64_t>::value_type) == 1, "");
+  static_assert(sizeof(digit_adaptor<int, 1000>::digit_type) == 2, "");
+  static_assert(std::is_same<std::iterator_traits<
+      digit_adaptor<const long>::const_iterator>::value_type,
+      std::uint8_t>::value, "");
+
+  auto x = std::uint64_t{18446744073709551615ULL};
+  const digit_adaptor<std::uint64_t> d{x};
+  auto copied = std::vector<digit_adaptor<std::uint64_t>::value_type>(20);
+  std::copy(d.begin(), d.end(), copied.begin());
+  auto decoded = copied;
+  d.decode(decoded.data());
+
+  const std::uint8_t expected[] = {1, 8, 4, 4, 6, 7, 4, 4, 0, 7,
+                                   3, 7, 0, 9, 5, 5, 1, 6, 1, 5};
+  if (!std::equal(copied.begin(), copied.end(), std::begin(expected)) ||
+      decoded != copied) {
+    return false;
+  }
+
+  const std::uint64_t first = d[0];
+  const long leading = digit_adaptor<const long>{-4417L, 6}[0];
+  int counts[10] = {};
+  jz::digit_histogram(d, counts);
+  return first == 1 && leading == 0 && counts[4] == 4 &&
+         jz::count_digit(d, 7) == 3;
+}
+
+// Returns the digit 'index' places from the least significant end, which
+// never needs the digit count.
+constexpr int digit_from_end(int x, int index) {
+  const digit_adaptor<const int> d{x, jz::uncounted};
+  return d.crbegin()[index];
+}
+
+constexpr int kConstant = 4417;
+constexpr digit_adaptor<const int> kCounted{kConstant};
+constexpr digit_adaptor<const int> kPadded{kConstant, 6};
+constexpr digit_adaptor<const int> kDeferred{kConstant, jz::uncounted};
+
+// Tests that adaptors still work in constant expressions, and that an
+// uncounted adaptor counts the number as it is whenever it's asked.
+bool TestUncountedAdaptor() {
+  static_assert(kCounted.size() == 4 && kCounted[0] == 4, "");
+  static_assert(*kCounted.begin() == 4 && *kCounted.rbegin() == 7, "");
+  static_assert(kPadded.size() == 6 && kPadded[1] == 0 && kPadded[5] == 7,
+                "");
+  static_assert(kDeferred.size() == 4 && kDeferred[3] == 7, "");
+  static_assert(digit_from_end(4417, 0) == 7, "");
+  static_assert(digit_from_end(-8675309, 3) == 5, "");
+
+  auto x = 5;
+  const digit_adaptor<int> d{x, jz::uncounted};
+  *d.rbegin() = 7;
+  d.rbegin()[2] = 3;
+  if (x != 307 || d.size() != 3) { return false; }
+
+  x = 123456;
+  if (d.size() != 6 || d[0] != 1 || *(d.end() - 1) != 6) { return false; }
+
+  auto y = 123456;
+  const digit_adaptor<int> counted{y};
+  y = 12345678;
+  if (counted.size() != 6 || d != digit_adaptor<int>{x} ||
+      std::distance(d.rbegin(), d.rend()) != 6) {
+    return false;
+  }
+
+  // A forward walk counts once, when the iterators are made.
+  auto forward = 0;
+  for (auto i = d.begin(); i != d.end(); ++i) {
+    forward = forward * 10 + *i;
+  }
+  return forward == 123456 && d.begin() + 10 == d.end();
+}
+
+// Tests that reverse iterators stop at rend(), as forward iterators stop at
+// end(), and read 0 there.
+bool TestReverseIteratorsClamp() {
+  const int x = 12345;
+  const digit_adaptor<const int> d{x};
+
+  if (d.rbegin() + 10 != d.rend()) { return false; }
+  if (std::distance(d.rbegin(), d.rbegin() + 10) != 5) { return false; }
+
+  auto i = d.rbegin();
+  for (int step = 0; step != 8; ++step) { ++i; }
+  if (i != d.rend()) { return false; }
+
+  auto j = d.rbegin();
+  j += 10;
+  if (j != d.rend() || *(d.rbegin() - 1) != 0) { return false; }
+
+  // Without a count, reverse iterators stop at the most digits an int
+  // holds, and read leading zeros up to there.
+  const digit_adaptor<const int> deferred{x, jz::uncounted};
+  return std::distance(deferred.rbegin(), deferred.rbegin() + 100) == 10 &&
+         deferred.rbegin()[7] == 0 && deferred.rbegin()[4] == 1;
+}
+
 // Declares our set of test cases.
-#define TEST_CASE(x) TestCase{ #x, x }
-const TestCase tests[] = {
+const jz::test::TestCase tests[] = {
   TEST_CASE(TestReadingDecimalDigitsFromPositiveSignedInt),
   TEST_CASE(TestReadingDecimalDigitsFromNegativeSignedInt),
   TEST_CASE(TestReadingDecimalDigitsFromUnsignedInt),
@@ -659,21 +848,18 @@ const TestCase tests[] = {
   TEST_CASE(TestReadingViaReverseIterators),
   TEST_CASE(TestSortingDigits),
   TEST_CASE(TestReversingDigits),
+  TEST_CASE(TestComparingAdaptors),
+  TEST_CASE(TestHashingAdaptors),
+  TEST_CASE(TestDigitSignatures),
+  TEST_CASE(TestGroupingByPermutationHash),
+  TEST_CASE(TestDigitType),
+  TEST_CASE(TestUncountedAdaptor),
+  TEST_CASE(TestReverseIteratorsClamp),
 };
 
 }  // namespace
 
 
 int main() {
-  int pass_cnt = 0, fail_cnt = 0;
-
-  for (const auto& test : tests) {
-    const bool passed = test.test();
-    std::cout << (passed ? "PASS     :  " : "     FAIL:  ")
-              << test.name << '\n';
-    pass_cnt += passed == true;
-    fail_cnt += passed == false;
-  }
-
-  std::cout << "Passed: " << pass_cnt << " Failed: " << fail_cnt << '\n';
+  jz::test::run_tests(tests);
 }
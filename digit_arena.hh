@@ -0,0 +1,187 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_ARENA_HH_
+#define DIGIT_ARENA_HH_
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+
+namespace jz {
+
+// A bump arena for the short-lived buffers of a batch of work:  big_digits
+// limbs, multiplication scratch, and the like.  Allocating moves a pointer
+// forward.  Deallocating the most recent allocation moves it back, so
+// scratch that's freed in the reverse order it was allocated, as recursive
+// algorithms' is, gets reused straight away.  Anything else waits for
+// reset(), which frees everything at once.
+//
+// The arena grows by chunks from the global operator new.  When a batch
+// needed more than one, reset() replaces them with one chunk as large as
+// all of them together, so once the batches settle into a size, the arena
+// stops allocating.
+//
+// An arena isn't thread safe.  thread_arena() gives each thread its own.
+class digit_arena {
+ public:
+  explicit digit_arena(std::size_t chunk_bytes = std::size_t{64} << 10)
+  : next_chunk_bytes_{chunk_bytes} {}
+
+  digit_arena(const digit_arena&)            = delete;
+  digit_arena& operator=(const digit_arena&) = delete;
+
+  ~digit_arena() { release(); }
+
+  // Returns 'bytes' bytes aligned to 'align', a power of 2.  Throws
+  // std::bad_alloc if that's more than a chunk can hold.
+  void* allocate(std::size_t bytes,
+                 std::size_t align = alignof(std::max_align_t)) {
+    auto p = align_up(top_, align);
+    if (chunk_ == nullptr || p > end_ || bytes > std::size_t(end_ - p)) {
+      if (bytes > kMaxChunkBytes - align) {
+        throw std::bad_alloc{};
+      }
+      grow(bytes + align);
+      p = align_up(top_, align);
+    }
+    top_ = p + bytes;
+    return p;
+  }
+
+  // Takes back the most recent allocation.  Anything else waits for
+  // reset().
+  void deallocate(void* p, std::size_t bytes) noexcept {
+    if (static_cast<char*>(p) + bytes == top_) {
+      top_ = static_cast<char*>(p);
+    }
+  }
+
+  // Frees everything the arena has handed out, which must no longer be in
+  // use.
+  void reset() {
+    if (chunk_ != nullptr && chunk_->prev != nullptr) {
+      const auto total = capacity();
+      release();
+      grow(total);
+    }
+    top_ = chunk_ != nullptr ? chunk_->data() : nullptr;
+  }
+
+  // Returns the bytes the arena holds, across all its chunks.
+  std::size_t capacity() const noexcept {
+    auto total = std::size_t{0};
+    for (auto c = chunk_; c != nullptr; c = c->prev) {
+      total += c->bytes;
+    }
+    return total;
+  }
+
+  // Returns the bytes handed out from the current chunk.
+  std::size_t used() const noexcept {
+    return chunk_ != nullptr ? std::size_t(top_ - chunk_->data()) : 0;
+  }
+
+  // Returns this thread's arena.
+  static digit_arena& thread_arena() {
+    thread_local digit_arena arena;
+    return arena;
+  }
+
+ private:
+  struct alignas(std::max_align_t) chunk {
+    chunk*      prev;
+    std::size_t bytes;
+
+    char* data() noexcept { return reinterpret_cast<char*>(this + 1); }
+  };
+
+  // The most a chunk can hold, with its header, in a size_t.
+  static constexpr std::size_t kMaxChunkBytes =
+      std::numeric_limits<std::size_t>::max() - sizeof(chunk);
+
+  chunk*      chunk_ = nullptr;
+  char*       top_ = nullptr;
+  char*       end_ = nullptr;
+  std::size_t next_chunk_bytes_;
+
+  static char* align_up(char* p, std::size_t align) noexcept {
+    const auto bits = reinterpret_cast<std::uintptr_t>(p);
+    return p + ((align - bits % align) % align);
+  }
+
+  // Starts a chunk with room for at least 'bytes' bytes, at most
+  // kMaxChunkBytes.  Each chunk is at least twice the last, so a growing
+  // batch needs few of them.
+  void grow(std::size_t bytes) {
+    auto size = bytes > next_chunk_bytes_ ? bytes : next_chunk_bytes_;
+    if (size > kMaxChunkBytes) {
+      size = kMaxChunkBytes;
+    }
+    const auto c = static_cast<chunk*>(::operator new(sizeof(chunk) + size));
+    c->prev = chunk_;
+    c->bytes = size;
+    chunk_ = c;
+    top_ = c->data();
+    end_ = top_ + size;
+    next_chunk_bytes_ = size < kMaxChunkBytes / 2 ? 2 * size : kMaxChunkBytes;
+  }
+
+  void release() noexcept {
+    while (chunk_ != nullptr) {
+      const auto prev = chunk_->prev;
+      ::operator delete(chunk_);
+      chunk_ = prev;
+    }
+    top_ = end_ = nullptr;
+  }
+};
+
+// A standard allocator that draws from a digit_arena, by default the
+// calling thread's.  Containers that hold one, such as
+// big_digits<RADIX, arena_allocator<std::uint64_t>>, keep their arena
+// when copied, and must be gone before it's reset.
+template <typename T>
+class arena_allocator {
+ public:
+  using value_type = T;
+
+  arena_allocator() noexcept : arena_{&digit_arena::thread_arena()} {}
+
+  explicit arena_allocator(digit_arena& arena) noexcept : arena_{&arena} {}
+
+  template <typename U>
+  arena_allocator(const arena_allocator<U>& other) noexcept
+  : arena_{other.arena()} {}
+
+  T* allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_alloc{};
+    }
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, std::size_t n) noexcept {
+    arena_->deallocate(p, n * sizeof(T));
+  }
+
+  digit_arena* arena() const noexcept { return arena_; }
+
+ private:
+  digit_arena* arena_;
+};
+
+template <typename T, typename U>
+bool operator==(const arena_allocator<T>& lhs,
+                const arena_allocator<U>& rhs) noexcept {
+  return lhs.arena() == rhs.arena();
+}
+
+template <typename T, typename U>
+bool operator!=(const arena_allocator<T>& lhs,
+                const arena_allocator<U>& rhs) noexcept {
+  return lhs.arena() != rhs.arena();
+}
+
+}  // namespace jz
+#endif // DIGIT_ARENA_HH_
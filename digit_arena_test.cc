@@ -0,0 +1,233 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_arena.hh"
+#include "big_multiply.hh"
+#include "digit_trie.hh"
+#include "digit_test.hh"
+
+// GCC flags the free() of memory from operator new once the replacements
+// below inline, which is the point of replacing both.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpragmas"
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Counts every allocation from the global heap, which the arena's chunks
+// come from, too.
+namespace {
+std::atomic<std::size_t> heap_allocations{0};
+}  // namespace
+
+void* operator new(std::size_t bytes) {
+  ++heap_allocations;
+  if (const auto p = std::malloc(bytes ? bytes : 1)) {
+    return p;
+  }
+  throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+using jz::arena_allocator;
+using jz::digit_arena;
+
+using arena_digits = jz::big_digits<10, arena_allocator<std::uint64_t>>;
+
+std::string random_digits(std::mt19937_64& rng, std::size_t n) {
+  auto text = std::string(n, '0');
+  for (auto& c : text) {
+    c = char('0' + rng() % 10);
+  }
+  return text;
+}
+
+// Tests that freeing the latest allocation gives its room back, and that
+// freeing any other waits for reset().
+bool TestLatestAllocationComesBack() {
+  digit_arena arena{1024};
+  const auto a = arena.allocate(100);
+  const auto b = arena.allocate(100);
+  arena.deallocate(b, 100);
+  if (arena.allocate(100) != b) { return false; }
+
+  arena.deallocate(a, 100);
+  const auto used = arena.used();
+  if (arena.allocate(8) == a || arena.used() <= used) { return false; }
+
+  arena.reset();
+  return arena.used() == 0 && arena.allocate(100) == a;
+}
+
+// Tests alignment, including past the end of a chunk.
+bool TestAlignment() {
+  digit_arena arena{256};
+  for (std::size_t align = 1; align <= 64; align *= 2) {
+    for (int i = 0; i != 20; ++i) {
+      arena.allocate(std::size_t(i) * 7 % 31 + 1, 1);
+      const auto p = arena.allocate(24, align);
+      if (reinterpret_cast<std::uintptr_t>(p) % align != 0) { return false; }
+    }
+  }
+  return true;
+}
+
+// Tests that a batch that overflowed into several chunks leaves one big
+// enough for all of it, so the same batch again takes nothing from the
+// heap.
+bool TestResetCoalesces() {
+  digit_arena arena{128};
+  const auto batch = [&] {
+    for (int i = 0; i != 50; ++i) {
+      arena.allocate(100);
+    }
+  };
+  batch();
+  if (arena.capacity() < 5000) { return false; }
+
+  const auto before = heap_allocations.load();
+  arena.reset();
+  const auto capacity = arena.capacity();
+  if (heap_allocations.load() != before + 1) { return false; }
+  batch();
+  arena.reset();
+  batch();
+  return heap_allocations.load() == before + 1 &&
+         arena.capacity() == capacity;
+}
+
+// Tests that products built in an arena match the heap's, for every
+// algorithm.
+bool TestArenaProductsMatch() {
+  auto rng = std::mt19937_64{95};
+  digit_arena arena;
+  const auto alloc = arena_allocator<std::uint64_t>{arena};
+
+  auto options = jz::big_multiply_options{};
+  options.karatsuba_limbs = 4;
+  options.toom3_limbs = 12;
+  options.ntt_limbs = 40;
+  for (const std::size_t n : {10, 300, 800, 3000}) {
+    const auto ta = random_digits(rng, n), tb = random_digits(rng, n + 50);
+    const auto expected = jz::big_multiply(jz::big_digits<>{ta},
+                                           jz::big_digits<>{tb}, options);
+    const auto product = jz::big_multiply(arena_digits{ta, alloc},
+                                          arena_digits{tb, alloc}, options);
+    if (product.str() != expected.str() ||
+        product.get_allocator().arena() != &arena) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tests that requests too large to fit in a chunk throw, rather than wrap
+// around to a small one, and leave the arena usable.
+bool TestHugeRequestsThrow() {
+  digit_arena arena{256};
+  const auto huge = std::numeric_limits<std::size_t>::max();
+  for (const auto bytes : {huge, huge - 8, huge - 64, huge / 2 + 1}) {
+    try {
+      arena.allocate(bytes, 64);
+      return false;
+    } catch (const std::bad_alloc&) {
+    }
+  }
+  try {
+    arena_allocator<std::uint64_t>{arena}.allocate(huge / 8);
+    return false;
+  } catch (const std::bad_alloc&) {
+  }
+  return arena.allocate(100) != nullptr;
+}
+
+// Tests that a trie built in an arena matches the heap's, and draws from
+// the arena.
+bool TestArenaTrie() {
+  auto rng = std::mt19937_64{9500};
+  auto keys = std::vector<long>(2000);
+  for (auto& key : keys) {
+    key = long(rng() % 1000000);
+  }
+  digit_arena arena;
+  const auto heap = jz::digit_trie<long>{keys.begin(), keys.end()};
+  const auto trie = jz::digit_trie<long, 10, arena_allocator<long>>{
+      keys.begin(), keys.end(), 0, arena_allocator<long>{arena}};
+  return arena.used() != 0 && trie.get_allocator().arena() == &arena &&
+         std::equal(heap.begin(), heap.end(), trie.begin(), trie.end()) &&
+         trie.find_prefix(12).size() == heap.find_prefix(12).size();
+}
+
+// Tests that batches of parsing, multiplying with each algorithm, and
+// decoding settle into taking nothing from the heap.
+bool TestSteadyStateAllocatesNothing() {
+  auto rng = std::mt19937_64{950};
+  auto texts = std::vector<std::string>{};
+  for (const std::size_t n : {20, 500, 2000, 9000}) {
+    texts.push_back(random_digits(rng, n));
+    texts.push_back(random_digits(rng, n + 40));
+  }
+  auto decoded = std::vector<std::uint8_t>(20000);
+  auto& arena = digit_arena::thread_arena();
+
+  // Schoolbook, Karatsuba, Toom-3 and the NTT, from the shortest pair up.
+  auto options = jz::big_multiply_options{};
+  options.toom3_limbs = 60;
+  options.ntt_limbs = 300;
+
+  auto before = std::size_t{0};
+  for (int batch = 0; batch != 8; ++batch) {
+    if (batch == 3) {
+      before = heap_allocations.load();
+    }
+    arena.reset();
+    for (std::size_t i = 0; i != texts.size(); i += 2) {
+      const auto a = arena_digits{texts[i]}, b = arena_digits{texts[i + 1]};
+      const auto product = jz::big_multiply(a, b, options);
+      product.decode(decoded.data());
+    }
+  }
+  return heap_allocations.load() == before;
+}
+
+// Tests that each thread's default arena is its own.
+bool TestThreadArenas() {
+  const auto mine = arena_allocator<std::uint64_t>{}.arena();
+  auto theirs = mine;
+  std::thread{[&] { theirs = arena_allocator<char>{}.arena(); }}.join();
+  return mine == &digit_arena::thread_arena() && theirs != mine &&
+         arena_allocator<char>{} == arena_allocator<std::uint64_t>{};
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestLatestAllocationComesBack),
+  TEST_CASE(TestAlignment),
+  TEST_CASE(TestResetCoalesces),
+  TEST_CASE(TestArenaProductsMatch),
+  TEST_CASE(TestHugeRequestsThrow),
+  TEST_CASE(TestArenaTrie),
+  TEST_CASE(TestSteadyStateAllocatesNothing),
+  TEST_CASE(TestThreadArenas),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,656 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_BATCH_HH_
+#define DIGIT_BATCH_HH_
+
+#include "digit_adaptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace jz {
+namespace detail {
+
+// Returns the character for a digit.  Digits past 9 are lowercase letters.
+constexpr char digit_char(int digit) noexcept {
+  return "0123456789abcdefghijklmnopqrstuvwxyz"[digit];
+}
+
+// Holds the two-character spelling of every value in [0, RADIX^2), so
+// formatting can emit two digits per division.
+template <int RADIX>
+struct alignas(kTableAlign) digit_pair_table {
+  char pairs[2 * RADIX * RADIX];
+};
+
+template <int RADIX>
+constexpr digit_pair_table<RADIX> make_digit_pair_table() noexcept {
+  digit_pair_table<RADIX> table{};
+  for (int i = 0; i != RADIX * RADIX; ++i) {
+    table.pairs[2 * i]     = digit_char(i / RADIX);
+    table.pairs[2 * i + 1] = digit_char(i % RADIX);
+  }
+  return table;
+}
+
+template <int RADIX>
+struct digit_pairs {
+  static constexpr digit_pair_table<RADIX> table =
+      make_digit_pair_table<RADIX>();
+};
+
+template <int RADIX>
+constexpr digit_pair_table<RADIX> digit_pairs<RADIX>::table;
+
+// Returns true if all eight bytes in 'chunk' are ASCII digits.
+constexpr bool is_eight_digits(std::uint64_t chunk) noexcept {
+  return ((chunk & 0xF0F0F0F0F0F0F0F0ULL) |
+          (((chunk + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4))
+      == 0x3333333333333333ULL;
+}
+
+// Converts eight ASCII digits, loaded little-endian, into their value.
+// This combines adjacent digits pairwise with multiplies, SWAR-style:
+// first into four 2-digit lanes, then two 4-digit lanes, and then one.
+constexpr std::uint32_t parse_eight_digits(std::uint64_t chunk) noexcept {
+  chunk -= 0x3030303030303030ULL;
+  chunk = (chunk * 10) + (chunk >> 8);
+  return static_cast<std::uint32_t>(
+      (((chunk & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) +
+       (((chunk >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32))))
+      >> 32);
+}
+
+// Loads eight bytes as a little-endian integer.
+inline std::uint64_t load_le64(const char* p) noexcept {
+  std::uint64_t chunk;
+  std::memcpy(&chunk, p, sizeof chunk);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  chunk = __builtin_bswap64(chunk);
+#endif
+  return chunk;
+}
+
+// Returns the number of significant bits in 'value'.
+inline int bit_length(std::uint64_t value) noexcept {
+#if defined(__GNUC__)
+  return value == 0 ? 0 : 64 - __builtin_clzll(value);
+#else
+  auto bits = 0;
+  for (; value != 0; value >>= 1) {
+    ++bits;
+  }
+  return bits;
+#endif
+}
+
+// Holds the number of RADIX digits in the smallest value of each bit
+// length.  Values of the same bit length have that many digits, or one
+// more.
+template <int RADIX>
+struct alignas(kTableAlign) digits_by_bit_length_table {
+  std::uint8_t digits[65];
+};
+
+template <int RADIX>
+constexpr digits_by_bit_length_table<RADIX>
+make_digits_by_bit_length_table() noexcept {
+  digits_by_bit_length_table<RADIX> table{};
+  table.digits[0] = 1;
+  for (int bits = 1; bits <= 64; ++bits) {
+    auto u = std::uint64_t{1} << (bits - 1);
+    auto d = std::uint8_t{0};
+    do {
+      ++d;
+      u /= RADIX;
+    } while (u != 0);
+    table.digits[bits] = d;
+  }
+  return table;
+}
+
+template <int RADIX>
+struct digits_by_bit_length {
+  static constexpr digits_by_bit_length_table<RADIX> table =
+      make_digits_by_bit_length_table<RADIX>();
+};
+
+template <int RADIX>
+constexpr digits_by_bit_length_table<RADIX>
+    digits_by_bit_length<RADIX>::table;
+
+// Holds RADIX^n and the repunit (RADIX^n - 1) / (RADIX - 1), side by side
+// so each n's pair shares a cache line, for n up to the digits in U.
+// RADIX^n wraps at the top, but only ever multiplies zero.
+template <typename U, int RADIX>
+struct alignas(kTableAlign) digit_run_table {
+  static constexpr std::size_t kCount = max_radix_digits<U, RADIX>() + 1;
+
+  struct run {
+    U power;
+    U repunit;
+  };
+  run runs[kCount];
+};
+
+template <typename U, int RADIX>
+constexpr digit_run_table<U, RADIX> make_digit_run_table() noexcept {
+  digit_run_table<U, RADIX> table{};
+  table.runs[0].power = 1;
+  for (auto n = std::size_t{1}; n != table.kCount; ++n) {
+    const auto& prev = table.runs[n - 1];
+    table.runs[n].power = static_cast<U>(prev.power * RADIX);
+    table.runs[n].repunit = static_cast<U>(prev.repunit * RADIX + 1);
+  }
+  return table;
+}
+
+template <typename W, int RADIX>
+struct digit_run_storage {
+  static constexpr digit_run_table<W, RADIX> table =
+      make_digit_run_table<W, RADIX>();
+};
+
+template <typename W, int RADIX>
+constexpr digit_run_table<W, RADIX> digit_run_storage<W, RADIX>::table;
+
+// Finds the table for U by width alone, as radix_powers does.
+template <typename U, int RADIX>
+struct digit_runs : digit_run_storage<unsigned_of_width_t<U>, RADIX> {};
+
+// Holds the N digits of every value in [0, RADIX^N), most significant
+// first, so decoding can emit N digits per division.
+template <int RADIX, int N>
+struct alignas(kTableAlign) digit_chunk_table {
+  static constexpr std::size_t kValues = N == 4
+      ? std::size_t{RADIX} * RADIX * RADIX * RADIX
+      : std::size_t{RADIX} * RADIX;
+  static_assert(kValues <= 65536,
+                "Chunk tables past 64K entries would take megabytes");
+
+  radix_digit_t<RADIX> digits[kValues][N];
+};
+
+template <int RADIX, int N>
+constexpr digit_chunk_table<RADIX, N> make_digit_chunk_table() noexcept {
+  digit_chunk_table<RADIX, N> table{};
+  for (auto v = std::size_t{0}; v != table.kValues; ++v) {
+    auto u = v;
+    for (auto i = N; i-- != 0; ) {
+      table.digits[v][i] = static_cast<radix_digit_t<RADIX>>(u % RADIX);
+      u /= RADIX;
+    }
+  }
+  return table;
+}
+
+template <int RADIX, int N>
+struct digit_chunks {
+  static constexpr digit_chunk_table<RADIX, N> table =
+      make_digit_chunk_table<RADIX, N>();
+};
+
+template <int RADIX, int N>
+constexpr digit_chunk_table<RADIX, N> digit_chunks<RADIX, N>::table;
+
+template <int N>
+using chunk_digits = std::integral_constant<int, N>;
+
+// Counts digits with the tables, as described at count_digits().
+template <int RADIX>
+std::size_t count_digits(std::uint64_t value, std::true_type) noexcept {
+  const auto& powers = radix_powers<std::uint64_t, RADIX>::table;
+  const auto& by_bits = digits_by_bit_length<RADIX>::table;
+
+  const auto digits = std::size_t{by_bits.digits[bit_length(value)]};
+  return digits + (digits < powers.kCount && value >= powers.powers[digits]);
+}
+
+// Counts digits by dividing, one per digit.
+template <int RADIX>
+std::size_t count_digits(std::uint64_t value, std::false_type) noexcept {
+  auto digits = std::size_t{0};
+  do {
+    ++digits;
+    value /= RADIX;
+  } while (value != 0);
+  return digits;
+}
+
+// Writes the digits of 'value' backward from 'end' to 'first', which is
+// where they'll end, one digit per division.
+template <int RADIX>
+void format_chunks(std::uint64_t value, char*, char* end,
+                   chunk_digits<1>) noexcept {
+  do {
+    *--end = digit_char(static_cast<int>(value % RADIX));
+    value /= RADIX;
+  } while (value != 0);
+}
+
+// Writes two digits per division, from digit_pairs.
+template <int RADIX>
+void format_chunks(std::uint64_t value, char*, char* end,
+                   chunk_digits<2>) noexcept {
+  const auto& pairs = digit_pairs<RADIX>::table.pairs;
+
+  while (value >= RADIX * RADIX) {
+    const auto pair = value % (RADIX * RADIX);
+    value /= RADIX * RADIX;
+    end -= 2;
+    std::memcpy(end, &pairs[2 * pair], 2);
+  }
+
+  if (value >= RADIX) {
+    end -= 2;
+    std::memcpy(end, &pairs[2 * value], 2);
+  } else {
+    *--end = digit_char(static_cast<int>(value));
+  }
+}
+
+// Spells 'n' digits from a digit_chunks entry.  Up to radix 10, that's
+// one add across all four bytes.
+template <int RADIX>
+void spell_digits(const radix_digit_t<RADIX>* digits, char* out,
+                  std::size_t n) noexcept {
+  if (RADIX <= 10 && n == 4) {
+    std::uint32_t spelled;
+    std::memcpy(&spelled, digits, 4);
+    spelled += 0x30303030u;
+    std::memcpy(out, &spelled, 4);
+    return;
+  }
+  for (auto i = std::size_t{0}; i != n; ++i) {
+    out[i] = digit_char(digits[i]);
+  }
+}
+
+// Writes four digits per division, from digit_chunks, and the last few
+// from the tail of one entry.
+template <int RADIX>
+void format_chunks(std::uint64_t value, char* first, char* end,
+                   chunk_digits<4>) noexcept {
+  constexpr auto kQuad = std::uint64_t{RADIX} * RADIX * RADIX * RADIX;
+  const auto& quads = digit_chunks<RADIX, 4>::table.digits;
+
+  while (value >= kQuad) {
+    const auto quad = value % kQuad;
+    value /= kQuad;
+    end -= 4;
+    spell_digits<RADIX>(quads[quad], end, 4);
+  }
+
+  const auto n = static_cast<std::size_t>(end - first);
+  spell_digits<RADIX>(quads[value] + 4 - n, first, n);
+}
+
+// Decodes the last 'count' digits of 'value' into 'digits', one digit per
+// division.
+template <int RADIX>
+void decode_chunks(std::uint64_t value, radix_digit_t<RADIX>* digits,
+                   std::size_t count, chunk_digits<1>) noexcept {
+  while (count-- != 0) {
+    digits[count] = static_cast<radix_digit_t<RADIX>>(value % RADIX);
+    value /= RADIX;
+  }
+}
+
+// Decodes N digits per division, from digit_chunks, and the last few from
+// the tail of one entry.
+template <int RADIX, int N, typename = std::enable_if_t<(N > 1)>>
+void decode_chunks(std::uint64_t value, radix_digit_t<RADIX>* digits,
+                   std::size_t count, chunk_digits<N>) noexcept {
+  constexpr auto kChunk = std::uint64_t{digit_chunk_table<RADIX, N>::kValues};
+  const auto& chunks = digit_chunks<RADIX, N>::table.digits;
+
+  while (count >= N) {
+    const auto chunk = value % kChunk;
+    value /= kChunk;
+    count -= N;
+    std::memcpy(digits + count, chunks[chunk], sizeof chunks[chunk]);
+  }
+
+  std::memcpy(digits, chunks[value] + N - count, count * sizeof *digits);
+}
+
+}  // namespace detail
+
+// Parses the RADIX digits in [first, last) into 'value'.  Letters spell
+// digits past 9, in either case.  Returns false, leaving 'value' alone, if
+// the range is empty, holds anything else, or overflows 64 bits.
+//
+// Decimal input parses eight characters per step, with SWAR arithmetic.
+template <int RADIX = 10>
+bool parse_digits(const char* first, const char* last,
+                  std::uint64_t& value) noexcept {
+  static_assert(RADIX > 1 && RADIX <= 36, "Digits are 0-9 and a-z");
+
+  constexpr auto kMax = std::numeric_limits<std::uint64_t>::max();
+  constexpr auto kMaxDigits = detail::max_radix_digits<std::uint64_t, RADIX>();
+
+  if (first == last) {
+    return false;
+  }
+
+  // Leading zeros can't overflow.
+  while (last - first > std::ptrdiff_t(kMaxDigits) && *first == '0') {
+    ++first;
+  }
+  if (last - first > std::ptrdiff_t(kMaxDigits)) {
+    return false;
+  }
+
+  // Only a number with the maximum digit count can overflow.
+  const bool may_overflow = last - first == std::ptrdiff_t(kMaxDigits);
+  auto u = std::uint64_t{0};
+
+  if (RADIX == 10) {
+    for (; last - first >= 8; first += 8) {
+      const auto chunk = detail::load_le64(first);
+      if (!detail::is_eight_digits(chunk)) {
+        return false;
+      }
+      const auto eight = detail::parse_eight_digits(chunk);
+      if (may_overflow && u > (kMax - eight) / 100000000) {
+        return false;
+      }
+      u = u * 100000000 + eight;
+    }
+  }
+
+  for (; first != last; ++first) {
+    const char c = *first;
+    const unsigned d = c >= '0' && c <= '9' ? unsigned(c - '0')
+                     : c >= 'a' && c <= 'z' ? unsigned(c - 'a' + 10)
+                     : c >= 'A' && c <= 'Z' ? unsigned(c - 'A' + 10)
+                     : unsigned(RADIX);
+    if (d >= unsigned(RADIX) ||
+        (may_overflow && u > (kMax - d) / RADIX)) {
+      return false;
+    }
+    u = u * RADIX + d;
+  }
+
+  value = u;
+  return true;
+}
+
+// Returns the number of RADIX digits in 'value', with 0 having 1 digit.
+// The value's bit length bounds its digit count to one of two neighbors,
+// and one comparison against the power table picks between them.  Under
+// no_tables, this divides by RADIX until nothing's left.
+template <int RADIX = 10, typename Tables = pair_tables>
+std::size_t count_digits(std::uint64_t value) noexcept {
+  return detail::count_digits<RADIX>(value, typename Tables::powers{});
+}
+
+// Writes the RADIX digits of 'value' to 'out', most significant first, and
+// returns the end of the output.  This emits Tables::kChunkDigits digits
+// per division.  'out' needs room for count_digits<RADIX>(value)
+// characters.
+template <int RADIX = 10, typename Tables = pair_tables>
+char* format_digits(std::uint64_t value, char* out) noexcept {
+  static_assert(RADIX > 1 && RADIX <= 36, "Digits are 0-9 and a-z");
+
+  const auto end = out + count_digits<RADIX, Tables>(value);
+  detail::format_chunks<RADIX>(value, out, end,
+                               detail::chunk_digits<Tables::kChunkDigits>{});
+  return end;
+}
+
+// Decodes the RADIX digits of 'value' into 'digits', most significant
+// first, and returns the number of digits.  This decodes
+// Tables::kChunkDigits digits per division.  'digits' needs room for
+// count_digits<RADIX>(value) entries.
+template <int RADIX = 10, typename Tables = pair_tables>
+std::size_t decode_digits(std::uint64_t value,
+                          radix_digit_t<RADIX>* digits) noexcept {
+  const auto count = count_digits<RADIX, Tables>(value);
+  detail::decode_chunks<RADIX>(value, digits, count,
+                               detail::chunk_digits<Tables::kChunkDigits>{});
+  return count;
+}
+
+// Encodes 'count' RADIX digits, most significant first, into a value.
+// Results wider than 64 bits wrap.
+template <int RADIX = 10>
+std::uint64_t encode_digits(const radix_digit_t<RADIX>* digits,
+                            std::size_t count) noexcept {
+  auto value = std::uint64_t{0};
+  for (auto i = std::size_t{0}; i != count; ++i) {
+    value = value * RADIX + digits[i];
+  }
+  return value;
+}
+
+// Adapts a span of integers for digit operations applied to every element,
+// like running a digit_adaptor over each one in turn.  The operations work
+// on each value's magnitude, with as many digits as it needs, and keep its
+// sign.  As with digit_adaptor, a result too large for T wraps.
+//
+// The point is throughput:  each operation is a tight loop over the span,
+// on plain arithmetic, rather than a walk through proxy references.
+// Every operation divides only by RADIX.  Tables decides whether
+// sort_digits looks up its runs of equal digits, and is passed on to the
+// adaptors operator[] returns.
+template <typename T, int RADIX = 10, typename Tables = power_tables>
+class batch_digit_adaptor {
+  static_assert(RADIX > 1, "RADIX must be larger than 1");
+  static_assert(std::is_integral<std::remove_cv_t<T>>::value,
+                "T must be an integer type");
+
+ public:
+  using value_type = std::remove_cv_t<T>;
+
+  batch_digit_adaptor(T* first, T* last) noexcept
+  : first_{first}, last_{last} {}
+
+  T* begin() const noexcept { return first_; }
+  T* end()   const noexcept { return last_; }
+
+  std::size_t size() const noexcept {
+    return static_cast<std::size_t>(last_ - first_);
+  }
+
+  // Returns a digit_adaptor on one element.
+  digit_adaptor<T, RADIX, Tables> operator[](std::size_t index) const
+      noexcept {
+    return digit_adaptor<T, RADIX, Tables>{first_[index]};
+  }
+
+  // Reverses the digits of every value, as std::reverse on its adaptor
+  // would.  Trailing zeros become leading zeros, and vanish.
+  void reverse_digits() const noexcept {
+    reverse_digits(first_);
+  }
+
+  // Writes each value with its digits reversed to 'out', leaving the span
+  // as is.
+  template <typename OutputIt>
+  OutputIt reverse_digits(OutputIt out) const {
+    for (auto p = first_; p != last_; ++p) {
+      auto u = magnitude(*p);
+      auto reversed = NCU{0};
+      do {
+        reversed = static_cast<NCU>(reversed * RADIX + u % RADIX);
+        u /= RADIX;
+      } while (u != 0);
+      *out++ = with_sign(*p, reversed);
+    }
+    return out;
+  }
+
+  // Sorts the digits of every value into ascending order, as std::sort on
+  // its adaptor would.
+  //
+  // When a count for every digit fits in one 64-bit word, this counts the
+  // digits in packed bit fields, and then emits each run of equal digits
+  // in one multiply-add, as digit * 11...1.  Under no_tables, it appends
+  // the digits one at a time instead.  Without packed counts, it falls
+  // back on digit_signature.
+  void sort_digits() const noexcept {
+    sort_digits(first_);
+  }
+
+  // Writes each value with its digits sorted to 'out', leaving the span as
+  // is.
+  template <typename OutputIt>
+  OutputIt sort_digits(OutputIt out) const {
+    return sort_digits(out, std::integral_constant<bool, kPackedCounts>{});
+  }
+
+  // Writes the sum of each value's digits to 'out'.
+  template <typename OutputIt>
+  OutputIt digit_sums(OutputIt out) const {
+    for (auto p = first_; p != last_; ++p) {
+      auto u = magnitude(*p);
+      auto sum = NCU{0};
+      do {
+        sum += u % RADIX;
+        u /= RADIX;
+      } while (u != 0);
+      *out++ = sum;
+    }
+    return out;
+  }
+
+  // Writes the Luhn check digit for each value to 'out':  the digit that,
+  // appended to the value, makes its Luhn sum a multiple of RADIX.  For
+  // decimal, this is the familiar credit card check digit.
+  template <typename OutputIt>
+  OutputIt check_digits(OutputIt out) const {
+    for (auto p = first_; p != last_; ++p) {
+      auto u = magnitude(*p);
+      auto sum = unsigned{0};
+      for (bool twice = true; u != 0; twice = !twice) {
+        auto d = static_cast<unsigned>(u % RADIX);
+        u /= RADIX;
+        if (twice) {
+          d *= 2;
+          d = d / RADIX + d % RADIX;
+        }
+        sum += d;
+      }
+      *out++ = static_cast<value_type>((RADIX - sum % RADIX) % RADIX);
+    }
+    return out;
+  }
+
+  // Adds the number of times each digit appears to 'counts', which must
+  // hold RADIX entries.
+  template <typename Count>
+  void histogram(Count* counts) const noexcept {
+    for (auto p = first_; p != last_; ++p) {
+      auto u = magnitude(*p);
+      do {
+        ++counts[u % RADIX];
+        u /= RADIX;
+      } while (u != 0);
+    }
+  }
+
+ private:
+  using NCU = std::make_unsigned_t<value_type>;
+
+  static constexpr std::size_t kMaxDigits =
+      detail::max_radix_digits<NCU, RADIX>();
+
+  // Bits per digit count, for packed counting.
+  static constexpr int kCountBits =
+      kMaxDigits < 16 ? 4 : kMaxDigits < 32 ? 5 : kMaxDigits < 64 ? 6 : 7;
+  static constexpr bool kPackedCounts = RADIX * kCountBits <= 64;
+
+  T* first_;
+  T* last_;
+
+  static constexpr auto kCountMask = (std::uint64_t{1} << kCountBits) - 1;
+
+  template <typename OutputIt>
+  OutputIt sort_digits(OutputIt out,
+                       std::true_type /* packed counts */) const {
+    return sort_digits(out, std::true_type{}, typename Tables::powers{});
+  }
+
+  template <typename OutputIt>
+  OutputIt sort_digits(OutputIt out, std::true_type /* packed counts */,
+                       std::true_type /* powers */) const {
+    const auto& runs = detail::digit_runs<NCU, RADIX>::table.runs;
+
+    for (auto p = first_; p != last_; ++p) {
+      const auto counts = count_digits(magnitude(*p));
+
+      // Zeros sort to the front, and vanish.  An empty run multiplies by 1
+      // and adds 0, so there's no need to branch on it.
+      auto sorted = NCU{0};
+      for (int digit = 1; digit != RADIX; ++digit) {
+        const auto n = (counts >> (digit * kCountBits)) & kCountMask;
+        sorted = static_cast<NCU>(sorted * runs[n].power +
+                                  digit * runs[n].repunit);
+      }
+      *out++ = with_sign(*p, sorted);
+    }
+    return out;
+  }
+
+  template <typename OutputIt>
+  OutputIt sort_digits(OutputIt out, std::true_type /* packed counts */,
+                       std::false_type /* powers */) const {
+    for (auto p = first_; p != last_; ++p) {
+      const auto counts = count_digits(magnitude(*p));
+
+      auto sorted = NCU{0};
+      for (int digit = 1; digit != RADIX; ++digit) {
+        auto n = (counts >> (digit * kCountBits)) & kCountMask;
+        for (; n != 0; --n) {
+          sorted = static_cast<NCU>(sorted * RADIX + digit);
+        }
+      }
+      *out++ = with_sign(*p, sorted);
+    }
+    return out;
+  }
+
+  // Counts each digit of 'u' in a kCountBits-wide field of the result.
+  static std::uint64_t count_digits(NCU u) noexcept {
+    auto counts = std::uint64_t{0};
+    do {
+      counts += std::uint64_t{1} << ((u % RADIX) * kCountBits);
+      u /= RADIX;
+    } while (u != 0);
+    return counts;
+  }
+
+  template <typename OutputIt>
+  OutputIt sort_digits(OutputIt out,
+                       std::false_type /* packed counts */) const {
+    for (auto p = first_; p != last_; ++p) {
+      const value_type value = *p;
+      const digit_signature<const value_type, RADIX> signature{
+          digit_adaptor<const value_type, RADIX, Tables>{value}};
+      *out++ = with_sign(value, signature.value());
+    }
+    return out;
+  }
+
+  static NCU magnitude(value_type value) noexcept {
+    return detail::magnitude(value);
+  }
+
+  static value_type with_sign(value_type original, NCU u) noexcept {
+    return static_cast<value_type>(original < 0 ? NCU(-u) : u);
+  }
+};
+
+// Returns a batch_digit_adaptor over [first, last).
+template <int RADIX = 10, typename Tables = power_tables, typename T>
+batch_digit_adaptor<T, RADIX, Tables> make_batch_digit_adaptor(
+    T* first, T* last) noexcept {
+  return batch_digit_adaptor<T, RADIX, Tables>{first, last};
+}
+
+}  // namespace jz
+#endif // DIGIT_BATCH_HH_
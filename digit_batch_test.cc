@@ -0,0 +1,295 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_batch.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using jz::batch_digit_adaptor;
+using jz::digit_adaptor;
+
+template <int RADIX = 10>
+bool parses(const char* text, std::uint64_t expected) {
+  auto value = std::uint64_t{~expected};
+  return jz::parse_digits<RADIX>(text, text + std::strlen(text), value) &&
+         value == expected;
+}
+
+template <int RADIX = 10>
+bool rejects(const char* text) {
+  auto value = std::uint64_t{4417};
+  return !jz::parse_digits<RADIX>(text, text + std::strlen(text), value) &&
+         value == 4417;
+}
+
+// Tests decimal parsing, on both sides of the eight-character SWAR steps.
+bool TestParseDecimal() {
+  if (!parses("0", 0))                                   { return false; }
+  if (!parses("7", 7))                                   { return false; }
+  if (!parses("12345678", 12345678))                     { return false; }
+  if (!parses("123456789", 123456789))                   { return false; }
+  if (!parses("9876543210123456", 9876543210123456ULL))  { return false; }
+  if (!parses("18446744073709551615", UINT64_MAX))       { return false; }
+  if (!parses("000000000000000000000042", 42))           { return false; }
+
+  if (!rejects(""))                      { return false; }
+  if (!rejects("18446744073709551616"))  { return false; }
+  if (!rejects("99999999999999999999"))  { return false; }
+  if (!rejects("123456789012345678901")) { return false; }
+  if (!rejects("1234x678"))              { return false; }
+  if (!rejects("12345678/"))             { return false; }
+  if (!rejects("-1"))                    { return false; }
+  if (!rejects("1234567:"))              { return false; }
+
+  return true;
+}
+
+// Tests parsing in other radices, where letters are digits.
+bool TestParseOtherRadices() {
+  if (!parses<16>("ffffffffffffffff", UINT64_MAX)) { return false; }
+  if (!parses<16>("DeadBeef", 0xDEADBEEF))         { return false; }
+  if (!parses<2>("101", 5))                        { return false; }
+  if (!parses<36>("zz", 36 * 36 - 1))              { return false; }
+
+  if (!rejects<16>("10000000000000000")) { return false; }
+  if (!rejects<8>("8"))                  { return false; }
+  if (!rejects<16>("g"))                 { return false; }
+
+  return true;
+}
+
+// Tests formatting against std::to_string, and in other radices.
+bool TestFormatDigits() {
+  auto rng = std::mt19937_64{82};
+  char buf[64];
+
+  for (int i = 0; i != 10000; ++i) {
+    const auto value = rng() >> (rng() % 64);
+    const auto end = jz::format_digits(value, buf);
+    if (std::string(buf, end) != std::to_string(value)) { return false; }
+  }
+
+  if (std::string(buf, jz::format_digits<16>(0xBEEF, buf)) != "beef") {
+    return false;
+  }
+  if (std::string(buf, jz::format_digits<2>(5, buf)) != "101") {
+    return false;
+  }
+  if (std::string(buf, jz::format_digits<2>(UINT64_MAX, buf))
+      != std::string(64, '1')) {
+    return false;
+  }
+
+  return true;
+}
+
+// Tests that decoding and encoding round-trip.
+bool TestDecodeEncode() {
+  std::uint8_t digits[64];
+
+  if (jz::decode_digits(8675309, digits) != 7) { return false; }
+  if (digits[0] != 8 || digits[6] != 9)        { return false; }
+  if (jz::encode_digits(digits, 7) != 8675309) { return false; }
+
+  if (jz::decode_digits(0, digits) != 1 || digits[0] != 0) { return false; }
+
+  const auto n = jz::decode_digits<7>(UINT64_MAX, digits);
+  return jz::encode_digits<7>(digits, n) == UINT64_MAX;
+}
+
+// Tests each batch operation against the same work done through
+// digit_adaptor and the standard algorithms.
+bool TestBatchMatchesAdaptor() {
+  auto rng = std::mt19937_64{8675309};
+  auto values = std::vector<long>{};
+  for (int i = 0; i != 1000; ++i) {
+    const auto value = static_cast<long>(rng() % 100000000000LL);
+    values.push_back(i % 3 == 0 ? -value : value);
+  }
+  values.push_back(0);
+  values.push_back(1000);
+
+  auto reversed = values, sorted = values;
+  batch_digit_adaptor<long>{reversed.data(), reversed.data() + reversed.size()}
+      .reverse_digits();
+  jz::make_batch_digit_adaptor(sorted.data(), sorted.data() + sorted.size())
+      .sort_digits();
+
+  const auto batch = jz::make_batch_digit_adaptor(
+      values.data(), values.data() + values.size());
+  auto sums = std::vector<long>{};
+  batch.digit_sums(std::back_inserter(sums));
+
+  long counts[10] = {};
+  batch.histogram(counts);
+
+  long expected_counts[10] = {};
+  for (std::size_t i = 0; i != values.size(); ++i) {
+    auto value = values[i];
+    auto digits = digit_adaptor<long>{value};
+
+    for (const auto d : digits) { ++expected_counts[d]; }
+    if (sums[i] != std::accumulate(digits.begin(), digits.end(), 0L)) {
+      return false;
+    }
+
+    std::reverse(digits.begin(), digits.end());
+    if (reversed[i] != value) { return false; }
+
+    value = values[i];
+    std::sort(digits.begin(), digits.end());
+    if (sorted[i] != value) { return false; }
+  }
+
+  return std::equal(std::begin(counts), std::end(counts),
+                    std::begin(expected_counts));
+}
+
+// Tests Luhn check digits on known card-style numbers.
+bool TestCheckDigits() {
+  unsigned long long values[] = {7992739871ULL, 453201511283036ULL, 0};
+  auto checks = std::vector<unsigned long long>{};
+  jz::make_batch_digit_adaptor(std::begin(values), std::end(values))
+      .check_digits(std::back_inserter(checks));
+
+  return checks == std::vector<unsigned long long>{3, 6, 0};
+}
+
+// Returns true if every table policy formats, decodes and counts 'value'
+// the same way.
+template <int RADIX, typename... Tables>
+bool policies_agree(std::uint64_t value) {
+  char expected[65], text[65];
+  std::uint8_t expected_digits[64], digits[64];
+  const auto length =
+      jz::format_digits<RADIX, jz::no_tables>(value, expected) - expected;
+  jz::decode_digits<RADIX, jz::no_tables>(value, expected_digits);
+
+  const bool agree[] = {
+    (jz::count_digits<RADIX, Tables>(value) == std::size_t(length) &&
+     jz::format_digits<RADIX, Tables>(value, text) - text == length &&
+     std::equal(text, text + length, expected) &&
+     jz::decode_digits<RADIX, Tables>(value, digits) ==
+         std::size_t(length) &&
+     std::equal(digits, digits + length, expected_digits))...
+  };
+  return std::all_of(std::begin(agree), std::end(agree),
+                     [](bool b) { return b; });
+}
+
+// Tests that every table policy gives the same digits, on both kernels and
+// the adaptor.
+bool TestTablePolicies() {
+  auto rng = std::mt19937_64{98};
+  for (int i = 0; i != 5000; ++i) {
+    const auto value = i < 100 ? std::uint64_t(i) : rng() >> (rng() % 64);
+    if (!policies_agree<10, jz::power_tables, jz::pair_tables,
+                        jz::quad_tables>(value) ||
+        !policies_agree<16, jz::power_tables, jz::pair_tables,
+                        jz::quad_tables>(value) ||
+        !policies_agree<7, jz::pair_tables, jz::quad_tables>(value) ||
+        !policies_agree<2, jz::pair_tables, jz::quad_tables>(value) ||
+        !policies_agree<36, jz::pair_tables>(value)) {
+      return false;
+    }
+  }
+  char buf[20];
+  if (std::string(buf, jz::format_digits<10, jz::no_tables>(UINT64_MAX, buf))
+      != "18446744073709551615") {
+    return false;
+  }
+
+  auto value = -9876543210L;
+  const auto fixed = digit_adaptor<long, 10, jz::no_tables>{value};
+  auto reference = -9876543210L;
+  const auto tabled = digit_adaptor<long>{reference};
+  if (!std::equal(fixed.begin(), fixed.end(), tabled.begin(), tabled.end())) {
+    return false;
+  }
+  std::sort(fixed.begin(), fixed.end());
+
+  std::vector<long> values(2000);
+  for (auto& v : values) {
+    v = static_cast<long>(rng() >> (rng() % 64));
+  }
+  auto computed = values;
+  jz::make_batch_digit_adaptor<10, jz::no_tables>(
+      computed.data(), computed.data() + computed.size()).sort_digits();
+  jz::make_batch_digit_adaptor<10>(
+      values.data(), values.data() + values.size()).sort_digits();
+  if (computed != values) {
+    return false;
+  }
+
+  return value == -123456789L &&
+         std::hash<digit_adaptor<long, 10, jz::no_tables>>{}(fixed) ==
+             std::hash<digit_adaptor<long>>{}(digit_adaptor<long>{value, 10});
+}
+
+// Returns true if 'table' starts on a cache line.
+template <typename Table>
+bool line_aligned(const Table& table) {
+  return reinterpret_cast<std::uintptr_t>(&table) % 64 == 0;
+}
+
+// Tests that tables are shared by every type of the same width, and start
+// on a cache line.
+bool TestSharedTables() {
+  using jz::detail::digit_runs;
+  using jz::detail::radix_powers;
+
+  const auto& powers = radix_powers<unsigned long long, 10>::table;
+  const auto& runs = digit_runs<unsigned long long, 10>::table;
+  if (sizeof(long) == sizeof(long long) &&
+      (static_cast<const void*>(&radix_powers<unsigned long, 10>::table) !=
+           &powers ||
+       static_cast<const void*>(&digit_runs<unsigned long, 10>::table) !=
+           &runs)) {
+    return false;
+  }
+  if (static_cast<const void*>(&radix_powers<unsigned, 16>::table) !=
+      &radix_powers<std::uint32_t, 16>::table) {
+    return false;
+  }
+
+  if (!line_aligned(powers) || !line_aligned(runs) ||
+      !line_aligned(radix_powers<unsigned char, 10>::table) ||
+      !line_aligned(jz::detail::digit_pairs<10>::table) ||
+      !line_aligned(jz::detail::digits_by_bit_length<10>::table)) {
+    return false;
+  }
+
+  return powers.kCount == 20 && powers.powers[19] == 10000000000000000000ULL &&
+         runs.kCount == 21 && runs.runs[3].power == 1000 &&
+         runs.runs[3].repunit == 111 &&
+         radix_powers<unsigned char, 10>::table.kCount == 3 &&
+         jz::detail::radix_power<unsigned char, 10>(2) == 100;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestParseDecimal),
+  TEST_CASE(TestParseOtherRadices),
+  TEST_CASE(TestFormatDigits),
+  TEST_CASE(TestDecodeEncode),
+  TEST_CASE(TestBatchMatchesAdaptor),
+  TEST_CASE(TestCheckDigits),
+  TEST_CASE(TestSharedTables),
+  TEST_CASE(TestTablePolicies),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,157 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_FILE_PIPELINE_HH_
+#define DIGIT_FILE_PIPELINE_HH_
+
+#include "digit_batch.hh"
+#include "mapped_file.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <sys/stat.h>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#error "digit_file_pipeline.hh maps little-endian files in place, and \
+requires a little-endian host"
+#endif
+
+namespace jz {
+
+// Selects the operation transform_digit_file() applies to each value.  Each
+// one produces one value of the same type per input value.
+enum class digit_file_op {
+  reverse_digits,  // batch_digit_adaptor::reverse_digits()
+  sort_digits,     // batch_digit_adaptor::sort_digits()
+  digit_sums,      // batch_digit_adaptor::digit_sums()
+  check_digits,    // batch_digit_adaptor::check_digits()
+};
+
+// Reports how long transform_digit_file() took.
+struct digit_file_stats {
+  std::uint64_t bytes = 0;     // Size of the input file.
+  std::uint64_t chunks = 0;    // Chunks processed.
+  double        seconds = 0;   // Wall time, mapping through unmapping.
+
+  double bytes_per_second() const noexcept {
+    return seconds > 0 ? double(bytes) / seconds : 0;
+  }
+};
+
+namespace detail {
+
+// Applies 'op' to [first, last), writing results to 'out'.
+template <typename T, int RADIX>
+void apply_digit_file_op(digit_file_op op, const T* first, const T* last,
+                         T* out) noexcept {
+  const auto batch = batch_digit_adaptor<const T, RADIX>{first, last};
+  switch (op) {
+    case digit_file_op::reverse_digits: batch.reverse_digits(out); break;
+    case digit_file_op::sort_digits:    batch.sort_digits(out);    break;
+    case digit_file_op::digit_sums:     batch.digit_sums(out);     break;
+    case digit_file_op::check_digits:   batch.check_digits(out);   break;
+  }
+}
+
+// Returns true if 'a' and 'b' both exist and name the same file, whether
+// through the same path or another link to it.
+inline bool same_file(const char* a, const char* b) noexcept {
+  struct stat sa, sb;
+  return ::stat(a, &sa) == 0 && ::stat(b, &sb) == 0 &&
+         sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+}
+
+}  // namespace detail
+
+// Transforms a flat file of little-endian T values into a file of the same
+// layout, holding the result of 'op' on each value.  Returns 0 on success,
+// or an errno value on failure.  An input whose size isn't a multiple of
+// sizeof(T) is EINVAL, and so is an output that names the input:  creating
+// the output truncates it, so transforming in place would wipe the input.
+//
+// Both files are memory-mapped, and the workers read straight from the
+// input mapping and write straight into the output mapping, so values are
+// never copied through an intermediate buffer.  Workers claim fixed-size
+// chunks from a shared counter, which keeps them busy when some chunks run
+// slower than others.  Results reach the file through the page cache when
+// the output is unmapped.  Callers that need them on disk should fsync.
+template <typename T, int RADIX = 10>
+int transform_digit_file(
+    const char* input, const char* output, digit_file_op op,
+    unsigned threads = std::thread::hardware_concurrency(),
+    digit_file_stats* stats = nullptr) {
+  static_assert(std::is_integral<T>::value && !std::is_const<T>::value,
+                "T must be a non-const integer type");
+
+  // Large enough to amortize the claim, small enough to balance the load.
+  constexpr std::size_t kChunkBytes = std::size_t{1} << 20;
+  constexpr std::size_t kChunkValues = kChunkBytes / sizeof(T);
+
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+
+  auto in = mapped_file{input};
+  if (!in) {
+    return in.error();
+  }
+  if (in.size() % sizeof(T) != 0 || detail::same_file(input, output)) {
+    return EINVAL;
+  }
+
+  auto out = mapped_file{output, in.size()};
+  if (!out) {
+    return out.error();
+  }
+
+  in.advise_sequential();
+  in.advise_huge_pages();
+  out.advise_huge_pages();
+
+  const auto count = in.size() / sizeof(T);
+  const auto chunks = (count + kChunkValues - 1) / kChunkValues;
+  const auto src = reinterpret_cast<const T*>(in.data());
+  const auto dst = reinterpret_cast<T*>(out.data());
+
+  std::atomic<std::size_t> next{0};
+  const auto work = [&] {
+    for (auto chunk = next++; chunk < chunks; chunk = next++) {
+      const auto first = chunk * kChunkValues;
+      const auto last = std::min(count, first + kChunkValues);
+      detail::apply_digit_file_op<T, RADIX>(op, src + first, src + last,
+                                            dst + first);
+    }
+  };
+
+  threads = static_cast<unsigned>(
+      std::max<std::size_t>(1, std::min<std::size_t>(threads, chunks)));
+  auto workers = std::vector<std::thread>{};
+  for (unsigned i = 1; i < threads; ++i) {
+    workers.emplace_back(work);
+  }
+  work();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+
+  out = mapped_file{};
+  in = mapped_file{};
+
+  if (stats) {
+    stats->bytes = count * sizeof(T);
+    stats->chunks = chunks;
+    stats->seconds =
+        std::chrono::duration<double>(clock::now() - start).count();
+  }
+
+  return 0;
+}
+
+}  // namespace jz
+#endif // DIGIT_FILE_PIPELINE_HH_
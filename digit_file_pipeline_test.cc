@@ -0,0 +1,190 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_file_pipeline.hh"
+#include "digit_test.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+using jz::digit_file_op;
+using jz::transform_digit_file;
+
+// Returns a scratch file name unique to this process, and removes the file
+// when it goes out of scope.
+class scratch_file {
+ public:
+  explicit scratch_file(const char* tag)
+  : path_{"/tmp/digit_file_pipeline_test." + std::to_string(::getpid())
+          + "." + tag} {}
+
+  ~scratch_file() { std::remove(path_.c_str()); }
+
+  const char* c_str() const { return path_.c_str(); }
+
+ private:
+  std::string path_;
+};
+
+template <typename T>
+bool write_values(const scratch_file& path, const std::vector<T>& values) {
+  const auto f = std::fopen(path.c_str(), "wb");
+  if (!f) { return false; }
+  const auto n = values.empty() ? 0 : std::fwrite(values.data(), sizeof(T),
+                                                 values.size(), f);
+  return std::fclose(f) == 0 && n == values.size();
+}
+
+template <typename T>
+std::vector<T> read_values(const scratch_file& path) {
+  auto values = std::vector<T>{};
+  const auto f = std::fopen(path.c_str(), "rb");
+  if (!f) { return values; }
+  T value;
+  while (std::fread(&value, sizeof value, 1, f) == 1) {
+    values.push_back(value);
+  }
+  std::fclose(f);
+  return values;
+}
+
+// Runs 'op' through a file and in memory, and compares the results.  The
+// value count spans several chunks, with a partial chunk at the end.
+template <typename T, int RADIX = 10>
+bool MatchesInMemory(digit_file_op op, unsigned threads) {
+  const scratch_file in{"in"}, out{"out"};
+  auto rng = std::mt19937_64{83};
+  auto values = std::vector<T>(3 * (1 << 20) / sizeof(T) + 17);
+  for (auto& value : values) {
+    value = static_cast<T>(rng() >> (rng() % 64));
+  }
+  if (!write_values(in, values)) { return false; }
+
+  auto stats = jz::digit_file_stats{};
+  if (transform_digit_file<T, RADIX>(in.c_str(), out.c_str(), op, threads,
+                                     &stats) != 0) {
+    return false;
+  }
+  if (stats.bytes != values.size() * sizeof(T) || stats.chunks != 4) {
+    return false;
+  }
+
+  auto expected = values;
+  const auto batch = jz::batch_digit_adaptor<T, RADIX>{
+      expected.data(), expected.data() + expected.size()};
+  switch (op) {
+    case digit_file_op::reverse_digits: batch.reverse_digits();        break;
+    case digit_file_op::sort_digits:    batch.sort_digits();           break;
+    case digit_file_op::digit_sums:
+      batch.digit_sums(expected.begin());
+      break;
+    case digit_file_op::check_digits:
+      batch.check_digits(expected.begin());
+      break;
+  }
+
+  return read_values<T>(out) == expected;
+}
+
+bool TestReverseUint32() {
+  return MatchesInMemory<std::uint32_t>(digit_file_op::reverse_digits, 3);
+}
+
+bool TestSortUint64() {
+  return MatchesInMemory<std::uint64_t>(digit_file_op::sort_digits, 2);
+}
+
+bool TestDigitSumsOctal() {
+  return MatchesInMemory<std::uint64_t, 8>(digit_file_op::digit_sums, 1);
+}
+
+bool TestCheckDigitsUint32() {
+  return MatchesInMemory<std::uint32_t>(digit_file_op::check_digits, 4);
+}
+
+// Tests the error cases:  a missing input, and a ragged one.
+bool TestErrors() {
+  const scratch_file in{"ragged"}, out{"ragged.out"};
+
+  if (transform_digit_file<std::uint32_t>("/nonexistent/in", out.c_str(),
+                                          digit_file_op::reverse_digits)
+      != ENOENT) {
+    return false;
+  }
+
+  if (!write_values(in, std::vector<std::uint8_t>{1, 2, 3, 4, 5})) {
+    return false;
+  }
+  return transform_digit_file<std::uint32_t>(in.c_str(), out.c_str(),
+                                             digit_file_op::reverse_digits)
+      == EINVAL;
+}
+
+// Tests that an output naming the input, directly or through a hard link,
+// is rejected and leaves the input alone.
+bool TestOutputIsInput() {
+  const scratch_file in{"same"}, link{"same.link"};
+  const auto values = std::vector<std::uint32_t>{12, 345, 6789};
+  if (!write_values(in, values) || ::link(in.c_str(), link.c_str()) != 0) {
+    return false;
+  }
+
+  for (const auto output : {in.c_str(), link.c_str()}) {
+    if (transform_digit_file<std::uint32_t>(in.c_str(), output,
+                                            digit_file_op::reverse_digits)
+        != EINVAL) {
+      return false;
+    }
+  }
+  return read_values<std::uint32_t>(in) == values;
+}
+
+// Tests that the output's blocks are allocated before the workers write
+// through the mapping, so a full disk is an error return, not SIGBUS.
+bool TestOutputIsAllocated() {
+  const scratch_file out{"allocated.out"};
+
+  // Nothing is written yet, so the blocks can only come from allocation.
+  const auto bytes = std::size_t{1} << 20;
+  const jz::mapped_file file{out.c_str(), bytes};
+  struct stat st;
+  if (!file || ::stat(out.c_str(), &st) != 0) { return false; }
+  return static_cast<std::size_t>(st.st_blocks) * 512 >= bytes;
+}
+
+// Tests that an empty input gives an empty output.
+bool TestEmptyFile() {
+  const scratch_file in{"empty"}, out{"empty.out"};
+  if (!write_values(in, std::vector<std::uint64_t>{})) { return false; }
+
+  return transform_digit_file<std::uint64_t>(in.c_str(), out.c_str(),
+                                             digit_file_op::sort_digits) == 0
+      && read_values<std::uint64_t>(out).empty();
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestReverseUint32),
+  TEST_CASE(TestSortUint64),
+  TEST_CASE(TestDigitSumsOctal),
+  TEST_CASE(TestCheckDigitsUint32),
+  TEST_CASE(TestErrors),
+  TEST_CASE(TestOutputIsInput),
+  TEST_CASE(TestOutputIsAllocated),
+  TEST_CASE(TestEmptyFile),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
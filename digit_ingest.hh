@@ -0,0 +1,630 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_INGEST_HH_
+#define DIGIT_INGEST_HH_
+
+#include "digit_file_pipeline.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define JZ_HAVE_IO_URING 1
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+#endif
+
+namespace jz {
+
+// Tunes ingest_digit_file().
+struct digit_ingest_options {
+  std::size_t buffer_bytes = std::size_t{4} << 20;  // Multiple of 4096.
+  std::size_t buffers = 16;
+  unsigned    workers = std::thread::hardware_concurrency();
+  bool        use_io_uring = true;  // Falls back to pread if unavailable.
+  bool        direct = false;       // O_DIRECT, where the filesystem allows.
+};
+
+// Reports what ingest_digit_file() did.
+struct digit_ingest_stats {
+  std::uint64_t bytes = 0;
+  double        seconds = 0;
+  bool          used_io_uring = false;
+  bool          used_fixed_buffers = false;  // Registered with io_uring.
+  bool          used_direct = false;
+
+  double bytes_per_second() const noexcept {
+    return seconds > 0 ? double(bytes) / seconds : 0;
+  }
+};
+
+namespace detail {
+
+constexpr std::size_t kIngestAlignment = 4096;
+
+// Holds the ingest buffers, and the queues that pass them from the reader
+// to the workers, from the workers to the writer, and from the writer back
+// to the reader.  Buffers are identified by index throughout.
+class ingest_buffers {
+ public:
+  struct filled {
+    std::size_t buffer;
+    std::uint64_t seq;
+    std::size_t bytes;
+  };
+
+  ingest_buffers(std::size_t count, std::size_t bytes)
+  : bytes_{bytes}, data_(count, nullptr) {
+    for (std::size_t i = 0; i != count; ++i) {
+      void* p = nullptr;
+      if (::posix_memalign(&p, kIngestAlignment, bytes) != 0) {
+        error_ = ENOMEM;
+        return;
+      }
+      data_[i] = static_cast<unsigned char*>(p);
+      free_.push_back(i);
+    }
+  }
+
+  ~ingest_buffers() {
+    for (auto p : data_) { std::free(p); }
+  }
+
+  ingest_buffers(const ingest_buffers&) = delete;
+  ingest_buffers& operator=(const ingest_buffers&) = delete;
+
+  int error() const noexcept { return error_; }
+  std::size_t count() const noexcept { return data_.size(); }
+  std::size_t bytes() const noexcept { return bytes_; }
+  unsigned char* data(std::size_t buffer) const noexcept {
+    return data_[buffer];
+  }
+
+  // Takes a free buffer, waiting for one if 'wait'.  Returns false if none
+  // is available, or the pipeline has stopped.
+  bool take_free(std::size_t& buffer, bool wait) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    if (wait) {
+      freed_.wait(lock, [this] { return stopped_ || !free_.empty(); });
+    }
+    if (stopped_ || free_.empty()) {
+      return false;
+    }
+    buffer = free_.back();
+    free_.pop_back();
+    return true;
+  }
+
+  void put_free(std::size_t buffer) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    free_.push_back(buffer);
+    freed_.notify_all();
+  }
+
+  void put_filled(filled f) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    filled_.push(f);
+    work_ready_.notify_one();
+  }
+
+  // Takes a filled buffer for a worker.  Returns false when reading has
+  // finished and nothing is left.
+  bool take_filled(filled& f) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    work_ready_.wait(lock, [this] {
+      return stopped_ || reads_done_ || !filled_.empty();
+    });
+    if (stopped_ || filled_.empty()) {
+      return false;
+    }
+    f = filled_.front();
+    filled_.pop();
+    return true;
+  }
+
+  void put_done(filled f) {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    done_.push_back(f);
+    std::push_heap(done_.begin(), done_.end(), later_seq);
+    done_ready_.notify_one();
+  }
+
+  // Takes the buffer with sequence number 'seq' for the writer, waiting
+  // for it.  Returns false once the pipeline has stopped.
+  bool take_done(std::uint64_t seq, filled& f) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    done_ready_.wait(lock, [this, seq] {
+      return stopped_ || (!done_.empty() && done_.front().seq == seq);
+    });
+    if (stopped_) {
+      return false;
+    }
+    std::pop_heap(done_.begin(), done_.end(), later_seq);
+    f = done_.back();
+    done_.pop_back();
+    return true;
+  }
+
+  // Tells the workers no more buffers are coming.
+  void finish_reads() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    reads_done_ = true;
+    work_ready_.notify_all();
+  }
+
+  // Stops every stage, for errors.
+  void stop() {
+    const std::lock_guard<std::mutex> lock{mutex_};
+    stopped_ = true;
+    freed_.notify_all();
+    work_ready_.notify_all();
+    done_ready_.notify_all();
+  }
+
+ private:
+  std::size_t bytes_;
+  std::vector<unsigned char*> data_;
+  int error_ = 0;
+
+  std::mutex mutex_;
+  std::condition_variable freed_, work_ready_, done_ready_;
+  std::vector<std::size_t> free_;
+  std::queue<filled> filled_;
+  std::vector<filled> done_;  // A min-heap on seq.
+  bool reads_done_ = false, stopped_ = false;
+
+  static bool later_seq(const filled& a, const filled& b) noexcept {
+    return a.seq > b.seq;
+  }
+};
+
+// Reads [0, size) of 'fd' into buffers in order, with pread.  Returns 0,
+// or an errno value.
+inline int read_with_pread(int fd, std::uint64_t size, ingest_buffers& pool) {
+  auto seq = std::uint64_t{0};
+  for (auto offset = std::uint64_t{0}; offset < size; ++seq) {
+    std::size_t buffer;
+    if (!pool.take_free(buffer, true)) {
+      return 0;
+    }
+
+    const auto want = static_cast<std::size_t>(
+        std::min<std::uint64_t>(pool.bytes(), size - offset));
+    auto have = std::size_t{0};
+    while (have < want) {
+      const auto n = ::pread(fd, pool.data(buffer) + have,
+                             pool.bytes() - have,
+                             static_cast<off_t>(offset + have));
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n < 0) { return errno; }
+      if (n == 0) { return EIO; }  // The file shrank under us.
+      have += static_cast<std::size_t>(n);
+    }
+
+    pool.put_filled({buffer, seq, want});
+    offset += want;
+  }
+  return 0;
+}
+
+#if JZ_HAVE_IO_URING
+
+// Drives a minimal io_uring through the raw system calls:  just enough to
+// keep a set of reads in flight and reap their completions.
+class io_uring_reader {
+ public:
+  explicit io_uring_reader(unsigned entries) noexcept {
+    io_uring_params params;
+    std::memset(&params, 0, sizeof params);
+    fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) {
+      return;
+    }
+
+    sq_bytes_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_bytes_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single) {
+      sq_bytes_ = cq_bytes_ = std::max(sq_bytes_, cq_bytes_);
+    }
+
+    sq_ring_ = map(sq_bytes_, IORING_OFF_SQ_RING);
+    cq_ring_ = single ? sq_ring_ : map(cq_bytes_, IORING_OFF_CQ_RING);
+    sqe_bytes_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = static_cast<io_uring_sqe*>(map(sqe_bytes_, IORING_OFF_SQES));
+    if (!sq_ring_ || !cq_ring_ || !sqes_) {
+      close();
+      return;
+    }
+
+    const auto sq = static_cast<unsigned char*>(sq_ring_);
+    const auto cq = static_cast<unsigned char*>(cq_ring_);
+    sq_tail_  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask_  = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cq_head_  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail_  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask_  = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  }
+
+  ~io_uring_reader() noexcept { close(); }
+
+  io_uring_reader(const io_uring_reader&) = delete;
+  io_uring_reader& operator=(const io_uring_reader&) = delete;
+
+  bool is_open() const noexcept { return fd_ >= 0; }
+
+  // Returns true if the kernel supports 'opcode'.  A ring can open on a
+  // kernel that predates the opcode, or that has it disabled, so probe
+  // before relying on it.  Kernels too old to probe support neither
+  // IORING_OP_READ nor anything newer.
+  bool supports(unsigned opcode) const noexcept {
+    constexpr unsigned kOps = 256;
+    auto words = std::vector<std::uint64_t>(
+        (sizeof(io_uring_probe) + kOps * sizeof(io_uring_probe_op)) / 8);
+    const auto probe = reinterpret_cast<io_uring_probe*>(words.data());
+    if (::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_PROBE, probe,
+                  kOps) != 0) {
+      return false;
+    }
+    return opcode <= probe->last_op && opcode < probe->ops_len &&
+           (probe->ops[opcode].flags & IO_URING_OP_SUPPORTED) != 0;
+  }
+
+  // Registers the buffers, so reads can skip mapping them each time.
+  // Registration counts against the locked-memory limit, so it can fail.
+  bool register_buffers(const ingest_buffers& pool) noexcept {
+    if (!supports(IORING_OP_READ_FIXED)) {
+      return false;
+    }
+
+    auto iovecs = std::vector<iovec>(pool.count());
+    for (std::size_t i = 0; i != pool.count(); ++i) {
+      iovecs[i] = {pool.data(i), pool.bytes()};
+    }
+    fixed_ = ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS,
+                       iovecs.data(), static_cast<unsigned>(iovecs.size()))
+        == 0;
+    return fixed_;
+  }
+
+  // Queues a read of 'bytes' at 'offset' into 'buffer', tagged with
+  // 'tag'.  The caller keeps no more reads in flight than ring entries.
+  void queue_read(int fd, const ingest_buffers& pool, std::size_t buffer,
+                  std::size_t bytes, std::uint64_t offset,
+                  std::uint64_t tag) noexcept {
+    const auto tail = *sq_tail_;
+    const auto index = tail & sq_mask_;
+    auto& sqe = sqes_[index];
+    std::memset(&sqe, 0, sizeof sqe);
+    sqe.opcode = fixed_ ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe.fd = fd;
+    sqe.off = offset;
+    sqe.addr = reinterpret_cast<std::uint64_t>(pool.data(buffer));
+    sqe.len = static_cast<unsigned>(bytes);
+    sqe.buf_index = static_cast<std::uint16_t>(buffer);
+    sqe.user_data = tag;
+    sq_array_[index] = index;
+    __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+    ++queued_;
+  }
+
+  // Submits queued reads and, if 'wait', waits for at least one to
+  // complete.  Returns 0, or an errno value.
+  int submit(bool wait) noexcept {
+    const auto to_submit = queued_;
+    for (;;) {
+      const auto n = ::syscall(__NR_io_uring_enter, fd_, to_submit,
+                               wait ? 1u : 0u,
+                               wait ? IORING_ENTER_GETEVENTS : 0u,
+                               nullptr, 0);
+      if (n >= 0) {
+        queued_ = 0;
+        return 0;
+      }
+      if (errno != EINTR) {
+        return errno;
+      }
+    }
+  }
+
+  // Calls fxn(tag, result) for each completion.  Returns how many.
+  template <typename Fxn>
+  unsigned reap(Fxn&& fxn) {
+    auto head = *cq_head_;
+    const auto tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    auto count = 0u;
+    for (; head != tail; ++head, ++count) {
+      const auto& cqe = cqes_[head & cq_mask_];
+      fxn(cqe.user_data, cqe.res);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+    return count;
+  }
+
+ private:
+  int fd_ = -1;
+  void* sq_ring_ = nullptr;
+  void* cq_ring_ = nullptr;
+  io_uring_sqe* sqes_ = nullptr;
+  std::size_t sq_bytes_ = 0, cq_bytes_ = 0, sqe_bytes_ = 0;
+  unsigned* sq_tail_ = nullptr;
+  unsigned* sq_array_ = nullptr;
+  unsigned* cq_head_ = nullptr;
+  unsigned* cq_tail_ = nullptr;
+  io_uring_cqe* cqes_ = nullptr;
+  unsigned sq_mask_ = 0, cq_mask_ = 0, queued_ = 0;
+  bool fixed_ = false;
+
+  void* map(std::size_t bytes, unsigned long long offset) noexcept {
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd_, static_cast<off_t>(offset));
+    return p == MAP_FAILED ? nullptr : p;
+  }
+
+  void close() noexcept {
+    if (sqes_) { ::munmap(sqes_, sqe_bytes_); }
+    if (cq_ring_ && cq_ring_ != sq_ring_) { ::munmap(cq_ring_, cq_bytes_); }
+    if (sq_ring_) { ::munmap(sq_ring_, sq_bytes_); }
+    if (fd_ >= 0) { ::close(fd_); }
+    sqes_ = nullptr;
+    sq_ring_ = cq_ring_ = nullptr;
+    fd_ = -1;
+  }
+};
+
+// Returns true if an io_uring read failed with an error that pread may
+// not share:  this kernel's io_uring can't read the file, or can't meet
+// its O_DIRECT alignment, or a security policy blocks the ring.
+inline bool ring_refused(int error) noexcept {
+  return error == EINVAL || error == EOPNOTSUPP || error == EPERM;
+}
+
+// Reads [0, size) of 'fd' into buffers through io_uring, keeping every
+// free buffer busy with a read.  Completions arrive in any order, and a
+// short read resubmits the rest.  Returns 0, or an errno value.
+//
+// If the ring refuses the reads before any buffer reaches the workers,
+// this gives every buffer back and sets 'restart', so the caller can read
+// the whole file another way.  Once a buffer is on its way, the error
+// stands.
+inline int read_with_io_uring(io_uring_reader& ring, int fd,
+                              std::uint64_t size, ingest_buffers& pool,
+                              bool& restart) {
+  struct pending {
+    std::uint64_t seq;
+    std::size_t want;
+    std::size_t have;
+  };
+
+  auto reads = std::vector<pending>(pool.count());
+  auto offset = std::uint64_t{0};
+  auto seq = std::uint64_t{0};
+  auto in_flight = std::size_t{0};
+  auto error = 0;
+  auto delivered = false;
+  auto held = std::vector<bool>(pool.count());
+  restart = false;
+
+  const auto queue = [&](std::size_t buffer) {
+    const auto& r = reads[buffer];
+    ring.queue_read(fd, pool, buffer, pool.bytes() - r.have,
+                    r.seq * pool.bytes() + r.have, buffer);
+  };
+
+  // After an error, stops queuing but keeps reaping:  the kernel may still
+  // be writing into buffers that are in flight.
+  while ((error == 0 && offset < size) || in_flight != 0) {
+    // Starts a read on every free buffer, waiting for one only when
+    // nothing is in flight to wait on instead.
+    std::size_t buffer;
+    while (error == 0 && offset < size &&
+           pool.take_free(buffer, in_flight == 0)) {
+      const auto want = static_cast<std::size_t>(
+          std::min<std::uint64_t>(pool.bytes(), size - offset));
+      reads[buffer] = {seq++, want, 0};
+      held[buffer] = true;
+      queue(buffer);
+      offset += want;
+      ++in_flight;
+    }
+    if (in_flight == 0) {
+      break;  // Stopped.
+    }
+
+    if (const auto e = ring.submit(true)) {
+      return e;  // The ring itself failed.  Nothing more will complete.
+    }
+    ring.reap([&](std::uint64_t tag, std::int32_t result) {
+      auto& r = reads[tag];
+      if (result == -EINTR || result == -EAGAIN) {
+        result = 0;  // Retry as a short read.
+      } else if (result < 0) {
+        error = error ? error : -result;
+      } else if (result == 0) {
+        error = error ? error : EIO;  // The file shrank under us.
+      }
+      r.have += static_cast<std::size_t>(std::max(result, 0));
+      if (error == 0 && r.have < r.want) {
+        queue(static_cast<std::size_t>(tag));
+        return;
+      }
+      if (error == 0) {
+        pool.put_filled({static_cast<std::size_t>(tag), r.seq, r.want});
+        held[tag] = false;
+        delivered = true;
+      }
+      --in_flight;
+    });
+  }
+
+  if (error != 0 && !delivered && ring_refused(error)) {
+    for (std::size_t buffer = 0; buffer != held.size(); ++buffer) {
+      if (held[buffer]) {
+        pool.put_free(buffer);
+      }
+    }
+    restart = true;
+  }
+  return error;
+}
+
+#endif  // JZ_HAVE_IO_URING
+
+}  // namespace detail
+
+// Streams a flat file of little-endian T values through 'op' and hands the
+// results to 'sink', in file order, as sink(const T* first, const T* last).
+// Returns 0 on success, or an errno value on failure.  An input whose size
+// isn't a multiple of sizeof(T) is EINVAL.
+//
+// This is for inputs too large to map at once.  It runs three stages over a
+// fixed pool of aligned buffers:  a reader that keeps reads in flight
+// through io_uring (or a pread loop, where io_uring isn't available), a
+// pool of workers that run the digit operation in place, and a writer that
+// calls the sink in order and then recycles the buffer.  With enough
+// buffers, the disk never waits on the workers, nor the workers on the disk.
+//
+// The reader only uses io_uring where the kernel says it supports the
+// reads, and starts over with pread if the ring refuses the first ones.
+template <typename T, int RADIX = 10, typename Sink>
+int ingest_digit_file(const char* path, digit_file_op op, Sink&& sink,
+                      const digit_ingest_options& options = {},
+                      digit_ingest_stats* stats = nullptr) {
+  static_assert(std::is_integral<T>::value && !std::is_const<T>::value,
+                "T must be a non-const integer type");
+
+  using clock = std::chrono::steady_clock;
+  const auto start = clock::now();
+
+  if (options.buffer_bytes == 0 ||
+      options.buffer_bytes % detail::kIngestAlignment != 0 ||
+      options.buffers == 0) {
+    return EINVAL;
+  }
+
+  // O_DIRECT skips the page cache, but not every filesystem has it.
+  auto direct = false;
+  auto fd = -1;
+#ifdef O_DIRECT
+  if (options.direct) {
+    fd = ::open(path, O_RDONLY | O_DIRECT);
+    direct = fd >= 0;
+  }
+#endif
+  if (fd < 0) {
+    fd = ::open(path, O_RDONLY);
+  }
+  if (fd < 0) {
+    return errno;
+  }
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    const auto error = errno;
+    ::close(fd);
+    return error;
+  }
+  const auto size = static_cast<std::uint64_t>(st.st_size);
+  if (size % sizeof(T) != 0) {
+    ::close(fd);
+    return EINVAL;
+  }
+
+  detail::ingest_buffers pool{options.buffers, options.buffer_bytes};
+  if (pool.error() != 0) {
+    ::close(fd);
+    return pool.error();
+  }
+
+  auto workers = std::vector<std::thread>{};
+  for (unsigned i = 0; i != std::max(1u, options.workers); ++i) {
+    workers.emplace_back([&pool, op] {
+      detail::ingest_buffers::filled f;
+      while (pool.take_filled(f)) {
+        const auto first = reinterpret_cast<T*>(pool.data(f.buffer));
+        detail::apply_digit_file_op<T, RADIX>(
+            op, first, first + f.bytes / sizeof(T), first);
+        pool.put_done(f);
+      }
+    });
+  }
+
+  const auto blocks = (size + pool.bytes() - 1) / pool.bytes();
+  auto writer = std::thread{[&pool, &sink, blocks] {
+    detail::ingest_buffers::filled f;
+    for (auto seq = std::uint64_t{0}; seq != blocks; ++seq) {
+      if (!pool.take_done(seq, f)) {
+        return;
+      }
+      const auto first = reinterpret_cast<const T*>(pool.data(f.buffer));
+      sink(first, first + f.bytes / sizeof(T));
+      pool.put_free(f.buffer);
+    }
+  }};
+
+  auto error = 0;
+  auto used_io_uring = false, used_fixed = false;
+#if JZ_HAVE_IO_URING
+  if (options.use_io_uring) {
+    detail::io_uring_reader ring{static_cast<unsigned>(options.buffers)};
+    if (ring.is_open() && ring.supports(IORING_OP_READ)) {
+      used_io_uring = true;
+      used_fixed = ring.register_buffers(pool);
+      auto restart = false;
+      error = detail::read_with_io_uring(ring, fd, size, pool, restart);
+      if (restart) {
+        used_io_uring = used_fixed = false;
+      }
+    }
+  }
+#endif
+  if (!used_io_uring) {
+    error = detail::read_with_pread(fd, size, pool);
+  }
+
+  if (error != 0) {
+    pool.stop();
+  }
+  pool.finish_reads();
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  writer.join();
+  ::close(fd);
+
+  if (stats) {
+    stats->bytes = size;
+    stats->seconds =
+        std::chrono::duration<double>(clock::now() - start).count();
+    stats->used_io_uring = used_io_uring;
+    stats->used_fixed_buffers = used_fixed;
+    stats->used_direct = direct;
+  }
+
+  return error;
+}
+
+}  // namespace jz
+#endif // DIGIT_INGEST_HH_
@@ -0,0 +1,209 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_ingest.hh"
+#include "digit_test.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+using jz::digit_file_op;
+using jz::digit_ingest_options;
+using jz::ingest_digit_file;
+
+// Returns a scratch file name unique to this process, and removes the file
+// when it goes out of scope.
+class scratch_file {
+ public:
+  explicit scratch_file(const char* tag)
+  : path_{"/tmp/digit_ingest_test." + std::to_string(::getpid())
+          + "." + tag} {}
+
+  ~scratch_file() { std::remove(path_.c_str()); }
+
+  const char* c_str() const { return path_.c_str(); }
+
+ private:
+  std::string path_;
+};
+
+template <typename T>
+bool write_values(const scratch_file& path, const std::vector<T>& values) {
+  const auto f = std::fopen(path.c_str(), "wb");
+  if (!f) { return false; }
+  const auto n = values.empty() ? 0 : std::fwrite(values.data(), sizeof(T),
+                                                 values.size(), f);
+  return std::fclose(f) == 0 && n == values.size();
+}
+
+// Small buffers, so even a modest file cycles each one many times.
+digit_ingest_options small_buffers(bool use_io_uring) {
+  auto options = digit_ingest_options{};
+  options.buffer_bytes = 4096 * 3;
+  options.buffers = 5;
+  options.workers = 3;
+  options.use_io_uring = use_io_uring;
+  return options;
+}
+
+// Runs 'op' over a file through ingest_digit_file(), and in memory, and
+// compares the results.  The file ends partway through a buffer.
+template <typename T, int RADIX = 10>
+bool MatchesInMemory(digit_file_op op, const digit_ingest_options& options) {
+  const scratch_file in{"in"};
+  auto rng = std::mt19937_64{84};
+  auto values = std::vector<T>(200 * options.buffer_bytes / sizeof(T) / 3
+                               + 11);
+  for (auto& value : values) {
+    value = static_cast<T>(rng() >> (rng() % 64));
+  }
+  if (!write_values(in, values)) { return false; }
+
+  auto results = std::vector<T>{};
+  auto stats = jz::digit_ingest_stats{};
+  const auto sink = [&results](const T* first, const T* last) {
+    results.insert(results.end(), first, last);
+  };
+  if (ingest_digit_file<T, RADIX>(in.c_str(), op, sink, options, &stats)
+      != 0) {
+    return false;
+  }
+  if (stats.bytes != values.size() * sizeof(T)) { return false; }
+
+  auto expected = values;
+  jz::detail::apply_digit_file_op<T, RADIX>(
+      op, values.data(), values.data() + values.size(), expected.data());
+
+  return results == expected;
+}
+
+bool TestReverseThroughPread() {
+  return MatchesInMemory<std::uint32_t>(digit_file_op::reverse_digits,
+                                        small_buffers(false));
+}
+
+bool TestSortThroughIoUring() {
+  return MatchesInMemory<std::uint64_t>(digit_file_op::sort_digits,
+                                        small_buffers(true));
+}
+
+bool TestDigitSumsHexOneWorker() {
+  auto options = small_buffers(true);
+  options.workers = 1;
+  options.buffers = 1;
+  return MatchesInMemory<std::uint64_t, 16>(digit_file_op::digit_sums,
+                                            options);
+}
+
+// Tests O_DIRECT, which the ingest drops quietly where it's unsupported.
+bool TestDirect() {
+  auto options = small_buffers(true);
+  options.direct = true;
+  if (!MatchesInMemory<std::uint32_t>(digit_file_op::check_digits, options)) {
+    return false;
+  }
+  options.use_io_uring = false;
+  return MatchesInMemory<std::uint32_t>(digit_file_op::check_digits, options);
+}
+
+// Tests the error cases:  a missing input, a ragged one, and bad options.
+bool TestErrors() {
+  const scratch_file in{"ragged"};
+  const auto sink = [](const std::uint32_t*, const std::uint32_t*) {};
+
+  if (ingest_digit_file<std::uint32_t>("/nonexistent/in",
+                                       digit_file_op::reverse_digits, sink)
+      != ENOENT) {
+    return false;
+  }
+
+  if (!write_values(in, std::vector<std::uint8_t>{1, 2, 3, 4, 5})) {
+    return false;
+  }
+  if (ingest_digit_file<std::uint32_t>(in.c_str(),
+                                       digit_file_op::reverse_digits, sink)
+      != EINVAL) {
+    return false;
+  }
+
+  auto options = digit_ingest_options{};
+  options.buffer_bytes = 1000;
+  return ingest_digit_file<std::uint8_t>(in.c_str(),
+                                         digit_file_op::reverse_digits,
+                                         [](const std::uint8_t*,
+                                            const std::uint8_t*) {},
+                                         options) == EINVAL;
+}
+
+// Tests that an empty input never calls the sink.
+bool TestEmptyFile() {
+  const scratch_file in{"empty"};
+  if (!write_values(in, std::vector<std::uint64_t>{})) { return false; }
+
+  auto calls = 0;
+  const auto sink = [&calls](const std::uint64_t*, const std::uint64_t*) {
+    ++calls;
+  };
+  return ingest_digit_file<std::uint64_t>(in.c_str(),
+                                          digit_file_op::sort_digits, sink)
+      == 0 && calls == 0;
+}
+
+// Tests that a ring refusing its first reads hands every buffer back for
+// the pread fallback.  O_DIRECT reads of a length that isn't a multiple of
+// the block size are EINVAL.
+bool TestRingRefusal() {
+#if JZ_HAVE_IO_URING && defined(O_DIRECT)
+  const scratch_file in{"refused"};
+  if (!write_values(in, std::vector<std::uint64_t>(1024))) { return false; }
+
+  jz::detail::ingest_buffers pool{3, 1000};
+  jz::detail::io_uring_reader ring{3};
+  const auto fd = ::open(in.c_str(), O_RDONLY | O_DIRECT);
+  if (fd < 0 || !ring.is_open() || !ring.supports(IORING_OP_READ)) {
+    if (fd >= 0) { ::close(fd); }
+    return true;  // Nothing to refuse.
+  }
+
+  auto restart = false;
+  const auto error = jz::detail::read_with_io_uring(ring, fd, 3000, pool,
+                                                    restart);
+  ::close(fd);
+  if (error != EINVAL || !restart) {
+    return false;
+  }
+  std::size_t buffer;
+  for (std::size_t i = 0; i != pool.count(); ++i) {
+    if (!pool.take_free(buffer, false)) {
+      return false;
+    }
+  }
+#endif
+  return true;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestReverseThroughPread),
+  TEST_CASE(TestSortThroughIoUring),
+  TEST_CASE(TestDigitSumsHexOneWorker),
+  TEST_CASE(TestDirect),
+  TEST_CASE(TestErrors),
+  TEST_CASE(TestEmptyFile),
+  TEST_CASE(TestRingRefusal),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,450 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_PATTERN_HH_
+#define DIGIT_PATTERN_HH_
+
+#include "digit_adaptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace jz {
+
+// Matches integers against a wildcard pattern over their RADIX digits, most
+// significant first.  Patterns use a glob-like syntax:
+//
+//   0-9, a-z   A literal digit.  Letters are 10 through 35, for RADIX > 10,
+//              in either case.
+//   ?          Any one digit.
+//   [...]      One digit from a class, such as [137] or [0-4].  A leading ^
+//              negates the class, as in [^05].
+//   *          Any run of zero or more digits.
+//
+// So 12?4*9 matches 1234569 and 12049, but not 1234 or 12340.  Numbers match
+// on their magnitude, with as many digits as the value needs.  An adaptor
+// with an explicit size() also matches on its leading zeros.
+//
+// The constructor compiles the pattern once.  Patterns without a * have a
+// fixed length, and compile to a range check on the value (covering the
+// length and any literal leading digits), followed by a short list of
+// per-place checks:  runs of literal digits become one divide-and-modulo
+// against the power table, and classes become a bitmask test on one digit.
+// Patterns with a * extract the digits and match the segments between the
+// stars, leftmost first.
+//
+// The span matchers evaluate a block of 64 numbers at a time.  The range
+// check runs across the whole block, then each per-place check runs down the
+// column of numbers still in the running, until none are left.
+template <int RADIX = 10>
+class digit_pattern {
+  static_assert(RADIX > 1, "RADIX must be larger than 1");
+  static_assert(RADIX <= 36, "Patterns spell digits as 0-9 and a-z");
+
+ public:
+  // Compiles 'pattern'.  A malformed pattern isn't valid(), and matches
+  // nothing.
+  explicit digit_pattern(const char* pattern) {
+    valid_ = parse(pattern);
+    if (valid_) {
+      compile();
+    }
+  }
+
+  // Returns true if the pattern parsed.
+  bool valid() const noexcept { return valid_; }
+
+  // Returns true if the digits of 'value' match.
+  template <typename T>
+  bool matches(T value) const noexcept {
+    static_assert(sizeof(T) <= sizeof(std::uint64_t),
+                  "Values must fit in 64 bits");
+    const auto u = static_cast<std::uint64_t>(detail::magnitude(value));
+    return fixed_ ? in_range(u) && passes_checks(u)
+                  : valid_ && matches_digits(u, natural_length(u));
+  }
+
+  // Returns true if the adaptor's digits match, including any leading zeros
+  // its size() adds.
+  template <typename T, typename Tables>
+  bool matches(const digit_adaptor<T, RADIX, Tables>& digits) const noexcept {
+    static_assert(sizeof(T) <= sizeof(std::uint64_t),
+                  "Values must fit in 64 bits");
+    const auto u = static_cast<std::uint64_t>(
+        detail::magnitude(static_cast<T>(digits)));
+    return valid_ && matches_digits(u, digits.size());
+  }
+
+  // Sets bit i % 64 of bitmap[i / 64] if first[i] matches, and clears it
+  // otherwise, for every value in [first, last).  Returns the number of
+  // matches.  'bitmap' must hold (last - first + 63) / 64 words.
+  template <typename T>
+  std::size_t match(const T* first, const T* last,
+                    std::uint64_t* bitmap) const noexcept {
+    auto count = std::size_t{0};
+
+    for (; first < last; first += kBlock) {
+      const auto n = std::min(kBlock, static_cast<std::size_t>(last - first));
+      const auto bits = match_block(first, n);
+      *bitmap++ = bits;
+      count += popcount(bits);
+    }
+
+    return count;
+  }
+
+  // Writes the index of each matching value in [first, last) to 'out', in
+  // order.  Returns the end of the output.
+  template <typename T, typename OutputIt>
+  OutputIt find_matches(const T* first, const T* last, OutputIt out) const {
+    for (auto base = std::size_t{0}; first < last;
+         first += kBlock, base += kBlock) {
+      const auto n = std::min(kBlock, static_cast<std::size_t>(last - first));
+      for (auto bits = match_block(first, n); bits != 0; bits &= bits - 1) {
+        *out++ = base + count_trailing_zeros(bits);
+      }
+    }
+
+    return out;
+  }
+
+ private:
+  using mask_type = std::uint64_t;
+
+  static constexpr std::size_t kBlock = 64;
+  static constexpr std::size_t kMaxDigits =
+      detail::max_radix_digits<std::uint64_t, RADIX>();
+  static constexpr mask_type kAnyDigit = (mask_type{1} << RADIX) - 1;
+
+  // Adaptors padded past this many digits never match.
+  static constexpr std::size_t kMaxLength = 128;
+
+  // A per-place check on a fixed-length pattern.  Literal runs compare
+  // (u / RADIX^place) % RADIX^width against 'value'.  Classes test digit
+  // (u / RADIX^place) % RADIX against the bits in 'value'.
+  struct check {
+    std::uint64_t divisor;
+    std::uint64_t modulus;
+    std::uint64_t value;
+    bool          is_class;
+  };
+
+  bool valid_ = false;
+  bool fixed_ = false;
+
+  // One digit class per pattern position, with stars removed.  'segments_'
+  // holds the index where each star-delimited segment starts, plus a final
+  // end index.
+  std::vector<mask_type> classes_;
+  std::vector<std::size_t> segments_;
+
+  // The compiled form of a fixed-length pattern.  Values in [lo_, hi_]
+  // have the right length and literal leading digits.
+  std::uint64_t lo_ = 1;
+  std::uint64_t hi_ = 0;
+  std::vector<check> checks_;
+
+  static constexpr std::uint64_t power(std::size_t exponent) noexcept {
+    return detail::radix_power<std::uint64_t, RADIX>(exponent);
+  }
+
+  static std::size_t popcount(std::uint64_t bits) noexcept {
+    auto count = std::size_t{0};
+    for (; bits != 0; bits &= bits - 1) {
+      ++count;
+    }
+    return count;
+  }
+
+  static std::size_t count_trailing_zeros(std::uint64_t bits) noexcept {
+#if defined(__GNUC__)
+    return static_cast<std::size_t>(__builtin_ctzll(bits));
+#else
+    auto count = std::size_t{0};
+    for (; (bits & 1) == 0; bits >>= 1) {
+      ++count;
+    }
+    return count;
+#endif
+  }
+
+  // Returns a character's digit value, or -1 if it isn't a digit in RADIX.
+  static int digit_value(char c) noexcept {
+    const int d = c >= '0' && c <= '9' ? c - '0'
+                : c >= 'a' && c <= 'z' ? c - 'a' + 10
+                : c >= 'A' && c <= 'Z' ? c - 'A' + 10 : RADIX;
+    return d < RADIX ? d : -1;
+  }
+
+  // Parses a [...] class starting just past the '['.  Returns the class
+  // mask, or 0 if it's malformed.
+  static mask_type parse_class(const char*& p) noexcept {
+    const bool negate = *p == '^';
+    p += negate;
+
+    auto mask = mask_type{0};
+    while (*p != ']') {
+      const int lo = digit_value(*p);
+      if (lo < 0) {
+        return 0;
+      }
+
+      int hi = lo;
+      if (p[1] == '-' && p[2] != ']' && p[2] != '\0') {
+        hi = digit_value(p[2]);
+        if (hi < lo) {
+          return 0;
+        }
+        p += 2;
+      }
+      ++p;
+
+      for (int d = lo; d <= hi; ++d) {
+        mask |= mask_type{1} << d;
+      }
+    }
+    ++p;
+
+    return negate ? ~mask & kAnyDigit : mask;
+  }
+
+  bool parse(const char* p) {
+    segments_.push_back(0);
+
+    while (*p != '\0') {
+      const char c = *p++;
+      if (c == '*') {
+        segments_.push_back(classes_.size());
+      } else if (c == '?') {
+        classes_.push_back(kAnyDigit);
+      } else if (c == '[') {
+        const auto mask = parse_class(p);
+        if (mask == 0) {
+          return false;
+        }
+        classes_.push_back(mask);
+      } else {
+        const int d = digit_value(c);
+        if (d < 0) {
+          return false;
+        }
+        classes_.push_back(mask_type{1} << d);
+      }
+    }
+
+    segments_.push_back(classes_.size());
+    return !classes_.empty() || segments_.size() > 2;
+  }
+
+  static bool is_literal(mask_type mask) noexcept {
+    return (mask & (mask - 1)) == 0;
+  }
+
+  static int literal_digit(mask_type mask) noexcept {
+    return static_cast<int>(count_trailing_zeros(mask));
+  }
+
+  // Compiles a fixed-length pattern to a range and per-place checks.
+  void compile() {
+    fixed_ = segments_.size() == 2;
+    if (!fixed_) {
+      return;
+    }
+
+    const auto length = classes_.size();
+    if (length > kMaxDigits) {
+      return;  // Nothing that long fits in 64 bits, so lo_ > hi_.
+    }
+
+    // Values of exactly 'length' digits.
+    constexpr auto kMax = std::numeric_limits<std::uint64_t>::max();
+    auto lo = length == 1 ? std::uint64_t{0} : power(length - 1);
+    auto hi = length == kMaxDigits ? kMax : power(length) - 1;
+
+    // Narrows that to the literal leading digits.
+    auto prefix = std::size_t{0};
+    auto value = std::uint64_t{0};
+    auto overflow = false;
+    while (prefix != length && is_literal(classes_[prefix])) {
+      const auto d = static_cast<std::uint64_t>(
+          literal_digit(classes_[prefix++]));
+      overflow |= value > (kMax - d) / RADIX;
+      value = value * RADIX + d;
+    }
+
+    if (prefix != 0) {
+      const auto scale = power(length - prefix);
+      if (overflow || value > kMax / scale) {
+        lo = 1, hi = 0;
+      } else {
+        const auto first = value * scale;
+        lo = std::max(lo, first);
+        hi = std::min(hi, first > kMax - (scale - 1) ? kMax
+                                                     : first + (scale - 1));
+      }
+    }
+
+    lo_ = lo;
+    hi_ = hi;
+
+    // Checks the remaining places, least significant last.
+    for (auto i = prefix; i != length; ) {
+      const auto mask = classes_[i];
+      if (mask == kAnyDigit) {
+        ++i;
+        continue;
+      }
+
+      if (!is_literal(mask)) {
+        checks_.push_back({power(length - 1 - i), RADIX, mask, true});
+        ++i;
+        continue;
+      }
+
+      auto run = std::uint64_t{0};
+      auto j = i;
+      while (j != length && is_literal(classes_[j])) {
+        run = run * RADIX + literal_digit(classes_[j++]);
+      }
+      checks_.push_back({power(length - j), power(j - i), run, false});
+      i = j;
+    }
+  }
+
+  bool in_range(std::uint64_t u) const noexcept {
+    return u >= lo_ && u <= hi_;
+  }
+
+  bool passes(const check& c, std::uint64_t u) const noexcept {
+    const auto q = u / c.divisor;
+    return c.is_class ? (c.value >> (q % RADIX)) & 1
+                      : q % c.modulus == c.value;
+  }
+
+  bool passes_checks(std::uint64_t u) const noexcept {
+    for (const auto& c : checks_) {
+      if (!passes(c, u)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static std::size_t natural_length(std::uint64_t u) noexcept {
+    auto length = std::size_t{1};
+    while (length != kMaxDigits && u >= power(length)) {
+      ++length;
+    }
+    return length;
+  }
+
+  // Returns true if classes [first, last) match digits starting at 'at'.
+  bool segment_at(std::size_t first, std::size_t last,
+                  const std::uint8_t* digits, std::size_t at) const noexcept {
+    for (auto i = first; i != last; ++i) {
+      if (((classes_[i] >> digits[at + i - first]) & 1) == 0) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Matches 'length' digits of 'u', with leading zeros if needed, up to
+  // kMaxLength digits.  The first
+  // segment anchors to the front and the last to the back.  Segments in
+  // between match leftmost first, which suffices when a star separates
+  // each of them.
+  bool matches_digits(std::uint64_t u, std::size_t length) const noexcept {
+    if (length > kMaxLength) {
+      return false;
+    }
+
+    std::uint8_t digits[kMaxLength];
+    for (auto i = length; i-- != 0; ) {
+      digits[i] = static_cast<std::uint8_t>(u % RADIX);
+      u /= RADIX;
+    }
+
+    const auto segments = segments_.size() - 1;
+    const auto front = segments_[1] - segments_[0];
+    const auto back = segments_[segments] - segments_[segments - 1];
+
+    if (segments == 1) {
+      return length == front && segment_at(0, front, digits, 0);
+    }
+
+    if (front + back > length ||
+        !segment_at(0, front, digits, 0) ||
+        !segment_at(segments_[segments - 1], segments_[segments], digits,
+                    length - back)) {
+      return false;
+    }
+
+    auto at = front;
+    const auto limit = length - back;
+    for (auto s = std::size_t{1}; s + 1 < segments; ++s) {
+      const auto first = segments_[s], last = segments_[s + 1];
+      const auto size = last - first;
+
+      while (at + size <= limit && !segment_at(first, last, digits, at)) {
+        ++at;
+      }
+      if (at + size > limit) {
+        return false;
+      }
+      at += size;
+    }
+
+    return true;
+  }
+
+  // Returns a bitmap of the matches among the 'n' values at 'values'.
+  template <typename T>
+  std::uint64_t match_block(const T* values, std::size_t n) const noexcept {
+    static_assert(sizeof(T) <= sizeof(std::uint64_t),
+                  "Values must fit in 64 bits");
+
+    auto bits = std::uint64_t{0};
+
+    if (!fixed_) {
+      for (auto i = std::size_t{0}; i != n; ++i) {
+        bits |= std::uint64_t{matches(values[i])} << i;
+      }
+      return bits;
+    }
+
+    // The range check has no branches, so it vectorizes.
+    for (auto i = std::size_t{0}; i != n; ++i) {
+      const auto u = static_cast<std::uint64_t>(detail::magnitude(values[i]));
+      bits |= std::uint64_t{in_range(u)} << i;
+    }
+
+    // Each check runs down the column of values still matching.
+    for (const auto& c : checks_) {
+      if (bits == 0) {
+        break;
+      }
+      for (auto live = bits; live != 0; live &= live - 1) {
+        const auto i = count_trailing_zeros(live);
+        const auto u =
+            static_cast<std::uint64_t>(detail::magnitude(values[i]));
+        if (!passes(c, u)) {
+          bits &= ~(std::uint64_t{1} << i);
+        }
+      }
+    }
+
+    return bits;
+  }
+};
+
+template <int RADIX>
+constexpr std::size_t digit_pattern<RADIX>::kBlock;
+
+template <int RADIX>
+constexpr std::uint64_t digit_pattern<RADIX>::kAnyDigit;
+
+}  // namespace jz
+#endif // DIGIT_PATTERN_HH_
@@ -0,0 +1,211 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_pattern.hh"
+#include "digit_test.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using jz::digit_adaptor;
+using jz::digit_pattern;
+
+// Tests literal digits and single-digit wildcards.
+bool TestFixedLengthPatterns() {
+  const digit_pattern<> pattern{"12?4"};
+  if (!pattern.valid()) { return false; }
+
+  if (!pattern.matches(1234))   { return false; }
+  if (!pattern.matches(1204))   { return false; }
+  if (!pattern.matches(-1294))  { return false; }
+  if (pattern.matches(1235))    { return false; }
+  if (pattern.matches(124))     { return false; }
+  if (pattern.matches(12345))   { return false; }
+  if (pattern.matches(2234))    { return false; }
+
+  const digit_pattern<> exact{"0"};
+  if (!exact.matches(0) || exact.matches(10)) { return false; }
+
+  return true;
+}
+
+// Tests bracketed digit classes, including ranges and negation.
+bool TestDigitClasses() {
+  const digit_pattern<> pattern{"[1-3]?[^05]"};
+  if (!pattern.valid()) { return false; }
+
+  if (!pattern.matches(101))  { return false; }
+  if (!pattern.matches(399))  { return false; }
+  if (pattern.matches(100))   { return false; }
+  if (pattern.matches(405))   { return false; }
+  if (pattern.matches(305))   { return false; }
+  if (pattern.matches(31))    { return false; }
+
+  const digit_pattern<16> hex{"[a-F]f"};
+  if (!hex.matches(0xAF) || !hex.matches(0xFF) || hex.matches(0x9F)) {
+    return false;
+  }
+
+  return true;
+}
+
+// Tests stars, anchored at both ends and floating in the middle.
+bool TestStars() {
+  const digit_pattern<> pattern{"12?4*9"};
+  if (!pattern.matches(1234569))  { return false; }
+  if (!pattern.matches(12049))    { return false; }
+  if (pattern.matches(1234))      { return false; }
+  if (pattern.matches(12340))     { return false; }
+
+  const digit_pattern<> middle{"*44*17*"};
+  if (!middle.matches(4417))        { return false; }
+  if (!middle.matches(9449917))     { return false; }
+  if (middle.matches(1744))         { return false; }
+
+  const digit_pattern<> ends{"4*4"};
+  if (!ends.matches(44) || !ends.matches(4004) || ends.matches(4)) {
+    return false;
+  }
+
+  const digit_pattern<> all{"*"};
+  if (!all.matches(0) || !all.matches(UINT64_MAX)) { return false; }
+
+  return true;
+}
+
+// Tests that adaptors match on their leading zeros.
+bool TestAdaptorsWithLeadingZeros() {
+  const digit_pattern<> pattern{"00?7"};
+  const int value = 17;
+
+  if (!pattern.matches(digit_adaptor<const int>{value, 4})) { return false; }
+  if (pattern.matches(digit_adaptor<const int>{value}))     { return false; }
+  if (pattern.matches(value))                               { return false; }
+
+  using untabled = digit_adaptor<const int, 10, jz::no_tables>;
+  if (!pattern.matches(untabled{value, 4}))                 { return false; }
+
+  return true;
+}
+
+// Tests that malformed patterns are rejected and match nothing.
+bool TestMalformedPatterns() {
+  for (const auto text : {"", "12x", "[12", "[]", "[9-1]", "[^0-9]", "1a"}) {
+    const digit_pattern<> pattern{text};
+    if (pattern.valid() || pattern.matches(1) || pattern.matches(12)) {
+      return false;
+    }
+  }
+
+  return digit_pattern<16>{"1a"}.valid();
+}
+
+// Tests patterns at the edge of 64 bits.
+bool TestWidePatterns() {
+  const digit_pattern<> top{"18446744073709551615"};
+  if (!top.matches(UINT64_MAX) || top.matches(UINT64_MAX - 1)) {
+    return false;
+  }
+
+  const digit_pattern<> high{"1[89]??????????????????"};
+  if (!high.matches(UINT64_MAX)) { return false; }
+
+  const digit_pattern<> overflow{"99999999999999999999"};
+  if (overflow.matches(UINT64_MAX)) { return false; }
+
+  const digit_pattern<> too_long{"1????????????????????"};
+  if (too_long.matches(UINT64_MAX)) { return false; }
+
+  return true;
+}
+
+// Returns true if 'pattern' matches the string 's', by brute force.  This
+// is a simple recursive glob over the pattern syntax.
+bool glob(const char* pattern, const char* s) {
+  if (*pattern == '\0') { return *s == '\0'; }
+  if (*pattern == '*') {
+    return glob(pattern + 1, s) || (*s != '\0' && glob(pattern, s + 1));
+  }
+  if (*s == '\0') { return false; }
+  if (*pattern == '?') { return glob(pattern + 1, s + 1); }
+  if (*pattern == '[') {
+    const auto close = std::strchr(pattern, ']');
+    const bool negate = pattern[1] == '^';
+    bool found = false;
+    for (auto p = pattern + 1 + negate; p != close; ++p) {
+      if (p[1] == '-' && p + 2 != close) {
+        found |= *s >= p[0] && *s <= p[2];
+        p += 2;
+      } else {
+        found |= *s == *p;
+      }
+    }
+    return found != negate && glob(close + 1, s + 1);
+  }
+  return *pattern == *s && glob(pattern + 1, s + 1);
+}
+
+// Compares the span matchers against a brute-force glob on random values.
+bool TestSpanMatchersMatchBruteForce() {
+  auto rng = std::mt19937_64{81};
+  auto values = std::vector<std::int64_t>{};
+  for (int i = 0; i != 5000; ++i) {
+    const auto digits = 1 + rng() % 18;
+    auto value = std::int64_t(rng() % jz::detail::radix_power<
+                                  std::uint64_t, 10>(digits));
+    values.push_back(rng() & 1 ? -value : value);
+  }
+
+  const char* patterns[] = {
+    "1*", "*7", "??", "1?3?5", "[1-4]*[^0-2]", "*12*3*", "9[0-4]???[5-9]*",
+    "[2468]?????????", "*0*0*0*", "5", "12345678901?",
+  };
+
+  for (const auto text : patterns) {
+    const digit_pattern<> pattern{text};
+    auto expected = std::vector<std::size_t>{};
+    for (std::size_t i = 0; i != values.size(); ++i) {
+      const auto u = values[i] < 0 ? -std::uint64_t(values[i])
+                                   : std::uint64_t(values[i]);
+      if (glob(text, std::to_string(u).c_str())) { expected.push_back(i); }
+    }
+
+    auto found = std::vector<std::size_t>{};
+    pattern.find_matches(values.data(), values.data() + values.size(),
+                         std::back_inserter(found));
+    if (found != expected) { return false; }
+
+    auto bitmap = std::vector<std::uint64_t>((values.size() + 63) / 64);
+    const auto count = pattern.match(
+        values.data(), values.data() + values.size(), bitmap.data());
+    if (count != expected.size()) { return false; }
+    for (const auto i : expected) {
+      if (((bitmap[i / 64] >> (i % 64)) & 1) == 0) { return false; }
+    }
+  }
+
+  return true;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestFixedLengthPatterns),
+  TEST_CASE(TestDigitClasses),
+  TEST_CASE(TestStars),
+  TEST_CASE(TestAdaptorsWithLeadingZeros),
+  TEST_CASE(TestMalformedPatterns),
+  TEST_CASE(TestWidePatterns),
+  TEST_CASE(TestSpanMatchersMatchBruteForce),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
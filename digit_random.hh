@@ -0,0 +1,395 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_RANDOM_HH_
+#define DIGIT_RANDOM_HH_
+
+#include "digit_adaptor.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+namespace jz {
+
+// Draws integers whose digits follow a given distribution:  how many digits
+// each value has, and how likely each digit is at each position.  Load
+// tests want data shaped like the real thing, such as amounts whose leading
+// digits follow Benford's law, or fixed-width codes with leading zeros, and
+// a uniform draw over the integers is mostly 19-digit numbers.
+//
+// digit_random builds each value directly, rather than drawing values and
+// rejecting the ones with the wrong shape.  It picks a length from one alias
+// table, then a digit for each position from that position's alias table,
+// and adds each digit times its power of RADIX.  A run of uniform positions
+// at the end of the value comes from a single multiply:  the high half of
+// a 64-bit random number times RADIX^n.  So a Benford-like value costs two
+// alias lookups and a multiply, whatever its length.
+
+// Describes the values digit_random draws.
+struct digit_distribution {
+  // lengths[i] is the weight of values with i + 1 digits.
+  std::vector<double> lengths;
+
+  // positions[p][d] is the weight of digit d at position p, counting from
+  // the most significant digit.  Each row holds RADIX weights.  Positions
+  // past the end, and empty rows, are uniform.
+  std::vector<std::vector<double>> positions;
+
+  // If true, a value's length includes its leading zeros, as with
+  // fixed-width codes.  Otherwise, values of two or more digits never start
+  // with a zero, so each value's length is its natural digit count.
+  bool leading_zeros = false;
+};
+
+// Returns a distribution with every length from 'min_digits' through
+// 'max_digits' equally likely, and uniform digits.
+inline digit_distribution uniform_digit_lengths(std::size_t min_digits,
+                                                std::size_t max_digits) {
+  auto dist = digit_distribution{};
+  for (auto d = std::size_t{1}; d <= max_digits; ++d) {
+    dist.lengths.push_back(d >= min_digits ? 1.0 : 0.0);
+  }
+  return dist;
+}
+
+// Returns a distribution like uniform_digit_lengths(), but whose leading
+// digits follow Benford's law:  d leads with probability log(1 + 1/d).
+template <int RADIX = 10>
+digit_distribution benford_digits(std::size_t min_digits,
+                                  std::size_t max_digits) {
+  auto dist = uniform_digit_lengths(min_digits, max_digits);
+  dist.positions.emplace_back(RADIX, 0.0);
+  for (int d = 1; d != RADIX; ++d) {
+    dist.positions[0][d] = std::log1p(1.0 / d);
+  }
+  return dist;
+}
+
+// Returns a distribution of 'width'-digit codes, with leading zeros, and
+// uniform digits.
+inline digit_distribution fixed_width_digits(std::size_t width) {
+  auto dist = uniform_digit_lengths(width, width);
+  dist.leading_zeros = true;
+  return dist;
+}
+
+namespace detail {
+
+// Returns the largest n such that every n-digit RADIX number fits in T.
+template <typename T, int RADIX>
+constexpr std::size_t max_full_digits() noexcept {
+  auto u = static_cast<std::uint64_t>(std::numeric_limits<T>::max());
+  auto d = std::size_t{0};
+
+  while (u >= RADIX - 1) {
+    u = (u - (RADIX - 1)) / RADIX;
+    d++;
+  }
+
+  return d;
+}
+
+// Generates 64-bit random numbers with one multiply each, as wyrand does.
+// Its quality is plenty for test data, and it's several times faster than
+// std::mt19937_64.
+class digit_rng {
+ public:
+  explicit digit_rng(std::uint64_t seed) noexcept : state_{seed} { }
+
+  std::uint64_t operator()() noexcept {
+    state_ += 0xA0761D6478BD642FULL;
+    const auto p = umul128(state_, state_ ^ 0xE7037ED1A0B428DBULL);
+    return p.hi ^ p.lo;
+  }
+
+ private:
+  std::uint64_t state_;
+};
+
+// Holds one column of a Vose alias table.  A draw picks a column, then keeps
+// it if a second draw falls below 'threshold', or takes 'alias' otherwise.
+struct alias_entry {
+  std::uint32_t threshold;
+  std::uint32_t alias;
+};
+
+// Builds an alias table over 'weights' into 'out'.  Returns false if the
+// weights are negative, not finite, or all zero.
+inline bool build_alias_table(const double* weights, std::size_t n,
+                              alias_entry* out) {
+  auto sum = 0.0;
+  for (std::size_t i = 0; i != n; ++i) {
+    if (!(weights[i] >= 0.0) || !std::isfinite(weights[i])) {
+      return false;
+    }
+    sum += weights[i];
+  }
+  if (!(sum > 0.0) || !std::isfinite(sum)) {
+    return false;
+  }
+
+  auto scaled = std::vector<double>(n);
+  auto small = std::vector<std::uint32_t>{};
+  auto large = std::vector<std::uint32_t>{};
+  for (std::size_t i = 0; i != n; ++i) {
+    scaled[i] = weights[i] * double(n) / sum;
+    (scaled[i] < 1.0 ? small : large).push_back(std::uint32_t(i));
+  }
+
+  while (!small.empty() && !large.empty()) {
+    const auto s = small.back();
+    const auto l = large.back();
+    small.pop_back();
+    out[s] = {static_cast<std::uint32_t>(scaled[s] * 4294967296.0), l};
+    scaled[l] -= 1.0 - scaled[s];
+    if (scaled[l] < 1.0) {
+      large.pop_back();
+      small.push_back(l);
+    }
+  }
+
+  // What's left is full, up to rounding.  These keep their own column.
+  for (const auto i : small) { out[i] = {0xFFFFFFFFu, i}; }
+  for (const auto i : large) { out[i] = {0xFFFFFFFFu, i}; }
+  return true;
+}
+
+// Draws from an alias table of 'n' columns with 32 random bits.  The high
+// half of bits * n picks the column, and the low half, which is uniform
+// too, decides between it and its alias.  The choice is a mask rather than
+// a branch, which would mispredict on every skewed table.
+inline std::uint32_t draw_alias(const alias_entry* table, std::size_t n,
+                                std::uint32_t bits) noexcept {
+  const auto m = std::uint64_t{bits} * n;
+  const auto column = static_cast<std::uint32_t>(m >> 32);
+  const auto& entry = table[column];
+  const auto take_alias =
+      0u - std::uint32_t{static_cast<std::uint32_t>(m) >= entry.threshold};
+  return column ^ ((column ^ entry.alias) & take_alias);
+}
+
+// Returns true if every weight in 'row' is the same.
+inline bool uniform_weights(const std::vector<double>& row) noexcept {
+  for (const auto w : row) {
+    if (w != row.front()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace detail
+
+// Draws T values, of up to kMaxDigits RADIX digits, from a
+// digit_distribution.  Values are never negative, even for signed T.
+template <typename T, int RADIX = 10>
+class digit_random {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= 8,
+                "T must be an integer type of up to 64 bits");
+  static_assert(RADIX > 1, "RADIX must be larger than 1");
+
+ public:
+  // The most digits a value can have.  Every value of this many digits fits
+  // in T.
+  static constexpr std::size_t kMaxDigits =
+      detail::max_full_digits<T, RADIX>();
+
+  // Prepares to draw from 'dist', seeding the generator with 'seed'.  A
+  // distribution with lengths past kMaxDigits, a row of the wrong size, bad
+  // weights, or a length whose positions can't all be filled isn't valid(),
+  // and draws zeros.
+  explicit digit_random(const digit_distribution& dist,
+                        std::uint64_t seed = 0)
+      : rng_{seed} {
+    valid_ = build(dist);
+  }
+
+  // Returns true if the distribution made sense.
+  bool valid() const noexcept { return valid_; }
+
+  // Returns the next value.
+  T operator()() noexcept {
+    std::size_t digits;
+    return (*this)(digits);
+  }
+
+  // Returns the next value, and sets 'digits' to its length.
+  T operator()(std::size_t& digits) noexcept {
+    digits = 1;
+    return valid_ ? draw(rng_, digits) : T{0};
+  }
+
+  // Fills [first, last) with values, and the matching entries of 'digits'
+  // with their lengths, if 'digits' isn't null.
+  void generate(T* first, T* last, std::size_t* digits = nullptr) noexcept {
+    // A local copy of the generator stays in a register.  The member could
+    // alias the output, so the compiler would store and reload it.
+    if (!valid_) {
+      std::fill(first, last, T{0});
+      if (digits) {
+        std::fill(digits, digits + (last - first), std::size_t{1});
+      }
+      return;
+    }
+
+    auto rng = rng_;
+    std::size_t length;
+    for (; first != last; ++first) {
+      *first = draw(rng, length);
+      if (digits) {
+        *digits++ = length;
+      }
+    }
+    rng_ = rng;
+  }
+
+ private:
+  // Says how to draw values of one length:  the first 'head' positions from
+  // their alias tables, the first of them from table 'first_table', and
+  // the rest as 'tail_base' plus one multiply by 'tail_scale'.  A
+  // 'tail_scale' of zero stands for 2^64, which the power table can't hold.
+  // When every position is uniform, but the value can't start with a zero,
+  // the tail covers the whole value, from RADIX^(length - 1) up.
+  struct length_plan {
+    std::uint32_t head = 0;
+    std::uint32_t first_table = 0;
+    std::uint64_t tail_base = 0;
+    std::uint64_t tail_scale = 0;
+  };
+
+  // Draws one value with 'rng', and sets 'digits' to its length.  The
+  // distribution must be valid().
+  T draw(detail::digit_rng& rng, std::size_t& digits) const noexcept {
+    const auto r = rng();
+    const auto length = detail::draw_alias(
+        lengths_.data(), lengths_.size(), static_cast<std::uint32_t>(r)) + 1;
+    const auto& plan = plans_[length];
+    digits = length;
+
+    auto value = plan.head == 0 ? 0 : draw_head(rng, plan, length, r >> 32);
+    if (plan.head != length) {
+      const auto tail = rng();
+      const auto scaled = plan.tail_scale == 0
+          ? tail : detail::umul128(tail, plan.tail_scale).hi;
+      value += plan.tail_base + scaled;
+    }
+    return static_cast<T>(value);
+  }
+
+  // Draws the positions that have alias tables.  Each draw uses 32 bits.
+  // The first position gets 'bits', what's left of the number that picked
+  // the length, and each later pair of positions shares a number.
+  std::uint64_t draw_head(detail::digit_rng& rng, const length_plan& plan,
+                          std::size_t length,
+                          std::uint64_t bits) const noexcept {
+    const auto& powers = detail::radix_powers<std::uint64_t, RADIX>::table;
+    auto value = draw_digit(plan.first_table, bits) *
+                 powers.powers[length - 1];
+    for (std::size_t p = 1; p < plan.head; p += 2) {
+      bits = rng();
+      value += draw_digit(p, bits) * powers.powers[length - 1 - p];
+      if (p + 1 != plan.head) {
+        value += draw_digit(p + 1, bits >> 32) * powers.powers[length - 2 - p];
+      }
+    }
+    return value;
+  }
+
+  std::uint64_t draw_digit(std::size_t table,
+                           std::uint64_t bits) const noexcept {
+    return detail::draw_alias(&digits_[table * RADIX], RADIX,
+                              static_cast<std::uint32_t>(bits));
+  }
+
+  // Tables 0 through kMaxDigits - 1 are positions.  Table kMaxDigits is the
+  // first position, without zero, for values that can't start with one.
+  static constexpr std::size_t kNoZeroTable = kMaxDigits;
+
+  bool build(const digit_distribution& dist) {
+    if (dist.lengths.empty() || dist.lengths.size() > kMaxDigits ||
+        dist.positions.size() > kMaxDigits) {
+      return false;
+    }
+    lengths_.resize(dist.lengths.size());
+    if (!detail::build_alias_table(dist.lengths.data(), dist.lengths.size(),
+                                   lengths_.data())) {
+      return false;
+    }
+
+    // Lays out every position's weights, uniform ones included, so that
+    // a length's head can run past a uniform position.
+    auto rows = std::vector<std::vector<double>>(kMaxDigits + 1);
+    auto uniform = std::vector<bool>(kMaxDigits + 1, true);
+    for (std::size_t p = 0; p != kMaxDigits; ++p) {
+      rows[p].assign(RADIX, 1.0);
+      if (p < dist.positions.size() && !dist.positions[p].empty()) {
+        if (dist.positions[p].size() != RADIX) {
+          return false;
+        }
+        rows[p] = dist.positions[p];
+        uniform[p] = detail::uniform_weights(rows[p]);
+      }
+    }
+    rows[kNoZeroTable] = rows[0];
+    rows[kNoZeroTable][0] = 0.0;
+    uniform[kNoZeroTable] = false;
+    const bool uniform_lead = detail::uniform_weights(std::vector<double>(
+        rows[0].begin() + 1, rows[0].end()));
+
+    digits_.resize((kMaxDigits + 1) * RADIX);
+    auto usable = std::vector<bool>(kMaxDigits + 1);
+    for (std::size_t t = 0; t != rows.size(); ++t) {
+      usable[t] = detail::build_alias_table(rows[t].data(), RADIX,
+                                            &digits_[t * RADIX]);
+    }
+
+    const auto& powers = detail::radix_powers<std::uint64_t, RADIX>::table;
+    plans_.resize(dist.lengths.size() + 1);
+    for (std::size_t length = 1; length != plans_.size(); ++length) {
+      auto& plan = plans_[length];
+      plan.first_table = static_cast<std::uint32_t>(
+          length > 1 && !dist.leading_zeros ? kNoZeroTable : 0);
+
+      for (std::size_t p = 0; p != length; ++p) {
+        const auto table = p == 0 ? plan.first_table : p;
+        if (!uniform[table]) {
+          plan.head = static_cast<std::uint32_t>(p + 1);
+        }
+        if (!usable[table] && dist.lengths[length - 1] > 0.0) {
+          return false;
+        }
+      }
+
+      if (plan.head == 1 && plan.first_table == kNoZeroTable && uniform_lead) {
+        plan.head = 0;
+        plan.tail_base = powers.powers[length - 1];
+      }
+
+      // Subtracting the base wraps, so 2^64 - base comes out right too.
+      const auto tail = length - plan.head;
+      plan.tail_scale =
+          (tail < powers.kCount ? powers.powers[tail] : 0) - plan.tail_base;
+    }
+    return true;
+  }
+
+  detail::digit_rng                rng_;
+  bool                             valid_ = false;
+  std::vector<detail::alias_entry> lengths_;
+  std::vector<detail::alias_entry> digits_;
+  std::vector<length_plan>         plans_;
+};
+
+template <typename T, int RADIX>
+constexpr std::size_t digit_random<T, RADIX>::kMaxDigits;
+
+template <typename T, int RADIX>
+constexpr std::size_t digit_random<T, RADIX>::kNoZeroTable;
+
+}  // namespace jz
+
+#endif  // DIGIT_RANDOM_HH_
@@ -0,0 +1,180 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_random.hh"
+#include "digit_test.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using jz::digit_distribution;
+using jz::digit_random;
+
+constexpr int kDraws = 200000;
+
+// Returns true if 'count' of kDraws is within 'slack' of 'probability'.
+bool near(int count, double probability, double slack = 0.01) {
+  return std::fabs(double(count) / kDraws - probability) <= slack;
+}
+
+// Returns the digits of 'value', most significant first, padded to
+// 'length' with leading zeros.
+template <int RADIX = 10>
+std::vector<int> digits_of(std::uint64_t value, std::size_t length) {
+  auto digits = std::vector<int>(length);
+  for (auto i = length; i-- != 0; value /= RADIX) {
+    digits[i] = static_cast<int>(value % RADIX);
+  }
+  return value == 0 ? digits : std::vector<int>{};
+}
+
+// Tests that values have the lengths they claim, without leading zeros, in
+// the proportions asked for.
+bool TestLengths() {
+  auto dist = digit_distribution{};
+  dist.lengths = {1, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1};
+  digit_random<std::uint64_t> random{dist, 88};
+  if (!random.valid()) { return false; }
+
+  int counts[20] = {};
+  for (int i = 0; i != kDraws; ++i) {
+    std::size_t length;
+    const auto value = random(length);
+    const auto digits = digits_of(value, length);
+    if (length > 19 || digits.empty() || (length > 1 && digits[0] == 0)) {
+      return false;
+    }
+    ++counts[length];
+  }
+  return near(counts[1], 0.25) && near(counts[3], 0.5) &&
+         near(counts[19], 0.25);
+}
+
+// Tests that leading digits follow Benford's law, and that the rest of the
+// digits stay uniform.
+bool TestBenford() {
+  digit_random<std::uint32_t> random{jz::benford_digits(2, 9), 880};
+  int leading[10] = {}, last[10] = {};
+  for (int i = 0; i != kDraws; ++i) {
+    std::size_t length;
+    const auto value = random(length);
+    const auto digits = digits_of(value, length);
+    if (digits.empty() || digits[0] == 0) { return false; }
+    ++leading[digits[0]];
+    ++last[digits.back()];
+  }
+  for (int d = 1; d != 10; ++d) {
+    if (!near(leading[d], std::log10(1.0 + 1.0 / d))) { return false; }
+  }
+  for (int d = 0; d != 10; ++d) {
+    if (!near(last[d], 0.1)) { return false; }
+  }
+  return true;
+}
+
+// Tests fixed-width codes, whose leading zeros count, with a skewed
+// distribution in the middle.
+bool TestFixedWidth() {
+  auto dist = jz::fixed_width_digits(5);
+  dist.positions = {{}, {}, {1, 0, 1, 0, 1, 0, 1, 0, 1, 0},
+                    {0, 0, 0, 0, 0, 0, 0, 1, 0, 0}};
+  digit_random<int> random{dist, 8800};
+  if (!random.valid()) { return false; }
+
+  int first_zero = 0;
+  for (int i = 0; i != kDraws; ++i) {
+    std::size_t length;
+    const auto value = random(length);
+    const auto digits = digits_of(value, length);
+    if (length != 5 || value < 0 || digits.empty() || digits[2] % 2 != 0 ||
+        digits[3] != 7) {
+      return false;
+    }
+    first_zero += digits[0] == 0;
+  }
+  return near(first_zero, 0.1);
+}
+
+// Tests the widest values:  ones that need every bit of a 64-bit word, and
+// the largest that fit in small and signed types.
+bool TestExtremes() {
+  if (digit_random<std::uint64_t, 16>::kMaxDigits != 16 ||
+      digit_random<std::uint64_t, 2>::kMaxDigits != 64 ||
+      digit_random<std::int64_t>::kMaxDigits != 18 ||
+      digit_random<std::int8_t>::kMaxDigits != 2) {
+    return false;
+  }
+
+  digit_random<std::uint64_t, 16> hex{jz::fixed_width_digits(16), 88000};
+  auto seen_top = false;
+  for (int i = 0; i != 1000; ++i) {
+    seen_top |= hex() >> 60 == 0xF;
+  }
+
+  digit_random<std::int8_t> small{jz::uniform_digit_lengths(2, 2)};
+  for (int i = 0; i != 1000; ++i) {
+    const auto value = small();
+    if (value < 10 || value > 99) { return false; }
+  }
+  return seen_top;
+}
+
+// Tests that a seed repeats its sequence, and generate() matches one draw
+// at a time.
+bool TestGenerate() {
+  const auto dist = jz::benford_digits(1, 12);
+  digit_random<std::uint64_t> a{dist, 7}, b{dist, 7};
+  auto values = std::vector<std::uint64_t>(1000);
+  auto lengths = std::vector<std::size_t>(1000);
+  a.generate(values.data(), values.data() + values.size(), lengths.data());
+
+  for (std::size_t i = 0; i != values.size(); ++i) {
+    std::size_t length;
+    if (b(length) != values[i] || length != lengths[i]) { return false; }
+  }
+  return true;
+}
+
+// Tests distributions that can't be drawn from.
+bool TestInvalid() {
+  const auto invalid = [](const digit_distribution& dist) {
+    digit_random<std::uint64_t> random{dist};
+    return !random.valid() && random() == 0;
+  };
+
+  auto dist = digit_distribution{};
+  if (!invalid(dist)) { return false; }                     // No lengths.
+  if (!invalid(jz::uniform_digit_lengths(1, 20))) { return false; }
+  if (!invalid(jz::uniform_digit_lengths(3, 2))) { return false; }
+  dist.lengths = {1, -1};
+  if (!invalid(dist)) { return false; }
+
+  // Only zero may lead, which a 2-digit value can't have.
+  dist = jz::uniform_digit_lengths(1, 2);
+  dist.positions = {{1, 0, 0, 0, 0, 0, 0, 0, 0, 0}};
+  if (!invalid(dist)) { return false; }
+  dist.lengths = {1, 0};                                     // 1 digit is OK.
+  if (invalid(dist)) { return false; }
+
+  dist.positions = {{1, 2, 3}};                              // Short row.
+  return invalid(dist);
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestLengths),
+  TEST_CASE(TestBenford),
+  TEST_CASE(TestFixedWidth),
+  TEST_CASE(TestExtremes),
+  TEST_CASE(TestGenerate),
+  TEST_CASE(TestInvalid),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
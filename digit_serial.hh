@@ -0,0 +1,442 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_SERIAL_HH_
+#define DIGIT_SERIAL_HH_
+
+#include "digit_adaptor.hh"
+#include "digit_batch.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace jz {
+
+// Binary formats for digit sequences that keep their digit count.  A
+// digit_adaptor with an explicit digit count gives leading zeros meaning
+// (007 isn't 7), which writing out the plain integer loses, and which text
+// keeps at a byte per digit.
+//
+// The record format writes one value on its own, in 1 to 20 bytes:  a
+// varint of the value's magnitude, whose first byte also carries the sign,
+// and a flag for an explicit digit count, which follows as a second varint
+// only when it differs from the value's natural count.  So values without
+// leading zeros cost what a plain varint would.
+//
+// The column format writes an array, in blocks of kDigitColumnBlock values.
+// Each block holds its first value, then the zigzag deltas between
+// neighbors bit-packed at the block's widest delta, then the digit counts,
+// which it stores as "all natural," as one count for the block, or
+// bit-packed one per value.  Sorted keys and fixed-width codes (zip codes,
+// account numbers) pack down to a few bits per value.
+//
+// Encoders write through a raw pointer, which must have room for the
+// bound, and return the end of what they wrote.  Decoders return the end of
+// what they read, or nullptr if the input is truncated or malformed.  Both
+// formats are little-endian on every host.
+
+constexpr std::size_t kMaxDigitRecordBytes = 20;
+constexpr std::size_t kDigitColumnBlock = 128;
+
+namespace detail {
+
+template <typename T>
+constexpr std::uint64_t serial_magnitude(T value) noexcept {
+  return value < 0 ? std::uint64_t{0} - static_cast<std::uint64_t>(value)
+                   : static_cast<std::uint64_t>(value);
+}
+
+inline unsigned char* put_varint(std::uint64_t value,
+                                 unsigned char* out) noexcept {
+  while (value >= 0x80) {
+    *out++ = static_cast<unsigned char>(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = static_cast<unsigned char>(value);
+  return out;
+}
+
+// Reads a varint into 'value', starting 'shift' bits up.  Returns nullptr
+// if the input runs out, or the value passes 64 bits.
+inline const unsigned char* get_varint(const unsigned char* p,
+                                       const unsigned char* last,
+                                       std::uint64_t& value,
+                                       int shift = 0) noexcept {
+  for (; shift < 64; shift += 7) {
+    if (p == last) {
+      return nullptr;
+    }
+    const auto byte = std::uint64_t{*p++};
+    const auto bits = byte & 0x7F;
+    if (shift > 57 && (bits >> (64 - shift)) != 0) {
+      return nullptr;
+    }
+    value |= bits << shift;
+    if ((byte & 0x80) == 0) {
+      return p;
+    }
+  }
+  return nullptr;
+}
+
+constexpr std::uint64_t zigzag(std::uint64_t delta) noexcept {
+  return (delta << 1) ^ (std::uint64_t{0} - (delta >> 63));
+}
+
+constexpr std::uint64_t unzigzag(std::uint64_t z) noexcept {
+  return (z >> 1) ^ (std::uint64_t{0} - (z & 1));
+}
+
+inline void store_le64(std::uint64_t value, unsigned char* p) noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  value = __builtin_bswap64(value);
+#endif
+  std::memcpy(p, &value, sizeof value);
+}
+
+inline std::uint64_t load_le64(const unsigned char* p) noexcept {
+  return load_le64(reinterpret_cast<const char*>(p));
+}
+
+constexpr std::size_t packed_bytes(std::size_t count, int width) noexcept {
+  return (count * static_cast<std::size_t>(width) + 7) / 8;
+}
+
+// Packs 'count' values of 'width' bits, least significant bit first.  Each
+// value is OR'ed into a 64-bit accumulator, which goes out a word at a
+// time.  'out' needs 8 bytes of slack past packed_bytes(count, width).
+inline unsigned char* pack_bits(const std::uint64_t* values,
+                                std::size_t count, int width,
+                                unsigned char* out) noexcept {
+  if (width == 0) {
+    return out;
+  }
+  const auto end = out + packed_bytes(count, width);
+  auto acc = std::uint64_t{0};
+  auto bits = 0;
+  for (std::size_t i = 0; i != count; ++i) {
+    const auto v = values[i];
+    acc |= v << bits;
+    bits += width;
+    if (bits >= 64) {
+      store_le64(acc, out);
+      out += 8;
+      bits -= 64;
+      acc = bits != 0 ? v >> (width - bits) : 0;
+    }
+  }
+  if (bits != 0) {
+    store_le64(acc, out);
+  }
+  return end;
+}
+
+// Unpacks 'count' values of 'width' bits.  Each value comes from one
+// unaligned 64-bit load at its byte offset, plus one more byte when it
+// straddles nine.  'in' must be readable 8 bytes past the packed data.
+inline void unpack_bits(const unsigned char* in, std::size_t count, int width,
+                        std::uint64_t* values) noexcept {
+  if (width == 0) {
+    std::fill(values, values + count, std::uint64_t{0});
+    return;
+  }
+  const auto mask = width == 64 ? ~std::uint64_t{0}
+                                : (std::uint64_t{1} << width) - 1;
+  auto bit = std::size_t{0};
+  for (std::size_t i = 0; i != count; ++i, bit += width) {
+    const auto p = in + bit / 8;
+    const auto shift = static_cast<int>(bit % 8);
+    auto v = load_le64(p) >> shift;
+    if (shift + width > 64) {
+      v |= std::uint64_t{p[8]} << (64 - shift);
+    }
+    values[i] = v & mask;
+  }
+}
+
+// Returns true if 'magnitude' has exactly 'digits' RADIX digits.  This
+// checks the value against the powers on either side, which is cheaper than
+// counting its digits.
+template <int RADIX>
+bool has_natural_digits(std::uint64_t magnitude, std::size_t digits) noexcept {
+  const auto& powers = radix_powers<std::uint64_t, RADIX>::table;
+  if (digits == 0 || digits > powers.kCount) {
+    return false;
+  }
+  return (digits == 1 || magnitude >= powers.powers[digits - 1]) &&
+         (digits == powers.kCount || magnitude < powers.powers[digits]);
+}
+
+enum digit_column_mode : unsigned char {
+  kNaturalDigits = 0,  // Every value has its natural digit count.
+  kBlockDigits = 1,    // Every value has the same digit count.
+  kPackedDigits = 2,   // Each value's digit count is packed.
+};
+
+}  // namespace detail
+
+// Writes 'value' with 'digits' digits as a record, and returns the end of
+// the output.  'out' needs room for kMaxDigitRecordBytes bytes.
+template <int RADIX = 10, typename T>
+unsigned char* encode_digit_record(T value, std::size_t digits,
+                                   unsigned char* out) noexcept {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= 8,
+                "T must be an integer type of up to 64 bits");
+
+  const auto magnitude = detail::serial_magnitude(value);
+  const bool explicit_digits =
+      !detail::has_natural_digits<RADIX>(magnitude, digits);
+
+  auto first = static_cast<unsigned char>(
+      (magnitude & 0x1F) << 2 | (value < 0) << 1 | explicit_digits);
+  if (magnitude > 0x1F) {
+    *out++ = first | 0x80;
+    out = detail::put_varint(magnitude >> 5, out);
+  } else {
+    *out++ = first;
+  }
+  return explicit_digits ? detail::put_varint(digits, out) : out;
+}
+
+// Writes a digit_adaptor's number, with its digit count.
+template <typename T, int RADIX, typename Tables>
+unsigned char* encode_digit_record(
+    const digit_adaptor<T, RADIX, Tables>& adaptor,
+    unsigned char* out) noexcept {
+  return encode_digit_record<RADIX>(static_cast<T>(adaptor), adaptor.size(),
+                                    out);
+}
+
+// Reads a record from [first, last) into 'value' and 'digits'.  Returns the
+// end of the record, or nullptr if it's truncated, malformed, or doesn't
+// fit in T.
+template <int RADIX = 10, typename T>
+const unsigned char* decode_digit_record(const unsigned char* first,
+                                         const unsigned char* last, T& value,
+                                         std::size_t& digits) noexcept {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= 8,
+                "T must be an integer type of up to 64 bits");
+  using U = std::make_unsigned_t<T>;
+
+  if (first == last) {
+    return nullptr;
+  }
+  const auto head = *first++;
+  auto magnitude = static_cast<std::uint64_t>((head >> 2) & 0x1F);
+  if (head & 0x80) {
+    first = detail::get_varint(first, last, magnitude, 5);
+    if (!first) {
+      return nullptr;
+    }
+  }
+
+  const bool negative = (head & 2) != 0;
+  const auto limit = std::uint64_t{std::numeric_limits<U>::max()} >>
+                     std::is_signed<T>::value;
+  if (negative ? (!std::is_signed<T>::value || magnitude == 0 ||
+                  magnitude > limit + 1)
+               : magnitude > limit) {
+    return nullptr;
+  }
+
+  auto count = std::uint64_t{0};
+  if (head & 1) {
+    first = detail::get_varint(first, last, count);
+    if (!first || count > std::numeric_limits<std::size_t>::max()) {
+      return nullptr;
+    }
+  } else {
+    count = count_digits<RADIX>(magnitude);
+  }
+
+  value = static_cast<T>(negative ? U{0} - static_cast<U>(magnitude)
+                                  : static_cast<U>(magnitude));
+  digits = static_cast<std::size_t>(count);
+  return first;
+}
+
+// Returns the most bytes encode_digit_column() writes for 'count' values.
+constexpr std::size_t max_digit_column_bytes(std::size_t count) noexcept {
+  const auto blocks = (count + kDigitColumnBlock - 1) / kDigitColumnBlock;
+  // Per block:  three header bytes, the base, the deltas, the digit counts,
+  // and 8 bytes of slack for the packer.
+  return 10 + blocks * (3 + 10 + 8 * kDigitColumnBlock + kDigitColumnBlock
+                        + 8);
+}
+
+// Writes 'count' values as a column, with the digit counts in 'digits', or
+// with their natural digit counts if 'digits' is null.  Returns the end of
+// the output.  'out' needs room for max_digit_column_bytes(count) bytes.
+template <int RADIX = 10, typename T>
+unsigned char* encode_digit_column(const T* values,
+                                   const std::uint8_t* digits,
+                                   std::size_t count,
+                                   unsigned char* out) noexcept {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= 8,
+                "T must be an integer type of up to 64 bits");
+
+  std::uint64_t deltas[kDigitColumnBlock];
+  std::uint64_t widths[kDigitColumnBlock];
+
+  out = detail::put_varint(count, out);
+  for (std::size_t start = 0; start < count; start += kDigitColumnBlock) {
+    const auto n = std::min(kDigitColumnBlock, count - start);
+    const auto block = values + start;
+
+    // Deltas wrap, so any pair of 64-bit patterns has one.  Zigzag keeps
+    // small steps down as small as small steps up.
+    auto prev = static_cast<std::uint64_t>(block[0]);
+    auto any = std::uint64_t{0};
+    for (std::size_t i = 1; i != n; ++i) {
+      const auto v = static_cast<std::uint64_t>(block[i]);
+      deltas[i - 1] = detail::zigzag(v - prev);
+      any |= deltas[i - 1];
+      prev = v;
+    }
+    const auto width = detail::bit_length(any);
+
+    auto mode = detail::kNaturalDigits;
+    auto widest = std::uint64_t{0};
+    if (digits) {
+      auto natural = true, same = true;
+      for (std::size_t i = 0; i != n; ++i) {
+        const auto d = digits[start + i];
+        natural = natural && detail::has_natural_digits<RADIX>(
+            detail::serial_magnitude(block[i]), d);
+        same &= d == digits[start];
+        widths[i] = d;
+        widest |= d;
+      }
+      mode = natural ? detail::kNaturalDigits
+           : same    ? detail::kBlockDigits
+                     : detail::kPackedDigits;
+    }
+
+    *out++ = static_cast<unsigned char>(width);
+    *out++ = mode;
+    out = detail::put_varint(
+        detail::zigzag(static_cast<std::uint64_t>(block[0])), out);
+    out = detail::pack_bits(deltas, n - 1, width, out);
+
+    if (mode == detail::kBlockDigits) {
+      *out++ = digits[start];
+    } else if (mode == detail::kPackedDigits) {
+      const auto digit_width = detail::bit_length(widest);
+      *out++ = static_cast<unsigned char>(digit_width);
+      out = detail::pack_bits(widths, n, digit_width, out);
+    }
+  }
+  return out;
+}
+
+// Returns the number of values in the column starting at 'first', or
+// SIZE_MAX if it doesn't start with a count.
+inline std::size_t digit_column_count(const unsigned char* first,
+                                      const unsigned char* last) noexcept {
+  auto count = std::uint64_t{0};
+  return detail::get_varint(first, last, count) &&
+         count <= std::numeric_limits<std::size_t>::max() - 1
+      ? static_cast<std::size_t>(count) : SIZE_MAX;
+}
+
+// Reads a column of 'count' values from [first, last) into 'values', and
+// their digit counts into 'digits', unless it's null.  Returns the end of
+// the column, or nullptr if it's truncated or malformed, or doesn't hold
+// 'count' values.  Values too wide for T are truncated to T.
+template <int RADIX = 10, typename T>
+const unsigned char* decode_digit_column(const unsigned char* first,
+                                         const unsigned char* last,
+                                         T* values, std::uint8_t* digits,
+                                         std::size_t count) noexcept {
+  static_assert(std::is_integral<T>::value && sizeof(T) <= 8,
+                "T must be an integer type of up to 64 bits");
+
+  // Packed data is read a word at a time.  Near the end of the input, it
+  // comes from this copy instead, which has room to over-read.
+  unsigned char padded[8 * kDigitColumnBlock + 16];
+  std::uint64_t unpacked[kDigitColumnBlock];
+
+  const auto packed = [&](std::size_t bytes) -> const unsigned char* {
+    if (static_cast<std::size_t>(last - first) < bytes) {
+      return nullptr;
+    }
+    if (static_cast<std::size_t>(last - first) >= bytes + 9) {
+      return first;
+    }
+    std::memcpy(padded, first, bytes);
+    std::memset(padded + bytes, 0, 16);
+    return padded;
+  };
+
+  if (digit_column_count(first, last) != count) {
+    return nullptr;
+  }
+  auto header = std::uint64_t{0};
+  first = detail::get_varint(first, last, header);
+
+  for (std::size_t start = 0; start < count; start += kDigitColumnBlock) {
+    const auto n = std::min(kDigitColumnBlock, count - start);
+    if (last - first < 3) {
+      return nullptr;
+    }
+    const int width = *first++;
+    const auto mode = *first++;
+    auto base = std::uint64_t{0};
+    first = detail::get_varint(first, last, base);
+    if (!first || width > 64 || mode > detail::kPackedDigits) {
+      return nullptr;
+    }
+
+    const auto delta_bytes = detail::packed_bytes(n - 1, width);
+    const auto in = packed(delta_bytes);
+    if (!in) {
+      return nullptr;
+    }
+    detail::unpack_bits(in, n - 1, width, unpacked);
+    first += delta_bytes;
+
+    auto v = detail::unzigzag(base);
+    values[start] = static_cast<T>(v);
+    for (std::size_t i = 1; i != n; ++i) {
+      v += detail::unzigzag(unpacked[i - 1]);
+      values[start + i] = static_cast<T>(v);
+    }
+
+    if (mode == detail::kBlockDigits) {
+      if (first == last) {
+        return nullptr;
+      }
+      const auto d = *first++;
+      if (digits) { std::fill(digits + start, digits + start + n, d); }
+    } else if (mode == detail::kPackedDigits) {
+      if (first == last) {
+        return nullptr;
+      }
+      const int digit_width = *first++;
+      const auto digit_bytes = detail::packed_bytes(n, digit_width);
+      const auto din = digit_width <= 8 ? packed(digit_bytes) : nullptr;
+      if (!din) {
+        return nullptr;
+      }
+      first += digit_bytes;
+      if (digits) {
+        detail::unpack_bits(din, n, digit_width, unpacked);
+        for (std::size_t i = 0; i != n; ++i) {
+          digits[start + i] = static_cast<std::uint8_t>(unpacked[i]);
+        }
+      }
+    } else if (digits) {
+      for (std::size_t i = 0; i != n; ++i) {
+        digits[start + i] = static_cast<std::uint8_t>(count_digits<RADIX>(
+            detail::serial_magnitude(values[start + i])));
+      }
+    }
+  }
+  return first;
+}
+
+}  // namespace jz
+#endif // DIGIT_SERIAL_HH_
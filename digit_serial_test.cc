@@ -0,0 +1,242 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_serial.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+
+using jz::decode_digit_column;
+using jz::decode_digit_record;
+using jz::encode_digit_column;
+using jz::encode_digit_record;
+
+template <int RADIX = 10, typename T>
+bool record_round_trips(T value, std::size_t digits,
+                        std::size_t expected_bytes = 0) {
+  unsigned char buf[jz::kMaxDigitRecordBytes] = {};
+  const auto end = encode_digit_record<RADIX>(value, digits, buf);
+  if (expected_bytes != 0 && std::size_t(end - buf) != expected_bytes) {
+    return false;
+  }
+
+  auto got = T{};
+  auto got_digits = std::size_t{};
+  return decode_digit_record<RADIX>(buf, end, got, got_digits) == end &&
+         got == value && got_digits == digits;
+}
+
+// Tests records, with and without leading zeros, at the edges of each type.
+bool TestRecordRoundTrip() {
+  if (!record_round_trips(7, 1, 1))        { return false; }
+  if (!record_round_trips(7, 3, 2))        { return false; }  // 007
+  if (!record_round_trips(0, 1, 1))        { return false; }
+  if (!record_round_trips(0, 5, 2))        { return false; }  // 00000
+  if (!record_round_trips(31, 2, 1))       { return false; }
+  if (!record_round_trips(32, 2, 2))       { return false; }
+  if (!record_round_trips(-12345, 5))      { return false; }
+  if (!record_round_trips(12345, 2))       { return false; }  // Too few.
+  if (!record_round_trips(12345, 1000))    { return false; }
+  if (!record_round_trips<16>(0xBEEFu, 8)) { return false; }
+
+  if (!record_round_trips(std::numeric_limits<std::int64_t>::min(), 19)) {
+    return false;
+  }
+  if (!record_round_trips(std::numeric_limits<std::uint64_t>::max(), 20,
+                          10)) {
+    return false;
+  }
+  if (!record_round_trips(std::numeric_limits<std::int8_t>::min(), 3)) {
+    return false;
+  }
+
+  auto rng = std::mt19937_64{87};
+  for (int i = 0; i != 10000; ++i) {
+    const auto value = static_cast<std::int64_t>(rng() >> (rng() % 64));
+    if (!record_round_trips(value, jz::count_digits(value) + rng() % 3)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tests records written from, and read back into, a digit_adaptor.
+bool TestRecordAdaptor() {
+  auto zip = 2134;
+  unsigned char buf[jz::kMaxDigitRecordBytes] = {};
+  const auto end = encode_digit_record(jz::digit_adaptor<int>{zip, 5}, buf);
+
+  auto value = 0;
+  auto digits = std::size_t{};
+  if (decode_digit_record(buf, end, value, digits) != end) { return false; }
+  if (jz::digit_adaptor<int>{value, digits} != jz::digit_adaptor<int>{zip, 5}) {
+    return false;
+  }
+
+  unsigned char untabled[jz::kMaxDigitRecordBytes] = {};
+  const auto untabled_end = encode_digit_record(
+      jz::digit_adaptor<int, 10, jz::no_tables>{zip, 5}, untabled);
+  return std::equal(buf, end, untabled, untabled_end);
+}
+
+// Tests that truncated, overlong, and out-of-range records fail.
+bool TestRecordErrors() {
+  unsigned char buf[jz::kMaxDigitRecordBytes] = {};
+  auto value = std::int64_t{};
+  auto digits = std::size_t{};
+
+  const auto end = encode_digit_record(-123456789012LL, 20, buf);
+  for (auto p = buf; p != end; ++p) {
+    if (decode_digit_record(buf, p, value, digits)) { return false; }
+  }
+
+  // Eleven continuation bytes can't be a 64-bit value.
+  const unsigned char overlong[] = {
+    0x80, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01
+  };
+  if (decode_digit_record(std::begin(overlong), std::end(overlong), value,
+                          digits)) {
+    return false;
+  }
+
+  // 300 doesn't fit in an 8-bit type, and -1 doesn't fit in an unsigned one.
+  auto small = std::int8_t{};
+  auto u = 0u;
+  const auto big_end = encode_digit_record(300, 3, buf);
+  if (decode_digit_record(buf, big_end, small, digits)) { return false; }
+  const auto neg_end = encode_digit_record(-1, 1, buf);
+  return !decode_digit_record(buf, neg_end, u, digits);
+}
+
+template <int RADIX = 10, typename T>
+bool column_round_trips(const std::vector<T>& values,
+                        const std::vector<std::uint8_t>& digits,
+                        std::size_t* bytes = nullptr) {
+  auto buf = std::vector<unsigned char>(
+      jz::max_digit_column_bytes(values.size()));
+  const auto end = encode_digit_column<RADIX>(
+      values.data(), digits.empty() ? nullptr : digits.data(), values.size(),
+      buf.data());
+  if (bytes) { *bytes = std::size_t(end - buf.data()); }
+
+  // Decoding exactly the encoded bytes exercises the padded path.
+  const auto exact = std::vector<unsigned char>(buf.data(), end);
+  if (jz::digit_column_count(exact.data(), exact.data() + exact.size())
+      != values.size()) {
+    return false;
+  }
+  auto got = std::vector<T>(values.size());
+  auto got_digits = std::vector<std::uint8_t>(values.size());
+  if (decode_digit_column<RADIX>(exact.data(), exact.data() + exact.size(),
+                                 got.data(), got_digits.data(), values.size())
+      != exact.data() + exact.size()) {
+    return false;
+  }
+  if (got != values) { return false; }
+
+  for (std::size_t i = 0; i != values.size(); ++i) {
+    const auto expected = digits.empty()
+        ? jz::count_digits<RADIX>(jz::detail::serial_magnitude(values[i]))
+        : digits[i];
+    if (got_digits[i] != expected) { return false; }
+  }
+  return true;
+}
+
+// Tests columns of every length around the block size, with random
+// values, which need the full delta width.
+bool TestColumnRandom() {
+  auto rng = std::mt19937_64{870};
+  for (const auto n : {0, 1, 2, 127, 128, 129, 1000}) {
+    auto values = std::vector<std::uint64_t>(n);
+    for (auto& value : values) { value = rng(); }
+    if (!column_round_trips(values, {})) { return false; }
+    if (!column_round_trips<16>(values, {})) { return false; }
+  }
+
+  auto extremes = std::vector<std::int64_t>{
+    std::numeric_limits<std::int64_t>::min(),
+    std::numeric_limits<std::int64_t>::max(), 0, -1,
+    std::numeric_limits<std::int64_t>::min(), 1,
+  };
+  return column_round_trips(extremes, {});
+}
+
+// Tests sorted keys, which pack to a few bits each, and fixed-width codes
+// with leading zeros, which store one digit count per block.
+bool TestColumnCompact() {
+  auto rng = std::mt19937_64{8700};
+  auto keys = std::vector<std::uint64_t>(10000);
+  auto key = std::uint64_t{1600000000000};
+  for (auto& k : keys) { k = key += rng() % 16; }
+
+  auto bytes = std::size_t{};
+  if (!column_round_trips(keys, {}, &bytes)) { return false; }
+  if (bytes > keys.size() * 6 / 8) { return false; }
+
+  auto zips = std::vector<std::uint32_t>(10000);
+  for (auto& zip : zips) { zip = static_cast<std::uint32_t>(rng() % 100000); }
+  if (!column_round_trips(zips, std::vector<std::uint8_t>(zips.size(), 5),
+                          &bytes)) {
+    return false;
+  }
+
+  // Mixed widths within a block get packed counts.
+  auto mixed = std::vector<std::uint8_t>(zips.size());
+  for (auto& d : mixed) { d = static_cast<std::uint8_t>(5 + rng() % 4); }
+  return column_round_trips(zips, mixed);
+}
+
+// Tests that every truncation of a column fails, as do corrupt headers.
+bool TestColumnErrors() {
+  auto values = std::vector<std::int32_t>{};
+  auto digits = std::vector<std::uint8_t>{};
+  for (int i = 0; i != 300; ++i) {
+    values.push_back(i * i * (i % 2 ? 1 : -1));
+    digits.push_back(static_cast<std::uint8_t>(6 + i % 3));
+  }
+
+  auto buf = std::vector<unsigned char>(
+      jz::max_digit_column_bytes(values.size()));
+  const auto end = encode_digit_column(values.data(), digits.data(),
+                                       values.size(), buf.data());
+  auto got = std::vector<std::int32_t>(values.size());
+
+  for (auto p = buf.data(); p != end; ++p) {
+    const auto cut = std::vector<unsigned char>(buf.data(), p);
+    if (decode_digit_column(cut.data(), cut.data() + cut.size(), got.data(),
+                            nullptr, values.size())) {
+      return false;
+    }
+  }
+  if (decode_digit_column(buf.data(), end, got.data(), nullptr,
+                          values.size() - 1)) {
+    return false;
+  }
+
+  buf[1] = 65;  // The first block's delta width.
+  return !decode_digit_column(buf.data(), end, got.data(), nullptr,
+                              values.size());
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestRecordRoundTrip),
+  TEST_CASE(TestRecordAdaptor),
+  TEST_CASE(TestRecordErrors),
+  TEST_CASE(TestColumnRandom),
+  TEST_CASE(TestColumnCompact),
+  TEST_CASE(TestColumnErrors),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,551 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_SERVICE_HH_
+#define DIGIT_SERVICE_HH_
+
+#include "digit_file_pipeline.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace jz {
+
+// The wire protocol is a stream of fixed-size headers, each followed by
+// 'count' 64-bit values in host byte order.  The socket is local, so there
+// is no byte swapping.  A connection may have many requests outstanding,
+// and gets its responses in the order it sent the requests.
+constexpr std::uint32_t kDigitServiceMaxValues = std::uint32_t{1} << 16;
+
+struct digit_service_request {
+  std::uint32_t id;        // Echoed in the response.
+  std::uint16_t op;        // A digit_file_op.
+  std::uint16_t radix;     // 2, 8, 10, 16, or 36.
+  std::uint32_t count;     // Values that follow, up to the maximum.
+  std::uint32_t reserved;
+};
+
+struct digit_service_response {
+  std::uint32_t id;
+  std::int32_t  status;    // 0, or EINVAL for an unsupported op or radix.
+  std::uint32_t count;     // Results that follow:  'count' on success, or 0.
+  std::uint32_t reserved;
+};
+
+static_assert(sizeof(digit_service_request) == 16, "unexpected padding");
+static_assert(sizeof(digit_service_response) == 16, "unexpected padding");
+
+// Counts what a digit_service did.
+struct digit_service_stats {
+  std::uint64_t connections = 0;
+  std::uint64_t requests = 0;
+  std::uint64_t batches = 0;   // Kernel calls.  Requests per batch > 1
+  std::uint64_t values = 0;    // means requests were coalesced.
+};
+
+namespace detail {
+
+template <int RADIX>
+bool service_transform(digit_file_op op, const std::uint64_t* first,
+                       const std::uint64_t* last, std::uint64_t* out) {
+  switch (op) {
+    case digit_file_op::reverse_digits:
+    case digit_file_op::sort_digits:
+    case digit_file_op::digit_sums:
+    case digit_file_op::check_digits:
+      apply_digit_file_op<std::uint64_t, RADIX>(op, first, last, out);
+      return true;
+  }
+  return false;
+}
+
+// Applies 'op' in 'radix' to [first, last).  Returns false if either one
+// isn't supported.
+inline bool service_transform(digit_file_op op, int radix,
+                              const std::uint64_t* first,
+                              const std::uint64_t* last, std::uint64_t* out) {
+  switch (radix) {
+    case 2:  return service_transform<2>(op, first, last, out);
+    case 8:  return service_transform<8>(op, first, last, out);
+    case 10: return service_transform<10>(op, first, last, out);
+    case 16: return service_transform<16>(op, first, last, out);
+    case 36: return service_transform<36>(op, first, last, out);
+    default: return false;
+  }
+}
+
+// Fills in a sockaddr_un for 'path'.  Returns false if it doesn't fit.
+inline bool unix_address(const char* path, sockaddr_un& addr) noexcept {
+  std::memset(&addr, 0, sizeof addr);
+  addr.sun_family = AF_UNIX;
+  const auto length = std::strlen(path);
+  if (length == 0 || length >= sizeof addr.sun_path) {
+    return false;
+  }
+  std::memcpy(addr.sun_path, path, length);
+  return true;
+}
+
+// Sends all of [data, data + bytes) on a blocking socket.  Returns 0, or an
+// errno value.
+inline int send_all(int fd, const void* data, std::size_t bytes,
+                    int flags = 0) noexcept {
+  auto p = static_cast<const unsigned char*>(data);
+  while (bytes != 0) {
+    const auto n = ::send(fd, p, bytes, flags | MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR) { continue; }
+    if (n < 0) { return errno; }
+    p += n;
+    bytes -= static_cast<std::size_t>(n);
+  }
+  return 0;
+}
+
+// Receives exactly 'bytes' from a blocking socket.  Returns 0, or an errno
+// value.  A peer that closes early is ECONNRESET.
+inline int recv_all(int fd, void* data, std::size_t bytes) noexcept {
+  auto p = static_cast<unsigned char*>(data);
+  while (bytes != 0) {
+    const auto n = ::recv(fd, p, bytes, 0);
+    if (n < 0 && errno == EINTR) { continue; }
+    if (n < 0) { return errno; }
+    if (n == 0) { return ECONNRESET; }
+    p += n;
+    bytes -= static_cast<std::size_t>(n);
+  }
+  return 0;
+}
+
+}  // namespace detail
+
+// Serves digit operations over a Unix domain socket, so several processes
+// on a host can share one warm copy of the tables.
+//
+// The service is a single-threaded epoll loop.  Each pass reads whatever
+// every ready connection has sent, then groups the complete requests by op
+// and radix and runs each group through the batch kernels as one batch.  So
+// under light load a request is served alone, with no added delay, and
+// under heavy load requests coalesce into larger batches on their own.
+class digit_service {
+ public:
+  // Listens on 'path', replacing any stale socket there.
+  explicit digit_service(const char* path) : path_{path} {
+    sockaddr_un addr;
+    if (!detail::unix_address(path, addr)) {
+      error_ = ENAMETOOLONG;
+      return;
+    }
+
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                          0);
+    wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+    if (listen_fd_ < 0 || wake_fd_ < 0 || epoll_fd_ < 0) {
+      error_ = errno;
+      return;
+    }
+
+    ::unlink(path);
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr),
+               sizeof addr) != 0 ||
+        ::listen(listen_fd_, SOMAXCONN) != 0) {
+      error_ = errno;
+      return;
+    }
+    bound_ = true;
+
+    if (!watch(listen_fd_, &listen_fd_, EPOLLIN) ||
+        !watch(wake_fd_, &wake_fd_, EPOLLIN)) {
+      error_ = errno;
+    }
+  }
+
+  ~digit_service() {
+    for (const auto& entry : connections_) { ::close(entry.first); }
+    for (const auto fd : {epoll_fd_, wake_fd_, listen_fd_}) {
+      if (fd >= 0) { ::close(fd); }
+    }
+    if (bound_) {
+      ::unlink(path_.c_str());
+    }
+  }
+
+  digit_service(const digit_service&) = delete;
+  digit_service& operator=(const digit_service&) = delete;
+
+  bool is_open() const noexcept { return error_ == 0; }
+  explicit operator bool() const noexcept { return is_open(); }
+  int error() const noexcept { return error_; }
+
+  // Serves until stop().  Returns 0, or an errno value.
+  int run() {
+    if (error_ != 0) {
+      return error_;
+    }
+
+    epoll_event events[64];
+    for (;;) {
+      const auto n = ::epoll_wait(epoll_fd_, events, 64, -1);
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n < 0) { return errno; }
+
+      for (int i = 0; i != n; ++i) {
+        const auto tag = events[i].data.ptr;
+        if (tag == &wake_fd_) {
+          return 0;
+        } else if (tag == &listen_fd_) {
+          accept_all();
+        } else {
+          const auto conn = static_cast<connection*>(tag);
+          if (events[i].events & EPOLLIN) {
+            read_requests(*conn);
+          }
+          if (events[i].events & EPOLLHUP) {
+            conn->eof = true;
+          }
+          if (events[i].events & EPOLLERR) {
+            conn->broken = true;
+          }
+        }
+      }
+
+      serve_batches();
+      for (int i = 0; i != n; ++i) {
+        const auto tag = events[i].data.ptr;
+        if (tag != &wake_fd_ && tag != &listen_fd_) {
+          flush(*static_cast<connection*>(tag));
+        }
+      }
+      for (auto& conn : ready_) {
+        flush(*conn);
+      }
+      ready_.clear();
+      close_finished();
+    }
+  }
+
+  // Makes run() return.  Safe to call from another thread, or a signal
+  // handler.
+  void stop() noexcept {
+    const std::uint64_t one = 1;
+    const auto written = ::write(wake_fd_, &one, sizeof one);
+    static_cast<void>(written);
+  }
+
+  // Read these once run() returns.
+  const digit_service_stats& stats() const noexcept { return stats_; }
+
+ private:
+  // Stops reading from a client that isn't reading its responses.
+  static constexpr std::size_t kMaxBacklog = std::size_t{4} << 20;
+
+  struct connection {
+    int fd = -1;
+    std::vector<unsigned char> in, out;
+    std::size_t parsed = 0;    // Bytes of 'in' claimed by requests.
+    std::size_t written = 0;   // Bytes of 'out' sent.
+    std::uint32_t events = 0;  // Current epoll interest.
+    bool eof = false;          // The client has finished sending.
+    bool broken = false;       // The socket failed.
+  };
+
+  struct pending {
+    connection* conn;
+    digit_service_request request;
+    std::size_t values;        // Offset of the values in conn->in.
+    std::size_t results;       // Offset of the results in results_.
+    bool ok;
+  };
+
+  std::string path_;
+  int listen_fd_ = -1, wake_fd_ = -1, epoll_fd_ = -1;
+  int error_ = 0;
+  bool bound_ = false;
+  std::unordered_map<int, std::unique_ptr<connection>> connections_;
+  std::vector<pending> pending_;
+  std::vector<std::size_t> order_;
+  std::vector<std::uint64_t> batch_, results_;
+  std::vector<connection*> ready_;
+  digit_service_stats stats_;
+
+  bool watch(int fd, void* tag, std::uint32_t events) noexcept {
+    epoll_event event;
+    event.events = events;
+    event.data.ptr = tag;
+    return ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) == 0;
+  }
+
+  void accept_all() {
+    for (;;) {
+      const auto fd = ::accept4(listen_fd_, nullptr, nullptr,
+                                SOCK_NONBLOCK | SOCK_CLOEXEC);
+      if (fd < 0) {
+        return;  // EAGAIN, or a client that gave up.  Either way, move on.
+      }
+      auto conn = std::unique_ptr<connection>{new connection};
+      conn->fd = fd;
+      conn->events = EPOLLIN;
+      if (!watch(fd, conn.get(), conn->events)) {
+        ::close(fd);
+        continue;
+      }
+      connections_.emplace(fd, std::move(conn));
+      ++stats_.connections;
+    }
+  }
+
+  // Reads what's available, and queues each complete request.
+  void read_requests(connection& conn) {
+    unsigned char buf[65536];
+    for (;;) {
+      const auto n = ::recv(conn.fd, buf, sizeof buf, 0);
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n == 0) {
+        conn.eof = true;
+        break;
+      }
+      if (n < 0) {
+        conn.broken |= errno != EAGAIN;
+        break;
+      }
+      conn.in.insert(conn.in.end(), buf, buf + n);
+      if (std::size_t(n) < sizeof buf) {
+        break;
+      }
+    }
+
+    for (;;) {
+      const auto available = conn.in.size() - conn.parsed;
+      digit_service_request request;
+      if (available < sizeof request) {
+        break;
+      }
+      std::memcpy(&request, conn.in.data() + conn.parsed, sizeof request);
+      if (request.count > kDigitServiceMaxValues) {
+        conn.broken = true;  // Out of sync, or hostile.  Either way, hang up.
+        break;
+      }
+      const auto bytes = sizeof request + request.count * sizeof(std::uint64_t);
+      if (available < bytes) {
+        break;
+      }
+      pending_.push_back({&conn, request, conn.parsed + sizeof request, 0,
+                          false});
+      conn.parsed += bytes;
+    }
+  }
+
+  // Runs each group of requests with the same op and radix as one batch,
+  // then queues the responses in the order the requests arrived.
+  void serve_batches() {
+    if (pending_.empty()) {
+      return;
+    }
+
+    order_.resize(pending_.size());
+    for (std::size_t i = 0; i != order_.size(); ++i) { order_[i] = i; }
+    const auto key = [this](std::size_t i) {
+      return std::make_pair(pending_[i].request.op, pending_[i].request.radix);
+    };
+    std::stable_sort(order_.begin(), order_.end(),
+                     [&key](std::size_t a, std::size_t b) {
+                       return key(a) < key(b);
+                     });
+
+    batch_.clear();
+    results_.clear();
+    for (auto first = order_.begin(); first != order_.end(); ) {
+      const auto last = std::find_if(first, order_.end(),
+                                     [&](std::size_t i) {
+                                       return key(i) != key(*first);
+                                     });
+
+      const auto start = batch_.size();
+      for (auto it = first; it != last; ++it) {
+        auto& p = pending_[*it];
+        const auto values = reinterpret_cast<const std::uint64_t*>(
+            p.conn->in.data() + p.values);
+        p.results = batch_.size();
+        batch_.insert(batch_.end(), values, values + p.request.count);
+      }
+
+      results_.resize(batch_.size());
+      const auto& request = pending_[*first].request;
+      const auto ok = detail::service_transform(
+          static_cast<digit_file_op>(request.op), request.radix,
+          batch_.data() + start, batch_.data() + batch_.size(),
+          results_.data() + start);
+      for (auto it = first; it != last; ++it) {
+        pending_[*it].ok = ok;
+      }
+      stats_.batches += ok;
+      first = last;
+    }
+
+    for (const auto& p : pending_) {
+      const auto count = p.ok ? p.request.count : 0;
+      const digit_service_response response{
+        p.request.id, p.ok ? 0 : EINVAL, count, 0
+      };
+      const auto bytes = reinterpret_cast<const unsigned char*>(&response);
+      const auto values = reinterpret_cast<const unsigned char*>(
+          results_.data() + p.results);
+      auto& out = p.conn->out;
+      out.insert(out.end(), bytes, bytes + sizeof response);
+      out.insert(out.end(), values, values + count * sizeof(std::uint64_t));
+      ready_.push_back(p.conn);
+      stats_.values += count;
+    }
+    stats_.requests += pending_.size();
+
+    // Drops the requests we've answered from each connection's input.
+    for (const auto& p : pending_) {
+      auto& conn = *p.conn;
+      if (conn.parsed != 0) {
+        conn.in.erase(conn.in.begin(), conn.in.begin() + conn.parsed);
+        conn.parsed = 0;
+      }
+    }
+    pending_.clear();
+  }
+
+  // Sends what it can, and watches for writability if any is left.
+  void flush(connection& conn) {
+    while (conn.written < conn.out.size()) {
+      const auto n = ::send(conn.fd, conn.out.data() + conn.written,
+                            conn.out.size() - conn.written, MSG_NOSIGNAL);
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n < 0) {
+        conn.broken |= errno != EAGAIN;
+        break;
+      }
+      conn.written += static_cast<std::size_t>(n);
+    }
+    if (conn.written == conn.out.size()) {
+      conn.out.clear();
+      conn.written = 0;
+    }
+
+    const auto backlog = conn.out.size() - conn.written;
+    const std::uint32_t events =
+        (backlog != 0 ? EPOLLOUT : 0u) |
+        (backlog < kMaxBacklog && !conn.eof ? EPOLLIN : 0u);
+    if (events != conn.events && !conn.broken) {
+      epoll_event event;
+      event.events = events;
+      event.data.ptr = &conn;
+      ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &event);
+      conn.events = events;
+    }
+  }
+
+  // Closes connections that failed, or that have finished sending and have
+  // all their responses.
+  void close_finished() {
+    for (auto it = connections_.begin(); it != connections_.end(); ) {
+      const auto& conn = *it->second;
+      if (conn.broken || (conn.eof && conn.out.empty())) {
+        ::close(it->first);
+        it = connections_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+};
+
+// Talks to a digit_service.  Calls block.  send() and receive() can be
+// used separately to keep several requests in flight on one connection.
+class digit_service_client {
+ public:
+  explicit digit_service_client(const char* path) {
+    sockaddr_un addr;
+    if (!detail::unix_address(path, addr)) {
+      error_ = ENAMETOOLONG;
+      return;
+    }
+    fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0 ||
+        ::connect(fd_, reinterpret_cast<const sockaddr*>(&addr),
+                  sizeof addr) != 0) {
+      error_ = errno;
+    }
+  }
+
+  ~digit_service_client() {
+    if (fd_ >= 0) { ::close(fd_); }
+  }
+
+  digit_service_client(const digit_service_client&) = delete;
+  digit_service_client& operator=(const digit_service_client&) = delete;
+
+  bool is_open() const noexcept { return error_ == 0; }
+  explicit operator bool() const noexcept { return is_open(); }
+  int error() const noexcept { return error_; }
+
+  // Sends a request for 'op' on [first, last).  Returns 0, or an errno
+  // value.  More than kDigitServiceMaxValues values is E2BIG.
+  int send(std::uint32_t id, digit_file_op op, int radix,
+           const std::uint64_t* first, const std::uint64_t* last) noexcept {
+    const auto count = static_cast<std::size_t>(last - first);
+    if (count > kDigitServiceMaxValues) {
+      return E2BIG;
+    }
+    const digit_service_request request{
+      id, static_cast<std::uint16_t>(op), static_cast<std::uint16_t>(radix),
+      static_cast<std::uint32_t>(count), 0
+    };
+    if (const auto e = detail::send_all(fd_, &request, sizeof request,
+                                        count != 0 ? MSG_MORE : 0)) {
+      return e;
+    }
+    return detail::send_all(fd_, first, count * sizeof(std::uint64_t));
+  }
+
+  // Receives the next response into 'results', and its request's id into
+  // 'id'.  Returns the response's status, or an errno value.
+  int receive(std::uint32_t& id, std::vector<std::uint64_t>& results) {
+    digit_service_response response;
+    if (const auto e = detail::recv_all(fd_, &response, sizeof response)) {
+      return e;
+    }
+    id = response.id;
+    results.resize(response.count);
+    if (const auto e = detail::recv_all(
+            fd_, results.data(), response.count * sizeof(std::uint64_t))) {
+      return e;
+    }
+    return response.status;
+  }
+
+  // Sends one request and waits for its response.
+  int transform(digit_file_op op, int radix, const std::uint64_t* first,
+                const std::uint64_t* last,
+                std::vector<std::uint64_t>& results) {
+    if (const auto e = send(0, op, radix, first, last)) {
+      return e;
+    }
+    std::uint32_t id;
+    return receive(id, results);
+  }
+
+ private:
+  int fd_ = -1;
+  int error_ = 0;
+};
+
+}  // namespace jz
+#endif // DIGIT_SERVICE_HH_
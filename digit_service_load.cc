@@ -0,0 +1,223 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+//
+// Generates load against a digit_service, and reports latency percentiles.
+//
+//   digit_service_load [--socket PATH] [--clients N] [--requests N]
+//                      [--values N] [--depth N] [--op OPERATION]
+//                      [--radix N]
+//
+// Each client is a thread with its own connection, which keeps --depth
+// requests of --values values in flight until it has sent --requests of
+// them.  Latency runs from sending a request to receiving its response.
+// Without --socket, it starts a service in this process, on a scratch
+// socket, so one command measures the whole round trip.
+//
+// Operations are as for digit_tool:  reverse, sort-digits, digit-sum, and
+// checksum.
+#include "digit_service.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+
+struct operation_name {
+  const char*       name;
+  jz::digit_file_op op;
+};
+
+const operation_name operations[] = {
+  {"reverse",     jz::digit_file_op::reverse_digits},
+  {"sort-digits", jz::digit_file_op::sort_digits},
+  {"digit-sum",   jz::digit_file_op::digit_sums},
+  {"checksum",    jz::digit_file_op::check_digits},
+};
+
+struct load_options {
+  const char*       path = nullptr;
+  unsigned          clients = 4;
+  unsigned          requests = 10000;  // Per client.
+  unsigned          values = 64;       // Per request.
+  unsigned          depth = 4;         // Requests in flight, per client.
+  jz::digit_file_op op = jz::digit_file_op::reverse_digits;
+  int               radix = 10;
+};
+
+// Runs one client.  Appends each request's latency, in nanoseconds, to
+// 'latencies'.  Returns 0, or an errno value.
+int run_client(const load_options& options, unsigned seed,
+               std::vector<std::uint64_t>& latencies) {
+  jz::digit_service_client client{options.path};
+  if (!client) {
+    return client.error();
+  }
+
+  auto rng = std::mt19937_64{seed};
+  auto values = std::vector<std::uint64_t>(options.values);
+  for (auto& value : values) {
+    value = rng() >> (rng() % 64);
+  }
+
+  auto sent_at = std::deque<clock_type::time_point>{};
+  auto results = std::vector<std::uint64_t>{};
+  auto sent = 0u;
+  for (auto received = 0u; received != options.requests; ++received) {
+    while (sent != options.requests && sent_at.size() < options.depth) {
+      sent_at.push_back(clock_type::now());
+      if (const auto e = client.send(sent++, options.op, options.radix,
+                                     values.data(),
+                                     values.data() + values.size())) {
+        return e;
+      }
+    }
+
+    std::uint32_t id;
+    if (const auto e = client.receive(id, results)) {
+      return e;
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock_type::now() - sent_at.front()).count();
+    sent_at.pop_front();
+    latencies.push_back(static_cast<std::uint64_t>(ns));
+  }
+  return 0;
+}
+
+double percentile(const std::vector<std::uint64_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  const auto i = static_cast<std::size_t>(p * double(sorted.size() - 1));
+  return double(sorted[i]) / 1e3;
+}
+
+int usage() {
+  std::fprintf(stderr,
+      "usage: digit_service_load [--socket PATH] [--clients N] "
+      "[--requests N] [--values N]\n"
+      "                          [--depth N] [--op OPERATION] [--radix N]\n"
+      "operations: reverse sort-digits digit-sum checksum\n"
+      "radices: 2 8 10 16 36\n");
+  return 2;
+}
+
+}  // namespace
+
+
+int main(int argc, char* argv[]) {
+  auto options = load_options{};
+  for (int i = 1; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    const auto count = [&] {
+      return static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+    };
+    if (std::strcmp(argv[i], "--socket") == 0 && has_value) {
+      options.path = argv[++i];
+    } else if (std::strcmp(argv[i], "--clients") == 0 && has_value) {
+      options.clients = count();
+    } else if (std::strcmp(argv[i], "--requests") == 0 && has_value) {
+      options.requests = count();
+    } else if (std::strcmp(argv[i], "--values") == 0 && has_value) {
+      options.values = std::min(count(), jz::kDigitServiceMaxValues);
+    } else if (std::strcmp(argv[i], "--depth") == 0 && has_value) {
+      options.depth = count();
+    } else if (std::strcmp(argv[i], "--radix") == 0 && has_value) {
+      options.radix = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--op") == 0 && has_value) {
+      const operation_name* selected = nullptr;
+      for (const auto& entry : operations) {
+        if (std::strcmp(argv[i + 1], entry.name) == 0) { selected = &entry; }
+      }
+      if (!selected) {
+        return usage();
+      }
+      options.op = selected->op;
+      ++i;
+    } else {
+      return usage();
+    }
+  }
+
+  // Starts a service in this process, unless pointed at one.
+  auto scratch = std::string{};
+  auto service = std::unique_ptr<jz::digit_service>{};
+  auto service_thread = std::thread{};
+  if (!options.path) {
+    scratch = "/tmp/digit_service_load." + std::to_string(::getpid());
+    options.path = scratch.c_str();
+    service.reset(new jz::digit_service{options.path});
+    if (!*service) {
+      std::fprintf(stderr, "digit_service_load: %s: %s\n", options.path,
+                   std::strerror(service->error()));
+      return 1;
+    }
+    service_thread = std::thread{[&service] { service->run(); }};
+  }
+
+  auto latencies = std::vector<std::vector<std::uint64_t>>(options.clients);
+  auto errors = std::vector<int>(options.clients);
+  auto clients = std::vector<std::thread>{};
+
+  const auto start = clock_type::now();
+  for (unsigned c = 0; c != options.clients; ++c) {
+    latencies[c].reserve(options.requests);
+    clients.emplace_back([&, c] {
+      errors[c] = run_client(options, c + 1, latencies[c]);
+    });
+  }
+  for (auto& client : clients) {
+    client.join();
+  }
+  const auto seconds =
+      std::chrono::duration<double>(clock_type::now() - start).count();
+
+  if (service) {
+    service->stop();
+    service_thread.join();
+  }
+
+  for (const auto error : errors) {
+    if (error != 0) {
+      std::fprintf(stderr, "digit_service_load: %s: %s\n", options.path,
+                   std::strerror(error));
+      return 1;
+    }
+  }
+
+  auto all = std::vector<std::uint64_t>{};
+  for (const auto& l : latencies) {
+    all.insert(all.end(), l.begin(), l.end());
+  }
+  std::sort(all.begin(), all.end());
+
+  const auto requests = double(all.size());
+  std::printf("%u clients, depth %u, %u values per request\n",
+              options.clients, options.depth, options.values);
+  std::printf("%.0f requests/s, %.1f M values/s\n", requests / seconds,
+              requests * options.values / seconds / 1e6);
+  std::printf("latency us:  p50 %.1f  p99 %.1f  p99.9 %.1f  max %.1f\n",
+              percentile(all, 0.50), percentile(all, 0.99),
+              percentile(all, 0.999), percentile(all, 1.0));
+  if (service) {
+    const auto& stats = service->stats();
+    std::printf("%.2f requests per batch\n",
+                double(stats.requests) / double(std::max<std::uint64_t>(
+                    1, stats.batches)));
+  }
+  return 0;
+}
@@ -0,0 +1,214 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_service.hh"
+#include "digit_test.hh"
+
+#include <cerrno>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using jz::digit_file_op;
+using jz::digit_service;
+using jz::digit_service_client;
+
+// Runs a digit_service on a scratch socket for as long as it's in scope.
+class running_service {
+ public:
+  running_service()
+  : path_{"/tmp/digit_service_test." + std::to_string(::getpid())},
+    service_{path_.c_str()},
+    thread_{[this] { service_.run(); }} {}
+
+  ~running_service() {
+    service_.stop();
+    thread_.join();
+  }
+
+  const char* path() const { return path_.c_str(); }
+
+ private:
+  std::string path_;
+  digit_service service_;
+  std::thread thread_;
+};
+
+std::vector<std::uint64_t> random_values(std::size_t count,
+                                         std::uint64_t seed) {
+  auto rng = std::mt19937_64{seed};
+  auto values = std::vector<std::uint64_t>(count);
+  for (auto& value : values) {
+    value = rng() >> (rng() % 64);
+  }
+  return values;
+}
+
+std::vector<std::uint64_t> expected(digit_file_op op, int radix,
+                                    const std::vector<std::uint64_t>& in) {
+  auto out = in;
+  jz::detail::service_transform(op, radix, in.data(), in.data() + in.size(),
+                                out.data());
+  return out;
+}
+
+// Tests each op in each radix against the same work done in process.
+bool TestMatchesInProcess() {
+  const running_service service;
+  digit_service_client client{service.path()};
+  if (!client) { return false; }
+
+  const auto values = random_values(1000, 85);
+  const digit_file_op ops[] = {
+    digit_file_op::reverse_digits, digit_file_op::sort_digits,
+    digit_file_op::digit_sums, digit_file_op::check_digits,
+  };
+  auto results = std::vector<std::uint64_t>{};
+  for (const auto op : ops) {
+    for (const auto radix : {2, 8, 10, 16, 36}) {
+      if (client.transform(op, radix, values.data(),
+                           values.data() + values.size(), results) != 0) {
+        return false;
+      }
+      if (results != expected(op, radix, values)) { return false; }
+    }
+  }
+  return true;
+}
+
+// Tests several clients, each with many requests in flight, which the
+// service coalesces.  Each client must get its own responses, in order.
+bool TestPipelinedClients() {
+  const running_service service;
+
+  auto ok = std::vector<int>(4, 0);
+  auto threads = std::vector<std::thread>{};
+  for (int c = 0; c != 4; ++c) {
+    threads.emplace_back([&service, &ok, c] {
+      digit_service_client client{service.path()};
+      if (!client) { return; }
+
+      const auto op = c % 2 ? digit_file_op::sort_digits
+                            : digit_file_op::reverse_digits;
+      auto inputs = std::vector<std::vector<std::uint64_t>>{};
+      for (std::uint32_t id = 0; id != 50; ++id) {
+        inputs.push_back(random_values(1 + id * 7, c * 100 + id));
+        const auto& in = inputs.back();
+        if (client.send(id, op, 10, in.data(), in.data() + in.size()) != 0) {
+          return;
+        }
+      }
+
+      auto results = std::vector<std::uint64_t>{};
+      for (std::uint32_t id = 0; id != 50; ++id) {
+        std::uint32_t got;
+        if (client.receive(got, results) != 0 || got != id ||
+            results != expected(op, 10, inputs[id])) {
+          return;
+        }
+      }
+      ok[c] = 1;
+    });
+  }
+  for (auto& thread : threads) { thread.join(); }
+
+  return ok == std::vector<int>(4, 1);
+}
+
+// Tests that an unsupported radix or op is refused without dropping the
+// connection, and that an oversized request does drop it.
+bool TestBadRequests() {
+  const running_service service;
+  digit_service_client client{service.path()};
+  const auto values = random_values(10, 1);
+  auto results = std::vector<std::uint64_t>{1, 2, 3};
+
+  if (client.transform(digit_file_op::sort_digits, 7, values.data(),
+                       values.data() + values.size(), results) != EINVAL ||
+      !results.empty()) {
+    return false;
+  }
+  if (client.transform(static_cast<digit_file_op>(99), 10, values.data(),
+                       values.data() + values.size(), results) != EINVAL) {
+    return false;
+  }
+  if (client.transform(digit_file_op::sort_digits, 10, values.data(),
+                       values.data() + values.size(), results) != 0) {
+    return false;
+  }
+
+  const auto big = std::vector<std::uint64_t>(jz::kDigitServiceMaxValues + 1);
+  if (client.send(1, digit_file_op::sort_digits, 10, big.data(),
+                  big.data() + big.size()) != E2BIG) {
+    return false;
+  }
+
+  // Forges an oversized header, which the client wouldn't send, on a raw
+  // socket.  The service should hang up.
+  sockaddr_un addr;
+  jz::detail::unix_address(service.path(), addr);
+  const auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr),
+                sizeof addr) != 0) {
+    ::close(fd);
+    return false;
+  }
+  const jz::digit_service_request forged{
+    2, 0, 10, jz::kDigitServiceMaxValues + 1, 0
+  };
+  jz::digit_service_response response;
+  const auto hung_up =
+      jz::detail::send_all(fd, &forged, sizeof forged) == 0 &&
+      jz::detail::recv_all(fd, &response, sizeof response) == ECONNRESET;
+  ::close(fd);
+  return hung_up;
+}
+
+// Tests the error cases for the endpoints themselves.
+bool TestErrors() {
+  digit_service_client nobody{"/nonexistent/digit_service"};
+  if (nobody.error() != ENOENT) { return false; }
+
+  const auto long_path = std::string(200, 'x');
+  digit_service service{long_path.c_str()};
+  return service.error() == ENAMETOOLONG &&
+         service.run() == ENAMETOOLONG;
+}
+
+// Tests that stop() ends run() cleanly, and that the socket goes away with
+// the service.
+bool TestStop() {
+  const auto path =
+      "/tmp/digit_service_test.stop." + std::to_string(::getpid());
+  auto status = -1;
+  auto existed = false;
+  {
+    digit_service service{path.c_str()};
+    auto thread = std::thread{[&] { status = service.run(); }};
+    existed = ::access(path.c_str(), F_OK) == 0;
+    service.stop();
+    thread.join();
+  }
+  return existed && status == 0 && ::access(path.c_str(), F_OK) != 0;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestMatchesInProcess),
+  TEST_CASE(TestPipelinedClients),
+  TEST_CASE(TestBadRequests),
+  TEST_CASE(TestErrors),
+  TEST_CASE(TestStop),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
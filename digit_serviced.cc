@@ -0,0 +1,70 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+//
+// Serves digit operations to local processes over a Unix domain socket.
+//
+//   digit_serviced [--socket PATH]
+//
+// The socket defaults to /tmp/digit_service.sock.  See digit_service.hh for
+// the protocol, and digit_service_load.cc for a client.  SIGINT or SIGTERM
+// stops the service, which then prints what it served.
+#include "digit_service.hh"
+
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+jz::digit_service* running = nullptr;
+
+extern "C" void handle_stop(int) {
+  if (running) { running->stop(); }
+}
+
+int usage() {
+  std::fprintf(stderr, "usage: digit_serviced [--socket PATH]\n");
+  return 2;
+}
+
+}  // namespace
+
+
+int main(int argc, char* argv[]) {
+  auto path = "/tmp/digit_service.sock";
+  for (int i = 1; i < argc; ++i) {
+    if (std::strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+      path = argv[++i];
+    } else {
+      return usage();
+    }
+  }
+
+  jz::digit_service service{path};
+  if (!service) {
+    std::fprintf(stderr, "digit_serviced: %s: %s\n", path,
+                 std::strerror(service.error()));
+    return 1;
+  }
+
+  running = &service;
+  std::signal(SIGINT, handle_stop);
+  std::signal(SIGTERM, handle_stop);
+
+  const auto error = service.run();
+  running = nullptr;
+  if (error != 0) {
+    std::fprintf(stderr, "digit_serviced: %s\n", std::strerror(error));
+    return 1;
+  }
+
+  const auto& stats = service.stats();
+  std::fprintf(stderr,
+               "digit_serviced: %llu connections, %llu requests, "
+               "%llu batches, %llu values\n",
+               static_cast<unsigned long long>(stats.connections),
+               static_cast<unsigned long long>(stats.requests),
+               static_cast<unsigned long long>(stats.batches),
+               static_cast<unsigned long long>(stats.values));
+  return 0;
+}
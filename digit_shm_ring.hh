@@ -0,0 +1,435 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_SHM_RING_HH_
+#define DIGIT_SHM_RING_HH_
+
+#include "digit_file_pipeline.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2
+#error "digit_shm_ring.hh shares atomics between processes, and requires \
+lock-free 64-bit atomics"
+#endif
+
+namespace jz {
+
+// These rings carry batches of 64-bit values between processes, through a
+// POSIX shared memory object.  Each slot holds one batch, and the worker
+// that takes a batch runs the digit operation on it where it lies, so a
+// batch is copied into shared memory once, and never out of it, unless
+// whoever reads the results chooses to.
+//
+// Both ends must agree on RADIX, which the segment records.  The process
+// that creates a ring owns its name, and removes it when it destroys the
+// ring.  Processes that attach by name must do so before then.  Attaching
+// while the creator is still setting the ring up fails with EAGAIN, and
+// may be retried.
+//
+// Nothing here blocks.  Callers poll the try_ calls, and yield or back off
+// as suits them.  A process that dies holding a slot stalls the ring.
+
+constexpr char kDigitShmRingMagic[8] = {'J','Z','D','I','G','R','N','G'};
+constexpr std::uint32_t kDigitShmRingVersion = 2;
+
+namespace detail {
+
+enum class shm_ring_kind : std::uint32_t { spsc = 1, mpmc = 2 };
+
+struct shm_ring_header {
+  char          magic[8];
+  std::uint32_t version;
+  shm_ring_kind kind;
+  std::uint32_t radix;
+  std::atomic<std::uint32_t> ready;  // Set last, once the rest is written.
+  std::uint64_t slots;          // A power of 2.
+  std::uint64_t slot_values;    // Batch capacity.
+  std::uint64_t slot_stride;    // Bytes per slot.
+
+  // Each index gets its own cache line, so the two ends don't contend.
+  alignas(64) std::atomic<std::uint64_t> head;  // Batches pushed.
+  alignas(64) std::atomic<std::uint64_t> tail;  // Batches taken.
+  alignas(64) std::atomic<std::uint64_t> done;  // SPSC: batches reaped.
+  alignas(64) std::atomic<std::uint32_t> closed;
+};
+
+struct shm_ring_slot {
+  std::atomic<std::uint64_t> seq;  // MPMC:  which lap may use this slot.
+  std::uint64_t tag;               // The producer's, passed to sinks.
+  std::uint32_t op;                // A digit_file_op.
+  std::uint32_t count;
+  // The values follow.
+};
+
+constexpr std::size_t kShmRingCacheLine = 64;
+
+// Maps a ring's shared memory object, whether creating it or attaching to
+// it, and checks what it finds.  The rings below build on this.
+class shm_ring_segment {
+ public:
+  shm_ring_segment(const char* name, shm_ring_kind kind, int radix,
+                   std::size_t slots, std::size_t slot_values) noexcept
+  : name_{name}, owner_{true} {
+    if (slots == 0 || (slots & (slots - 1)) != 0 || slot_values == 0 ||
+        slot_values > UINT32_MAX) {
+      error_ = EINVAL;
+      return;
+    }
+
+    const auto stride = (sizeof(shm_ring_slot) +
+                         slot_values * sizeof(std::uint64_t) +
+                         kShmRingCacheLine - 1) & ~(kShmRingCacheLine - 1);
+    const auto fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+      error_ = errno;
+      owner_ = false;
+      return;
+    }
+    const auto size = sizeof(shm_ring_header) + slots * stride;
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      error_ = errno;
+    } else {
+      map(fd, size);
+    }
+    ::close(fd);
+    if (error_ != 0) {
+      return;
+    }
+
+    header_ = new (data_) shm_ring_header{};
+    std::memcpy(header_->magic, kDigitShmRingMagic, sizeof header_->magic);
+    header_->version = kDigitShmRingVersion;
+    header_->kind = kind;
+    header_->radix = static_cast<std::uint32_t>(radix);
+    header_->slots = slots;
+    header_->slot_values = slot_values;
+    header_->slot_stride = stride;
+    for (std::size_t i = 0; i != slots; ++i) {
+      new (slot(i)) shm_ring_slot{};
+      slot(i)->seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Publishes the header and slots.  Until now, attachers see 'ready' as
+    // the zero ftruncate() left, and stay away.
+    header_->ready.store(1, std::memory_order_release);
+  }
+
+  shm_ring_segment(const char* name, shm_ring_kind kind, int radix) noexcept
+  : name_{name} {
+    const auto fd = ::shm_open(name, O_RDWR, 0);
+    if (fd < 0) {
+      error_ = errno;
+      return;
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      error_ = errno;
+    } else if (st.st_size == 0) {
+      error_ = EAGAIN;  // Not sized yet.
+    } else if (static_cast<std::size_t>(st.st_size) <
+               sizeof(shm_ring_header)) {
+      error_ = EINVAL;
+    } else {
+      map(fd, static_cast<std::size_t>(st.st_size));
+    }
+    ::close(fd);
+    if (error_ != 0) {
+      return;
+    }
+
+    // Reads nothing else in the header until the creator has published it.
+    header_ = static_cast<shm_ring_header*>(data_);
+    const auto& h = *header_;
+    if (h.ready.load(std::memory_order_acquire) == 0) {
+      error_ = EAGAIN;
+      return;
+    }
+    if (std::memcmp(h.magic, kDigitShmRingMagic, sizeof h.magic) != 0 ||
+        h.version != kDigitShmRingVersion || h.kind != kind ||
+        h.radix != static_cast<std::uint32_t>(radix) ||
+        h.slots == 0 || (h.slots & (h.slots - 1)) != 0 ||
+        h.slot_stride < sizeof(shm_ring_slot) +
+                        h.slot_values * sizeof(std::uint64_t) ||
+        (size_ - sizeof h) / h.slot_stride < h.slots) {
+      error_ = EINVAL;
+    }
+  }
+
+  ~shm_ring_segment() noexcept {
+    if (data_) {
+      ::munmap(data_, size_);
+    }
+    if (owner_) {
+      ::shm_unlink(name_.c_str());
+    }
+  }
+
+  shm_ring_segment(const shm_ring_segment&) = delete;
+  shm_ring_segment& operator=(const shm_ring_segment&) = delete;
+
+  int error() const noexcept { return error_; }
+  shm_ring_header& header() const noexcept { return *header_; }
+
+  shm_ring_slot* slot(std::uint64_t index) const noexcept {
+    return reinterpret_cast<shm_ring_slot*>(
+        static_cast<unsigned char*>(data_) + sizeof(shm_ring_header) +
+        (index & (header_->slots - 1)) * header_->slot_stride);
+  }
+
+  static std::uint64_t* values(shm_ring_slot* s) noexcept {
+    return reinterpret_cast<std::uint64_t*>(s + 1);
+  }
+
+  // Fills slot 's' from [first, last), up to its capacity.  Returns how
+  // many values it took.
+  std::size_t fill(shm_ring_slot* s, digit_file_op op, std::uint64_t tag,
+                   const std::uint64_t* first,
+                   const std::uint64_t* last) const noexcept {
+    const auto count = std::min<std::size_t>(last - first,
+                                             header_->slot_values);
+    s->tag = tag;
+    s->op = static_cast<std::uint32_t>(op);
+    s->count = static_cast<std::uint32_t>(count);
+    std::memcpy(values(s), first, count * sizeof(std::uint64_t));
+    return count;
+  }
+
+  template <int RADIX>
+  static void transform(shm_ring_slot* s) noexcept {
+    const auto first = values(s);
+    apply_digit_file_op<std::uint64_t, RADIX>(
+        static_cast<digit_file_op>(s->op), first, first + s->count, first);
+  }
+
+ private:
+  std::string name_;
+  void* data_ = nullptr;
+  std::size_t size_ = 0;
+  shm_ring_header* header_ = nullptr;
+  int error_ = 0;
+  bool owner_ = false;
+
+  void map(int fd, std::size_t size) noexcept {
+    const auto p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED,
+                          fd, 0);
+    if (p == MAP_FAILED) {
+      error_ = errno;
+    } else {
+      data_ = p;
+      size_ = size;
+    }
+  }
+};
+
+}  // namespace detail
+
+// A single-producer, single-worker ring, where the results come back to the
+// producer in the same slots.  Each slot goes around three stages:  the
+// producer pushes a batch into it, the worker transforms the batch, and the
+// producer reaps the results, which frees the slot.  One process (or
+// thread) pushes and reaps, and one other one processes.
+template <int RADIX = 10>
+class shm_digit_ring {
+ public:
+  // Creates a ring of 'slots' (a power of 2) batches of up to 'slot_values'
+  // values each, named 'name'.
+  shm_digit_ring(const char* name, std::size_t slots,
+                 std::size_t slot_values) noexcept
+  : segment_{name, detail::shm_ring_kind::spsc, RADIX, slots, slot_values} {}
+
+  // Attaches to the ring named 'name'.
+  explicit shm_digit_ring(const char* name) noexcept
+  : segment_{name, detail::shm_ring_kind::spsc, RADIX} {}
+
+  bool is_open() const noexcept { return segment_.error() == 0; }
+  explicit operator bool() const noexcept { return is_open(); }
+  int error() const noexcept { return segment_.error(); }
+
+  std::size_t batch_capacity() const noexcept {
+    return segment_.header().slot_values;
+  }
+
+  // Producer:  pushes up to batch_capacity() values from [first, last) for
+  // 'op'.  Returns how many it took, or 0 if the ring is full.
+  std::size_t try_push(digit_file_op op, const std::uint64_t* first,
+                       const std::uint64_t* last,
+                       std::uint64_t tag = 0) noexcept {
+    auto& h = segment_.header();
+    const auto head = h.head.load(std::memory_order_relaxed);
+    if (head - h.done.load(std::memory_order_relaxed) == h.slots ||
+        first == last) {
+      return 0;
+    }
+    const auto count = segment_.fill(segment_.slot(head), op, tag, first,
+                                     last);
+    h.head.store(head + 1, std::memory_order_release);
+    return count;
+  }
+
+  // Producer:  hands the oldest finished batch to sink(tag, first, last),
+  // and frees its slot.  Returns false if none has finished.
+  template <typename Sink>
+  bool try_reap(Sink&& sink) {
+    auto& h = segment_.header();
+    const auto done = h.done.load(std::memory_order_relaxed);
+    if (done == tail_cache_ &&
+        done == (tail_cache_ = h.tail.load(std::memory_order_acquire))) {
+      return false;
+    }
+    const auto s = segment_.slot(done);
+    const auto first = detail::shm_ring_segment::values(s);
+    sink(s->tag, static_cast<const std::uint64_t*>(first),
+         static_cast<const std::uint64_t*>(first + s->count));
+    h.done.store(done + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Producer:  tells the worker nothing more is coming.
+  void close() noexcept {
+    segment_.header().closed.store(1, std::memory_order_release);
+  }
+
+  // Worker:  transforms the next batch in place.  Returns false if none is
+  // waiting.
+  bool try_process() noexcept {
+    auto& h = segment_.header();
+    const auto tail = h.tail.load(std::memory_order_relaxed);
+    if (tail == head_cache_ &&
+        tail == (head_cache_ = h.head.load(std::memory_order_acquire))) {
+      return false;
+    }
+    detail::shm_ring_segment::transform<RADIX>(segment_.slot(tail));
+    h.tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Worker:  true once the producer has closed the ring, and every batch
+  // it pushed has been processed.
+  bool finished() const noexcept {
+    auto& h = segment_.header();
+    return h.closed.load(std::memory_order_acquire) != 0 &&
+           h.tail.load(std::memory_order_relaxed) ==
+           h.head.load(std::memory_order_acquire);
+  }
+
+ private:
+  detail::shm_ring_segment segment_;
+  std::uint64_t head_cache_ = 0;  // Worker's view of head.
+  std::uint64_t tail_cache_ = 0;  // Producer's view of tail.
+};
+
+// A multi-producer, multi-worker queue.  There's no return path here:  each
+// worker hands the results to its own sink, straight from the slot, and the
+// slot is free once the sink returns.  Slots carry a lap number, after
+// Dmitry Vyukov's bounded MPMC queue, so producers and workers each claim
+// slots with one compare-and-swap and never wait on one another's indices.
+template <int RADIX = 10>
+class shm_digit_queue {
+ public:
+  // Creates a queue of 'slots' (a power of 2) batches of up to
+  // 'slot_values' values each, named 'name'.
+  shm_digit_queue(const char* name, std::size_t slots,
+                  std::size_t slot_values) noexcept
+  : segment_{name, detail::shm_ring_kind::mpmc, RADIX, slots, slot_values} {}
+
+  // Attaches to the queue named 'name'.
+  explicit shm_digit_queue(const char* name) noexcept
+  : segment_{name, detail::shm_ring_kind::mpmc, RADIX} {}
+
+  bool is_open() const noexcept { return segment_.error() == 0; }
+  explicit operator bool() const noexcept { return is_open(); }
+  int error() const noexcept { return segment_.error(); }
+
+  std::size_t batch_capacity() const noexcept {
+    return segment_.header().slot_values;
+  }
+
+  // Producer:  pushes up to batch_capacity() values from [first, last) for
+  // 'op'.  Returns how many it took, or 0 if the queue is full.
+  std::size_t try_push(digit_file_op op, const std::uint64_t* first,
+                       const std::uint64_t* last,
+                       std::uint64_t tag = 0) noexcept {
+    auto& h = segment_.header();
+    if (first == last) {
+      return 0;
+    }
+    auto head = h.head.load(std::memory_order_relaxed);
+    for (;;) {
+      const auto s = segment_.slot(head);
+      const auto seq = s->seq.load(std::memory_order_acquire);
+      const auto lap = static_cast<std::int64_t>(seq - head);
+      if (lap < 0) {
+        return 0;  // Full.
+      }
+      if (lap > 0) {
+        head = h.head.load(std::memory_order_relaxed);
+      } else if (h.head.compare_exchange_weak(head, head + 1,
+                                              std::memory_order_relaxed)) {
+        const auto count = segment_.fill(s, op, tag, first, last);
+        s->seq.store(head + 1, std::memory_order_release);
+        return count;
+      }
+    }
+  }
+
+  // Producer:  tells the workers nothing more is coming.  Call it once
+  // every producer has finished pushing.
+  void close() noexcept {
+    segment_.header().closed.store(1, std::memory_order_release);
+  }
+
+  // Worker:  takes the next batch, transforms it in place, and hands the
+  // results to sink(tag, first, last).  Returns false if none is waiting.
+  template <typename Sink>
+  bool try_process(Sink&& sink) {
+    auto& h = segment_.header();
+    auto tail = h.tail.load(std::memory_order_relaxed);
+    for (;;) {
+      const auto s = segment_.slot(tail);
+      const auto seq = s->seq.load(std::memory_order_acquire);
+      const auto lap = static_cast<std::int64_t>(seq - (tail + 1));
+      if (lap < 0) {
+        return false;  // Empty.
+      }
+      if (lap > 0) {
+        tail = h.tail.load(std::memory_order_relaxed);
+      } else if (h.tail.compare_exchange_weak(tail, tail + 1,
+                                              std::memory_order_relaxed)) {
+        detail::shm_ring_segment::transform<RADIX>(s);
+        const auto first = detail::shm_ring_segment::values(s);
+        sink(s->tag, static_cast<const std::uint64_t*>(first),
+             static_cast<const std::uint64_t*>(first + s->count));
+        s->seq.store(tail + h.slots, std::memory_order_release);
+        return true;
+      }
+    }
+  }
+
+  // Worker:  true once the queue is closed, and every batch pushed has been
+  // taken.
+  bool finished() const noexcept {
+    auto& h = segment_.header();
+    return h.closed.load(std::memory_order_acquire) != 0 &&
+           h.tail.load(std::memory_order_relaxed) ==
+           h.head.load(std::memory_order_relaxed);
+  }
+
+ private:
+  detail::shm_ring_segment segment_;
+};
+
+}  // namespace jz
+#endif // DIGIT_SHM_RING_HH_
@@ -0,0 +1,267 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_shm_ring.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+using jz::digit_file_op;
+using jz::shm_digit_queue;
+using jz::shm_digit_ring;
+
+std::string scratch_name(const char* tag) {
+  return "/digit_shm_ring_test." + std::to_string(::getpid()) + "." + tag;
+}
+
+std::vector<std::uint64_t> random_values(std::size_t count,
+                                         std::uint64_t seed) {
+  auto rng = std::mt19937_64{seed};
+  auto values = std::vector<std::uint64_t>(count);
+  for (auto& value : values) {
+    value = rng() >> (rng() % 64);
+  }
+  return values;
+}
+
+template <int RADIX = 10>
+std::vector<std::uint64_t> expected(digit_file_op op,
+                                    const std::vector<std::uint64_t>& in) {
+  auto out = in;
+  jz::detail::apply_digit_file_op<std::uint64_t, RADIX>(
+      op, in.data(), in.data() + in.size(), out.data());
+  return out;
+}
+
+// Pushes all of 'values' through 'ring', reaping as it goes, and returns
+// the results.  Something else must be processing.
+template <int RADIX>
+std::vector<std::uint64_t> push_all(shm_digit_ring<RADIX>& ring,
+                                    digit_file_op op,
+                                    const std::vector<std::uint64_t>& values) {
+  auto results = std::vector<std::uint64_t>{};
+  const auto sink = [&results](std::uint64_t, const std::uint64_t* first,
+                               const std::uint64_t* last) {
+    results.insert(results.end(), first, last);
+  };
+
+  auto next = values.data();
+  const auto end = values.data() + values.size();
+  while (next != end) {
+    const auto n = ring.try_push(op, next, end);
+    next += n;
+    if (n == 0 && !ring.try_reap(sink)) {
+      std::this_thread::yield();
+    }
+  }
+  ring.close();
+  while (results.size() != values.size()) {
+    if (!ring.try_reap(sink)) {
+      std::this_thread::yield();
+    }
+  }
+  return results;
+}
+
+template <int RADIX>
+void process_all(shm_digit_ring<RADIX>& ring) {
+  while (!ring.finished()) {
+    if (!ring.try_process()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// Tests the ring between two threads, with batches that don't divide the
+// input evenly, and more batches than slots.
+bool TestRingThreads() {
+  const auto name = scratch_name("threads");
+  shm_digit_ring<16> producer{name.c_str(), 4, 100};
+  shm_digit_ring<16> worker{name.c_str()};
+  if (!producer || !worker || producer.batch_capacity() != 100) {
+    return false;
+  }
+
+  const auto values = random_values(10007, 86);
+  auto thread = std::thread{[&worker] { process_all(worker); }};
+  const auto results = push_all(producer, digit_file_op::sort_digits, values);
+  thread.join();
+
+  return results == expected<16>(digit_file_op::sort_digits, values);
+}
+
+// Tests the ring between two processes.
+bool TestRingProcesses() {
+  const auto name = scratch_name("processes");
+  shm_digit_ring<> producer{name.c_str(), 8, 256};
+  if (!producer) { return false; }
+
+  std::cout.flush();  // Or the child may repeat what's buffered.
+  const auto pid = ::fork();
+  if (pid == 0) {
+    shm_digit_ring<> worker{name.c_str()};
+    if (!worker) { ::_exit(1); }
+    process_all(worker);
+    ::_exit(0);
+  }
+
+  const auto values = random_values(100000, 860);
+  const auto results = push_all(producer, digit_file_op::reverse_digits,
+                                values);
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 &&
+         results == expected(digit_file_op::reverse_digits, values);
+}
+
+// Tests the queue with several producers and several workers.  Each batch
+// carries its offset as its tag, so the sinks can put results in place.
+bool TestQueueManyToMany() {
+  const auto name = scratch_name("queue");
+  shm_digit_queue<> queue{name.c_str(), 8, 64};
+  if (!queue) { return false; }
+
+  const auto values = random_values(50000, 8600);
+  auto results = std::vector<std::uint64_t>(values.size());
+  auto taken = std::vector<std::atomic<int>>(values.size());
+
+  auto workers = std::vector<std::thread>{};
+  for (int w = 0; w != 3; ++w) {
+    workers.emplace_back([&] {
+      shm_digit_queue<> worker{name.c_str()};
+      const auto sink = [&](std::uint64_t tag, const std::uint64_t* first,
+                            const std::uint64_t* last) {
+        std::copy(first, last, results.begin() + tag);
+        for (auto i = tag; i != tag + (last - first); ++i) { ++taken[i]; }
+      };
+      while (!worker.finished()) {
+        if (!worker.try_process(sink)) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+
+  // Each producer pushes every third batch.
+  const auto batch = queue.batch_capacity();
+  auto producers = std::vector<std::thread>{};
+  for (std::size_t p = 0; p != 3; ++p) {
+    producers.emplace_back([&, p] {
+      shm_digit_queue<> producer{name.c_str()};
+      for (auto offset = p * batch; offset < values.size();
+           offset += 3 * batch) {
+        const auto first = values.data() + offset;
+        const auto last = values.data() + std::min(values.size(),
+                                                   offset + batch);
+        while (producer.try_push(digit_file_op::check_digits, first, last,
+                                 offset) == 0) {
+          std::this_thread::yield();
+        }
+      }
+    });
+  }
+  for (auto& producer : producers) { producer.join(); }
+  queue.close();
+  for (auto& worker : workers) { worker.join(); }
+
+  return results == expected(digit_file_op::check_digits, values) &&
+         std::all_of(taken.begin(), taken.end(),
+                     [](const std::atomic<int>& n) { return n == 1; });
+}
+
+// Tests that full and empty rings refuse politely.
+bool TestFullAndEmpty() {
+  const auto name = scratch_name("full");
+  shm_digit_ring<> ring{name.c_str(), 2, 4};
+  const std::uint64_t values[] = {1, 2, 3, 4, 5, 6};
+  const auto sink = [](std::uint64_t, const std::uint64_t*,
+                       const std::uint64_t*) {};
+
+  if (ring.try_process() || ring.try_reap(sink)) { return false; }
+  if (ring.try_push(digit_file_op::sort_digits, values, values + 6) != 4) {
+    return false;
+  }
+  if (ring.try_push(digit_file_op::sort_digits, values, values + 2) != 2 ||
+      ring.try_push(digit_file_op::sort_digits, values, values + 2) != 0) {
+    return false;
+  }
+  if (ring.try_reap(sink)) { return false; }  // Nothing processed yet.
+  if (!ring.try_process() || !ring.try_process() || ring.try_process()) {
+    return false;
+  }
+  if (ring.finished()) { return false; }
+  ring.close();
+  return ring.finished() && ring.try_reap(sink) && ring.try_reap(sink) &&
+         !ring.try_reap(sink);
+}
+
+// Tests the error cases:  bad shapes, a missing name, a name in use, and
+// attaching with the wrong kind or radix.
+bool TestErrors() {
+  const auto name = scratch_name("errors");
+  if (shm_digit_ring<>{name.c_str(), 3, 8}.error() != EINVAL ||
+      shm_digit_ring<>{name.c_str(), 4, 0}.error() != EINVAL) {
+    return false;
+  }
+  if (shm_digit_ring<>{name.c_str()}.error() != ENOENT) {
+    return false;
+  }
+
+  shm_digit_ring<> ring{name.c_str(), 4, 8};
+  if (!ring) { return false; }
+  if (shm_digit_ring<>{name.c_str(), 4, 8}.error() != EEXIST) {
+    return false;
+  }
+  if (shm_digit_ring<16>{name.c_str()}.error() != EINVAL ||
+      shm_digit_queue<>{name.c_str()}.error() != EINVAL) {
+    return false;
+  }
+  return shm_digit_ring<>{name.c_str()}.is_open();
+}
+
+// Tests that attaching to a ring its creator hasn't finished setting up,
+// before or after sizing it, fails with EAGAIN.
+bool TestAttachBeforeReady() {
+  const auto name = scratch_name("unready");
+  const auto fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) { return false; }
+
+  const auto empty = shm_digit_ring<>{name.c_str()}.error();
+  const auto sized = ::ftruncate(fd, 4096) == 0
+                   ? shm_digit_ring<>{name.c_str()}.error() : -1;
+  ::close(fd);
+  ::shm_unlink(name.c_str());
+  return empty == EAGAIN && sized == EAGAIN;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestRingThreads),
+  TEST_CASE(TestRingProcesses),
+  TEST_CASE(TestQueueManyToMany),
+  TEST_CASE(TestFullAndEmpty),
+  TEST_CASE(TestErrors),
+  TEST_CASE(TestAttachBeforeReady),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,448 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_SIGNATURE_INDEX_HH_
+#define DIGIT_SIGNATURE_INDEX_HH_
+
+#include "digit_adaptor.hh"
+#include "mapped_file.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace jz {
+
+// The digit signature index is an on-disk map from digit_signature to the
+// list of stored values with that signature, i.e. from a multiset of digits
+// to all the numbers spelled with exactly those digits.  It's built offline
+// by write_digit_signature_index(), and used in place through a read-only
+// memory mapping by digit_signature_index, with no parsing at startup.
+//
+// File layout, all in native byte order, and each section 8-byte aligned:
+//
+//   header    digit_signature_index_header
+//   entries   digit_signature_index_entry[signature_count], sorted by
+//             (digits, sorted)
+//   buckets   uint32_t[bucket_count], an open-addressed hash table with
+//             linear probing.  Each holds 1 + an entry index, or 0 if empty.
+//   values    T[value_count], grouped by signature, ascending within each
+//             group
+//
+// Readers reject files with a different magic, version, radix, value type
+// or byte order.  Bump kDigitSignatureIndexVersion on any layout change.
+constexpr char kDigitSignatureIndexMagic[8] = {
+    'J', 'Z', 'D', 'I', 'G', 'S', 'I', 'G'};
+constexpr std::uint32_t kDigitSignatureIndexVersion = 1;
+constexpr std::uint32_t kDigitSignatureIndexByteOrder = 0x01020304;
+
+struct digit_signature_index_header {
+  char          magic[8];
+  std::uint32_t version;
+  std::uint32_t header_bytes;
+  std::uint32_t radix;
+  std::uint32_t value_bytes;
+  std::uint32_t value_is_signed;
+  std::uint32_t byte_order;
+  std::uint64_t signature_count;
+  std::uint64_t bucket_count;
+  std::uint64_t value_count;
+  std::uint64_t file_bytes;
+};
+
+struct digit_signature_index_entry {
+  std::uint64_t sorted;       // digit_signature::value()
+  std::uint32_t digits;       // digit_signature::size()
+  std::uint32_t value_count;  // Values with this signature.
+  std::uint64_t first_value;  // Index of the first of those values.
+};
+
+static_assert(sizeof(digit_signature_index_header) == 64,
+              "Unexpected header padding");
+static_assert(sizeof(digit_signature_index_entry) == 24,
+              "Unexpected entry padding");
+
+namespace detail {
+
+constexpr std::uint64_t align8(std::uint64_t offset) noexcept {
+  return (offset + 7) & ~std::uint64_t{7};
+}
+
+// Returns the bucket to start probing for a signature.  This must never
+// change for a given file version.
+constexpr std::uint64_t signature_bucket(std::uint64_t sorted,
+                                         std::uint32_t digits,
+                                         std::uint64_t bucket_count) noexcept {
+  return mix64(sorted ^ (digits * 0x9E3779B97F4A7C15ULL)) & (bucket_count - 1);
+}
+
+// Holds the offsets of each section in an index file.
+struct signature_index_layout {
+  std::uint64_t entries;
+  std::uint64_t buckets;
+  std::uint64_t values;
+  std::uint64_t file_bytes;
+};
+
+// Returns the layout for the given section sizes, or all zeros if the file
+// would be larger than 64 bits can address.  The sizes come from headers
+// that may be corrupt, so every step checks for overflow.
+template <typename T>
+constexpr signature_index_layout layout_signature_index(
+    std::uint64_t signatures, std::uint64_t buckets, std::uint64_t values) {
+  constexpr auto kMax = ~std::uint64_t{0} - 7;  // Leaves room for align8.
+  const auto entries_at = align8(sizeof(digit_signature_index_header));
+  if (signatures > (kMax - entries_at) / sizeof(digit_signature_index_entry)) {
+    return {};
+  }
+  const auto buckets_at = align8(
+      entries_at + signatures * sizeof(digit_signature_index_entry));
+  if (buckets > (kMax - buckets_at) / sizeof(std::uint32_t)) {
+    return {};
+  }
+  const auto values_at = align8(buckets_at + buckets * sizeof(std::uint32_t));
+  if (values > (kMax - values_at) / sizeof(T)) {
+    return {};
+  }
+  return {entries_at, buckets_at, values_at, values_at + values * sizeof(T)};
+}
+
+// Sorts [first, last) with up to 'threads' threads:  each thread sorts a
+// slice, and then pairs of slices merge in parallel until one remains.
+template <typename RandomIt, typename Compare>
+void parallel_sort(RandomIt first, RandomIt last, unsigned threads,
+                   Compare comp) {
+  const auto n = static_cast<std::size_t>(last - first);
+  threads = std::max(1u, std::min<unsigned>(threads,
+                                            static_cast<unsigned>(n / 4096 + 1)));
+
+  auto bounds = std::vector<RandomIt>{};
+  for (unsigned i = 0; i <= threads; ++i) {
+    bounds.push_back(first + static_cast<std::ptrdiff_t>(n * i / threads));
+  }
+
+  auto workers = std::vector<std::thread>{};
+  for (unsigned i = 0; i != threads; ++i) {
+    workers.emplace_back([&bounds, &comp, i] {
+      std::sort(bounds[i], bounds[i + 1], comp);
+    });
+  }
+  for (auto& worker : workers) { worker.join(); }
+
+  while (bounds.size() > 2) {
+    auto merged = std::vector<RandomIt>{};
+    workers.clear();
+    for (std::size_t i = 0; i + 2 < bounds.size(); i += 2) {
+      workers.emplace_back([&bounds, &comp, i] {
+        std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], comp);
+      });
+    }
+    for (auto& worker : workers) { worker.join(); }
+
+    for (std::size_t i = 0; i < bounds.size(); i += 2) {
+      merged.push_back(bounds[i]);
+    }
+    if (merged.back() != bounds.back()) {
+      merged.push_back(bounds.back());
+    }
+    bounds = std::move(merged);
+  }
+}
+
+}  // namespace detail
+
+// Writes a digit signature index holding the values in [first, last) to
+// 'path'.  Signatures are computed and sorted with up to 'threads' threads.
+// Returns 0 on success, or an errno value on failure.  More than UINT32_MAX
+// signatures, or values sharing one, is EOVERFLOW.
+//
+// The index is built in a temporary file beside 'path' and renamed over
+// it, so a reader with the old index open keeps the old one, whole.  The
+// signatures are sorted in memory from 'alloc', rebound as needed.
+template <typename T, int RADIX = 10, typename RandomIt,
+          typename Allocator = std::allocator<char>>
+int write_digit_signature_index(
+    const char* path, RandomIt first, RandomIt last,
+    unsigned threads = std::thread::hardware_concurrency(),
+    const Allocator& alloc = Allocator{}) {
+  static_assert(sizeof(T) <= sizeof(std::uint64_t),
+                "Signatures must fit in 64 bits");
+
+  using value_type = std::remove_cv_t<T>;
+
+  struct keyed_value {
+    std::uint64_t sorted;
+    std::uint32_t digits;
+    value_type    value;
+  };
+
+  const auto n = static_cast<std::size_t>(last - first);
+  threads = std::max(1u, threads);
+
+  // Computes every value's signature, in parallel slices.
+  using keyed_allocator = typename std::allocator_traits<
+      Allocator>::template rebind_alloc<keyed_value>;
+  auto keyed = std::vector<keyed_value, keyed_allocator>(
+      n, keyed_allocator{alloc});
+  {
+    auto workers = std::vector<std::thread>{};
+    for (unsigned t = 0; t != threads; ++t) {
+      workers.emplace_back([&, t] {
+        const auto begin = n * t / threads, end = n * (t + 1) / threads;
+        for (auto i = begin; i != end; ++i) {
+          const value_type value = first[static_cast<std::ptrdiff_t>(i)];
+          const digit_signature<const value_type, RADIX> signature{
+              digit_adaptor<const value_type, RADIX>{value}};
+          keyed[i] = {static_cast<std::uint64_t>(signature.value()),
+                      static_cast<std::uint32_t>(signature.size()), value};
+        }
+      });
+    }
+    for (auto& worker : workers) { worker.join(); }
+  }
+
+  detail::parallel_sort(keyed.begin(), keyed.end(), threads,
+                        [](const keyed_value& a, const keyed_value& b) {
+                          return std::tie(a.digits, a.sorted, a.value)
+                               < std::tie(b.digits, b.sorted, b.value);
+                        });
+
+  // Counts the signatures, and the values in the longest run that shares
+  // one.  Buckets and entries hold these in 32 bits.
+  auto signatures = std::uint64_t{0};
+  auto longest = std::uint64_t{0};
+  for (auto i = std::size_t{0}, run = std::size_t{0}; i != n; ++i) {
+    const bool starts = i == 0 || keyed[i].sorted != keyed[i - 1].sorted
+                     || keyed[i].digits != keyed[i - 1].digits;
+    signatures += starts;
+    run = starts ? 1 : run + 1;
+    longest = std::max<std::uint64_t>(longest, run);
+  }
+  if (signatures > UINT32_MAX || longest > UINT32_MAX) {
+    return EOVERFLOW;
+  }
+
+  // Keeps the hash table at most half full.
+  auto buckets = std::uint64_t{1};
+  while (buckets < 2 * signatures) {
+    buckets *= 2;
+  }
+
+  const auto layout =
+      detail::layout_signature_index<value_type>(signatures, buckets, n);
+  if (layout.file_bytes == 0 ||
+      layout.file_bytes > SIZE_MAX) {
+    return EFBIG;
+  }
+
+  // Builds the index beside 'path', and renames it into place once it's
+  // complete, so readers with the old index mapped keep seeing all of it.
+  const auto temp = std::string{path} + ".tmp." + std::to_string(::getpid());
+  auto file = mapped_file{temp.c_str(),
+                          static_cast<std::size_t>(layout.file_bytes)};
+  if (!file) {
+    std::remove(temp.c_str());
+    return file.error();
+  }
+
+  auto header = digit_signature_index_header{};
+  std::memcpy(header.magic, kDigitSignatureIndexMagic, sizeof header.magic);
+  header.version         = kDigitSignatureIndexVersion;
+  header.header_bytes    = sizeof header;
+  header.radix           = RADIX;
+  header.value_bytes     = sizeof(value_type);
+  header.value_is_signed = std::is_signed<value_type>::value;
+  header.byte_order      = kDigitSignatureIndexByteOrder;
+  header.signature_count = signatures;
+  header.bucket_count    = buckets;
+  header.value_count     = n;
+  header.file_bytes      = layout.file_bytes;
+  std::memcpy(file.data(), &header, sizeof header);
+
+  auto entries = reinterpret_cast<digit_signature_index_entry*>(
+      file.data() + layout.entries);
+  auto table = reinterpret_cast<std::uint32_t*>(file.data() + layout.buckets);
+  auto values = reinterpret_cast<value_type*>(file.data() + layout.values);
+
+  auto entry = entries - 1;
+  for (auto i = std::size_t{0}; i != n; ++i) {
+    if (i == 0 || keyed[i].sorted != keyed[i - 1].sorted
+               || keyed[i].digits != keyed[i - 1].digits) {
+      *++entry = {keyed[i].sorted, keyed[i].digits, 0, i};
+    }
+    ++entry->value_count;
+    values[i] = keyed[i].value;
+  }
+
+  for (auto i = std::uint64_t{0}; i != signatures; ++i) {
+    auto bucket = detail::signature_bucket(entries[i].sorted,
+                                           entries[i].digits, buckets);
+    while (table[bucket] != 0) {
+      bucket = (bucket + 1) & (buckets - 1);
+    }
+    table[bucket] = static_cast<std::uint32_t>(i + 1);
+  }
+
+  auto error = file.sync() ? 0 : file.error();
+  file = mapped_file{};
+  if (error == 0 && std::rename(temp.c_str(), path) != 0) {
+    error = errno;
+  }
+  if (error != 0) {
+    std::remove(temp.c_str());
+  }
+  return error;
+}
+
+// Provides lookups in a digit signature index file, mapped read-only.  See
+// write_digit_signature_index() for the file layout.  Opening validates the
+// header and section bounds, and nothing else, so startup cost doesn't grow
+// with the size of the index.  Instead, lookups check each bucket and entry
+// they read, so a corrupt file finds nothing rather than reading outside
+// the mapping.
+template <typename T, int RADIX = 10>
+class digit_signature_index {
+ public:
+  using value_type = std::remove_cv_t<T>;
+
+  // Holds the values that share one signature, in ascending order.
+  class posting_list {
+   public:
+    posting_list() noexcept = default;
+    posting_list(const value_type* first, std::size_t count) noexcept
+    : first_{first}, count_{count} {}
+
+    const value_type* begin() const noexcept { return first_; }
+    const value_type* end()   const noexcept { return first_ + count_; }
+    std::size_t       size()  const noexcept { return count_; }
+    bool              empty() const noexcept { return count_ == 0; }
+
+   private:
+    const value_type* first_ = nullptr;
+    std::size_t count_ = 0;
+  };
+
+  // Maps the index at 'path'.  Test the result with is_open().
+  explicit digit_signature_index(const char* path) noexcept
+  : file_{path} {
+    if (file_ && !validate()) {
+      file_ = mapped_file{};
+      error_ = EINVAL;
+    }
+  }
+
+  bool is_open() const noexcept { return error_ == 0 && file_.is_open(); }
+  explicit operator bool() const noexcept { return is_open(); }
+
+  // Returns an errno value describing why the index didn't open, or 0.
+  // A file that maps but doesn't hold a compatible index is EINVAL.
+  int error() const noexcept { return error_ ? error_ : file_.error(); }
+
+  // Returns the stored values that are permutations of the given digits.
+  template <typename U>
+  posting_list find(const digit_signature<U, RADIX>& signature) const noexcept {
+    if (!is_open()) {
+      return {};
+    }
+
+    const auto sorted = static_cast<std::uint64_t>(signature.value());
+    const auto digits = static_cast<std::uint32_t>(signature.size());
+    const auto mask = header_->bucket_count - 1;
+
+    // Probes each bucket at most once, in case a corrupt table has no
+    // empty bucket to stop on.
+    auto bucket = detail::signature_bucket(sorted, digits,
+                                           header_->bucket_count);
+    for (auto probes = header_->bucket_count;
+         probes != 0 && buckets_[bucket] != 0;
+         --probes, bucket = (bucket + 1) & mask) {
+      const auto index = buckets_[bucket] - std::uint64_t{1};
+      if (index >= header_->signature_count) {
+        return {};  // Corrupt.
+      }
+      const auto& entry = entries_[index];
+      if (entry.sorted == sorted && entry.digits == digits) {
+        if (entry.first_value > header_->value_count ||
+            entry.value_count > header_->value_count - entry.first_value) {
+          return {};  // Corrupt.
+        }
+        return {values_ + entry.first_value, entry.value_count};
+      }
+    }
+
+    return {};
+  }
+
+  template <typename U, typename Tables>
+  posting_list find(const digit_adaptor<U, RADIX, Tables>& digits) const
+      noexcept {
+    return find(digit_signature<U, RADIX>{digits});
+  }
+
+  std::uint64_t signature_count() const noexcept {
+    return is_open() ? header_->signature_count : 0;
+  }
+
+  std::uint64_t value_count() const noexcept {
+    return is_open() ? header_->value_count : 0;
+  }
+
+ private:
+  mapped_file file_;
+  int error_ = 0;
+  const digit_signature_index_header* header_ = nullptr;
+  const digit_signature_index_entry* entries_ = nullptr;
+  const std::uint32_t* buckets_ = nullptr;
+  const value_type* values_ = nullptr;
+
+  bool validate() noexcept {
+    if (file_.size() < sizeof(digit_signature_index_header)) {
+      return false;
+    }
+
+    header_ = reinterpret_cast<const digit_signature_index_header*>(
+        file_.data());
+
+    if (std::memcmp(header_->magic, kDigitSignatureIndexMagic,
+                    sizeof header_->magic) != 0 ||
+        header_->version != kDigitSignatureIndexVersion ||
+        header_->header_bytes != sizeof(digit_signature_index_header) ||
+        header_->radix != RADIX ||
+        header_->value_bytes != sizeof(value_type) ||
+        header_->value_is_signed != std::is_signed<value_type>::value ||
+        header_->byte_order != kDigitSignatureIndexByteOrder ||
+        (header_->bucket_count & (header_->bucket_count - 1)) != 0 ||
+        header_->signature_count >= header_->bucket_count) {
+      return false;
+    }
+
+    const auto layout = detail::layout_signature_index<value_type>(
+        header_->signature_count, header_->bucket_count,
+        header_->value_count);
+    if (layout.file_bytes == 0 ||
+        layout.file_bytes != header_->file_bytes ||
+        layout.file_bytes != file_.size()) {
+      return false;
+    }
+
+    entries_ = reinterpret_cast<const digit_signature_index_entry*>(
+        file_.data() + layout.entries);
+    buckets_ = reinterpret_cast<const std::uint32_t*>(
+        file_.data() + layout.buckets);
+    values_ = reinterpret_cast<const value_type*>(
+        file_.data() + layout.values);
+    return true;
+  }
+};
+
+}  // namespace jz
+#endif // DIGIT_SIGNATURE_INDEX_HH_
@@ -0,0 +1,357 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_signature_index.hh"
+#include "digit_arena.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+using jz::digit_adaptor;
+using jz::digit_signature;
+using jz::digit_signature_index;
+using jz::write_digit_signature_index;
+
+// Returns a scratch file name unique to this process, and removes the file
+// when it goes out of scope.
+class scratch_file {
+ public:
+  explicit scratch_file(const char* tag)
+  : path_{"/tmp/digit_signature_index_test." + std::to_string(::getpid())
+          + "." + tag} {}
+
+  ~scratch_file() { std::remove(path_.c_str()); }
+
+  const char* c_str() const { return path_.c_str(); }
+
+ private:
+  std::string path_;
+};
+
+// Returns true if 'postings' holds exactly 'expected', in order.
+template <typename Postings, typename T>
+bool holds(const Postings& postings, std::vector<T> expected) {
+  return std::vector<T>(postings.begin(), postings.end()) == expected;
+}
+
+// Tests that lookups return every stored permutation, in ascending order.
+bool TestFindsPermutations() {
+  const scratch_file path{"permutations"};
+  const long values[] = {4417, 1447, 7144, 123, 321, 213, 44, 1744, 7};
+
+  if (write_digit_signature_index<long>(path.c_str(), std::begin(values),
+                                        std::end(values), 2) != 0) {
+    return false;
+  }
+
+  const digit_signature_index<long> index{path.c_str()};
+  if (!index.is_open()) { return false; }
+  if (index.value_count() != 9 || index.signature_count() != 4) {
+    return false;
+  }
+
+  const long query = 4471;
+  if (!holds(index.find(digit_adaptor<const long>{query}),
+             std::vector<long>{1447, 1744, 4417, 7144})) {
+    return false;
+  }
+
+  const int small = 132;
+  if (!holds(index.find(digit_adaptor<const int>{small}),
+             std::vector<long>{123, 213, 321})) {
+    return false;
+  }
+
+  using untabled = digit_adaptor<const long, 10, jz::no_tables>;
+  if (!holds(index.find(untabled{query}),
+             std::vector<long>{1447, 1744, 4417, 7144})) {
+    return false;
+  }
+
+  const long missing = 4418;
+  if (!index.find(digit_adaptor<const long>{missing}).empty()) { return false; }
+
+  return true;
+}
+
+// Tests that the digit count is part of the signature, so leading zeros
+// matter.
+bool TestLeadingZerosCount() {
+  const scratch_file path{"zeros"};
+  const unsigned values[] = {12, 102, 120, 210, 21};
+
+  if (write_digit_signature_index<unsigned>(path.c_str(), std::begin(values),
+                                            std::end(values)) != 0) {
+    return false;
+  }
+
+  const digit_signature_index<unsigned> index{path.c_str()};
+  if (!index) { return false; }
+
+  const unsigned twelve = 12;
+  if (!holds(index.find(digit_adaptor<const unsigned>{twelve}),
+             std::vector<unsigned>{12, 21})) {
+    return false;
+  }
+  if (!holds(index.find(digit_adaptor<const unsigned>{twelve, 3}),
+             std::vector<unsigned>{102, 120, 210})) {
+    return false;
+  }
+
+  return true;
+}
+
+// Tests that readers reject missing files, and files built for a different
+// radix or value type.
+bool TestRejectsIncompatibleFiles() {
+  const scratch_file path{"incompatible"};
+  const int values[] = {1, 2, 3};
+
+  const digit_signature_index<int> missing{"/nonexistent/index"};
+  if (missing.is_open() || missing.error() != ENOENT) { return false; }
+
+  if (write_digit_signature_index<int, 8>(path.c_str(), std::begin(values),
+                                          std::end(values)) != 0) {
+    return false;
+  }
+
+  const digit_signature_index<int, 8> octal{path.c_str()};
+  if (!octal) { return false; }
+
+  const digit_signature_index<int> decimal{path.c_str()};
+  if (decimal.is_open() || decimal.error() != EINVAL) { return false; }
+
+  const digit_signature_index<long, 8> wide{path.c_str()};
+  if (wide.is_open() || wide.error() != EINVAL) { return false; }
+
+  const digit_signature_index<unsigned, 8> unsigned_values{path.c_str()};
+  if (unsigned_values.is_open()) { return false; }
+
+  const int three = 3;
+  if (!decimal.find(digit_adaptor<const int>{three}).empty()) { return false; }
+
+  return true;
+}
+
+// Overwrites the bytes at 'offset' in 'path' with 'value'.
+template <typename T>
+bool patch(const scratch_file& path, long offset, const T& value) {
+  const auto f = std::fopen(path.c_str(), "r+b");
+  if (!f) { return false; }
+  const auto ok = std::fseek(f, offset, SEEK_SET) == 0 &&
+                  std::fwrite(&value, sizeof value, 1, f) == 1;
+  return std::fclose(f) == 0 && ok;
+}
+
+// Tests that corrupt files are rejected at open, or find nothing, rather
+// than reading outside the mapping.
+bool TestCorruptFiles() {
+  const scratch_file path{"corrupt"};
+  const long values[] = {4417, 1447, 123};
+  const long query = 4471;
+
+  const auto write = [&path, &values] {
+    return write_digit_signature_index<long>(path.c_str(), std::begin(values),
+                                             std::end(values)) == 0;
+  };
+  using header = jz::digit_signature_index_header;
+  using entry = jz::digit_signature_index_entry;
+
+  // A value count whose size in bytes wraps around to the right file size.
+  if (!write() ||
+      !patch(path, offsetof(header, value_count),
+             (std::uint64_t{1} << 61) + 3)) {
+    return false;
+  }
+  const digit_signature_index<long> huge{path.c_str()};
+  if (huge.is_open() || huge.error() != EINVAL) { return false; }
+
+  // Entries whose values run past the end.  Both signatures' entries are
+  // out of range, so the lookup can't succeed on the other one.
+  for (long i = 0; i != 2; ++i) {
+    if ((i == 0 && !write()) ||
+        !patch(path, sizeof(header) + i * sizeof(entry)
+                         + offsetof(entry, first_value),
+               std::uint64_t{1} << 40)) {
+      return false;
+    }
+  }
+  const digit_signature_index<long> overrun{path.c_str()};
+  if (!overrun || !overrun.find(digit_adaptor<const long>{query}).empty()) {
+    return false;
+  }
+
+  // Buckets that point past the entries, and a table with no empty bucket
+  // to stop on.  Two signatures get four buckets.
+  const auto buckets_at = sizeof(header) + 2 * sizeof(entry);
+  for (const auto bucket : {std::uint32_t{3}, std::uint32_t{2}}) {
+    if (!write()) { return false; }
+    for (long i = 0; i != 4; ++i) {
+      if (!patch(path, buckets_at + i * sizeof bucket, bucket)) {
+        return false;
+      }
+    }
+    const digit_signature_index<long> index{path.c_str()};
+    const long missing = 9;
+    if (!index || !index.find(digit_adaptor<const long>{missing}).empty()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Tests that rebuilding an index replaces it without disturbing readers
+// that have the old one open.
+bool TestRebuildWhileOpen() {
+  const scratch_file path{"rebuild"};
+  const long before[] = {12, 21, 345};
+  const long after[] = {54, 45};
+  const long query = 12;
+
+  if (write_digit_signature_index<long>(path.c_str(), std::begin(before),
+                                        std::end(before)) != 0) {
+    return false;
+  }
+  const digit_signature_index<long> old_index{path.c_str()};
+  if (!old_index) { return false; }
+
+  if (write_digit_signature_index<long>(path.c_str(), std::begin(after),
+                                        std::end(after)) != 0) {
+    return false;
+  }
+  if (!holds(old_index.find(digit_adaptor<const long>{query}),
+             std::vector<long>{12, 21})) {
+    return false;
+  }
+
+  const digit_signature_index<long> new_index{path.c_str()};
+  if (!new_index || new_index.signature_count() != 1 ||
+      !new_index.find(digit_adaptor<const long>{query}).empty()) {
+    return false;
+  }
+
+  return write_digit_signature_index<long>("/nonexistent/index",
+                                           std::begin(after),
+                                           std::end(after)) == ENOENT;
+}
+
+// Tests an empty index.
+bool TestEmptyIndex() {
+  const scratch_file path{"empty"};
+  const long* none = nullptr;
+
+  if (write_digit_signature_index<long>(path.c_str(), none, none) != 0) {
+    return false;
+  }
+
+  const digit_signature_index<long> index{path.c_str()};
+  const long value = 1;
+  return index.is_open() && index.value_count() == 0 &&
+         index.find(digit_adaptor<const long>{value}).empty();
+}
+
+// Compares lookups against a brute-force scan on random values, built with
+// several threads.
+bool TestMatchesBruteForce() {
+  const scratch_file path{"random"};
+  auto rng = std::mt19937_64{80};
+  auto values = std::vector<std::uint32_t>{};
+  for (int i = 0; i != 50000; ++i) {
+    values.push_back(static_cast<std::uint32_t>(rng() % 100000));
+  }
+
+  if (write_digit_signature_index<std::uint32_t>(
+          path.c_str(), values.begin(), values.end(), 4) != 0) {
+    return false;
+  }
+
+  const digit_signature_index<std::uint32_t> index{path.c_str()};
+  if (!index) { return false; }
+
+  using signature = digit_signature<const std::uint32_t, 10>;
+
+  for (int i = 0; i != 500; ++i) {
+    const auto query = static_cast<std::uint32_t>(rng() % 100000);
+    const auto query_digits = digit_adaptor<const std::uint32_t>{query};
+
+    auto expected = std::vector<std::uint32_t>{};
+    for (const auto value : values) {
+      if (signature{digit_adaptor<const std::uint32_t>{value}}
+          == signature{query_digits}) {
+        expected.push_back(value);
+      }
+    }
+    std::sort(expected.begin(), expected.end());
+
+    if (!holds(index.find(query_digits), expected)) { return false; }
+  }
+
+  return true;
+}
+
+// Returns the contents of the file at 'path'.
+std::string read_file(const scratch_file& path) {
+  auto text = std::string{};
+  if (const auto f = std::fopen(path.c_str(), "rb")) {
+    char buf[4096];
+    for (std::size_t n; (n = std::fread(buf, 1, sizeof buf, f)) != 0; ) {
+      text.append(buf, n);
+    }
+    std::fclose(f);
+  }
+  return text;
+}
+
+// Tests that an index sorted in an arena is the same as one sorted on the
+// heap.
+bool TestArenaBuildMatches() {
+  const scratch_file heap_path{"heap"}, arena_path{"arena"};
+  auto rng = std::mt19937_64{95};
+  auto values = std::vector<long>{};
+  for (int i = 0; i != 20000; ++i) {
+    values.push_back(static_cast<long>(rng() % 1000000));
+  }
+
+  jz::digit_arena arena;
+  if (write_digit_signature_index<long>(heap_path.c_str(), values.begin(),
+                                        values.end(), 2) != 0 ||
+      write_digit_signature_index<long>(arena_path.c_str(), values.begin(),
+                                        values.end(), 2,
+                                        jz::arena_allocator<char>{arena})
+          != 0) {
+    return false;
+  }
+
+  const auto expected = read_file(heap_path);
+  return arena.capacity() != 0 && !expected.empty() &&
+         read_file(arena_path) == expected;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestFindsPermutations),
+  TEST_CASE(TestLeadingZerosCount),
+  TEST_CASE(TestRejectsIncompatibleFiles),
+  TEST_CASE(TestEmptyIndex),
+  TEST_CASE(TestCorruptFiles),
+  TEST_CASE(TestRebuildWhileOpen),
+  TEST_CASE(TestMatchesBruteForce),
+  TEST_CASE(TestArenaBuildMatches),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,47 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_TEST_HH_
+#define DIGIT_TEST_HH_
+
+#include <cstddef>
+#include <iostream>
+
+// This code would benefit from a proper unit-test framework.  I have not
+// included one here to keep this repository free of external dependencies.
+// Instead, I've just produced a very minimal framework, shared by every
+// *_test.cc.  Each declares its test cases with TEST_CASE in an array, and
+// passes it to run_tests() from main().
+
+namespace jz {
+namespace test {
+
+using TestCaseFxn = bool(void);
+
+struct TestCase {
+  const char  *name;
+  TestCaseFxn *test;
+};
+
+// Runs each test case in turn, and reports which passed.
+template <std::size_t N>
+void run_tests(const TestCase (&tests)[N]) {
+  int pass_cnt = 0, fail_cnt = 0;
+
+  for (const auto& test : tests) {
+    const bool passed = test.test();
+    std::cout << (passed ? "PASS     :  " : "     FAIL:  ")
+              << test.name << '\n';
+    pass_cnt += passed == true;
+    fail_cnt += passed == false;
+  }
+
+  std::cout << "Passed: " << pass_cnt << " Failed: " << fail_cnt << '\n';
+}
+
+}  // namespace test
+}  // namespace jz
+
+// Declares a test case named after its function.
+#define TEST_CASE(x) ::jz::test::TestCase{ #x, x }
+
+#endif // DIGIT_TEST_HH_
@@ -0,0 +1,492 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+//
+// Applies a digit operation to every line of newline-separated integers,
+// from files or stdin, and writes the results to stdout in input order.
+//
+//   digit_tool OPERATION [--radix N] [--to-radix N] [--threads N] [--stats]
+//              [FILE...]
+//
+// Operations:
+//   reverse        Reverses each number's digits.
+//   sort-digits    Sorts each number's digits into ascending order.
+//   digit-sum      Sums each number's digits, printed in decimal.
+//   checksum       Prints each number's Luhn check digit.
+//   radix-convert  Prints each number in --to-radix.
+//   histogram      Counts each digit across all the input.
+//
+// Input is read in large blocks, split at line boundaries, and handed to a
+// pool of workers.  Each worker parses its block (with SWAR parsing for
+// decimal), runs the operation over the whole batch, and formats the
+// results into an output block.  A writer emits output blocks in the order
+// they were read.
+#include "digit_batch.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+enum class operation {
+  reverse, sort_digits, digit_sum, checksum, radix_convert, histogram
+};
+
+struct operation_name {
+  const char* name;
+  operation   op;
+};
+
+const operation_name operations[] = {
+  {"reverse",       operation::reverse},
+  {"sort-digits",   operation::sort_digits},
+  {"digit-sum",     operation::digit_sum},
+  {"checksum",      operation::checksum},
+  {"radix-convert", operation::radix_convert},
+  {"histogram",     operation::histogram},
+};
+
+constexpr std::size_t kBlockBytes = std::size_t{4} << 20;
+constexpr std::size_t kNoLine = ~std::size_t{0};
+constexpr int kMaxRadix = 36;
+
+// Holds one block of input lines, and its results.
+struct block {
+  std::size_t seq = 0;
+  std::vector<char> text;
+  std::vector<char> out;
+  std::size_t lines = 0;
+  std::size_t bad_line = kNoLine;  // Index of the first bad line, if any.
+  std::uint64_t counts[kMaxRadix] = {};
+};
+
+using process_fxn = void(block&, operation);
+
+// Returns the most digits in radix 'to' it takes to write one digit in
+// radix 'from':  the smallest r with to^r >= from.
+constexpr std::size_t digits_per_digit(int from, int to) noexcept {
+  auto r = std::size_t{1};
+  for (auto power = to; power < from; power *= to) {
+    ++r;
+  }
+  return r;
+}
+
+// Parses, transforms and formats one block.  Parsing stops at the first
+// line that isn't a number, and the output holds the lines before it.
+template <int RADIX, int TO_RADIX>
+void process(block& b, operation op) {
+  auto values = std::vector<std::uint64_t>{};
+  auto negative = std::vector<std::uint8_t>{};
+  values.reserve(b.text.size() / 4);
+  negative.reserve(b.text.size() / 4);
+
+  const char* p = b.text.data();
+  for (const auto end = p + b.text.size(); p != end; ) {
+    const auto newline = static_cast<const char*>(
+        std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+    auto first = p, last = newline;
+    p = newline + 1;
+
+    if (last != first && last[-1] == '\r') { --last; }
+    const bool minus = first != last && *first == '-';
+    first += minus;
+
+    auto value = std::uint64_t{0};
+    if (!jz::parse_digits<RADIX>(first, last, value)) {
+      b.bad_line = values.size();
+      break;
+    }
+    values.push_back(value);
+    negative.push_back(minus);
+  }
+  b.lines = values.size();
+
+  auto batch = jz::make_batch_digit_adaptor<RADIX>(
+      values.data(), values.data() + values.size());
+
+  switch (op) {
+    case operation::reverse:     batch.reverse_digits();                 break;
+    case operation::sort_digits: batch.sort_digits();                    break;
+    case operation::digit_sum:   batch.digit_sums(values.begin());       break;
+    case operation::checksum:    batch.check_digits(values.begin());     break;
+    case operation::histogram:   batch.histogram(b.counts);              return;
+    case operation::radix_convert:                                       break;
+  }
+
+  // A line of k digits is a value below RADIX^k, so it takes at most k
+  // times digits_per_digit() in the output radix, plus a sign and a
+  // newline:  never more than that many times the line's own length.  Digit
+  // sums, at most k * (RADIX - 1), stay under RADIX^k too.
+  const auto out_radix = op == operation::digit_sum     ? 10
+                       : op == operation::radix_convert ? TO_RADIX
+                                                        : RADIX;
+  b.out.resize(b.text.size() * digits_per_digit(RADIX, out_radix));
+  auto out = b.out.data();
+
+  for (std::size_t i = 0; i != values.size(); ++i) {
+    switch (op) {
+      case operation::digit_sum:
+        out = jz::format_digits<10>(values[i], out);
+        break;
+      case operation::checksum:
+        out = jz::format_digits<RADIX>(values[i], out);
+        break;
+      case operation::radix_convert:
+        if (negative[i]) { *out++ = '-'; }
+        out = jz::format_digits<TO_RADIX>(values[i], out);
+        break;
+      default:
+        if (negative[i]) { *out++ = '-'; }
+        out = jz::format_digits<RADIX>(values[i], out);
+        break;
+    }
+    *out++ = '\n';
+  }
+
+  b.out.resize(static_cast<std::size_t>(out - b.out.data()));
+}
+
+// Returns the process function for a pair of radices, or nullptr.
+template <int RADIX>
+process_fxn* select_process(int to_radix) {
+  switch (to_radix) {
+    case 2:  return process<RADIX, 2>;
+    case 8:  return process<RADIX, 8>;
+    case 10: return process<RADIX, 10>;
+    case 16: return process<RADIX, 16>;
+    case 36: return process<RADIX, 36>;
+    default: return nullptr;
+  }
+}
+
+process_fxn* select_process(int radix, int to_radix) {
+  switch (radix) {
+    case 2:  return select_process<2>(to_radix);
+    case 8:  return select_process<8>(to_radix);
+    case 10: return select_process<10>(to_radix);
+    case 16: return select_process<16>(to_radix);
+    case 36: return select_process<36>(to_radix);
+    default: return nullptr;
+  }
+}
+
+// Writes all of [data, data + size) to 'fd'.  Returns false on error.
+bool write_all(int fd, const char* data, std::size_t size) {
+  while (size != 0) {
+    const auto n = ::write(fd, data, size);
+    if (n < 0) {
+      if (errno == EINTR) { continue; }
+      return false;
+    }
+    data += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+
+// Runs blocks through a pool of workers, and hands the results to a writer
+// in sequence order.  At most two blocks per worker are in flight, which
+// bounds memory use when the writer falls behind.
+class pipeline {
+ public:
+  pipeline(process_fxn* process, operation op, unsigned workers)
+  : process_{process}, op_{op}, slots_(2 * workers + 2) {
+    for (unsigned i = 0; i != workers; ++i) {
+      workers_.emplace_back([this] { work(); });
+    }
+    writer_ = std::thread{[this] { write(); }};
+  }
+
+  ~pipeline() { finish(); }
+
+  // Queues a block.  Blocks until there's room.  Returns false once the
+  // writer has stopped on an error.
+  bool submit(std::unique_ptr<block> b) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    room_.wait(lock, [this] {
+      return stopped_ || submitted_ - written_ < slots_.size();
+    });
+    if (stopped_) {
+      return false;
+    }
+    b->seq = submitted_++;
+    jobs_.push(std::move(b));
+    work_ready_.notify_one();
+    return true;
+  }
+
+  // Waits for every block to be written.
+  void finish() {
+    {
+      const std::lock_guard<std::mutex> lock{mutex_};
+      closed_ = true;
+    }
+    work_ready_.notify_all();
+    done_.notify_all();
+    for (auto& worker : workers_) {
+      if (worker.joinable()) { worker.join(); }
+    }
+    if (writer_.joinable()) { writer_.join(); }
+  }
+
+  // Returns the 1-based number of the first line that isn't a number, or 0.
+  std::size_t bad_line() const { return bad_line_; }
+
+  bool write_failed() const { return write_failed_; }
+
+  const std::uint64_t* counts() const { return counts_; }
+
+ private:
+  process_fxn* process_;
+  operation op_;
+  std::vector<std::unique_ptr<block>> slots_;
+  std::vector<std::thread> workers_;
+  std::thread writer_;
+
+  std::mutex mutex_;
+  std::condition_variable work_ready_, done_, room_;
+  std::queue<std::unique_ptr<block>> jobs_;
+  std::size_t submitted_ = 0, written_ = 0;
+  bool closed_ = false, stopped_ = false;
+
+  std::size_t lines_ = 0, bad_line_ = 0;
+  bool write_failed_ = false;
+  std::uint64_t counts_[kMaxRadix] = {};
+
+  void work() {
+    for (;;) {
+      std::unique_ptr<block> b;
+      {
+        std::unique_lock<std::mutex> lock{mutex_};
+        work_ready_.wait(lock, [this] { return closed_ || !jobs_.empty(); });
+        if (jobs_.empty()) {
+          return;
+        }
+        b = std::move(jobs_.front());
+        jobs_.pop();
+      }
+
+      process_(*b, op_);
+
+      const std::lock_guard<std::mutex> lock{mutex_};
+      const auto slot = b->seq % slots_.size();
+      slots_[slot] = std::move(b);
+      done_.notify_all();
+    }
+  }
+
+  void write() {
+    for (;;) {
+      std::unique_ptr<block> b;
+      {
+        std::unique_lock<std::mutex> lock{mutex_};
+        const auto slot = written_ % slots_.size();
+        done_.wait(lock, [this, slot] {
+          return slots_[slot] || (closed_ && written_ == submitted_);
+        });
+        if (!slots_[slot]) {
+          return;
+        }
+        b = std::move(slots_[slot]);
+      }
+
+      if (!stopped_) {
+        for (int d = 0; d != kMaxRadix; ++d) {
+          counts_[d] += b->counts[d];
+        }
+        if (!write_all(STDOUT_FILENO, b->out.data(), b->out.size())) {
+          write_failed_ = true;
+        }
+        if (b->bad_line != kNoLine) {
+          bad_line_ = lines_ + b->bad_line + 1;
+        }
+        lines_ += b->lines;
+      }
+
+      const std::lock_guard<std::mutex> lock{mutex_};
+      stopped_ = stopped_ || write_failed_ || bad_line_ != 0;
+      ++written_;
+      room_.notify_all();
+    }
+  }
+};
+
+// Reads 'fd' in large blocks, cut at the last newline in each, and submits
+// them.  A final line without a newline gets one.  Returns the bytes read,
+// or -1 on a read error.
+long long read_blocks(int fd, pipeline& pipe) {
+  auto carry = std::vector<char>{};
+  auto total = 0LL;
+
+  for (;;) {
+    auto b = std::unique_ptr<block>{new block};
+    b->text.swap(carry);
+    const auto have = b->text.size();
+    b->text.resize(std::max(have + kBlockBytes, 2 * have));
+
+    auto size = have;
+    auto eof = false;
+    while (size != b->text.size()) {
+      const auto n = ::read(fd, b->text.data() + size, b->text.size() - size);
+      if (n < 0 && errno == EINTR) { continue; }
+      if (n < 0) { return -1; }
+      if (n == 0) { eof = true; break; }
+      size += static_cast<std::size_t>(n);
+      total += n;
+    }
+
+    // Cuts the block after its last newline, and carries the rest over.
+    // A block that ends on a newline goes as it is.
+    auto cut = size;
+    if (!eof) {
+      while (cut != 0 && b->text[cut - 1] != '\n') { --cut; }
+      if (cut == 0) {
+        // No newline yet; grow the block and keep reading.
+        b->text.resize(size);
+        carry.swap(b->text);
+        continue;
+      }
+    }
+    carry.assign(b->text.begin() + cut, b->text.begin() + size);
+    b->text.resize(cut);
+
+    if (eof && !b->text.empty() && b->text.back() != '\n') {
+      b->text.push_back('\n');
+    }
+    if (!b->text.empty() && !pipe.submit(std::move(b))) {
+      return total;
+    }
+    if (eof) {
+      return total;
+    }
+  }
+}
+
+int usage() {
+  std::fprintf(stderr,
+      "usage: digit_tool OPERATION [--radix N] [--to-radix N] "
+      "[--threads N] [--stats] [FILE...]\n"
+      "operations: reverse sort-digits digit-sum checksum radix-convert "
+      "histogram\n"
+      "radices: 2 8 10 16 36\n");
+  return 2;
+}
+
+}  // namespace
+
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    return usage();
+  }
+
+  const operation_name* selected = nullptr;
+  for (const auto& entry : operations) {
+    if (std::strcmp(argv[1], entry.name) == 0) { selected = &entry; }
+  }
+  if (!selected) {
+    return usage();
+  }
+
+  auto radix = 10, to_radix = 16;
+  auto threads = std::max(1u, std::thread::hardware_concurrency());
+  auto stats = false;
+  auto files = std::vector<const char*>{};
+
+  for (int i = 2; i < argc; ++i) {
+    const bool has_value = i + 1 < argc;
+    if (std::strcmp(argv[i], "--radix") == 0 && has_value) {
+      radix = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--to-radix") == 0 && has_value) {
+      to_radix = std::atoi(argv[++i]);
+    } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+      threads = static_cast<unsigned>(std::max(1, std::atoi(argv[++i])));
+    } else if (std::strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+    } else if (argv[i][0] == '-' && argv[i][1] != '\0') {
+      return usage();
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+
+  const auto process = select_process(radix, to_radix);
+  if (!process) {
+    return usage();
+  }
+  if (files.empty()) {
+    files.push_back("-");
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  auto bytes = 0LL;
+  auto status = 0;
+
+  pipeline pipe{process, selected->op, threads};
+  for (const auto file : files) {
+    const bool is_stdin = std::strcmp(file, "-") == 0;
+    const int fd = is_stdin ? STDIN_FILENO : ::open(file, O_RDONLY);
+    if (fd < 0) {
+      std::fprintf(stderr, "digit_tool: %s: %s\n", file, std::strerror(errno));
+      status = 1;
+      break;
+    }
+
+    const auto n = read_blocks(fd, pipe);
+    if (n < 0) {
+      std::fprintf(stderr, "digit_tool: %s: %s\n", file, std::strerror(errno));
+      status = 1;
+    } else {
+      bytes += n;
+    }
+    if (!is_stdin) {
+      ::close(fd);
+    }
+    if (status != 0) {
+      break;
+    }
+  }
+  pipe.finish();
+
+  if (pipe.bad_line() != 0) {
+    std::fprintf(stderr, "digit_tool: line %zu: not a radix %d integer\n",
+                 pipe.bad_line(), radix);
+    status = 1;
+  } else if (pipe.write_failed()) {
+    status = 1;
+  } else if (selected->op == operation::histogram) {
+    auto out = std::string{};
+    char buf[32];
+    for (int d = 0; d != radix; ++d) {
+      out += jz::detail::digit_char(d);
+      out += ' ';
+      out.append(buf, jz::format_digits(pipe.counts()[d], buf));
+      out += '\n';
+    }
+    write_all(STDOUT_FILENO, out.data(), out.size());
+  }
+
+  if (stats) {
+    const auto seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "digit_tool: %lld bytes in %.3f s, %.1f MB/s\n",
+                 bytes, seconds, double(bytes) / seconds / 1e6);
+  }
+
+  return status;
+}
@@ -0,0 +1,363 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef DIGIT_TRIE_HH_
+#define DIGIT_TRIE_HH_
+
+#include "digit_adaptor.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace jz {
+
+// Indexes a set of integers by their RADIX digits, most significant first,
+// to answer "which keys start with these digits?"
+//
+// The trie keeps its keys sorted in digit order, i.e. lexicographically by
+// digits, so 12 < 123 < 13 < 2.  Every node covers a contiguous run of keys,
+// and a prefix query returns that run directly, without visiting the
+// subtree.  The nodes live in a single flat array in depth-first order.
+// Chains of single-child nodes are path-compressed away:  each node records
+// the number of digits all of its keys share, and the lookup skips straight
+// to the next digit that tells keys apart.
+//
+// Small radices give each internal node a dense array of RADIX child slots,
+// so a step down the trie is a single indexed load.  Larger radices store
+// (digit, child) pairs sorted by digit and use a binary search.
+//
+// By default, each key has as many digits as its value needs.  A trie built
+// with an explicit width pads every key with leading zeros to that width,
+// for fixed-width codes.  With a fixed width, digit order is numeric order.
+//
+// The keys and nodes come from Allocator, such as digit_arena.hh's
+// arena_allocator, rebound for each array.
+template <typename T, int RADIX = 10,
+          typename Allocator = std::allocator<std::remove_cv_t<T>>>
+class digit_trie {
+  static_assert(RADIX > 1, "RADIX must be larger than 1");
+  static_assert(RADIX < 65536, "RADIX must fit in 16 bits");
+  static_assert(std::is_same<typename Allocator::value_type,
+                             std::remove_cv_t<T>>::value,
+                "Allocator must allocate T");
+
+ public:
+  using value_type     = std::remove_cv_t<T>;
+  using size_type      = std::size_t;
+  using allocator_type = Allocator;
+  using const_iterator =
+      typename std::vector<value_type, Allocator>::const_iterator;
+
+  // Radices up to this size use dense child arrays.
+  static constexpr int kMaxDenseRadix = 16;
+
+  // Holds a run of keys in digit order.
+  class range {
+   public:
+    range(const_iterator first, const_iterator last) noexcept
+    : first_{first}, last_{last} {}
+
+    const_iterator begin() const noexcept { return first_; }
+    const_iterator end()   const noexcept { return last_; }
+
+    size_type size() const noexcept {
+      return static_cast<size_type>(last_ - first_);
+    }
+
+    bool empty() const noexcept { return first_ == last_; }
+
+   private:
+    const_iterator first_;
+    const_iterator last_;
+  };
+
+  digit_trie() : digit_trie(Allocator{}) {}
+
+  explicit digit_trie(const Allocator& alloc)
+  : keys_(alloc), nodes_(alloc), children_(alloc), child_digits_(alloc) {}
+
+  // Builds a trie holding the values in [first, last).  Input that's already
+  // in digit order builds in linear time.  Otherwise, it's sorted first.
+  // A non-zero 'width' pads every key to 'width' digits.
+  template <typename InputIt>
+  digit_trie(InputIt first, InputIt last, std::size_t width = 0,
+             const Allocator& alloc = Allocator{})
+  : width_{width}, keys_(first, last, alloc), nodes_(alloc),
+    children_(alloc), child_digits_(alloc) {
+    const auto less = [this](value_type a, value_type b) {
+      return key_less(a, b);
+    };
+
+    if (!std::is_sorted(keys_.begin(), keys_.end(), less)) {
+      std::sort(keys_.begin(), keys_.end(), less);
+    }
+
+    if (!keys_.empty()) {
+      build(0, static_cast<std::uint32_t>(keys_.size()));
+    }
+  }
+
+  // Returns the keys that start with the digits in 'prefix'.  The prefix's
+  // size() counts, so a 4-digit adaptor on 44 finds the keys starting with
+  // 0044.
+  template <typename U, typename Tables>
+  range find_prefix(const digit_adaptor<U, RADIX, Tables>& prefix) const
+      noexcept {
+    const auto length = prefix.size();
+    const auto node = descend(prefix);
+
+    if (node == kNoNode ||
+        prefix_of(keys_[nodes_[node].first], length)
+            != detail::magnitude(static_cast<U>(prefix))) {
+      return {keys_.end(), keys_.end()};
+    }
+
+    return {keys_.begin() + nodes_[node].first,
+            keys_.begin() + nodes_[node].last};
+  }
+
+  // Returns the keys that start with the digits of 'prefix', taking as many
+  // digits as its value needs.
+  range find_prefix(value_type prefix) const noexcept {
+    return find_prefix(digit_adaptor<const value_type, RADIX>{prefix});
+  }
+
+  // Returns true if 'key' is in the trie.
+  bool contains(value_type key) const noexcept {
+    const auto keys = find_prefix(
+        digit_adaptor<const value_type, RADIX>{key, key_length(key)});
+    return !keys.empty() && key_length(*keys.begin()) == key_length(key);
+  }
+
+  // Returns the keys in [lo, hi), in digit order.
+  range key_range(value_type lo, value_type hi) const noexcept {
+    const auto less = [this](value_type a, value_type b) {
+      return key_less(a, b);
+    };
+    const auto first = std::lower_bound(keys_.begin(), keys_.end(), lo, less);
+    const auto last = std::lower_bound(first, keys_.end(), hi, less);
+    return {first, std::max(first, last)};
+  }
+
+  // Iterates over all keys in digit order.
+  const_iterator begin() const noexcept { return keys_.begin(); }
+  const_iterator end()   const noexcept { return keys_.end(); }
+
+  size_type size()  const noexcept { return keys_.size(); }
+  bool      empty() const noexcept { return keys_.empty(); }
+
+  // Returns the key width, or 0 if keys have their natural width.
+  std::size_t width() const noexcept { return width_; }
+
+  // Returns the number of trie nodes, for sizing and tuning.
+  size_type node_count() const noexcept { return nodes_.size(); }
+
+  allocator_type get_allocator() const { return keys_.get_allocator(); }
+
+ private:
+  using NCU = std::make_unsigned_t<value_type>;
+  using digit_type = std::uint16_t;
+
+  static constexpr bool kDense = RADIX <= kMaxDenseRadix;
+  static constexpr std::uint32_t kNoNode = ~std::uint32_t{0};
+
+  struct node {
+    std::uint32_t first;        // First key under this node.
+    std::uint32_t last;         // One past the last key under this node.
+    std::uint32_t children;     // First child slot, or kNoNode for leaves.
+    std::uint16_t depth;        // Leading digits shared by all keys.
+    std::uint16_t child_count;  // Children in use.
+  };
+
+  template <typename U>
+  using vector_of = std::vector<
+      U, typename std::allocator_traits<Allocator>::template rebind_alloc<U>>;
+
+  std::size_t width_ = 0;
+  std::vector<value_type, Allocator> keys_;
+  vector_of<node> nodes_;
+
+  // Dense tries hold RADIX slots per internal node, with 0 for "no child."
+  // Node 0 is the root, so it's never anyone's child.  Sparse tries hold
+  // child_count slots per internal node, paired with child_digits_.
+  vector_of<std::uint32_t> children_;
+  vector_of<digit_type> child_digits_;
+
+  // Returns the number of digits in a key.
+  std::size_t key_length(value_type key) const noexcept {
+    if (width_ != 0) {
+      return width_;
+    }
+
+    const auto& table = detail::radix_powers<NCU, RADIX>::table;
+    const auto u = detail::magnitude(key);
+    return std::max(std::size_t{1}, static_cast<std::size_t>(
+        std::upper_bound(std::begin(table.powers), std::end(table.powers), u)
+        - std::begin(table.powers)));
+  }
+
+  // Returns the first 'digits' digits of a key, as a number.
+  NCU prefix_of(value_type key, std::size_t digits) const noexcept {
+    const auto length = key_length(key);
+    const auto u = detail::magnitude(key);
+
+    if (digits >= length) {
+      return u;
+    }
+
+    const auto shift = length - digits;
+    return shift < detail::radix_power_table<NCU, RADIX>::kCount
+         ? NCU(u / detail::radix_power<NCU, RADIX>(shift)) : NCU{0};
+  }
+
+  // Compares keys in digit order.
+  bool key_less(value_type a, value_type b) const noexcept {
+    const auto a_length = key_length(a), b_length = key_length(b);
+    const auto common = std::min(a_length, b_length);
+    const auto a_prefix = prefix_of(a, common);
+    const auto b_prefix = prefix_of(b, common);
+
+    return a_prefix != b_prefix ? a_prefix < b_prefix : a_length < b_length;
+  }
+
+  // Returns the digit at 'index' in a key, most significant first.
+  digit_type key_digit(value_type key, std::size_t index) const noexcept {
+    return static_cast<digit_type>(
+        digit_adaptor<const value_type, RADIX>{key, key_length(key)}[
+            static_cast<int>(index)]);
+  }
+
+  // Returns the end of the run of keys starting at 'first' that share the
+  // digit at 'depth'.  Keys are sorted, so this is a binary search.
+  std::uint32_t end_of_run(std::uint32_t first, std::uint32_t last,
+                           std::size_t depth) const noexcept {
+    const auto digit = key_digit(keys_[first], depth);
+    const auto end = std::partition_point(
+        keys_.begin() + first + 1, keys_.begin() + last,
+        [this, digit, depth](value_type key) {
+          return key_digit(key, depth) == digit;
+        });
+    return static_cast<std::uint32_t>(end - keys_.begin());
+  }
+
+  // Returns the number of leading digits keys a and b share.
+  std::size_t common_digits(value_type a, value_type b) const noexcept {
+    const auto common = std::min(key_length(a), key_length(b));
+    auto a_prefix = prefix_of(a, common), b_prefix = prefix_of(b, common);
+    auto shared = common;
+
+    while (a_prefix != b_prefix) {
+      a_prefix /= RADIX;
+      b_prefix /= RADIX;
+      --shared;
+    }
+
+    return shared;
+  }
+
+  // Builds the subtrie for keys [first, last), and returns its node index.
+  // Keys are sorted, so the digits shared by the whole run are those shared
+  // by its ends.
+  std::uint32_t build(std::uint32_t first, std::uint32_t last) {
+    const auto index = static_cast<std::uint32_t>(nodes_.size());
+    const auto depth = common_digits(keys_[first], keys_[last - 1]);
+
+    nodes_.push_back({first, last, kNoNode,
+                      static_cast<std::uint16_t>(depth), 0});
+
+    // Keys that end at this node sort ahead of the keys that continue.
+    auto group = first;
+    while (group != last && key_length(keys_[group]) == depth) {
+      ++group;
+    }
+
+    if (group == last) {
+      return index;
+    }
+
+    // Each run of keys with the same digit at 'depth' becomes a child.  The
+    // first pass counts the runs, so we can allocate their slots before the
+    // recursion appends slots of its own.
+    auto runs = std::size_t{0};
+    for (auto key = group; key != last; ) {
+      key = end_of_run(key, last, depth);
+      ++runs;
+    }
+
+    const auto slots = static_cast<std::uint32_t>(children_.size());
+    nodes_[index].children = slots;
+    nodes_[index].child_count = static_cast<std::uint16_t>(runs);
+    children_.resize(slots + (kDense ? RADIX : runs), 0);
+    if (!kDense) {
+      child_digits_.resize(slots + runs);
+    }
+
+    for (auto i = std::uint32_t{0}; group != last; ++i) {
+      const auto digit = key_digit(keys_[group], depth);
+      const auto end = end_of_run(group, last, depth);
+      const auto slot = slots + (kDense ? digit : i);
+
+      if (!kDense) {
+        child_digits_[slot] = digit;
+      }
+
+      const auto child = build(group, end);
+      children_[slot] = child;
+      group = end;
+    }
+
+    return index;
+  }
+
+  // Returns the child of 'parent' for 'digit', or kNoNode.
+  std::uint32_t child_of(const node& parent, digit_type digit) const noexcept {
+    if (parent.children == kNoNode) {
+      return kNoNode;
+    }
+
+    if (kDense) {
+      const auto child = children_[parent.children + digit];
+      return child != 0 ? child : kNoNode;
+    }
+
+    const auto first = child_digits_.begin() + parent.children;
+    const auto last = first + parent.child_count;
+    const auto it = std::lower_bound(first, last, digit);
+    return it != last && *it == digit
+         ? children_[parent.children + static_cast<std::uint32_t>(it - first)]
+         : kNoNode;
+  }
+
+  // Walks down the trie using the prefix's digits, and returns the node
+  // whose keys all share the prefix's length in digits, if any.  The digits
+  // skipped by path compression aren't checked here, so the caller compares
+  // one key from the node against the whole prefix.
+  template <typename U, typename Tables>
+  std::uint32_t descend(const digit_adaptor<U, RADIX, Tables>& prefix) const
+      noexcept {
+    if (nodes_.empty()) {
+      return kNoNode;
+    }
+
+    const auto length = prefix.size();
+    auto index = std::uint32_t{0};
+
+    while (nodes_[index].depth < length) {
+      const auto& n = nodes_[index];
+      const auto digit =
+          static_cast<digit_type>(prefix[static_cast<int>(n.depth)]);
+      index = child_of(n, digit);
+      if (index == kNoNode) {
+        return kNoNode;
+      }
+    }
+
+    return index;
+  }
+};
+
+}  // namespace jz
+#endif // DIGIT_TRIE_HH_
@@ -0,0 +1,187 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "digit_trie.hh"
+#include "digit_test.hh"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using jz::digit_adaptor;
+using jz::digit_trie;
+
+// Returns true if 'range' holds exactly 'expected', in order.
+template <typename Range>
+bool holds(const Range& range, std::vector<long> expected) {
+  return std::vector<long>(range.begin(), range.end()) == expected;
+}
+
+// Tests that the trie sorts its keys into digit order.
+bool TestKeysAreInDigitOrder() {
+  const long keys[] = {2, 13, 123, 12, 4417, 44, 441, 4417};
+  const digit_trie<long> trie{std::begin(keys), std::end(keys)};
+
+  if (trie.size() != 8) { return false; }
+
+  return holds(trie, {12, 123, 13, 2, 44, 441, 4417, 4417});
+}
+
+// Tests prefix queries, including prefixes that are themselves keys and
+// prefixes that fall inside a path-compressed run of digits.
+bool TestPrefixQueries() {
+  const long keys[] = {44170, 44171, 44179, 4418, 441, 4417, 5, 52, 123456};
+  const digit_trie<long> trie{std::begin(keys), std::end(keys)};
+
+  if (!holds(trie.find_prefix(4417L), {4417, 44170, 44171, 44179})) {
+    return false;
+  }
+  if (!holds(trie.find_prefix(441L), {441, 4417, 44170, 44171, 44179, 4418})) {
+    return false;
+  }
+  if (!holds(trie.find_prefix(5L), {5, 52}))  { return false; }
+  if (!holds(trie.find_prefix(123L), {123456})) { return false; }
+  if (!holds(trie.find_prefix(1234L), {123456})) { return false; }
+  if (!trie.find_prefix(1235L).empty())       { return false; }
+  if (!trie.find_prefix(44172L).empty())      { return false; }
+  if (!trie.find_prefix(6L).empty())          { return false; }
+  if (!trie.find_prefix(1234567L).empty())    { return false; }
+
+  // Queries through a digit_adaptor.
+  const int prefix = 44;
+  if (trie.find_prefix(digit_adaptor<const int>{prefix}).size() != 6) {
+    return false;
+  }
+  using untabled = digit_adaptor<const int, 10, jz::no_tables>;
+  if (trie.find_prefix(untabled{prefix}).size() != 6) {
+    return false;
+  }
+
+  return true;
+}
+
+// Tests membership queries.
+bool TestContains() {
+  const long keys[] = {441, 4417, 44170, 99};
+  const digit_trie<long> trie{std::begin(keys), std::end(keys)};
+
+  if (!trie.contains(441))   { return false; }
+  if (!trie.contains(4417))  { return false; }
+  if (!trie.contains(44170)) { return false; }
+  if (!trie.contains(99))    { return false; }
+  if (trie.contains(44))     { return false; }
+  if (trie.contains(4))      { return false; }
+  if (trie.contains(9))      { return false; }
+  if (trie.contains(44171))  { return false; }
+
+  const digit_trie<long> empty{};
+  if (empty.contains(0) || !empty.find_prefix(1L).empty()) { return false; }
+
+  return true;
+}
+
+// Tests fixed-width tries, where leading zeros are part of every key.
+bool TestFixedWidthKeys() {
+  const long keys[] = {441, 4417, 44170, 12};
+  const digit_trie<long> trie{std::begin(keys), std::end(keys), 5};
+
+  // With a fixed width, digit order is numeric order.
+  if (!holds(trie, {12, 441, 4417, 44170})) { return false; }
+
+  const long zero_zero = 0;
+  if (!holds(trie.find_prefix(digit_adaptor<const long>{zero_zero, 2}),
+             {12, 441})) {
+    return false;
+  }
+
+  const long prefix = 44;
+  if (!holds(trie.find_prefix(digit_adaptor<const long>{prefix, 4}),
+             {441})) {
+    return false;
+  }
+  if (!holds(trie.find_prefix(prefix), {44170})) { return false; }
+
+  if (!holds(trie.key_range(100, 5000), {441, 4417})) { return false; }
+
+  return true;
+}
+
+// Tests the sparse child layout used by large radices.
+bool TestSparseRadix() {
+  const long keys[] = {1020304, 1020399, 1029900, 5, 100};
+  const digit_trie<long, 100> trie{std::begin(keys), std::end(keys)};
+
+  if (!holds(trie.find_prefix(102L), {1020304, 1020399, 1029900})) {
+    return false;
+  }
+  if (!holds(trie.find_prefix(10203L), {1020304, 1020399})) { return false; }
+  if (!holds(trie.find_prefix(1L), {100, 1020304, 1020399, 1029900})) {
+    return false;
+  }
+  if (!trie.contains(5) || trie.contains(10203)) { return false; }
+
+  return true;
+}
+
+// Compares prefix queries against a brute-force scan on random keys, for
+// dense and sparse layouts.
+template <int RADIX>
+bool MatchesBruteForce() {
+  auto rng = std::mt19937_64{RADIX};
+  auto keys = std::vector<long>{};
+  for (int i = 0; i != 5000; ++i) {
+    keys.push_back(static_cast<long>(rng() % 10000000));
+  }
+
+  const digit_trie<long, RADIX> trie{keys.begin(), keys.end()};
+
+  for (int i = 0; i != 2000; ++i) {
+    const auto prefix = static_cast<long>(rng() % 1000);
+    const auto prefix_digits = digit_adaptor<const long, RADIX>{prefix};
+
+    auto expected = std::size_t{0};
+    for (const auto key : keys) {
+      const auto key_digits = digit_adaptor<const long, RADIX>{key};
+      expected += key_digits.size() >= prefix_digits.size() &&
+          std::equal(prefix_digits.begin(), prefix_digits.end(),
+                     key_digits.begin());
+    }
+
+    const auto found = trie.find_prefix(prefix);
+    if (found.size() != expected) { return false; }
+
+    for (const auto key : found) {
+      const auto key_digits = digit_adaptor<const long, RADIX>{key};
+      if (!std::equal(prefix_digits.begin(), prefix_digits.end(),
+                      key_digits.begin())) {
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool TestDecimalMatchesBruteForce() { return MatchesBruteForce<10>(); }
+bool TestOctalMatchesBruteForce()   { return MatchesBruteForce<8>(); }
+bool TestRadix100MatchesBruteForce() { return MatchesBruteForce<100>(); }
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestKeysAreInDigitOrder),
+  TEST_CASE(TestPrefixQueries),
+  TEST_CASE(TestContains),
+  TEST_CASE(TestFixedWidthKeys),
+  TEST_CASE(TestSparseRadix),
+  TEST_CASE(TestDecimalMatchesBruteForce),
+  TEST_CASE(TestOctalMatchesBruteForce),
+  TEST_CASE(TestRadix100MatchesBruteForce),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,404 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef FLOAT_DIGIT_ADAPTOR_HH_
+#define FLOAT_DIGIT_ADAPTOR_HH_
+
+#include "decimal_digit_adaptor.hh"
+
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+namespace jz {
+
+// Describes the IEEE 754 binary formats float_digit_adaptor understands.
+template <typename F>
+struct float_traits;
+
+template <>
+struct float_traits<double> {
+  using carrier = std::uint64_t;
+  static constexpr int kSignificandBits = 52;
+  static constexpr int kExponentBits    = 11;
+  static constexpr int kExponentBias    = 1023;
+};
+
+template <>
+struct float_traits<float> {
+  using carrier = std::uint32_t;
+  static constexpr int kSignificandBits = 23;
+  static constexpr int kExponentBits    = 8;
+  static constexpr int kExponentBias    = 127;
+};
+
+// Holds the shortest decimal that rounds back to a binary floating-point
+// value:  (-1)^negative * significand * 10^exponent.  The significand has
+// no trailing zeros, except that zero is 0 * 10^0.
+template <typename F>
+struct float_decimal {
+  using carrier = typename float_traits<F>::carrier;
+
+  bool          negative;
+  decimal_class kind;
+  carrier       significand;
+  int           exponent;
+};
+
+namespace detail {
+
+// These approximations of floor(log10(2^e)), floor(log10(3/4 * 2^e)) and
+// floor(log2(10^e)) are exact over the exponent ranges used below.
+constexpr int floor_log10_pow2(int e) noexcept {
+  return (e * 1262611) >> 22;
+}
+
+constexpr int floor_log10_three_quarters_pow2(int e) noexcept {
+  return (e * 1262611 - 524031) >> 22;
+}
+
+constexpr int floor_log2_pow10(int e) noexcept {
+  return (e * 1741647) >> 19;
+}
+
+// Holds 128-bit approximations of 10^k for kMinPow10 <= k <= kMaxPow10,
+// normalized so the top bit is set, and rounded up.  That is, entry k holds
+// ceil(10^k / 2^e), with e = floor_log2_pow10(k) + 1 - 128.  Each entry's
+// halves sit together, so a lookup touches one cache line.
+struct alignas(kTableAlign) float_pow10_table {
+  static constexpr int kMinPow10 = -292;
+  static constexpr int kMaxPow10 = 326;
+  static constexpr int kEntries = kMaxPow10 - kMinPow10 + 1;
+
+  uint128_parts pow10[kEntries];
+};
+
+// Minimal fixed-size big integer arithmetic, just enough to build the table
+// above at compile time.  Limbs are 32 bits, least significant first.
+constexpr int kPow10TableLimbs = 36;
+
+constexpr int bignum_bit_length(const std::uint32_t (&n)[kPow10TableLimbs]) {
+  for (int i = kPow10TableLimbs - 1; i >= 0; --i) {
+    if (n[i] != 0) {
+      auto bits = 32 * i;
+      for (auto limb = n[i]; limb != 0; limb >>= 1) {
+        ++bits;
+      }
+      return bits;
+    }
+  }
+  return 0;
+}
+
+constexpr std::uint64_t bignum_bits64(
+    const std::uint32_t (&n)[kPow10TableLimbs], int shift) {
+  auto result = std::uint64_t{0};
+  for (int i = 0; i != 2; ++i, shift += 32) {
+    const auto index = shift / 32, offset = shift % 32;
+    auto word = std::uint64_t{index < kPow10TableLimbs ? n[index] : 0u}
+                    >> offset;
+    if (offset != 0 && index + 1 < kPow10TableLimbs) {
+      word |= std::uint64_t{n[index + 1]} << (32 - offset);
+    }
+    result |= (word & 0xFFFFFFFFu) << (32 * i);
+  }
+  return result;
+}
+
+constexpr bool bignum_any_below(
+    const std::uint32_t (&n)[kPow10TableLimbs], int shift) {
+  for (int i = 0; i != shift / 32; ++i) {
+    if (n[i] != 0) { return true; }
+  }
+  return shift % 32 != 0 && (n[shift / 32] & ((1u << (shift % 32)) - 1)) != 0;
+}
+
+constexpr float_pow10_table make_float_pow10_table() {
+  constexpr int kMinPow10 = float_pow10_table::kMinPow10;
+  constexpr int kMaxPow10 = float_pow10_table::kMaxPow10;
+
+  // 'recip' holds floor(2^kRecipShift / 10^m), which gives the negative
+  // powers of 10 their leading 128 bits.
+  constexpr int kRecipShift = 1100;
+
+  float_pow10_table table{};
+  std::uint32_t pow10[kPow10TableLimbs] = {1};
+  std::uint32_t recip[kPow10TableLimbs] = {};
+  recip[kRecipShift / 32] = 1u << (kRecipShift % 32);
+
+  for (int m = 0; m <= kMaxPow10; ++m) {
+    const auto bits = bignum_bit_length(pow10);
+
+    // 10^m, rounded up to 128 bits.
+    if (bits <= 128) {
+      auto lo = bignum_bits64(pow10, 0), hi = bignum_bits64(pow10, 64);
+      for (int i = bits; i != 128; ++i) {
+        hi = (hi << 1) | (lo >> 63);
+        lo <<= 1;
+      }
+      table.pow10[m - kMinPow10].hi = hi;
+      table.pow10[m - kMinPow10].lo = lo;
+    } else {
+      const auto shift = bits - 128;
+      auto lo = bignum_bits64(pow10, shift);
+      auto hi = bignum_bits64(pow10, shift + 64);
+      if (bignum_any_below(pow10, shift) && ++lo == 0) {
+        ++hi;
+      }
+      table.pow10[m - kMinPow10].hi = hi;
+      table.pow10[m - kMinPow10].lo = lo;
+    }
+
+    // 10^-m = 2^-(bits + 127) * (2^(bits + 127) / 10^m), rounded up.  The
+    // quotient is never exact, so rounding up is adding 1.
+    if (m > 0 && -m >= kMinPow10) {
+      const auto shift = kRecipShift - bits - 127;
+      auto lo = bignum_bits64(recip, shift);
+      auto hi = bignum_bits64(recip, shift + 64);
+      if (++lo == 0) {
+        ++hi;
+      }
+      table.pow10[-m - kMinPow10].hi = hi;
+      table.pow10[-m - kMinPow10].lo = lo;
+    }
+
+    auto carry = std::uint64_t{0};
+    for (auto& limb : pow10) {
+      carry += std::uint64_t{limb} * 10;
+      limb = static_cast<std::uint32_t>(carry);
+      carry >>= 32;
+    }
+
+    auto remainder = std::uint64_t{0};
+    for (int i = kPow10TableLimbs - 1; i >= 0; --i) {
+      remainder = (remainder << 32) | recip[i];
+      recip[i] = static_cast<std::uint32_t>(remainder / 10);
+      remainder %= 10;
+    }
+  }
+
+  return table;
+}
+
+// Holds the table in a class template, so it's shared by every translation
+// unit that includes this header.
+template <typename Unused = void>
+struct float_pow10 {
+  static constexpr float_pow10_table table = make_float_pow10_table();
+};
+
+template <typename Unused>
+constexpr float_pow10_table float_pow10<Unused>::table;
+
+// Returns g * cp / 2^128 for doubles or g * cp / 2^64 for floats, rounded
+// to odd.  Round-to-odd keeps just enough information about the discarded
+// bits to compare against the rounding boundaries exactly.
+inline std::uint64_t round_to_odd(std::uint64_t g_hi, std::uint64_t g_lo,
+                                  std::uint64_t cp) noexcept {
+  const auto x = umul128(g_lo, cp);
+  auto y = umul128(g_hi, cp);
+  y.lo += x.hi;
+  y.hi += y.lo < x.hi;
+  return y.hi | (y.lo > 1);
+}
+
+inline std::uint32_t round_to_odd(std::uint64_t g, std::uint32_t cp) noexcept {
+  const auto p = umul128(g, cp);
+  return static_cast<std::uint32_t>(p.hi) | ((p.lo >> 32) > 1);
+}
+
+template <typename Carrier>
+inline Carrier round_to_odd_pow10(int k, Carrier cp) noexcept;
+
+template <>
+inline std::uint64_t round_to_odd_pow10(int k, std::uint64_t cp) noexcept {
+  const auto& table = float_pow10<>::table;
+  const auto i = k - float_pow10_table::kMinPow10;
+  return round_to_odd(table.pow10[i].hi, table.pow10[i].lo, cp);
+}
+
+template <>
+inline std::uint32_t round_to_odd_pow10(int k, std::uint32_t cp) noexcept {
+  const auto& table = float_pow10<>::table;
+  const auto i = k - float_pow10_table::kMinPow10;
+  return round_to_odd(table.pow10[i].hi + (table.pow10[i].lo != 0), cp);
+}
+
+}  // namespace detail
+
+// Computes the shortest decimal that reads back as 'value', picking the one
+// closest to 'value' when there's a choice.  This is Raffaello Giulietti's
+// Schubfach algorithm:  it finds the decimal in a single pass with a handful
+// of 64-bit multiplies, with no loops over digits and no big integers.
+template <typename F>
+inline float_decimal<F> to_shortest_decimal(F value) noexcept {
+  using traits  = float_traits<F>;
+  using carrier = typename traits::carrier;
+
+  static_assert(sizeof(F) == sizeof(carrier), "Unexpected float layout");
+  static_assert(std::numeric_limits<F>::is_iec559, "Requires IEEE 754");
+
+  constexpr int kTotalBits = 8 * sizeof(carrier);
+  constexpr int kSignificandBits = traits::kSignificandBits;
+  constexpr int kMaxExponent = (1 << traits::kExponentBits) - 1;
+  constexpr int kExponentOffset = traits::kExponentBias + kSignificandBits;
+
+  carrier bits{};
+  std::memcpy(&bits, &value, sizeof bits);
+
+  const bool negative = (bits >> (kTotalBits - 1)) != 0;
+  const auto fraction = bits & ((carrier{1} << kSignificandBits) - 1);
+  const auto biased_exponent =
+      static_cast<int>(bits >> kSignificandBits) & kMaxExponent;
+
+  if (biased_exponent == kMaxExponent) {
+    return {negative,
+            fraction == 0 ? decimal_class::infinity : decimal_class::nan,
+            0, 0};
+  }
+
+  if (biased_exponent == 0 && fraction == 0) {
+    return {negative, decimal_class::finite, 0, 0};
+  }
+
+  // value = c * 2^q
+  const auto c = biased_exponent != 0
+               ? carrier(fraction | (carrier{1} << kSignificandBits))
+               : fraction;
+  const auto q = biased_exponent != 0
+               ? biased_exponent - kExponentOffset
+               : 1 - kExponentOffset;
+
+  // The rounding interval is [cbl, cbr] * 2^(q - 2), open at both ends
+  // when c is odd.  It's lopsided at powers of 2.
+  const bool is_even = c % 2 == 0;
+  const bool lower_is_closer = fraction == 0 && biased_exponent > 1;
+
+  const auto cbl = carrier(4 * c - 2 + lower_is_closer);
+  const auto cb  = carrier(4 * c);
+  const auto cbr = carrier(4 * c + 2);
+
+  // Scale by 10^-k so that the interval holds at least one integer, and
+  // at most one multiple of 10.
+  const int k = lower_is_closer ? detail::floor_log10_three_quarters_pow2(q)
+                                : detail::floor_log10_pow2(q);
+  const int h = q + detail::floor_log2_pow10(-k) + 1;
+
+  const auto vbl = detail::round_to_odd_pow10<carrier>(-k, carrier(cbl << h));
+  const auto vb  = detail::round_to_odd_pow10<carrier>(-k, carrier(cb  << h));
+  const auto vbr = detail::round_to_odd_pow10<carrier>(-k, carrier(cbr << h));
+
+  const auto lower = carrier(vbl + !is_even);
+  const auto upper = carrier(vbr - !is_even);
+
+  auto significand = carrier{0};
+  auto exponent = k;
+
+  // If a multiple of 10 is in the interval, prefer the shorter decimal.
+  const auto s = carrier(vb / 4);
+  bool found = false;
+
+  if (s >= 10) {
+    const auto sp = carrier(s / 10);
+    const bool up_inside = lower <= 40 * sp;
+    const bool wp_inside = 40 * sp + 40 <= upper;
+
+    if (up_inside != wp_inside) {
+      significand = carrier(sp + wp_inside);
+      exponent = k + 1;
+      found = true;
+    }
+  }
+
+  // Otherwise, pick the integer in the interval closest to the value.
+  if (!found) {
+    const bool u_inside = lower <= 4 * s;
+    const bool w_inside = 4 * s + 4 <= upper;
+
+    if (u_inside != w_inside) {
+      significand = carrier(s + w_inside);
+    } else {
+      const auto mid = carrier(4 * s + 2);
+      const bool round_up = vb > mid || (vb == mid && (s & 1) != 0);
+      significand = carrier(s + round_up);
+    }
+  }
+
+  while (significand % 10 == 0 && significand != 0) {
+    significand /= 10;
+    ++exponent;
+  }
+
+  return {negative, decimal_class::finite, significand, exponent};
+}
+
+namespace detail {
+
+template <typename F>
+struct float_decimal_holder {
+  float_decimal<F> decimal_;
+};
+
+}  // namespace detail
+
+// Adapts a binary floating-point value to look like a read-only container
+// of the decimal digits of its shortest round-trip representation.  The
+// place value of the last digit is exponent().  For example, 0.25 holds the
+// digits 2 and 5, with exponent() == -2.  Zero, infinities and NaNs hold a
+// single zero digit.
+//
+// Construction runs the shortest-decimal conversion once.  Individual digits
+// are only extracted from the decimal significand when they're read, so
+// callers that need just the leading digit, the digit count or a rounding
+// digit never pay for formatting the rest.
+//
+// Like decimal64_digit_adaptor, this holds a copy of the value rather than a
+// reference to it.  Tables is the table policy for reading the digits.
+template <typename F, typename Tables = power_tables>
+class float_digit_adaptor
+    : private detail::float_decimal_holder<F>,
+      public decimal_digit_adaptor<const typename float_traits<F>::carrier, 0,
+                                   10, Tables> {
+  using holder  = detail::float_decimal_holder<F>;
+  using carrier = typename float_traits<F>::carrier;
+  using base    = decimal_digit_adaptor<const carrier, 0, 10, Tables>;
+
+ public:
+  explicit float_digit_adaptor(F value) noexcept
+  : holder{to_shortest_decimal(value)},
+    base{this->decimal_.significand, this->decimal_.exponent,
+         digit_adaptor<const carrier>{this->decimal_.significand}.size()} {}
+
+  // Copies refer to their own significand, not the original's.
+  float_digit_adaptor(const float_digit_adaptor& rhs) noexcept
+  : holder{rhs.decimal_},
+    base{this->decimal_.significand, this->decimal_.exponent, rhs.size()} {}
+
+  float_digit_adaptor& operator=(const float_digit_adaptor&) = delete;
+
+  // Returns the scientific-notation exponent, i.e. the place value of the
+  // first digit.  For example, 1234.5 returns 3.
+  int scientific_exponent() const noexcept {
+    return this->exponent() + static_cast<int>(this->size()) - 1;
+  }
+
+  // Shadows decimal_digit_adaptor::is_negative(), as the sign lives outside
+  // the significand.  Negative zero is negative.
+  bool is_negative() const noexcept {
+    return this->decimal_.negative;
+  }
+
+  bool is_finite() const noexcept {
+    return this->decimal_.kind == decimal_class::finite;
+  }
+
+  bool is_infinity() const noexcept {
+    return this->decimal_.kind == decimal_class::infinity;
+  }
+
+  bool is_nan() const noexcept {
+    return this->decimal_.kind == decimal_class::nan;
+  }
+};
+
+}  // namespace jz
+#endif // FLOAT_DIGIT_ADAPTOR_HH_
@@ -0,0 +1,179 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "float_digit_adaptor.hh"
+#include "digit_test.hh"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+
+namespace {
+
+using jz::float_digit_adaptor;
+
+// Returns the digits of a float_digit_adaptor as a string, for comparisons.
+template <typename F, typename Tables>
+std::string digit_string(const float_digit_adaptor<F, Tables>& d) {
+  auto s = std::string{};
+  for (const auto digit : d) {
+    s += static_cast<char>('0' + digit);
+  }
+  return s;
+}
+
+// Tests the shortest digits of some familiar doubles.
+bool TestShortestDigitsOfDoubles() {
+  const float_digit_adaptor<double> a{0.1};
+  if (digit_string(a) != "1" || a.exponent() != -1) { return false; }
+
+  const float_digit_adaptor<double> b{1.0};
+  if (digit_string(b) != "1" || b.exponent() != 0)  { return false; }
+
+  const float_digit_adaptor<double> c{123.456};
+  if (digit_string(c) != "123456")  { return false; }
+  if (c.exponent() != -3)           { return false; }
+  if (c.integer_digits() != 3)      { return false; }
+  if (c.scientific_exponent() != 2) { return false; }
+
+  const float_digit_adaptor<double> d{1e23};
+  if (digit_string(d) != "1" || d.exponent() != 23) { return false; }
+
+  const float_digit_adaptor<double> e{0.1 + 0.2};
+  if (digit_string(e) != "30000000000000004") { return false; }
+  if (e.exponent() != -17)                    { return false; }
+
+  const float_digit_adaptor<double> f{std::numeric_limits<double>::max()};
+  if (digit_string(f) != "17976931348623157") { return false; }
+  if (f.scientific_exponent() != 308)         { return false; }
+
+  const float_digit_adaptor<double> g{
+      std::numeric_limits<double>::denorm_min()};
+  if (digit_string(g) != "5" || g.exponent() != -324) { return false; }
+
+  const float_digit_adaptor<double> h{-2.5};
+  if (!h.is_negative() || digit_string(h) != "25") { return false; }
+
+  return true;
+}
+
+// Tests the shortest digits of some familiar floats.  These differ from the
+// digits of the same values widened to double.
+bool TestShortestDigitsOfFloats() {
+  const float_digit_adaptor<float> a{0.1f};
+  if (digit_string(a) != "1" || a.exponent() != -1) { return false; }
+
+  const float_digit_adaptor<float> b{16777216.0f};
+  if (digit_string(b) != "16777216" || b.exponent() != 0) { return false; }
+
+  const float_digit_adaptor<float> c{std::numeric_limits<float>::max()};
+  if (digit_string(c) != "34028235" || c.exponent() != 31) { return false; }
+
+  const float_digit_adaptor<float> d{
+      std::numeric_limits<float>::denorm_min()};
+  if (digit_string(d) != "1" || d.exponent() != -45) { return false; }
+
+  const float_digit_adaptor<double> e{0.1f};
+  if (digit_string(e) != "10000000149011612") { return false; }
+
+  return true;
+}
+
+// Tests zero and the non-finite values.
+bool TestSpecialValues() {
+  const float_digit_adaptor<double> z{0.0};
+  if (!z.is_finite() || z.is_negative())   { return false; }
+  if (z.size() != 1 || z[0] != 0)          { return false; }
+
+  const float_digit_adaptor<double> nz{-0.0};
+  if (!nz.is_negative())                   { return false; }
+
+  const float_digit_adaptor<double> inf{
+      std::numeric_limits<double>::infinity()};
+  if (!inf.is_infinity() || inf.is_finite()) { return false; }
+
+  const float_digit_adaptor<float> nan{
+      std::numeric_limits<float>::quiet_NaN()};
+  if (!nan.is_nan() || nan.is_finite())    { return false; }
+
+  return true;
+}
+
+// Tests the container and rounding interfaces inherited from
+// decimal_digit_adaptor, and that copies stand alone.
+bool TestContainerInterface() {
+  const float_digit_adaptor<double> d{2.675};
+
+  if (d.size() != 4)             { return false; }
+  if (*d.rbegin() != 5)          { return false; }
+  if (d.at_place(0) != 2)        { return false; }
+  if (d.rounding_digit(2) != 5)  { return false; }
+  if (d.is_sticky(2))            { return false; }
+  if (!d.rounds_up(2))           { return false; }
+
+  const auto copy = d;
+  if (digit_string(copy) != "2675" || copy.exponent() != -3) {
+    return false;
+  }
+
+  const float_digit_adaptor<double, jz::no_tables> untabled{2.675};
+  if (digit_string(untabled) != "2675" || !untabled.rounds_up(2)) {
+    return false;
+  }
+
+  return true;
+}
+
+// Tests that random doubles and floats read back exactly from their digits.
+template <typename F, typename Bits>
+bool RoundTripsRandomValues() {
+  auto rng = std::mt19937_64{0x5eed};
+
+  for (int i = 0; i != 100000; ++i) {
+    const auto bits = static_cast<Bits>(rng());
+    F value;
+    std::memcpy(&value, &bits, sizeof value);
+
+    if (!std::isfinite(value)) { continue; }
+
+    const float_digit_adaptor<F> d{value};
+    const auto text = (d.is_negative() ? "-" : "") + digit_string(d)
+                    + "e" + std::to_string(d.exponent());
+    const auto parsed = static_cast<F>(std::is_same<F, float>::value
+                                       ? std::strtof(text.c_str(), nullptr)
+                                       : std::strtod(text.c_str(), nullptr));
+
+    if (std::memcmp(&parsed, &value, sizeof value) != 0) { return false; }
+    if (d.size() > 1 && *d.rbegin() == 0)               { return false; }
+  }
+
+  return true;
+}
+
+bool TestRoundTripOfRandomDoubles() {
+  return RoundTripsRandomValues<double, std::uint64_t>();
+}
+
+bool TestRoundTripOfRandomFloats() {
+  return RoundTripsRandomValues<float, std::uint32_t>();
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestShortestDigitsOfDoubles),
+  TEST_CASE(TestShortestDigitsOfFloats),
+  TEST_CASE(TestSpecialValues),
+  TEST_CASE(TestContainerInterface),
+  TEST_CASE(TestRoundTripOfRandomDoubles),
+  TEST_CASE(TestRoundTripOfRandomFloats),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
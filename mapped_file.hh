@@ -0,0 +1,162 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef MAPPED_FILE_HH_
+#define MAPPED_FILE_HH_
+
+#include <cerrno>
+#include <cstddef>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace jz {
+
+// Maps a whole file into memory, POSIX-style.  This follows the iostreams
+// convention for errors:  constructors don't throw, and a failed mapping
+// tests false, with the errno value from the failing call in error().
+//
+// Mappings are move-only, and unmap when destroyed.
+class mapped_file {
+ public:
+  enum mode { read_only, read_write };
+
+  mapped_file() noexcept = default;
+
+  // Maps an existing file.
+  explicit mapped_file(const char* path, mode m = read_only) noexcept {
+    const int fd = ::open(path, m == read_only ? O_RDONLY : O_RDWR);
+    if (fd < 0) {
+      error_ = errno;
+      return;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+      error_ = errno;
+    } else {
+      map(fd, static_cast<std::size_t>(st.st_size), m);
+    }
+    ::close(fd);
+  }
+
+  // Creates (or truncates) a file of 'size' bytes, and maps it for writing.
+  // Truncating a file that's mapped elsewhere zeroes it there too, so
+  // callers that read one file and write another should check that the
+  // two differ first.
+  //
+  // The file's blocks are allocated up front, so a full disk fails here,
+  // with ENOSPC, rather than with SIGBUS on some later store through the
+  // mapping.
+  explicit mapped_file(const char* path, std::size_t size) noexcept {
+    const int fd = ::open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      error_ = errno;
+      return;
+    }
+
+    // posix_fallocate() returns its error, rather than setting errno.
+    const auto error = size == 0 ? 0
+        : ::posix_fallocate(fd, 0, static_cast<off_t>(size));
+    if (error != 0) {
+      error_ = error;
+    } else {
+      map(fd, size, read_write);
+    }
+    ::close(fd);
+  }
+
+  mapped_file(mapped_file&& rhs) noexcept
+  : data_{std::exchange(rhs.data_, nullptr)},
+    size_{std::exchange(rhs.size_, 0)},
+    error_{std::exchange(rhs.error_, 0)} {}
+
+  mapped_file& operator=(mapped_file&& rhs) noexcept {
+    if (this != &rhs) {
+      unmap();
+      data_ = std::exchange(rhs.data_, nullptr);
+      size_ = std::exchange(rhs.size_, 0);
+      error_ = std::exchange(rhs.error_, 0);
+    }
+    return *this;
+  }
+
+  mapped_file(const mapped_file&) = delete;
+  mapped_file& operator=(const mapped_file&) = delete;
+
+  ~mapped_file() noexcept { unmap(); }
+
+  // Returns true if the file is mapped.  Empty files map successfully, with
+  // a null data().
+  bool is_open() const noexcept { return error_ == 0 && (data_ || !size_); }
+  explicit operator bool() const noexcept { return is_open(); }
+
+  // Returns the errno value from the call that failed, or 0.
+  int error() const noexcept { return error_; }
+
+  unsigned char*       data()       noexcept { return data_; }
+  const unsigned char* data() const noexcept { return data_; }
+  std::size_t          size() const noexcept { return size_; }
+
+  // Hints that the mapping will be read mostly in order.
+  void advise_sequential() const noexcept {
+    if (data_) { ::madvise(data_, size_, MADV_SEQUENTIAL); }
+  }
+
+  // Hints that the mapping will be read soon.
+  void advise_willneed() const noexcept {
+    if (data_) { ::madvise(data_, size_, MADV_WILLNEED); }
+  }
+
+  // Asks for transparent huge pages, where the kernel supports them for
+  // this kind of mapping.  It's only a hint, so failure is ignored.
+  void advise_huge_pages() const noexcept {
+#ifdef MADV_HUGEPAGE
+    if (data_) { ::madvise(data_, size_, MADV_HUGEPAGE); }
+#endif
+  }
+
+  // Writes dirty pages back to the file.  Returns false and sets error() if
+  // that fails.
+  bool sync() noexcept {
+    if (data_ && ::msync(data_, size_, MS_SYNC) != 0) {
+      error_ = errno;
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  unsigned char* data_ = nullptr;
+  std::size_t size_ = 0;
+  int error_ = 0;
+
+  void map(int fd, std::size_t size, mode m) noexcept {
+    if (size == 0) {
+      return;
+    }
+
+    const int prot = m == read_only ? PROT_READ : PROT_READ | PROT_WRITE;
+    void* p = ::mmap(nullptr, size, prot, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      error_ = errno;
+      return;
+    }
+
+    data_ = static_cast<unsigned char*>(p);
+    size_ = size;
+  }
+
+  void unmap() noexcept {
+    if (data_) {
+      ::munmap(data_, size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+};
+
+}  // namespace jz
+#endif // MAPPED_FILE_HH_
@@ -0,0 +1,624 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef STRING_DIGIT_ADAPTOR_HH_
+#define STRING_DIGIT_ADAPTOR_HH_
+
+#include "digit_adaptor.hh"
+#include "digit_batch.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <type_traits>
+
+namespace jz {
+namespace detail {
+
+constexpr std::uint64_t kEachByte = 0x0101010101010101ULL;
+constexpr std::uint64_t kLow7     = 0x7F7F7F7F7F7F7F7FULL;
+constexpr std::uint64_t kHighNibs = 0xF0F0F0F0F0F0F0F0ULL;
+
+// Returns the value of a RADIX digit character, with letters in either
+// case.  The result is RADIX or more for anything else.
+template <int RADIX>
+constexpr unsigned char_digit(char c) noexcept {
+  return RADIX <= 10 ? unsigned(static_cast<unsigned char>(c) - '0')
+       : c >= '0' && c <= '9' ? unsigned(c - '0')
+       : c >= 'a' && c <= 'z' ? unsigned(c - 'a' + 10)
+       : c >= 'A' && c <= 'Z' ? unsigned(c - 'A' + 10)
+       : unsigned(RADIX);
+}
+
+// Returns 0x80 in each byte of 'chunk' that's zero, and 0 in the others.
+// No byte carries into its neighbor, so the result is exact.
+constexpr std::uint64_t zero_bytes(std::uint64_t chunk) noexcept {
+  return ~(((chunk & kLow7) + kLow7) | chunk | kLow7);
+}
+
+// Returns true if all eight bytes in 'chunk' are RADIX digits, for RADIX up
+// to 10.  This is is_eight_digits(), with the carry threshold moved.
+template <int RADIX>
+constexpr bool is_eight_radix_digits(std::uint64_t chunk) noexcept {
+  return ((chunk & kHighNibs) |
+          (((chunk + (16 - RADIX) * kEachByte) & kHighNibs) >> 4))
+      == 0x3333333333333333ULL;
+}
+
+inline void store_le64(std::uint64_t chunk, char* p) noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+  chunk = __builtin_bswap64(chunk);
+#endif
+  std::memcpy(p, &chunk, sizeof chunk);
+}
+
+inline std::uint64_t byte_swap64(std::uint64_t chunk) noexcept {
+#if defined(__GNUC__)
+  return __builtin_bswap64(chunk);
+#else
+  chunk = ((chunk & 0x00FF00FF00FF00FFULL) << 8) |
+          ((chunk >> 8) & 0x00FF00FF00FF00FFULL);
+  chunk = ((chunk & 0x0000FFFF0000FFFFULL) << 16) |
+          ((chunk >> 16) & 0x0000FFFF0000FFFFULL);
+  return (chunk << 32) | (chunk >> 32);
+#endif
+}
+
+// Returns the sum of the bytes in 'lanes'.  Pairs of lanes sum into 16
+// bits first, so the total can't overflow.
+constexpr std::size_t sum_byte_lanes(std::uint64_t lanes) noexcept {
+  const auto pairs = (lanes & 0x00FF00FF00FF00FFULL) +
+                     ((lanes >> 8) & 0x00FF00FF00FF00FFULL);
+  return static_cast<std::size_t>((pairs * 0x0001000100010001ULL) >> 48);
+}
+
+}  // namespace detail
+
+// Adapts a span of digit characters to look like the same container of
+// digits that digit_adaptor provides, with the same iterators and proxy
+// references.  Generic code written against one works with the other.
+//
+// Unlike a digit_adaptor, the digits never pass through an integer type, so
+// leading zeros stay put and there's no limit on length.  Digits past 9 are
+// letters, in either case; digits written through the adaptor use
+// lowercase.  Reading a character that isn't a RADIX digit gives an
+// unspecified value, so check valid() on untrusted input.
+//
+// Char is 'char' or 'const char'.  With 'const char', the container is
+// read-only, as digit_adaptor<const T> is.
+template <int RADIX = 10, typename Char = char>
+class string_digit_adaptor {
+  static_assert(RADIX > 1 && RADIX <= 36, "Digits are 0-9 and a-z");
+  static_assert(std::is_same<std::remove_const_t<Char>, char>::value,
+                "Char must be char or const char");
+
+  using string_type = std::conditional_t<std::is_const<Char>::value,
+                          const std::string, std::string>;
+
+ public:
+  constexpr string_digit_adaptor(Char* first, Char* last) noexcept
+  : first_{first}, last_{last} {}
+
+  constexpr string_digit_adaptor(Char* first, std::size_t digits) noexcept
+  : first_{first}, last_{first + digits} {}
+
+  // Adapts the whole string.  Changing the string's length invalidates the
+  // adaptor, as it would an iterator.
+  explicit string_digit_adaptor(string_type& digits) noexcept
+  : first_{&digits[0]}, last_{&digits[0] + digits.size()} {}
+
+  // Forward iterators.
+  constexpr auto begin() const noexcept {
+    return iterator_<Char>{first_};
+  }
+  constexpr auto end() const noexcept {
+    return iterator_<Char>{last_};
+  }
+  constexpr auto cbegin() const noexcept {
+    return iterator_<const char>{first_};
+  }
+  constexpr auto cend() const noexcept {
+    return iterator_<const char>{last_};
+  }
+
+  // Reverse iterators.
+  constexpr auto rbegin() const noexcept {
+    return std::reverse_iterator<iterator_<Char>>{end()};
+  }
+  constexpr auto rend() const noexcept {
+    return std::reverse_iterator<iterator_<Char>>{begin()};
+  }
+  constexpr auto crbegin() const noexcept {
+    return std::reverse_iterator<iterator_<const char>>{cend()};
+  }
+  constexpr auto crend() const noexcept {
+    return std::reverse_iterator<iterator_<const char>>{cbegin()};
+  }
+
+  // Provides indirect access to each digit.  Behaves as a reference or a
+  // const reference depending on whether Char is const.
+  constexpr auto operator[] (std::size_t index) const noexcept {
+    return reference_{first_ + index};
+  }
+
+  // Returns the number of digits in the container.
+  constexpr std::size_t size() const noexcept {
+    return static_cast<std::size_t>(last_ - first_);
+  }
+
+  // Returns the underlying characters.
+  constexpr Char* data() const noexcept {
+    return first_;
+  }
+
+  // Returns true if every character is a RADIX digit.  Radices up to 10
+  // check eight characters per step.
+  bool valid() const noexcept {
+    auto p = static_cast<const char*>(first_);
+    if (RADIX <= 10) {
+      for (; last_ - p >= 8; p += 8) {
+        if (!detail::is_eight_radix_digits<RADIX>(detail::load_le64(p))) {
+          return false;
+        }
+      }
+    }
+    for (; p != last_; ++p) {
+      if (detail::char_digit<RADIX>(*p) >= unsigned(RADIX)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Compares as standard containers do, by digit values, so "0a" and "0A"
+  // compare equal in radix 16.
+  bool operator==(const string_digit_adaptor& rhs) const noexcept {
+    if (size() != rhs.size()) {
+      return false;
+    }
+    if (RADIX <= 10) {
+      return std::memcmp(first_, rhs.first_, size()) == 0;
+    }
+    return std::equal(first_, last_, rhs.first_, [](char a, char b) {
+      return detail::char_digit<RADIX>(a) == detail::char_digit<RADIX>(b);
+    });
+  }
+
+  bool operator!=(const string_digit_adaptor& rhs) const noexcept {
+    return !this->operator==(rhs);
+  }
+
+ private:
+  Char* first_;
+  Char* last_;
+
+  // Forward declarations.
+  class mutable_pointer_;
+  class const_pointer_;
+  class const_reference_;
+
+  // Provides indirect access to one digit character.  This mirrors
+  // digit_adaptor's reference, with int standing in for T.
+  class mutable_reference_ {
+   public:
+    using is_digit_adaptor_mutable_reference = std::true_type;
+
+    constexpr explicit mutable_reference_(char* p) noexcept : p_{p} {}
+    constexpr mutable_reference_(const mutable_reference_&) = default;
+
+    constexpr operator int () const noexcept {
+      return static_cast<int>(detail::char_digit<RADIX>(*p_));
+    }
+
+    // Stores a digit, modulo RADIX, as digit_adaptor does.
+    constexpr const auto& operator=(int digit) const noexcept {
+      *p_ = detail::digit_char((digit % RADIX + RADIX) % RADIX);
+      return *this;
+    }
+
+    // Behaves like an lvalue reference, copying the referent's value to
+    // our value, rather than copying the proxy.
+    constexpr const auto& operator=(const_reference_ rhs) const noexcept {
+      *p_ = *rhs.p_;
+      return *this;
+    }
+    constexpr const auto& operator=(mutable_reference_ rhs) const noexcept {
+      *p_ = *rhs.p_;
+      return *this;
+    }
+
+    ~mutable_reference_() noexcept = default;
+
+    // Convert a "reference" back into a "pointer."
+    constexpr auto operator&() const noexcept {
+      return mutable_pointer_{p_};
+    }
+
+    constexpr bool operator<(const_reference_ rhs) const noexcept {
+      return int{*this} < int{rhs};
+    }
+
+    constexpr bool operator==(const_reference_ rhs) const noexcept {
+      return int{*this} == int{rhs};
+    }
+
+    constexpr const auto& operator++() const noexcept {
+      return this->operator=(int{*this} + 1);
+    }
+
+    constexpr const auto& operator--() const noexcept {
+      return this->operator=(int{*this} - 1);
+    }
+
+    constexpr int operator++(int) const noexcept {
+      auto temp = int{*this};
+      this->operator++();
+      return temp;
+    }
+
+    constexpr int operator--(int) const noexcept {
+      auto temp = int{*this};
+      this->operator--();
+      return temp;
+    }
+
+    // Swaps the underlying characters, not the reference proxies.
+    constexpr void swap(const mutable_reference_& rhs) const noexcept {
+      const auto c = *p_;
+      *p_ = *rhs.p_;
+      *rhs.p_ = c;
+    }
+
+    constexpr operator const_reference_() const noexcept {
+      return const_reference_{*this};
+    }
+
+   private:
+    char *const p_;
+    friend class const_reference_;
+  };
+
+  class mutable_pointer_ {
+   public:
+    constexpr explicit mutable_pointer_(char* p) noexcept : ref_{p} {}
+
+    constexpr auto operator->() const { return ref_; }
+    constexpr auto operator*()  const { return ref_; }
+
+   private:
+    mutable_reference_ ref_;
+  };
+
+  // Provides read-only indirect access to one digit character.
+  class const_reference_ {
+   public:
+    constexpr explicit const_reference_(const char* p) noexcept : p_{p} {}
+    constexpr const_reference_(const const_reference_&) noexcept = default;
+    constexpr const_reference_(const mutable_reference_& ref) noexcept
+    : p_{ref.p_} {}
+
+    constexpr operator int () const noexcept {
+      return static_cast<int>(detail::char_digit<RADIX>(*p_));
+    }
+
+    ~const_reference_() noexcept = default;
+
+    constexpr auto operator&() const noexcept {
+      return const_pointer_{p_};
+    }
+
+    constexpr bool operator<(const_reference_ rhs) const noexcept {
+      return int{*this} < int{rhs};
+    }
+
+    constexpr bool operator==(const_reference_ rhs) const noexcept {
+      return int{*this} == int{rhs};
+    }
+
+   private:
+    const char *const p_;
+    friend class mutable_reference_;
+  };
+
+  class const_pointer_ {
+   public:
+    constexpr explicit const_pointer_(const char* p) noexcept : ref_{p} {}
+
+    constexpr auto operator->() const { return ref_; }
+    constexpr auto operator*()  const { return ref_; }
+
+   private:
+    const_reference_ ref_;
+  };
+
+  using pointer_   = std::conditional_t<std::is_const<Char>::value,
+                         const_pointer_, mutable_pointer_>;
+  using reference_ = std::conditional_t<std::is_const<Char>::value,
+                         const_reference_, mutable_reference_>;
+
+  // Walks the characters directly, so unlike digit_adaptor's iterator this
+  // doesn't clamp at the ends.  QC is the "qualified Char."
+  template <typename QC>
+  class iterator_ {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = int;
+    using pointer   = std::conditional_t<std::is_const<QC>::value,
+                          const_pointer_, pointer_>;
+    using reference = std::conditional_t<std::is_const<QC>::value,
+                          const_reference_, reference_>;
+
+    constexpr iterator_() noexcept : p_{nullptr} {}
+    constexpr explicit iterator_(QC* p) noexcept : p_{p} {}
+
+    constexpr iterator_(const iterator_&)            = default;
+    constexpr iterator_& operator=(const iterator_&) = default;
+
+    constexpr auto& operator++() noexcept { ++p_; return *this; }
+    constexpr auto& operator--() noexcept { --p_; return *this; }
+
+    constexpr auto operator++(int) noexcept {
+      auto temp = iterator_{*this};
+      ++p_;
+      return temp;
+    }
+
+    constexpr auto operator--(int) noexcept {
+      auto temp = iterator_{*this};
+      --p_;
+      return temp;
+    }
+
+    constexpr auto operator+(difference_type rhs) const noexcept {
+      return iterator_{p_ + rhs};
+    }
+
+    constexpr auto operator-(difference_type rhs) const noexcept {
+      return iterator_{p_ - rhs};
+    }
+
+    friend constexpr auto operator+(difference_type lhs,
+                                    const iterator_& rhs) noexcept {
+      return iterator_{rhs.p_ + lhs};
+    }
+
+    constexpr difference_type operator-(const iterator_& rhs) const noexcept {
+      return p_ - rhs.p_;
+    }
+
+    constexpr auto& operator+=(difference_type rhs) noexcept {
+      p_ += rhs;
+      return *this;
+    }
+
+    constexpr auto& operator-=(difference_type rhs) noexcept {
+      p_ -= rhs;
+      return *this;
+    }
+
+    constexpr bool operator==(const iterator_& rhs) const noexcept {
+      return p_ == rhs.p_;
+    }
+
+    constexpr bool operator!=(const iterator_& rhs) const noexcept {
+      return p_ != rhs.p_;
+    }
+
+    constexpr bool operator<(const iterator_& rhs) const noexcept {
+      return p_ < rhs.p_;
+    }
+
+    constexpr bool operator>=(const iterator_& rhs) const noexcept {
+      return p_ >= rhs.p_;
+    }
+
+    constexpr bool operator>(const iterator_& rhs) const noexcept {
+      return p_ > rhs.p_;
+    }
+
+    constexpr bool operator<=(const iterator_& rhs) const noexcept {
+      return p_ <= rhs.p_;
+    }
+
+    constexpr reference operator*() const noexcept {
+      return reference{p_};
+    }
+
+    constexpr reference operator[](difference_type index) const noexcept {
+      return reference{p_ + index};
+    }
+
+   private:
+    QC* p_;
+  };
+
+ public:
+  using element_type    = Char;
+  using value_type      = int;
+  using size_type       = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer         = string_digit_adaptor::pointer_;
+  using const_pointer   = string_digit_adaptor::const_pointer_;
+  using reference       = string_digit_adaptor::reference_;
+  using const_reference = string_digit_adaptor::const_reference_;
+  using iterator        = string_digit_adaptor::iterator_<Char>;
+  using const_iterator  = string_digit_adaptor::iterator_<const char>;
+};
+
+// Returns a string_digit_adaptor over [first, last).
+template <int RADIX = 10, typename Char>
+constexpr string_digit_adaptor<RADIX, Char> make_string_digit_adaptor(
+    Char* first, Char* last) noexcept {
+  return string_digit_adaptor<RADIX, Char>{first, last};
+}
+
+template <int RADIX = 10>
+string_digit_adaptor<RADIX> make_string_digit_adaptor(
+    std::string& digits) noexcept {
+  return string_digit_adaptor<RADIX>{digits};
+}
+
+template <int RADIX = 10>
+string_digit_adaptor<RADIX, const char> make_string_digit_adaptor(
+    const std::string& digits) noexcept {
+  return string_digit_adaptor<RADIX, const char>{digits};
+}
+
+// The overloads below specialize the generic digit algorithms in
+// digit_adaptor.hh.  Radices up to 10 have contiguous digit characters, so
+// where it pays, they work on eight characters at a time, SWAR-style.
+// Larger radices, whose letters come in two cases, mostly go a character at
+// a time.
+
+// Reverses the digits in place.  Each step swaps byte-reversed 8-character
+// chunks from the two ends, and the middle finishes one character at a
+// time.  This is the same for every radix.
+template <int RADIX>
+void reverse_digits(const string_digit_adaptor<RADIX, char>& digits) noexcept {
+  auto lo = digits.data();
+  auto hi = lo + digits.size();
+  for (; hi - lo >= 16; lo += 8) {
+    hi -= 8;
+    const auto front = detail::load_le64(lo);
+    detail::store_le64(detail::byte_swap64(detail::load_le64(hi)), lo);
+    detail::store_le64(detail::byte_swap64(front), hi);
+  }
+  std::reverse(lo, hi);
+}
+
+// Returns the number of times 'digit' appears.  Each step compares eight
+// characters at once, and adds the matches into byte lanes, which get
+// summed before any passes 255.
+template <int RADIX, typename Char>
+std::size_t count_digit(const string_digit_adaptor<RADIX, Char>& digits,
+                        int digit) noexcept {
+  const char* p = digits.data();
+  const char* const last = p + digits.size();
+  auto count = std::size_t{0};
+
+  if (digit < 0 || digit >= RADIX) {
+    return 0;
+  }
+  if (RADIX <= 10) {
+    const auto c = static_cast<unsigned char>(detail::digit_char(digit));
+    const auto pattern = detail::kEachByte * c;
+    while (last - p >= 8) {
+      auto lanes = std::uint64_t{0};
+      const auto steps = std::min<std::ptrdiff_t>((last - p) / 8, 255);
+      for (const auto stop = p + 8 * steps; p != stop; p += 8) {
+        lanes += detail::zero_bytes(detail::load_le64(p) ^ pattern) >> 7;
+      }
+      count += detail::sum_byte_lanes(lanes);
+    }
+  }
+  for (; p != last; ++p) {
+    count += detail::char_digit<RADIX>(*p) == unsigned(digit);
+  }
+  return count;
+}
+
+namespace detail {
+
+// Counts digits a character at a time.  Characters that aren't digits
+// don't count.
+template <int RADIX, typename Count>
+void char_histogram(const char* p, const char* last, Count* counts) noexcept {
+  for (; p != last; ++p) {
+    const auto digit = char_digit<RADIX>(*p);
+    if (digit < unsigned(RADIX)) {
+      ++counts[digit];
+    }
+  }
+}
+
+// Counts digits in byte lanes:  each step adds a 0 or 1 to every lane of
+// one word per digit, and the lanes get summed before any passes 255.
+// That's a few operations per digit per step, which only pays for tiny
+// radices.
+template <int RADIX, typename Count>
+void swar_histogram(const char* p, const char* last, Count* counts) noexcept {
+  while (last - p >= 8) {
+    std::uint64_t lanes[RADIX] = {};
+    const auto steps = std::min<std::ptrdiff_t>((last - p) / 8, 255);
+    for (const auto stop = p + 8 * steps; p != stop; p += 8) {
+      const auto chunk = load_le64(p);
+      for (int digit = 0; digit != RADIX; ++digit) {
+        lanes[digit] += zero_bytes(chunk ^ (kEachByte * ('0' + digit))) >> 7;
+      }
+    }
+    for (int digit = 0; digit != RADIX; ++digit) {
+      counts[digit] += static_cast<Count>(sum_byte_lanes(lanes[digit]));
+    }
+  }
+  char_histogram<RADIX>(p, last, counts);
+}
+
+// Counts characters into four interleaved tables indexed by the raw
+// character, so repeated digits don't wait on each other's increments, and
+// nothing needs a range check.  Zeroing the tables costs too much for short
+// spans.
+template <int RADIX, typename Count>
+void table_histogram(const char* p, const char* last, Count* counts) noexcept {
+  constexpr auto kBlock = std::ptrdiff_t{1} << 30;  // Keeps the tables exact.
+  while (last - p >= 4) {
+    std::uint32_t tables[4][256] = {};
+    const auto stop = p + (std::min(last - p, kBlock) & ~std::ptrdiff_t{3});
+    for (; p != stop; p += 4) {
+      ++tables[0][static_cast<unsigned char>(p[0])];
+      ++tables[1][static_cast<unsigned char>(p[1])];
+      ++tables[2][static_cast<unsigned char>(p[2])];
+      ++tables[3][static_cast<unsigned char>(p[3])];
+    }
+    for (int digit = 0; digit != RADIX; ++digit) {
+      const auto c = static_cast<unsigned char>(digit_char(digit));
+      auto n = tables[0][c] + tables[1][c] + tables[2][c] + tables[3][c];
+      if (digit >= 10) {
+        const auto upper = static_cast<unsigned char>(c - 'a' + 'A');
+        n += tables[0][upper] + tables[1][upper] + tables[2][upper] +
+             tables[3][upper];
+      }
+      counts[digit] += static_cast<Count>(n);
+    }
+  }
+  char_histogram<RADIX>(p, last, counts);
+}
+
+}  // namespace detail
+
+// Adds the number of times each digit appears to 'counts', which must hold
+// RADIX entries.  Characters that aren't digits don't count.
+template <int RADIX, typename Char, typename Count>
+void digit_histogram(const string_digit_adaptor<RADIX, Char>& digits,
+                     Count* counts) noexcept {
+  constexpr auto kMinTableSpan = std::size_t{256};
+  const char* first = digits.data();
+  const char* last = first + digits.size();
+
+  if (RADIX <= 4) {
+    detail::swar_histogram<RADIX>(first, last, counts);
+  } else if (digits.size() >= kMinTableSpan) {
+    detail::table_histogram<RADIX>(first, last, counts);
+  } else {
+    detail::char_histogram<RADIX>(first, last, counts);
+  }
+}
+
+// Sorts the digits into ascending order, by counting them and writing each
+// run with memset.  The input must be valid().
+template <int RADIX>
+void sort_digits(const string_digit_adaptor<RADIX, char>& digits) noexcept {
+  std::size_t counts[RADIX] = {};
+  digit_histogram(digits, counts);
+
+  auto p = digits.data();
+  for (int digit = 0; digit != RADIX; ++digit) {
+    std::memset(p, detail::digit_char(digit), counts[digit]);
+    p += counts[digit];
+  }
+}
+
+}  // namespace jz
+#endif // STRING_DIGIT_ADAPTOR_HH_
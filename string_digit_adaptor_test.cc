@@ -0,0 +1,226 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "string_digit_adaptor.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using jz::digit_adaptor;
+using jz::string_digit_adaptor;
+
+// Returns a random string of 'length' RADIX digits.  Letters come in both
+// cases.
+template <int RADIX>
+std::string random_digits(std::mt19937_64& rng, std::size_t length) {
+  auto s = std::string(length, '0');
+  for (auto& c : s) {
+    c = jz::detail::digit_char(static_cast<int>(rng() % RADIX));
+    if (c >= 'a' && rng() % 2) { c = static_cast<char>(c - 'a' + 'A'); }
+  }
+  return s;
+}
+
+// Tests reading and writing digits through references, keeping leading
+// zeros and reading letters in either case.
+bool TestReadingAndWriting() {
+  auto zip = std::string{"02134"};
+  string_digit_adaptor<> d{zip};
+  if (d.size() != 5 || d[0] != 0 || d[1] != 2 || d[4] != 4) { return false; }
+
+  d[0] = 9;
+  d[4] = 13;                                    // Stored modulo RADIX.
+  ++d[1];
+  --d[2];
+  if (zip != "93033") { return false; }
+
+  jz::swap(d[0], d[4]);
+  if (zip != "33039") { return false; }
+  d[4]++;
+  if (zip != "33030") { return false; }
+
+  auto hex = std::string{"BeeF"};
+  string_digit_adaptor<16> h{hex};
+  if (h[0] != 11 || h[1] != 14 || h[3] != 15) { return false; }
+  h[1] = 10;
+  if (hex != "BaeF") { return false; }
+
+  // A long string, which no integer type could hold.
+  const auto big = std::string(100, '7') + "0";
+  const auto b = jz::make_string_digit_adaptor(big);
+  return b.size() == 101 && b[99] == 7 && b[100] == 0 && b.valid();
+}
+
+// Tests the iterators with standard algorithms, as digit_adaptor_test.cc
+// does for digit_adaptor.
+bool TestIterators() {
+  auto s = std::string{"8675309"};
+  string_digit_adaptor<> d{s};
+
+  std::sort(d.begin(), d.end());
+  if (s != "0356789") { return false; }
+  std::sort(d.rbegin(), d.rend());
+  if (s != "9876530") { return false; }
+  std::reverse(d.begin(), d.end());
+  if (s != "0356789") { return false; }
+
+  auto sum = 0;
+  for (auto it = d.crbegin(); it != d.crend(); ++it) {
+    sum = sum * 10 + *it;
+  }
+  if (sum != 9876530) { return false; }
+
+  const auto it = d.begin();
+  if (it[3] != 6 || *(it + 6) != 9 || *(2 + it) != 5 ||
+      d.end() - d.begin() != 7) {
+    return false;
+  }
+
+  const auto& cs = s;
+  const string_digit_adaptor<10, const char> c{cs};
+  return std::count(c.begin(), c.end(), 5) == 1 &&
+         *std::max_element(c.begin(), c.end()) == 9 &&
+         c == jz::make_string_digit_adaptor(cs);
+}
+
+// Runs the generic digit algorithms on a container, and returns its digits
+// with their histogram and count of 7s.
+template <typename Digits>
+std::vector<int> run_algorithms(const Digits& digits) {
+  auto result = std::vector<int>{};
+  std::size_t counts[10] = {};
+
+  jz::digit_histogram(digits, counts);
+  result.insert(result.end(), std::begin(counts), std::end(counts));
+  result.push_back(static_cast<int>(jz::count_digit(digits, 7)));
+
+  jz::reverse_digits(digits);
+  result.insert(result.end(), digits.begin(), digits.end());
+  jz::sort_digits(digits);
+  result.insert(result.end(), digits.begin(), digits.end());
+  return result;
+}
+
+// Tests that generic code gets the same answers from either representation.
+bool TestSwitchingRepresentations() {
+  auto n = std::uint64_t{7007123};         // Reversed, it passes 2^31.
+  auto s = std::string{"0007007123"};
+  return run_algorithms(digit_adaptor<std::uint64_t>{n, 10}) ==
+         run_algorithms(string_digit_adaptor<>{s}) &&
+         n == 12377 && s == "0000012377";
+}
+
+// Checks the SWAR algorithms against std ones on the raw characters.
+template <int RADIX>
+bool MatchesStd(std::mt19937_64& rng, std::size_t length) {
+  auto s = random_digits<RADIX>(rng, length);
+  const string_digit_adaptor<RADIX> d{s};
+
+  // Reversing works on raw characters, and keeps their case.
+  auto expected = s;
+  std::reverse(expected.begin(), expected.end());
+  jz::reverse_digits(d);
+  if (s != expected) { return false; }
+
+  std::size_t counts[RADIX] = {}, expected_counts[RADIX] = {};
+  jz::digit_histogram(d, counts);
+  for (const int digit : d) {
+    ++expected_counts[digit];
+  }
+  if (!std::equal(std::begin(counts), std::end(counts),
+                  std::begin(expected_counts))) {
+    return false;
+  }
+
+  const auto digit = static_cast<int>(rng() % RADIX);
+  if (jz::count_digit(d, digit) != expected_counts[digit]) { return false; }
+
+  jz::sort_digits(d);
+  return std::is_sorted(d.begin(), d.end()) &&
+         jz::count_digit(d, digit) == expected_counts[digit];
+}
+
+// Tests every length around the 8-character step and the histogram's
+// table threshold, in radices on each side of the SWAR cutoffs.
+bool TestSwarMatchesStd() {
+  auto rng = std::mt19937_64{91};
+  for (std::size_t length = 0; length != 300; ++length) {
+    if (!MatchesStd<2>(rng, length))  { return false; }
+    if (!MatchesStd<4>(rng, length))  { return false; }
+    if (!MatchesStd<5>(rng, length))  { return false; }
+    if (!MatchesStd<10>(rng, length)) { return false; }
+    if (!MatchesStd<16>(rng, length)) { return false; }
+    if (!MatchesStd<36>(rng, length)) { return false; }
+  }
+  return MatchesStd<2>(rng, 100000) && MatchesStd<10>(rng, 100000) &&
+         MatchesStd<36>(rng, 100000);
+}
+
+template <int RADIX>
+bool valid(const std::string& s) {
+  return string_digit_adaptor<RADIX, const char>{s}.valid();
+}
+
+// Tests validation with a bad character at every position, including the
+// characters just outside each radix's range.
+bool TestValid() {
+  if (!valid<10>("") || !valid<10>("0123456789") || !valid<2>("0110") ||
+      !valid<8>("01234567") || !valid<16>("0123456789abcdefABCDEF") ||
+      !valid<36>("0123456789abcdefghijklmnopqrstuvwxyzXYZ")) {
+    return false;
+  }
+
+  for (const char bad : {'/', ':', '8', '2', ' ', '\x80', '\xB0'}) {
+    for (std::size_t i = 0; i != 20; ++i) {
+      auto s = std::string(20, '1');
+      s[i] = bad;
+      if (valid<2>(s) || (bad != '2' && valid<8>(s)) ||
+          (bad != '8' && bad != '2' && valid<10>(s))) {
+        return false;
+      }
+    }
+  }
+  return !valid<16>("12g4") && !valid<16>("12G4") && !valid<16>("12@4") &&
+         !valid<36>("zz{") && !valid<36>("ZZ[") && !valid<36>("zz`");
+}
+
+// Tests that the histogram skips characters that aren't digits, on both
+// the character and table paths.
+bool TestHistogramSkipsNonDigits() {
+  for (const std::size_t length : {10, 1000}) {
+    auto s = std::string(length, '3');
+    s[1] = 'x';
+    s[length - 1] = '\xB3';
+    std::size_t counts[10] = {};
+    jz::digit_histogram(string_digit_adaptor<>{s}, counts);
+    if (counts[3] != length - 2 || counts[0] + counts[1] + counts[2] != 0) {
+      return false;
+    }
+  }
+  const string_digit_adaptor<10, const char> x3{"x3", 2};
+  return jz::count_digit(x3, 3) == 1 && jz::count_digit(x3, -1) == 0 &&
+         jz::count_digit(x3, 10) == 0;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestReadingAndWriting),
+  TEST_CASE(TestIterators),
+  TEST_CASE(TestSwitchingRepresentations),
+  TEST_CASE(TestSwarMatchesStd),
+  TEST_CASE(TestValid),
+  TEST_CASE(TestHistogramSkipsNonDigits),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
@@ -0,0 +1,198 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef WIDE_ARITHMETIC_HH_
+#define WIDE_ARITHMETIC_HH_
+
+#include "digit_adaptor.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// _addcarry_u64() and _subborrow_u64() are part of baseline x86-64, and
+// compile to ADC and SBB chains that keep the carry in the flags.
+#if defined(__x86_64__) || defined(_M_X64)
+#define JZ_HAVE_ADDCARRY 1
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+namespace jz {
+namespace detail {
+
+// Adds or subtracts one limb with a carry (or borrow) in and out, in
+// plain C++.  Compilers see through these less reliably than through the
+// intrinsics, but they work everywhere.
+struct portable_carry {
+  static std::uint64_t add(std::uint64_t a, std::uint64_t b,
+                           unsigned char& carry) noexcept {
+    const auto sum = a + b;
+    const auto total = sum + carry;
+    carry = static_cast<unsigned char>((sum < a) | (total < sum));
+    return total;
+  }
+
+  static std::uint64_t subtract(std::uint64_t a, std::uint64_t b,
+                                unsigned char& borrow) noexcept {
+    const auto diff = a - b;
+    const auto total = diff - borrow;
+    borrow = static_cast<unsigned char>((a < b) | (diff < borrow));
+    return total;
+  }
+};
+
+#if JZ_HAVE_ADDCARRY
+struct intrinsic_carry {
+  static std::uint64_t add(std::uint64_t a, std::uint64_t b,
+                           unsigned char& carry) noexcept {
+    unsigned long long sum;
+    carry = _addcarry_u64(carry, a, b, &sum);
+    return sum;
+  }
+
+  static std::uint64_t subtract(std::uint64_t a, std::uint64_t b,
+                                unsigned char& borrow) noexcept {
+    unsigned long long diff;
+    borrow = _subborrow_u64(borrow, a, b, &diff);
+    return diff;
+  }
+};
+
+using native_carry = intrinsic_carry;
+#else
+using native_carry = portable_carry;
+#endif
+
+// The kernels below, with the carry primitives as a parameter so the
+// tests and benchmarks can run both.  The main loops go four limbs at a
+// time, which lets the compiler keep the carry in the flags between them.
+template <typename Carry>
+inline std::uint64_t add_limbs(std::uint64_t* out, const std::uint64_t* a,
+                               const std::uint64_t* b,
+                               std::size_t n) noexcept {
+  auto carry = static_cast<unsigned char>(0);
+  auto i = std::size_t{0};
+  for (; n - i >= 4; i += 4) {
+    out[i + 0] = Carry::add(a[i + 0], b[i + 0], carry);
+    out[i + 1] = Carry::add(a[i + 1], b[i + 1], carry);
+    out[i + 2] = Carry::add(a[i + 2], b[i + 2], carry);
+    out[i + 3] = Carry::add(a[i + 3], b[i + 3], carry);
+  }
+  for (; i != n; ++i) {
+    out[i] = Carry::add(a[i], b[i], carry);
+  }
+  return carry;
+}
+
+template <typename Carry>
+inline std::uint64_t subtract_limbs(std::uint64_t* out,
+                                    const std::uint64_t* a,
+                                    const std::uint64_t* b,
+                                    std::size_t n) noexcept {
+  auto borrow = static_cast<unsigned char>(0);
+  auto i = std::size_t{0};
+  for (; n - i >= 4; i += 4) {
+    out[i + 0] = Carry::subtract(a[i + 0], b[i + 0], borrow);
+    out[i + 1] = Carry::subtract(a[i + 1], b[i + 1], borrow);
+    out[i + 2] = Carry::subtract(a[i + 2], b[i + 2], borrow);
+    out[i + 3] = Carry::subtract(a[i + 3], b[i + 3], borrow);
+  }
+  for (; i != n; ++i) {
+    out[i] = Carry::subtract(a[i], b[i], borrow);
+  }
+  return borrow;
+}
+
+// The multiplies are independent; only the high halves chain, through
+// one add with carry per limb.
+template <typename Carry>
+inline std::uint64_t multiply_limbs(std::uint64_t* out,
+                                    const std::uint64_t* a, std::size_t n,
+                                    std::uint64_t m,
+                                    std::uint64_t carry) noexcept {
+  for (auto i = std::size_t{0}; i != n; ++i) {
+    const auto p = umul128(a[i], m);
+    auto c = static_cast<unsigned char>(0);
+    out[i] = Carry::add(p.lo, carry, c);
+    carry = p.hi + c;
+  }
+  return carry;
+}
+
+}  // namespace detail
+
+// Kernels on little-endian limb vectors:  limb 0 is the least
+// significant.  'out' may be the same as either input, which makes them
+// in-place operations.  They don't allocate, and don't normalize:  the
+// length of the result is the length of the inputs.
+
+// Sets out = a + b over n limbs, and returns the carry out, 0 or 1.
+inline std::uint64_t add_limbs(std::uint64_t* out, const std::uint64_t* a,
+                               const std::uint64_t* b,
+                               std::size_t n) noexcept {
+  return detail::add_limbs<detail::native_carry>(out, a, b, n);
+}
+
+// Sets out = a - b over n limbs, modulo 2^(64n), and returns the borrow
+// out, which is 1 if b > a.
+inline std::uint64_t subtract_limbs(std::uint64_t* out,
+                                    const std::uint64_t* a,
+                                    const std::uint64_t* b,
+                                    std::size_t n) noexcept {
+  return detail::subtract_limbs<detail::native_carry>(out, a, b, n);
+}
+
+// Returns -1, 0 or 1 as a is less than, equal to or greater than b.
+inline int compare_limbs(const std::uint64_t* a, const std::uint64_t* b,
+                         std::size_t n) noexcept {
+  while (n-- != 0) {
+    if (a[n] != b[n]) {
+      return a[n] < b[n] ? -1 : 1;
+    }
+  }
+  return 0;
+}
+
+// Sets out = a * m + carry over n limbs, and returns the limb that
+// spills out the top.
+inline std::uint64_t multiply_limbs(std::uint64_t* out,
+                                    const std::uint64_t* a, std::size_t n,
+                                    std::uint64_t m,
+                                    std::uint64_t carry = 0) noexcept {
+  return detail::multiply_limbs<detail::native_carry>(out, a, n, m, carry);
+}
+
+// The same kernels, in place on the std::array values wide_digit_adaptor
+// adapts.  An adaptor on 'x' sees the new value on its next read, through
+// any proxy or iterator it has handed out.
+template <std::size_t N>
+inline std::uint64_t wide_add(std::array<std::uint64_t, N>& x,
+                              const std::array<std::uint64_t, N>& y) noexcept {
+  return add_limbs(x.data(), x.data(), y.data(), N);
+}
+
+template <std::size_t N>
+inline std::uint64_t wide_subtract(
+    std::array<std::uint64_t, N>& x,
+    const std::array<std::uint64_t, N>& y) noexcept {
+  return subtract_limbs(x.data(), x.data(), y.data(), N);
+}
+
+template <std::size_t N>
+inline int wide_compare(const std::array<std::uint64_t, N>& x,
+                        const std::array<std::uint64_t, N>& y) noexcept {
+  return compare_limbs(x.data(), y.data(), N);
+}
+
+template <std::size_t N>
+inline std::uint64_t wide_multiply(std::array<std::uint64_t, N>& x,
+                                   std::uint64_t m,
+                                   std::uint64_t carry = 0) noexcept {
+  return multiply_limbs(x.data(), x.data(), N, m, carry);
+}
+
+}  // namespace jz
+#endif // WIDE_ARITHMETIC_HH_
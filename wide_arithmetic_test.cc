@@ -0,0 +1,243 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "wide_arithmetic.hh"
+#include "wide_digit_adaptor.hh"
+#include "digit_test.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+namespace {
+
+using jz::wide_digit_adaptor;
+
+using limbs = std::vector<std::uint64_t>;
+using uint256 = std::array<std::uint64_t, 4>;
+
+// Slow references, which work in 32-bit halves so that every intermediate
+// fits in 64 bits, and share nothing with the kernels.
+std::vector<std::uint32_t> halves(const limbs& x) {
+  auto h = std::vector<std::uint32_t>{};
+  for (const auto limb : x) {
+    h.push_back(static_cast<std::uint32_t>(limb));
+    h.push_back(static_cast<std::uint32_t>(limb >> 32));
+  }
+  return h;
+}
+
+limbs join(const std::vector<std::uint32_t>& h) {
+  auto x = limbs(h.size() / 2);
+  for (std::size_t i = 0; i != x.size(); ++i) {
+    x[i] = h[2 * i] | std::uint64_t{h[2 * i + 1]} << 32;
+  }
+  return x;
+}
+
+limbs slow_add(const limbs& a, const limbs& b, std::uint64_t& carry) {
+  auto ha = halves(a);
+  const auto hb = halves(b);
+  auto c = std::uint64_t{0};
+  for (std::size_t i = 0; i != ha.size(); ++i) {
+    c += std::uint64_t{ha[i]} + hb[i];
+    ha[i] = static_cast<std::uint32_t>(c);
+    c >>= 32;
+  }
+  carry = c;
+  return join(ha);
+}
+
+limbs slow_subtract(const limbs& a, const limbs& b, std::uint64_t& borrow) {
+  auto ha = halves(a);
+  const auto hb = halves(b);
+  auto br = std::uint64_t{0};
+  for (std::size_t i = 0; i != ha.size(); ++i) {
+    const auto d = std::uint64_t{ha[i]} - hb[i] - br;
+    ha[i] = static_cast<std::uint32_t>(d);
+    br = d >> 63;
+  }
+  borrow = br;
+  return join(ha);
+}
+
+// Multiplies by m one 32-bit half at a time, so each product of halves,
+// plus two more halves, fits in 64 bits.
+limbs slow_multiply(const limbs& a, std::uint64_t m, std::uint64_t& top) {
+  const auto h = halves(a);
+  auto product = std::vector<std::uint32_t>(h.size() + 2);
+  for (const std::size_t shift : {0, 1}) {
+    const auto factor = (m >> (32 * shift)) & 0xFFFFFFFFu;
+    auto c = std::uint64_t{0};
+    for (std::size_t i = 0; i != h.size(); ++i) {
+      c += h[i] * factor + product[i + shift];
+      product[i + shift] = static_cast<std::uint32_t>(c);
+      c >>= 32;
+    }
+    product[h.size() + shift] = static_cast<std::uint32_t>(c);
+  }
+  auto result = join(product);
+  top = result.back();
+  result.pop_back();
+  return result;
+}
+
+limbs random_limbs(std::mt19937_64& rng, std::size_t n) {
+  auto x = limbs(n);
+  for (auto& limb : x) {
+    // All-ones and zero limbs make the long carry chains.
+    switch (rng() % 4) {
+      case 0:   limb = 0;     break;
+      case 1:   limb = ~0ULL; break;
+      default:  limb = rng(); break;
+    }
+  }
+  return x;
+}
+
+// Tests carries rippling across every limb, in and out of place.
+bool TestAddCarries() {
+  auto x = limbs{~0ULL, ~0ULL, ~0ULL, ~0ULL, ~0ULL, 7};
+  const auto one = limbs{1, 0, 0, 0, 0, 0};
+  auto sum = limbs(6);
+  if (jz::add_limbs(sum.data(), x.data(), one.data(), 6) != 0 ||
+      sum != limbs{0, 0, 0, 0, 0, 8}) {
+    return false;
+  }
+  if (jz::add_limbs(x.data(), x.data(), x.data(), 5) != 1 ||
+      x != limbs{~0ULL - 1, ~0ULL, ~0ULL, ~0ULL, ~0ULL, 7}) {
+    return false;
+  }
+
+  auto max = uint256{~0ULL, ~0ULL, ~0ULL, ~0ULL};
+  return jz::wide_add(max, uint256{1, 0, 0, 0}) == 1 && max == uint256{} &&
+         jz::add_limbs(sum.data(), sum.data(), one.data(), 0) == 0;
+}
+
+// Tests borrows, and that subtracting undoes adding.
+bool TestSubtractBorrows() {
+  auto x = uint256{0, 0, 0, 1};
+  if (jz::wide_subtract(x, uint256{1, 0, 0, 0}) != 0 ||
+      x != uint256{~0ULL, ~0ULL, ~0ULL, 0}) {
+    return false;
+  }
+  auto zero = uint256{};
+  if (jz::wide_subtract(zero, uint256{0, 0, 1, 0}) != 1 ||
+      zero != uint256{0, 0, ~0ULL, ~0ULL}) {
+    return false;
+  }
+
+  auto rng = std::mt19937_64{93};
+  for (int i = 0; i != 1000; ++i) {
+    const auto a = random_limbs(rng, 9), b = random_limbs(rng, 9);
+    auto c = a;
+    const auto carry = jz::add_limbs(c.data(), c.data(), b.data(), 9);
+    if (jz::subtract_limbs(c.data(), c.data(), b.data(), 9) != carry ||
+        c != a) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tests comparisons, which look at the most significant limb first.
+bool TestCompare() {
+  const auto a = uint256{~0ULL, 0, 0, 1}, b = uint256{0, 0, 0, 2};
+  const auto c = uint256{0, 1, 0, 1};
+  return jz::wide_compare(a, b) < 0 && jz::wide_compare(b, a) > 0 &&
+         jz::wide_compare(a, c) < 0 && jz::wide_compare(c, c) == 0 &&
+         jz::wide_compare(uint256{}, uint256{}) == 0 &&
+         jz::compare_limbs(a.data(), c.data(), 0) == 0 &&
+         jz::compare_limbs(a.data(), c.data(), 1) > 0;
+}
+
+// Tests every kernel, with both carry implementations, against the slow
+// references, at every length around the four-limb step.
+template <typename Carry>
+bool MatchesReference(std::mt19937_64& rng, std::size_t n) {
+  const auto a = random_limbs(rng, n), b = random_limbs(rng, n);
+  auto out = limbs(n);
+  auto expected_carry = std::uint64_t{0};
+
+  auto expected = slow_add(a, b, expected_carry);
+  if (jz::detail::add_limbs<Carry>(out.data(), a.data(), b.data(), n) !=
+      expected_carry || out != expected) {
+    return false;
+  }
+
+  expected = slow_subtract(a, b, expected_carry);
+  if (jz::detail::subtract_limbs<Carry>(out.data(), a.data(), b.data(), n) !=
+      expected_carry || out != expected) {
+    return false;
+  }
+
+  const auto m = rng() % 3 == 0 ? ~0ULL : rng() >> (rng() % 64);
+  expected = slow_multiply(a, m, expected_carry);
+  auto carry = jz::detail::multiply_limbs<Carry>(out.data(), a.data(), n, m,
+                                                  0);
+  if (carry != expected_carry || out != expected) { return false; }
+
+  // The carry in adds to the low limb.
+  auto bumped = limbs(n + 1);
+  bumped.back() = jz::detail::multiply_limbs<Carry>(bumped.data(), a.data(),
+                                                     n, m, 12345);
+  out.push_back(carry);
+  const auto addend = [&] {
+    auto x = limbs(n + 1);
+    x[0] = 12345;
+    return x;
+  }();
+  jz::add_limbs(out.data(), out.data(), addend.data(), n + 1);
+  return bumped == out;
+}
+
+bool TestKernelsMatchReference() {
+  auto rng = std::mt19937_64{930};
+  for (std::size_t n = 0; n != 20; ++n) {
+    for (int i = 0; i != 200; ++i) {
+      if (!MatchesReference<jz::detail::portable_carry>(rng, n) ||
+          !MatchesReference<jz::detail::native_carry>(rng, n)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Tests that an adaptor, and a proxy it handed out before the arithmetic,
+// read the new digits afterward.
+bool TestDigitsFollowArithmetic() {
+  auto x = uint256{999999, 0, 0, 0};
+  wide_digit_adaptor<4> d{x, 8};
+  auto hundreds = d[5];
+  if (hundreds != 9) { return false; }
+
+  jz::wide_add(x, uint256{1, 0, 0, 0});                 // 01000000
+  if (hundreds != 0 || d[1] != 1 || d[7] != 0) { return false; }
+
+  jz::wide_multiply(x, 3);                              // 03000000
+  if (d[1] != 3 || hundreds != 0) { return false; }
+
+  hundreds = 4;                                         // 03000400
+  jz::wide_subtract(x, uint256{1, 0, 0, 0});            // 03000399
+  const auto digits = std::vector<int>(d.begin(), d.end());
+  return x == uint256{3000399, 0, 0, 0} && hundreds == 3 &&
+         digits == std::vector<int>{0, 3, 0, 0, 0, 3, 9, 9};
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestAddCarries),
+  TEST_CASE(TestSubtractBorrows),
+  TEST_CASE(TestCompare),
+  TEST_CASE(TestKernelsMatchReference),
+  TEST_CASE(TestDigitsFollowArithmetic),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}
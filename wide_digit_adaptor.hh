@@ -0,0 +1,729 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#ifndef WIDE_DIGIT_ADAPTOR_HH_
+#define WIDE_DIGIT_ADAPTOR_HH_
+
+#include "digit_adaptor.hh"
+#include "wide_arithmetic.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace jz {
+namespace detail {
+
+// Calls f(std::integral_constant<std::size_t, I>) for I in [0, N), with the
+// loop written out, so the limb index is a constant in each call.
+template <typename F, std::size_t... I>
+inline void unroll(F&& f, std::index_sequence<I...>) {
+  const int expand[] = {0, (f(std::integral_constant<std::size_t, I>{}), 0)...};
+  (void)expand;
+}
+
+template <std::size_t N, typename F>
+inline void unroll(F&& f) {
+  unroll(std::forward<F>(f), std::make_index_sequence<N>{});
+}
+
+// Returns the number of RADIX digits in the largest N-limb value.
+template <std::size_t N, int RADIX>
+constexpr std::size_t max_wide_digits() noexcept {
+  std::uint64_t limbs[N] = {};
+  for (auto& limb : limbs) {
+    limb = ~std::uint64_t{0};
+  }
+
+  // Divides by RADIX, a limb at a time, until nothing is left.  RADIX is
+  // small, so 32-bit halves keep each step in 64 bits.
+  auto digits = std::size_t{0};
+  for (auto top = N; top != 0; ++digits) {
+    auto rem = std::uint64_t{0};
+    for (auto i = top; i-- != 0; ) {
+      const auto hi = (rem << 32) | (limbs[i] >> 32);
+      const auto lo = ((hi % RADIX) << 32) | (limbs[i] & 0xFFFFFFFFu);
+      limbs[i] = ((hi / RADIX) << 32) | (lo / RADIX);
+      rem = lo % RADIX;
+    }
+    while (top != 0 && limbs[top - 1] == 0) {
+      --top;
+    }
+  }
+  return digits;
+}
+
+// Holds RADIX^i, as N little-endian limbs, for every power that fits.
+template <std::size_t N, int RADIX>
+struct alignas(kTableAlign) wide_power_table {
+  static constexpr std::size_t kCount = max_wide_digits<N, RADIX>();
+
+  std::uint64_t powers[kCount][N];
+};
+
+template <std::size_t N, int RADIX>
+constexpr wide_power_table<N, RADIX> make_wide_power_table() noexcept {
+  wide_power_table<N, RADIX> table{};
+  table.powers[0][0] = 1;
+
+  for (auto i = std::size_t{1}; i != table.kCount; ++i) {
+    auto carry = std::uint64_t{0};
+    for (auto j = std::size_t{0}; j != N; ++j) {
+      const auto p = umul128(table.powers[i - 1][j], RADIX);
+      table.powers[i][j] = p.lo + carry;
+      carry = p.hi + (table.powers[i][j] < carry);
+    }
+  }
+  return table;
+}
+
+template <std::size_t N, int RADIX>
+struct wide_powers {
+  static constexpr wide_power_table<N, RADIX> table =
+      make_wide_power_table<N, RADIX>();
+};
+
+template <std::size_t N, int RADIX>
+constexpr wide_power_table<N, RADIX> wide_powers<N, RADIX>::table;
+
+// Divides a two-limb value by a 64-bit constant, with the method from
+// Moller and Granlund, "Improved division by invariant integers" (2011):
+// a multiply by a precomputed reciprocal, and two corrections.  A limb
+// chain divides by calling step() on each limb, most significant first.
+template <std::uint64_t D>
+struct limb_divider {
+  static_assert(D != 0, "Can't divide by zero");
+
+  static constexpr int shift() noexcept {
+    auto shift = 0;
+    for (auto d = D; (d >> 63) == 0; d <<= 1) {
+      ++shift;
+    }
+    return shift;
+  }
+
+  // Returns floor((2^128 - 1) / d) - 2^64, by long division of (~d:~0) by
+  // d, a bit at a time.
+  static constexpr std::uint64_t reciprocal(std::uint64_t d) noexcept {
+    auto hi = ~d, lo = ~std::uint64_t{0}, q = std::uint64_t{0};
+    for (int i = 0; i != 64; ++i) {
+      const bool top = (hi >> 63) != 0;
+      hi = (hi << 1) | (lo >> 63);
+      lo <<= 1;
+      q <<= 1;
+      if (top || hi >= d) {
+        hi -= d;
+        q |= 1;
+      }
+    }
+    return q;
+  }
+
+  // The divisor, shifted so its top bit is set, and its reciprocal.
+  static constexpr int kShift = shift();
+  static constexpr std::uint64_t kNorm = D << kShift;
+  static constexpr std::uint64_t kReciprocal = reciprocal(kNorm);
+
+  // Returns (rem:limb) / D, and leaves the remainder in 'rem', which must
+  // be less than D on entry.
+  static std::uint64_t step(std::uint64_t& rem, std::uint64_t limb) noexcept {
+    const auto u1 = kShift == 0 ? rem
+                  : (rem << kShift) | (limb >> ((64 - kShift) & 63));
+    const auto u0 = limb << kShift;
+
+    const auto p = umul128(kReciprocal, u1);
+    const auto q0 = p.lo + u0;
+    auto q1 = p.hi + u1 + 1 + (q0 < p.lo);
+    auto r = u0 - q1 * kNorm;
+
+    // The first correction happens often enough to do without a branch.
+    const auto over = std::uint64_t{0} - (r > q0);
+    q1 += over;
+    r += over & kNorm;
+    if (r >= kNorm) {
+      ++q1;
+      r -= kNorm;
+    }
+
+    rem = r >> kShift;
+    return q1;
+  }
+};
+
+}  // namespace detail
+
+// Adapts a fixed-width unsigned integer, held as std::array<std::uint64_t,
+// N> with the least significant limb first, to look like the same container
+// of digits that digit_adaptor provides.  This covers identifiers too wide
+// for any built-in type, such as 192- and 256-bit hashes, without a
+// dynamic big integer.
+//
+// Each digit read divides the number by the largest power of RADIX that
+// fits in a limb, one limb at a time, until it reaches the digit's chunk.
+// That's a few multiplies per limb per chunk, so reading every digit
+// through the iterators costs more than reading one.  decode() and
+// encode() do the whole number in one pass.
+//
+// Limb is 'std::uint64_t' or 'const std::uint64_t'.  With the latter, the
+// container is read-only, as digit_adaptor<const T> is.
+template <std::size_t N, int RADIX = 10, typename Limb = std::uint64_t>
+class wide_digit_adaptor {
+  static_assert(N > 0, "Needs at least one limb");
+  static_assert(RADIX > 1 && RADIX <= 256, "Digits must fit in a byte");
+  static_assert(std::is_same<std::remove_const_t<Limb>, std::uint64_t>::value,
+                "Limb must be std::uint64_t or const std::uint64_t");
+
+  using limbs_ = std::array<std::uint64_t, N>;
+  using number_type_ = std::conditional_t<std::is_const<Limb>::value,
+                           const limbs_, limbs_>;
+
+ public:
+  // The number of RADIX digits in the largest value.
+  static constexpr std::size_t kMaxDigits =
+      detail::max_wide_digits<N, RADIX>();
+
+  // Sets number of digits based on the current magnitude of the number.
+  // The number zero gets 1 digit.
+  explicit wide_digit_adaptor(number_type_& number) noexcept
+  : number_{number}, digits_{total_digits(number)} {}
+
+  // Sets an explicit number of digits, irrespective of the number's
+  // current magnitude.  As with digit_adaptor, too few digits may result
+  // in unusual operation.
+  wide_digit_adaptor(number_type_& number, std::size_t digits) noexcept
+  : number_{number}, digits_{digits} {}
+
+  // Forward iterators.
+  auto begin() const noexcept {
+    return iterator_<Forward, Limb>{*this, 0};
+  }
+  auto end() const noexcept {
+    return iterator_<Forward, Limb>{*this, digits_};
+  }
+  auto cbegin() const noexcept {
+    return iterator_<Forward, const Limb>{*this, 0};
+  }
+  auto cend() const noexcept {
+    return iterator_<Forward, const Limb>{*this, digits_};
+  }
+
+  // Reverse iterators.
+  auto rbegin() const noexcept {
+    return iterator_<Reverse, Limb>{*this, 0};
+  }
+  auto rend() const noexcept {
+    return iterator_<Reverse, Limb>{*this, digits_};
+  }
+  auto crbegin() const noexcept {
+    return iterator_<Reverse, const Limb>{*this, 0};
+  }
+  auto crend() const noexcept {
+    return iterator_<Reverse, const Limb>{*this, digits_};
+  }
+
+  // Explicit casts return the number.
+  explicit operator limbs_ () const noexcept {
+    return number_;
+  }
+
+  // Provides indirect access to each digit.  Behaves as a reference or a
+  // const reference depending on whether Limb is const.
+  auto operator[] (std::size_t index) const noexcept {
+    return reference_{&number_, position(index, digits_)};
+  }
+
+  // Returns the number of digits in the container.
+  constexpr std::size_t size() const noexcept {
+    return digits_;
+  }
+
+  // Compares as standard containers do:  equal if both hold the same number
+  // of digits with the same values.
+  bool operator==(const wide_digit_adaptor& rhs) const noexcept {
+    return digits_ == rhs.digits_ && number_ == rhs.number_;
+  }
+
+  bool operator!=(const wide_digit_adaptor& rhs) const noexcept {
+    return !this->operator==(rhs);
+  }
+
+  // Writes all size() digits to 'out', most significant first.  This
+  // divides the whole number into chunks in one pass, then splits each
+  // chunk with 64-bit arithmetic.
+  void decode(std::uint8_t* out) const noexcept {
+    std::uint64_t chunks[kChunks];
+    auto x = limbs_(number_);
+    for (auto& chunk : chunks) {
+      chunk = divide_by_chunk(x);
+    }
+
+    // Splits each chunk in half, so the two halves' digits come from
+    // independent chains of divisions.
+    constexpr auto kHalf = kChunkDigits / 2;
+    constexpr auto kHalfPower = detail::radix_powers<std::uint64_t, RADIX>::
+        table.powers[kHalf];
+    auto p = out + digits_;
+    for (auto c = std::size_t{0}; c != kChunks && p != out; ++c) {
+      auto lo = chunks[c] % kHalfPower;
+      auto hi = chunks[c] / kHalfPower;
+      if (p - out >= std::ptrdiff_t(kChunkDigits)) {
+        auto lo_end = p;
+        auto hi_end = p - kHalf;
+        for (auto i = std::size_t{0}; i != kHalf; ++i) {
+          *--lo_end = static_cast<std::uint8_t>(lo % RADIX);
+          lo /= RADIX;
+          *--hi_end = static_cast<std::uint8_t>(hi % RADIX);
+          hi /= RADIX;
+        }
+        if (kChunkDigits % 2 != 0) {
+          *--hi_end = static_cast<std::uint8_t>(hi);
+        }
+        p -= kChunkDigits;
+        continue;
+      }
+      for (auto i = std::size_t{0}; i != kChunkDigits && p != out; ++i) {
+        *--p = static_cast<std::uint8_t>(lo % RADIX);
+        lo = i + 1 == kHalf ? hi : lo / RADIX;
+      }
+    }
+    std::fill(out, p, std::uint8_t{0});      // Past kMaxDigits.
+  }
+
+  // Sets the number from size() digits, most significant first, a chunk
+  // of 64-bit arithmetic at a time.  Values too wide for N limbs wrap.
+  // Allowed only if Limb is not const.
+  void encode(const std::uint8_t* digits) const noexcept {
+    auto x = limbs_{};
+    auto p = digits;
+    const auto last = digits + digits_;
+
+    auto length = digits_ % kChunkDigits;
+    for (length = length ? length : kChunkDigits; p != last;
+         length = kChunkDigits) {
+      auto chunk = std::uint64_t{0};
+      for (const auto stop = p + length; p != stop; ++p) {
+        chunk = chunk * RADIX + *p;
+      }
+      multiply_add(x, detail::radix_power<std::uint64_t, RADIX>(length),
+                   chunk);
+    }
+    number_ = x;
+  }
+
+ private:
+  using NCU = std::uint64_t;
+
+  // Each chunk holds the digits of one limb-sized power, RADIX^k, that a
+  // chained division peels off.
+  static constexpr std::size_t kChunkDigits =
+      detail::max_radix_digits<std::uint64_t, RADIX>() - 1;
+  static constexpr std::uint64_t kChunk =
+      detail::radix_powers<std::uint64_t, RADIX>::table.powers[kChunkDigits];
+  static constexpr std::size_t kChunks =
+      (kMaxDigits + kChunkDigits - 1) / kChunkDigits;
+
+  using divider = detail::limb_divider<kChunk>;
+
+  number_type_& number_;
+  const std::size_t digits_;
+
+  // Divides 'x' by kChunk in place and returns the remainder.
+  static std::uint64_t divide_by_chunk(limbs_& x) noexcept {
+    auto rem = std::uint64_t{0};
+    detail::unroll<N>([&](auto i) {
+      constexpr auto limb = N - 1 - decltype(i)::value;
+      x[limb] = divider::step(rem, x[limb]);
+    });
+    return rem;
+  }
+
+  // Sets x = x * m + a, modulo 2^(64N).
+  static void multiply_add(limbs_& x, std::uint64_t m,
+                           std::uint64_t a) noexcept {
+    auto carry = a;
+    detail::unroll<N>([&](auto i) {
+      const auto p = detail::umul128(x[i], m);
+      x[i] = p.lo + carry;
+      carry = p.hi + (x[i] < carry);
+    });
+  }
+
+  // Sets x = x + d * RADIX^p, or x - d * RADIX^p, modulo 2^(64N).
+  // Powers past the table wrap, as digit_adaptor's do.
+  static void add_digit(limbs_& x, std::size_t p, std::uint64_t d,
+                        bool subtract) noexcept {
+    const auto& table = detail::wide_powers<N, RADIX>::table;
+    auto power = limbs_{};
+    const auto top = std::min(p, table.kCount - 1);
+    std::copy(table.powers[top], table.powers[top] + N, power.begin());
+    for (auto i = top; i != p; ++i) {
+      multiply_add(power, RADIX, 0);
+    }
+    multiply_add(power, d, 0);
+    if (subtract) {
+      wide_subtract(x, power);
+    } else {
+      wide_add(x, power);
+    }
+  }
+
+  // Returns the digit at position p, counting from the least significant.
+  static int read_digit(const limbs_& number, std::size_t p) noexcept {
+    const auto chunk_index = p / kChunkDigits;
+    if (chunk_index >= kChunks) {
+      return 0;
+    }
+    auto x = number;
+    auto chunk = divide_by_chunk(x);
+    for (auto c = std::size_t{0}; c != chunk_index; ++c) {
+      chunk = divide_by_chunk(x);
+    }
+    const auto power =
+        detail::radix_power<std::uint64_t, RADIX>(p % kChunkDigits);
+    return static_cast<int>((chunk / power) % RADIX);
+  }
+
+  static void write_digit(limbs_& number, std::size_t p, int digit) noexcept {
+    const auto old = read_digit(number, p);
+    digit %= RADIX;
+    digit += digit < 0 ? RADIX : 0;
+    if (digit != old) {
+      add_digit(number, p,
+                static_cast<std::uint64_t>(digit < old ? old - digit
+                                                       : digit - old),
+                digit < old);
+    }
+  }
+
+  // Returns the total number of RADIX digits in a number, by binary search
+  // of the power table.  Allow 0 to have exactly 1 digit.
+  static std::size_t total_digits(const limbs_& number) noexcept {
+    const auto& table = detail::wide_powers<N, RADIX>::table;
+    auto lo = std::size_t{1}, hi = table.kCount;
+    while (lo != hi) {
+      const auto mid = lo + (hi - lo) / 2;
+      if (less(number, table.powers[mid])) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return lo;
+  }
+
+  static bool less(const limbs_& a, const std::uint64_t (&b)[N]) noexcept {
+    for (auto i = N; i-- != 0; ) {
+      if (a[i] != b[i]) {
+        return a[i] < b[i];
+      }
+    }
+    return false;
+  }
+
+  enum iterator_dir { Forward, Reverse };
+
+  // Returns the position, counting from the least significant digit, of
+  // an index.  Clamps index to digits >= index >= 0.
+  template <iterator_dir Direction = Forward>
+  static std::size_t position(std::size_t index, std::size_t digits) noexcept {
+    index = std::min(digits, index);
+    if (Direction == Forward) {
+      return index < digits ? digits - 1 - index : 0;
+    }
+    return index;
+  }
+
+  // Forward declarations.
+  class mutable_pointer_;
+  class const_pointer_;
+  class const_reference_;
+
+  // Provides indirect access to a digit, as digit_adaptor's reference
+  // does, with int standing in for T.
+  class mutable_reference_ {
+   public:
+    using is_digit_adaptor_mutable_reference = std::true_type;
+
+    mutable_reference_(limbs_* number, std::size_t position) noexcept
+    : number_{number}, position_{position} {}
+
+    mutable_reference_(const mutable_reference_&) = default;
+
+    operator int () const noexcept {
+      return read_digit(*number_, position_);
+    }
+
+    const auto& operator=(int digit) const noexcept {
+      write_digit(*number_, position_, digit);
+      return *this;
+    }
+
+    // Behaves like an lvalue reference, copying the referent's value to
+    // our value, rather than copying the proxy.
+    const auto& operator=(const_reference_ rhs) const noexcept {
+      return this->operator=(int{rhs});
+    }
+    const auto& operator=(mutable_reference_ rhs) const noexcept {
+      return this->operator=(int{rhs});
+    }
+
+    ~mutable_reference_() noexcept = default;
+
+    // Convert a "reference" back into a "pointer."
+    auto operator&() const noexcept {
+      return mutable_pointer_{number_, position_};
+    }
+
+    bool operator<(const_reference_ rhs) const noexcept {
+      return int{*this} < int{rhs};
+    }
+
+    bool operator==(const_reference_ rhs) const noexcept {
+      return int{*this} == int{rhs};
+    }
+
+    const auto& operator++() const noexcept {
+      return this->operator=(int{*this} + 1);
+    }
+
+    const auto& operator--() const noexcept {
+      return this->operator=(int{*this} - 1);
+    }
+
+    int operator++(int) const noexcept {
+      auto temp = int{*this};
+      this->operator++();
+      return temp;
+    }
+
+    int operator--(int) const noexcept {
+      auto temp = int{*this};
+      this->operator--();
+      return temp;
+    }
+
+    // Swaps the underlying digit values, not the reference proxies.
+    void swap(const mutable_reference_& rhs) const noexcept {
+      auto d1 = int{*this};
+      auto d2 = int{rhs};
+      this->operator=(d2);
+      rhs.operator=(d1);
+    }
+
+    operator const_reference_() const noexcept {
+      return const_reference_{*this};
+    }
+
+   private:
+    limbs_ *const number_;
+    const std::size_t position_;
+    friend class const_reference_;
+  };
+
+  class mutable_pointer_ {
+   public:
+    mutable_pointer_(limbs_* number, std::size_t position) noexcept
+    : ref_{number, position} {}
+
+    auto operator->() const { return ref_; }
+    auto operator*()  const { return ref_; }
+
+   private:
+    mutable_reference_ ref_;
+  };
+
+  // Provides read-only indirect access to a digit.
+  class const_reference_ {
+   public:
+    const_reference_(const limbs_* number, std::size_t position) noexcept
+    : number_{number}, position_{position} {}
+
+    const_reference_(const const_reference_&) noexcept = default;
+
+    const_reference_(const mutable_reference_& ref) noexcept
+    : number_{ref.number_}, position_{ref.position_} {}
+
+    operator int () const noexcept {
+      return read_digit(*number_, position_);
+    }
+
+    ~const_reference_() noexcept = default;
+
+    auto operator&() const noexcept {
+      return const_pointer_{number_, position_};
+    }
+
+    bool operator<(const_reference_ rhs) const noexcept {
+      return int{*this} < int{rhs};
+    }
+
+    bool operator==(const_reference_ rhs) const noexcept {
+      return int{*this} == int{rhs};
+    }
+
+   private:
+    const limbs_ *const number_;
+    const std::size_t position_;
+  };
+
+  class const_pointer_ {
+   public:
+    const_pointer_(const limbs_* number, std::size_t position) noexcept
+    : ref_{number, position} {}
+
+    auto operator->() const { return ref_; }
+    auto operator*()  const { return ref_; }
+
+   private:
+    const_reference_ ref_;
+  };
+
+  using pointer_   = std::conditional_t<std::is_const<Limb>::value,
+                         const_pointer_, mutable_pointer_>;
+  using reference_ = std::conditional_t<std::is_const<Limb>::value,
+                         const_reference_, mutable_reference_>;
+
+  // Supports forward and reverse traversal, as digit_adaptor's iterator
+  // does.  QL is the "qualified Limb."
+  template <iterator_dir Direction, typename QL = Limb>
+  class iterator_ {
+   public:
+    using iterator_category = std::random_access_iterator_tag;
+    using difference_type   = std::ptrdiff_t;
+    using value_type        = int;
+    using pointer   = std::conditional_t<std::is_const<QL>::value,
+                          const_pointer_, pointer_>;
+    using reference = std::conditional_t<std::is_const<QL>::value,
+                          const_reference_, reference_>;
+
+    iterator_(const wide_digit_adaptor& wda, std::size_t index) noexcept
+    : adaptor_{&wda}, index_{index} {}
+
+    iterator_(const iterator_&)            = default;
+    iterator_& operator=(const iterator_&) = default;
+
+    auto& operator++() noexcept {
+      if (index_ < adaptor_->digits_) ++index_;
+      return *this;
+    }
+
+    auto operator++(int) noexcept {
+      auto temp = iterator_{*this};
+      this->operator++();
+      return temp;
+    }
+
+    auto& operator--() noexcept {
+      if (index_ > 0) --index_;
+      return *this;
+    }
+
+    auto operator--(int) noexcept {
+      auto temp = iterator_{*this};
+      this->operator--();
+      return temp;
+    }
+
+    auto operator+(difference_type rhs) const noexcept {
+      auto temp = iterator_{*this};
+      temp += rhs;
+      return temp;
+    }
+
+    auto operator-(difference_type rhs) const noexcept {
+      auto temp = iterator_{*this};
+      temp -= rhs;
+      return temp;
+    }
+
+    difference_type operator-(const iterator_& rhs) const noexcept {
+      return difference_type(index_) - difference_type(rhs.index_);
+    }
+
+    auto& operator+=(difference_type rhs) noexcept {
+      const auto index = std::max(difference_type{0},
+                                  difference_type(index_) + rhs);
+      index_ = std::min(adaptor_->digits_, std::size_t(index));
+      return *this;
+    }
+
+    auto& operator-=(difference_type rhs) noexcept {
+      return this->operator+=(-rhs);
+    }
+
+    bool operator==(const iterator_& rhs) const noexcept {
+      return index_ == rhs.index_;
+    }
+
+    bool operator!=(const iterator_& rhs) const noexcept {
+      return !this->operator==(rhs);
+    }
+
+    bool operator<(const iterator_& rhs) const noexcept {
+      return index_ < rhs.index_;
+    }
+
+    bool operator>=(const iterator_& rhs) const noexcept {
+      return !this->operator<(rhs);
+    }
+
+    bool operator>(const iterator_& rhs) const noexcept {
+      return index_ > rhs.index_;
+    }
+
+    bool operator<=(const iterator_& rhs) const noexcept {
+      return !this->operator>(rhs);
+    }
+
+    reference operator*() const noexcept {
+      return {&adaptor_->number_,
+              position<Direction>(index_, adaptor_->digits_)};
+    }
+
+   private:
+    const wide_digit_adaptor* adaptor_;
+    std::size_t index_;
+  };
+
+ public:
+  using element_type    = Limb;
+  using value_type      = int;
+  using size_type       = std::size_t;
+  using difference_type = std::ptrdiff_t;
+  using pointer         = wide_digit_adaptor::pointer_;
+  using const_pointer   = wide_digit_adaptor::const_pointer_;
+  using reference       = wide_digit_adaptor::reference_;
+  using const_reference = wide_digit_adaptor::const_reference_;
+  using iterator        = wide_digit_adaptor::iterator_<Forward, Limb>;
+  using const_iterator  = wide_digit_adaptor::iterator_<Forward, const Limb>;
+};
+
+template <std::size_t N, int RADIX, typename Limb>
+constexpr std::size_t wide_digit_adaptor<N, RADIX, Limb>::kMaxDigits;
+
+template <std::size_t N, int RADIX, typename Limb>
+constexpr std::size_t wide_digit_adaptor<N, RADIX, Limb>::kChunkDigits;
+
+template <std::size_t N, int RADIX, typename Limb>
+constexpr std::uint64_t wide_digit_adaptor<N, RADIX, Limb>::kChunk;
+
+template <std::size_t N, int RADIX, typename Limb>
+constexpr std::size_t wide_digit_adaptor<N, RADIX, Limb>::kChunks;
+
+// Returns a wide_digit_adaptor on 'number', with its natural digit count.
+template <int RADIX = 10, std::size_t N>
+wide_digit_adaptor<N, RADIX> make_wide_digit_adaptor(
+    std::array<std::uint64_t, N>& number) noexcept {
+  return wide_digit_adaptor<N, RADIX>{number};
+}
+
+template <int RADIX = 10, std::size_t N>
+wide_digit_adaptor<N, RADIX, const std::uint64_t> make_wide_digit_adaptor(
+    const std::array<std::uint64_t, N>& number) noexcept {
+  return wide_digit_adaptor<N, RADIX, const std::uint64_t>{number};
+}
+
+}  // namespace jz
+#endif // WIDE_DIGIT_ADAPTOR_HH_
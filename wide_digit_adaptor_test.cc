@@ -0,0 +1,250 @@
+// Author:  Joe Zbiciak <joe.zbiciak@leftturnonly.info>
+// SPDX-License-Identifier:  CC-BY-SA-4.0
+#include "wide_digit_adaptor.hh"
+#include "digit_test.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using jz::digit_adaptor;
+using jz::wide_digit_adaptor;
+
+using uint192 = std::array<std::uint64_t, 3>;
+using uint256 = std::array<std::uint64_t, 4>;
+
+// Returns the RADIX digits of 'number', most significant first, by long
+// division in 32-bit halves.  This is slow, and shares nothing with the
+// adaptor.
+template <int RADIX, std::size_t N>
+std::vector<int> slow_digits(std::array<std::uint64_t, N> number) {
+  auto digits = std::vector<int>{};
+  do {
+    auto rem = std::uint64_t{0};
+    for (auto i = N; i-- != 0; ) {
+      const auto hi = (rem << 32) | (number[i] >> 32);
+      const auto lo = ((hi % RADIX) << 32) | (number[i] & 0xFFFFFFFFu);
+      number[i] = ((hi / RADIX) << 32) | (lo / RADIX);
+      rem = lo % RADIX;
+    }
+    digits.insert(digits.begin(), static_cast<int>(rem));
+  } while (number != std::array<std::uint64_t, N>{});
+  return digits;
+}
+
+template <typename Digits>
+std::vector<int> iterated(const Digits& digits) {
+  return std::vector<int>(digits.begin(), digits.end());
+}
+
+template <typename Digits>
+std::vector<int> decoded(const Digits& digits) {
+  auto bytes = std::vector<std::uint8_t>(digits.size());
+  digits.decode(bytes.data());
+  return std::vector<int>(bytes.begin(), bytes.end());
+}
+
+template <int RADIX, std::size_t N>
+std::array<std::uint64_t, N> random_number(std::mt19937_64& rng) {
+  auto number = std::array<std::uint64_t, N>{};
+  for (auto& limb : number) {
+    limb = rng() >> (rng() % 64);
+  }
+  number[rng() % N] = 0;
+  return number;
+}
+
+// Tests reading the digits of the largest 256-bit value.
+bool TestReadingDigits() {
+  const auto max = uint256{~0ULL, ~0ULL, ~0ULL, ~0ULL};
+  const auto d = jz::make_wide_digit_adaptor(max);
+  auto expected = std::vector<int>{};
+  for (const char c : std::string{"115792089237316195423570985008687907853"
+                                  "269984665640564039457584007913129639935"}) {
+    expected.push_back(c - '0');
+  }
+  if (d.size() != 78 || d.kMaxDigits != 78 || iterated(d) != expected ||
+      decoded(d) != expected) {
+    return false;
+  }
+
+  auto reversed = std::vector<int>(d.crbegin(), d.crend());
+  std::reverse(reversed.begin(), reversed.end());
+  if (reversed != expected || d[0] != 1 || d[77] != 5) { return false; }
+
+  // Every hex digit of the limbs.
+  const auto hex = uint256{0x0123456789ABCDEFULL, 0xFEDCBA9876543210ULL,
+                           0, 0x8000000000000000ULL};
+  const auto h = jz::make_wide_digit_adaptor<16>(hex);
+  return h.size() == 64 && h[0] == 8 && h[1] == 0 && h[32] == 15 &&
+         h[47] == 0 && h[48] == 0 && h[49] == 1 && h[56] == 8 && h[63] == 15;
+}
+
+// Tests writing digits, with wrap-around past the top limb.
+bool TestWritingDigits() {
+  auto x = uint256{};
+  wide_digit_adaptor<4> d{x, 78};
+  const auto max = uint256{~0ULL, ~0ULL, ~0ULL, ~0ULL};
+  const auto digits = slow_digits<10>(max);
+  for (std::size_t i = 0; i != digits.size(); ++i) {
+    d[i] = digits[i];
+  }
+  if (x != max) { return false; }
+
+  // Adding 1 to the last digit wraps to 0, as digit_adaptor would, and
+  // takes the rest of the number along with it.
+  ++d[77];
+  if (x != uint256{}) { return false; }
+
+  --d[77];                    // 0 - 1 is 9, modulo RADIX; the value is 9.
+  if (x != uint256{9, 0, 0, 0}) { return false; }
+
+  d[40] = 3;
+  d[77] = 2;
+  jz::swap(d[40], d[77]);
+  d[0]++;
+  return slow_digits<10>(x) ==
+         std::vector<int>{1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                          0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                          0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+                          0, 0, 0, 0, 0, 0, 0, 0, 0, 3};
+}
+
+// Tests that a one-limb value reads as digit_adaptor<std::uint64_t> does,
+// in several radices.
+template <int RADIX>
+bool MatchesUint64(std::uint64_t value) {
+  auto wide = std::array<std::uint64_t, 2>{value, 0};
+  auto narrow = value;
+  const wide_digit_adaptor<2, RADIX> w{wide};
+  const digit_adaptor<std::uint64_t, RADIX> n{narrow};
+  auto expected = std::vector<int>{};
+  for (const auto digit : n) {
+    expected.push_back(static_cast<int>(std::uint64_t{digit}));
+  }
+  return w.size() == n.size() && iterated(w) == expected &&
+         decoded(w) == expected;
+}
+
+bool TestMatchesUint64() {
+  auto rng = std::mt19937_64{92};
+  for (int i = 0; i != 1000; ++i) {
+    const auto value = rng() >> (rng() % 64);
+    if (!MatchesUint64<10>(value) || !MatchesUint64<2>(value) ||
+        !MatchesUint64<7>(value) || !MatchesUint64<16>(value) ||
+        !MatchesUint64<36>(value)) {
+      return false;
+    }
+  }
+  return MatchesUint64<10>(0) && MatchesUint64<10>(~0ULL);
+}
+
+// Tests decode() and encode() against the slow digits, with and without
+// leading zeros.
+template <int RADIX, std::size_t N>
+bool RoundTrips(std::mt19937_64& rng) {
+  const auto number = random_number<RADIX, N>(rng);
+  const auto expected = slow_digits<RADIX>(number);
+  const wide_digit_adaptor<N, RADIX, const std::uint64_t> d{number};
+  if (d.size() != expected.size() || decoded(d) != expected ||
+      iterated(d) != expected) {
+    return false;
+  }
+
+  const auto padded = d.size() + rng() % 30;
+  auto bytes = std::vector<std::uint8_t>(padded);
+  wide_digit_adaptor<N, RADIX, const std::uint64_t>{number, padded}.decode(
+      bytes.data());
+  if (!std::all_of(bytes.begin(), bytes.end() - d.size(),
+                   [](std::uint8_t b) { return b == 0; })) {
+    return false;
+  }
+
+  auto copy = std::array<std::uint64_t, N>{};
+  wide_digit_adaptor<N, RADIX>{copy, padded}.encode(bytes.data());
+  return copy == number;
+}
+
+bool TestRoundTrips() {
+  auto rng = std::mt19937_64{920};
+  for (int i = 0; i != 500; ++i) {
+    if (!RoundTrips<10, 3>(rng) || !RoundTrips<10, 4>(rng) ||
+        !RoundTrips<10, 1>(rng) || !RoundTrips<2, 3>(rng) ||
+        !RoundTrips<3, 4>(rng) || !RoundTrips<16, 4>(rng) ||
+        !RoundTrips<36, 3>(rng) || !RoundTrips<255, 2>(rng)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Tests sorting and reversing digits with std algorithms, as
+// digit_adaptor_test.cc does.  The values stay under 2^128, so any
+// arrangement of 45 digits fits in 192 bits.
+bool TestStdAlgorithms() {
+  auto rng = std::mt19937_64{9200};
+  for (int i = 0; i != 50; ++i) {
+    auto x = random_number<10, 3>(rng);
+    x[2] = 0;
+    wide_digit_adaptor<3> d{x, 45};
+    auto expected = iterated(d);
+
+    std::sort(d.begin(), d.end());
+    std::sort(expected.begin(), expected.end());
+    if (iterated(d) != expected) { return false; }
+
+    std::reverse(d.begin(), d.end());
+    std::reverse(expected.begin(), expected.end());
+    if (iterated(d) != expected) { return false; }
+  }
+  return true;
+}
+
+// Tests natural digit counts at every power of 10, and comparisons.
+bool TestDigitCounts() {
+  auto power = uint192{1, 0, 0};
+  for (std::size_t digits = 1; digits <= 58; ++digits) {
+    auto below = power;
+    for (auto i = std::size_t{0}; i != 3 && below[i]-- == 0; ++i) {}
+    if (wide_digit_adaptor<3>{power}.size() != digits ||
+        (digits > 1 && wide_digit_adaptor<3>{below}.size() != digits - 1)) {
+      return false;
+    }
+    auto carry = std::uint64_t{0};
+    for (auto& limb : power) {
+      const auto p = jz::detail::umul128(limb, 10);
+      limb = p.lo + carry;
+      carry = p.hi + (limb < carry);
+    }
+  }
+
+  auto zero = uint192{}, a = uint192{5, 6, 7}, b = a;
+  return wide_digit_adaptor<3>{zero}.size() == 1 &&
+         wide_digit_adaptor<3>{a} == wide_digit_adaptor<3>{b} &&
+         wide_digit_adaptor<3>{a} != wide_digit_adaptor<3>{b, 60} &&
+         wide_digit_adaptor<3>::kMaxDigits == 58;
+}
+
+// Declares our set of test cases.
+const jz::test::TestCase tests[] = {
+  TEST_CASE(TestReadingDigits),
+  TEST_CASE(TestWritingDigits),
+  TEST_CASE(TestMatchesUint64),
+  TEST_CASE(TestRoundTrips),
+  TEST_CASE(TestStdAlgorithms),
+  TEST_CASE(TestDigitCounts),
+};
+
+}  // namespace
+
+
+int main() {
+  jz::test::run_tests(tests);
+}